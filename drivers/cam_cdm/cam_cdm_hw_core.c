@@ -18,6 +18,7 @@
 #include "cam_cdm.h"
 #include "cam_cdm_core_common.h"
 #include "cam_cdm_soc.h"
+#include "cam_cdm_util.h"
 #include "cam_io_util.h"
 #include "cam_cdm_hw_reg_1_0.h"
 #include "cam_cdm_hw_reg_1_1.h"
@@ -32,6 +33,10 @@
 #define CAM_CDM_BL_FIFO_WAIT_TIMEOUT 2000
 #define CAM_CDM_DBG_GEN_IRQ_USR_DATA 0xff
 
+/* CAM_CDM_OPT_* stages run on mem handle BLs before submission */
+static uint cdm_bl_opt_flags;
+module_param(cdm_bl_opt_flags, uint, 0644);
+
 static void cam_hw_cdm_work(struct work_struct *work);
 
 /* DT match table entry for all CDM variants*/
@@ -757,6 +762,46 @@ end:
 	return rc;
 }
 
+static void cam_hw_cdm_optimize_bl(struct cam_cdm_bl_cmd *bl_cmd)
+{
+	int rc;
+	uintptr_t cpu_addr;
+	size_t buf_len;
+	uint32_t size = bl_cmd->len;
+
+	if ((bl_cmd->len > CAM_CDM_OPT_MAX_BL_SIZE) ||
+		(bl_cmd->len % 4) || (bl_cmd->offset % 4))
+		return;
+
+	rc = cam_mem_get_cpu_buf(bl_cmd->bl_addr.mem_handle, &cpu_addr,
+		&buf_len);
+	if (rc || !cpu_addr) {
+		CAM_DBG(CAM_CDM, "No cpu address for hdl=%x rc=%d",
+			bl_cmd->bl_addr.mem_handle, rc);
+		return;
+	}
+
+	if ((buf_len < bl_cmd->offset) ||
+		((buf_len - bl_cmd->offset) < bl_cmd->len))
+		goto put_buf;
+
+	rc = cam_cdm_util_optimize_cmd_buf(
+		(uint32_t *)(cpu_addr + bl_cmd->offset), &size,
+		cdm_bl_opt_flags);
+	if (rc) {
+		CAM_DBG(CAM_CDM, "BL hdl=%x not optimized rc=%d",
+			bl_cmd->bl_addr.mem_handle, rc);
+		goto put_buf;
+	}
+
+	CAM_DBG(CAM_CDM, "BL hdl=%x offset=%u len %u -> %u",
+		bl_cmd->bl_addr.mem_handle, bl_cmd->offset, bl_cmd->len, size);
+	bl_cmd->len = size;
+
+put_buf:
+	cam_mem_put_cpu_buf(bl_cmd->bl_addr.mem_handle);
+}
+
 int cam_hw_cdm_submit_debug_gen_irq(
 	struct cam_hw_info *cdm_hw,
 	uint32_t            fifo_idx)
@@ -1002,6 +1047,10 @@ int cam_hw_cdm_submit_bl(struct cam_hw_info *cdm_hw,
 				break;
 			}
 
+			if (cdm_bl_opt_flags && (req->data->type ==
+				CAM_CDM_BL_CMD_TYPE_MEM_HANDLE))
+				cam_hw_cdm_optimize_bl(&cdm_cmd->cmd[i]);
+
 			CAM_DBG(CAM_CDM, "Got the HW VA");
 			if (core->bl_fifo[fifo_idx].bl_tag >=
 				(bl_fifo->bl_depth - 1))
@@ -7,6 +7,10 @@
 #include <linux/kernel.h>
 #include <linux/errno.h>
 #include <linux/bug.h>
+#include <linux/mm.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/ktime.h>
 
 #include "cam_cdm_intf_api.h"
 #include "cam_cdm_util.h"
@@ -479,10 +483,32 @@ int cam_cdm_get_ioremap_from_base(uint32_t hw_base,
 	return ret;
 }
 
-static int cam_cdm_util_reg_cont_write(void __iomem *base_addr,
-	uint32_t *cmd_buf, uint32_t cmd_buf_size, uint32_t *used_bytes)
+/**
+ * struct cam_cdm_util_exec_ctx - Software CDM execution state
+ * @device_base:     Current ioremapped base selected by change-base
+ * @base_table:      Register maps of the client
+ * @base_array_size: Number of entries in @base_table
+ */
+struct cam_cdm_util_exec_ctx {
+	void __iomem             **device_base;
+	struct cam_soc_reg_map   **base_table;
+	uint32_t                   base_array_size;
+};
+
+typedef int (*cam_cdm_util_exec_func)(struct cam_cdm_util_exec_ctx *ctx,
+	uint32_t cdm_cmd_type, uint32_t *cmd_buf, uint32_t cmd_buf_size,
+	uint32_t *used_bytes);
+
+/*
+ * Command handlers below issue relaxed writes only, the ordering against
+ * the rest of the system is provided by the barriers around the whole BL
+ * in cam_cdm_util_cmd_buf_write.
+ */
+static int cam_cdm_util_reg_cont_write(struct cam_cdm_util_exec_ctx *ctx,
+	uint32_t cdm_cmd_type, uint32_t *cmd_buf, uint32_t cmd_buf_size,
+	uint32_t *used_bytes)
 {
-	int ret = 0;
+	void __iomem *base_addr = *ctx->device_base;
 	uint32_t *data;
 	struct cdm_regcontinuous_cmd *reg_cont;
 
@@ -509,12 +535,14 @@ static int cam_cdm_util_reg_cont_write(void __iomem *base_addr,
 	*used_bytes = (reg_cont->count * sizeof(uint32_t)) +
 		(4 * cdm_get_cmd_header_size(CAM_CDM_CMD_REG_CONT));
 
-	return ret;
+	return 0;
 }
 
-static int cam_cdm_util_reg_random_write(void __iomem *base_addr,
-	uint32_t *cmd_buf, uint32_t cmd_buf_size, uint32_t *used_bytes)
+static int cam_cdm_util_reg_random_write(struct cam_cdm_util_exec_ctx *ctx,
+	uint32_t cdm_cmd_type, uint32_t *cmd_buf, uint32_t cmd_buf_size,
+	uint32_t *used_bytes)
 {
+	void __iomem *base_addr = *ctx->device_base;
 	uint32_t i;
 	struct cdm_regrandom_cmd *reg_random;
 	uint32_t *data;
@@ -536,9 +564,6 @@ static int cam_cdm_util_reg_random_write(void __iomem *base_addr,
 	data = cmd_buf + cdm_get_cmd_header_size(CAM_CDM_CMD_REG_RANDOM);
 
 	for (i = 0; i < reg_random->count; i++) {
-		CAM_DBG(CAM_CDM, "reg random: offset %pK, value 0x%x",
-			((void __iomem *)(base_addr + data[0])),
-			data[1]);
 		cam_io_w(data[1], base_addr + data[0]);
 		data += 2;
 	}
@@ -549,14 +574,22 @@ static int cam_cdm_util_reg_random_write(void __iomem *base_addr,
 	return 0;
 }
 
-static int cam_cdm_util_swd_dmi_write(uint32_t cdm_cmd_type,
-	void __iomem *base_addr, uint32_t *cmd_buf, uint32_t cmd_buf_size,
+static int cam_cdm_util_swd_dmi_write(struct cam_cdm_util_exec_ctx *ctx,
+	uint32_t cdm_cmd_type, uint32_t *cmd_buf, uint32_t cmd_buf_size,
 	uint32_t *used_bytes)
 {
-	uint32_t i;
+	void __iomem *base_addr = *ctx->device_base;
+	void __iomem *data_lo, *data_hi;
+	uint32_t i, num_words;
 	struct cdm_dmi_cmd *swd_dmi;
 	uint32_t *data;
 
+	if (!base_addr) {
+		CAM_ERR(CAM_CDM, "Got SWI DMI cmd =%d for invalid hw",
+			cdm_cmd_type);
+		return -EINVAL;
+	}
+
 	swd_dmi = (struct cdm_dmi_cmd *)cmd_buf;
 
 	if (cmd_buf_size < (cdm_required_size_dmi() + swd_dmi->length + 1)) {
@@ -566,32 +599,71 @@ static int cam_cdm_util_swd_dmi_write(uint32_t cdm_cmd_type,
 	}
 	data = cmd_buf + cdm_required_size_dmi();
 
+	/*
+	 * The DMI data port auto increments, back to back relaxed writes to
+	 * the same device are not reordered so no barrier is needed between
+	 * them.
+	 */
 	if (cdm_cmd_type == CAM_CDM_CMD_SWD_DMI_64) {
-		for (i = 0; i < (swd_dmi->length + 1)/8; i++) {
-			cam_io_w_mb(data[0], base_addr +
-				swd_dmi->DMIAddr + CAM_CDM_DMI_DATA_LO_OFFSET);
-			cam_io_w_mb(data[1], base_addr +
-				swd_dmi->DMIAddr + CAM_CDM_DMI_DATA_HI_OFFSET);
+		data_lo = base_addr + swd_dmi->DMIAddr +
+			CAM_CDM_DMI_DATA_LO_OFFSET;
+		data_hi = base_addr + swd_dmi->DMIAddr +
+			CAM_CDM_DMI_DATA_HI_OFFSET;
+		num_words = (swd_dmi->length + 1) / 8;
+		for (i = 0; i < num_words; i++) {
+			cam_io_w(data[0], data_lo);
+			cam_io_w(data[1], data_hi);
 			data += 2;
 		}
-	} else if (cdm_cmd_type == CAM_CDM_CMD_DMI) {
-		for (i = 0; i < (swd_dmi->length + 1)/4; i++) {
-			cam_io_w_mb(data[0], base_addr +
-				swd_dmi->DMIAddr + CAM_CDM_DMI_DATA_OFFSET);
-			data += 1;
-		}
 	} else {
-		for (i = 0; i < (swd_dmi->length + 1)/4; i++) {
-			cam_io_w_mb(data[0], base_addr +
-				swd_dmi->DMIAddr + CAM_CDM_DMI_DATA_LO_OFFSET);
-			data += 1;
-		}
+		if (cdm_cmd_type == CAM_CDM_CMD_DMI)
+			data_lo = base_addr + swd_dmi->DMIAddr +
+				CAM_CDM_DMI_DATA_OFFSET;
+		else
+			data_lo = base_addr + swd_dmi->DMIAddr +
+				CAM_CDM_DMI_DATA_LO_OFFSET;
+		num_words = (swd_dmi->length + 1) / 4;
+		for (i = 0; i < num_words; i++)
+			cam_io_w(data[i], data_lo);
 	}
 	*used_bytes = (4 * cdm_required_size_dmi()) + swd_dmi->length + 1;
 
 	return 0;
 }
 
+static int cam_cdm_util_change_base(struct cam_cdm_util_exec_ctx *ctx,
+	uint32_t cdm_cmd_type, uint32_t *cmd_buf, uint32_t cmd_buf_size,
+	uint32_t *used_bytes)
+{
+	int ret;
+	struct cdm_changebase_cmd *change_base_cmd =
+		(struct cdm_changebase_cmd *)cmd_buf;
+
+	ret = cam_cdm_get_ioremap_from_base(change_base_cmd->base,
+		ctx->base_array_size, ctx->base_table, ctx->device_base);
+	if (ret != 0) {
+		CAM_ERR(CAM_CDM, "Get ioremap change base failed %x",
+			change_base_cmd->base);
+		return ret;
+	}
+	CAM_DBG(CAM_CDM, "Got ioremap for %x addr=%pK",
+		change_base_cmd->base, *ctx->device_base);
+
+	*used_bytes = 4 * cdm_required_size_changebase();
+
+	return 0;
+}
+
+static const cam_cdm_util_exec_func
+	cam_cdm_util_exec_table[CAM_CDM_CMD_PRIVATE_BASE_MAX + 1] = {
+	[CAM_CDM_CMD_DMI]         = cam_cdm_util_swd_dmi_write,
+	[CAM_CDM_CMD_REG_CONT]    = cam_cdm_util_reg_cont_write,
+	[CAM_CDM_CMD_REG_RANDOM]  = cam_cdm_util_reg_random_write,
+	[CAM_CDM_CMD_CHANGE_BASE] = cam_cdm_util_change_base,
+	[CAM_CDM_CMD_SWD_DMI_32]  = cam_cdm_util_swd_dmi_write,
+	[CAM_CDM_CMD_SWD_DMI_64]  = cam_cdm_util_swd_dmi_write,
+};
+
 int cam_cdm_util_cmd_buf_write(void __iomem **current_device_base,
 	uint32_t *cmd_buf, uint32_t cmd_buf_size,
 	struct cam_soc_reg_map *base_table[CAM_SOC_MAX_BLOCK],
@@ -599,94 +671,445 @@ int cam_cdm_util_cmd_buf_write(void __iomem **current_device_base,
 {
 	int ret = 0;
 	uint32_t cdm_cmd_type = 0, total_cmd_buf_size = 0;
-	uint32_t used_bytes = 0;
+	uint32_t used_bytes = 0, num_cmds = 0;
+	ktime_t start_time;
+	cam_cdm_util_exec_func exec;
+	struct cam_cdm_util_exec_ctx ctx = {
+		.device_base = current_device_base,
+		.base_table = base_table,
+		.base_array_size = base_array_size,
+	};
 
 	total_cmd_buf_size = cmd_buf_size;
+	start_time = ktime_get();
 
+	/* Order the BL against register writes issued before it */
+	wmb();
 	while (cmd_buf_size > 0) {
 		CAM_DBG(CAM_CDM, "cmd data=%x", *cmd_buf);
 		cdm_cmd_type = (*cmd_buf >> CAM_CDM_COMMAND_OFFSET);
-		switch (cdm_cmd_type) {
-		case CAM_CDM_CMD_REG_CONT: {
-			ret = cam_cdm_util_reg_cont_write(*current_device_base,
-				cmd_buf, cmd_buf_size, &used_bytes);
-			if (ret)
-				break;
-
-			if (used_bytes > 0) {
-				cmd_buf_size -= used_bytes;
-				cmd_buf += used_bytes/4;
-			}
-			}
+		exec = (cdm_cmd_type <= CAM_CDM_CMD_PRIVATE_BASE_MAX) ?
+			cam_cdm_util_exec_table[cdm_cmd_type] : NULL;
+		if (!exec) {
+			CAM_ERR(CAM_CDM, "unsupported cdm_cmd_type type 0%x",
+				cdm_cmd_type);
+			ret = -EINVAL;
 			break;
-		case CAM_CDM_CMD_REG_RANDOM: {
-			ret = cam_cdm_util_reg_random_write(
-				*current_device_base, cmd_buf, cmd_buf_size,
-				&used_bytes);
-			if (ret)
-				break;
-
-			if (used_bytes > 0) {
-				cmd_buf_size -= used_bytes;
-				cmd_buf += used_bytes / 4;
-			}
-			}
+		}
+
+		used_bytes = 0;
+		ret = exec(&ctx, cdm_cmd_type, cmd_buf, cmd_buf_size,
+			&used_bytes);
+		if (ret < 0)
 			break;
-		case CAM_CDM_CMD_DMI:
-		case CAM_CDM_CMD_SWD_DMI_32:
-		case CAM_CDM_CMD_SWD_DMI_64: {
-			if (*current_device_base == 0) {
-				CAM_ERR(CAM_CDM,
-					"Got SWI DMI cmd =%d for invalid hw",
-					cdm_cmd_type);
-				ret = -EINVAL;
-				break;
+
+		if (!used_bytes || (used_bytes > cmd_buf_size)) {
+			CAM_ERR(CAM_CDM, "invalid cmd 0x%x size %u left %u",
+				cdm_cmd_type, used_bytes, cmd_buf_size);
+			ret = -EINVAL;
+			break;
+		}
+
+		cmd_buf_size -= used_bytes;
+		cmd_buf += used_bytes / 4;
+		num_cmds++;
+	}
+	/* Ensure all BL writes are done before the BL is reported done */
+	wmb();
+
+	CAM_DBG(CAM_CDM, "BL tag=%u size=%u cmds=%u executed in %lld ns rc=%d",
+		bl_tag, total_cmd_buf_size, num_cmds,
+		ktime_to_ns(ktime_sub(ktime_get(), start_time)), ret);
+
+	return ret;
+}
+
+/**
+ * struct cam_cdm_opt_write - Register write collected by the optimizer
+ * @offset: Register offset from the current base
+ * @value:  Value to be written
+ * @pos:    Position of the write in its segment
+ * @dead:   Write is overwritten later in the same segment
+ */
+struct cam_cdm_opt_write {
+	uint32_t offset;
+	uint32_t value;
+	uint32_t pos;
+	uint32_t dead;
+};
+
+/**
+ * struct cam_cdm_opt_ctx - Command buffer optimizer state
+ * @flags:        CAM_CDM_OPT_* stages to run
+ * @out:          Output command buffer
+ * @out_size:     Size of output buffer in dwords
+ * @out_used:     Dwords written to output buffer
+ * @writes:       Register writes of the current segment
+ * @sorted:       Scratch array used for dead write detection
+ * @num_writes:   Number of entries in @writes
+ * @seg_start:    First input dword of the current segment
+ * @seg_size:     Input dwords in the current segment
+ * @base:         Last base emitted to the output
+ * @base_valid:   @base holds a valid value
+ * @pending_base: Base of a change-base not emitted yet
+ * @base_pending: @pending_base holds a valid value
+ */
+struct cam_cdm_opt_ctx {
+	uint32_t                  flags;
+	uint32_t                 *out;
+	uint32_t                  out_size;
+	uint32_t                  out_used;
+	struct cam_cdm_opt_write *writes;
+	struct cam_cdm_opt_write *sorted;
+	uint32_t                  num_writes;
+	uint32_t                 *seg_start;
+	uint32_t                  seg_size;
+	uint32_t                  base;
+	bool                      base_valid;
+	uint32_t                  pending_base;
+	bool                      base_pending;
+};
+
+static int cam_cdm_util_opt_emit(struct cam_cdm_opt_ctx *ctx,
+	uint32_t *src, uint32_t num_dwords)
+{
+	if ((ctx->out_size - ctx->out_used) < num_dwords)
+		return -ENOSPC;
+
+	memcpy(ctx->out + ctx->out_used, src, num_dwords * sizeof(uint32_t));
+	ctx->out_used += num_dwords;
+
+	return 0;
+}
+
+static int cam_cdm_util_opt_emit_base(struct cam_cdm_opt_ctx *ctx)
+{
+	if (!ctx->base_pending)
+		return 0;
+
+	ctx->base_pending = false;
+	if (ctx->base_valid && (ctx->base == ctx->pending_base))
+		return 0;
+
+	if ((ctx->out_size - ctx->out_used) <
+		cdm_required_size_changebase())
+		return -ENOSPC;
+
+	cdm_write_changebase(ctx->out + ctx->out_used, ctx->pending_base);
+	ctx->out_used += cdm_required_size_changebase();
+	ctx->base = ctx->pending_base;
+	ctx->base_valid = true;
+
+	return 0;
+}
+
+static int cam_cdm_util_opt_cmp_write(const void *a, const void *b)
+{
+	const struct cam_cdm_opt_write *wa = a;
+	const struct cam_cdm_opt_write *wb = b;
+
+	if (wa->offset != wb->offset)
+		return (wa->offset < wb->offset) ? -1 : 1;
+
+	return (wa->pos < wb->pos) ? -1 : 1;
+}
+
+static void cam_cdm_util_opt_mark_dead(struct cam_cdm_opt_ctx *ctx)
+{
+	uint32_t i;
+
+	memcpy(ctx->sorted, ctx->writes,
+		ctx->num_writes * sizeof(struct cam_cdm_opt_write));
+	sort(ctx->sorted, ctx->num_writes, sizeof(struct cam_cdm_opt_write),
+		cam_cdm_util_opt_cmp_write, NULL);
+
+	for (i = 0; (i + 1) < ctx->num_writes; i++) {
+		if (ctx->sorted[i].offset == ctx->sorted[i + 1].offset)
+			ctx->writes[ctx->sorted[i].pos].dead = 1;
+	}
+}
+
+static int cam_cdm_util_opt_flush_writes(struct cam_cdm_opt_ctx *ctx)
+{
+	int rc = 0;
+	uint32_t i, k, run, random_hdr = 0, random_cnt = 0;
+	uint32_t *out;
+	struct cam_cdm_opt_write *w = ctx->writes;
+	struct cdm_regcontinuous_cmd *reg_cont;
+
+	if (!ctx->num_writes)
+		return 0;
+
+	if (!(ctx->flags & (CAM_CDM_OPT_MERGE_REG | CAM_CDM_OPT_DEAD_WRITE))) {
+		rc = cam_cdm_util_opt_emit(ctx, ctx->seg_start, ctx->seg_size);
+		goto end;
+	}
+
+	if (ctx->flags & CAM_CDM_OPT_DEAD_WRITE)
+		cam_cdm_util_opt_mark_dead(ctx);
+
+	out = ctx->out;
+	i = 0;
+	while (i < ctx->num_writes) {
+		if (w[i].dead) {
+			i++;
+			continue;
+		}
+
+		/* Length of the run of live writes to consecutive registers */
+		run = 1;
+		if ((ctx->flags & CAM_CDM_OPT_MERGE_REG) &&
+			(w[i].offset <= CAM_CDM_REG_OFFSET_MASK)) {
+			for (k = i + 1; (k < ctx->num_writes) &&
+				(run < CAM_CMD_LENGTH_MASK); k++) {
+				if (w[k].dead)
+					break;
+				if (w[k].offset != (w[i].offset + (4 * run)))
+					break;
+				run++;
 			}
-			ret = cam_cdm_util_swd_dmi_write(cdm_cmd_type,
-				*current_device_base, cmd_buf, cmd_buf_size,
-				&used_bytes);
-			if (ret)
-				break;
-
-			if (used_bytes > 0) {
-				cmd_buf_size -= used_bytes;
-				cmd_buf += used_bytes / 4;
+		}
+
+		/* A reg-continuous command pays off from three registers */
+		if (run >= 3) {
+			if (random_cnt) {
+				((struct cdm_regrandom_cmd *)
+					&out[random_hdr])->count = random_cnt;
+				random_cnt = 0;
 			}
+
+			if ((ctx->out_size - ctx->out_used) <
+				cdm_required_size_reg_continuous(run)) {
+				rc = -ENOSPC;
+				goto end;
 			}
-			break;
-		case CAM_CDM_CMD_CHANGE_BASE: {
-			struct cdm_changebase_cmd *change_base_cmd =
-				(struct cdm_changebase_cmd *)cmd_buf;
-
-			ret = cam_cdm_get_ioremap_from_base(
-				change_base_cmd->base, base_array_size,
-				base_table, current_device_base);
-			if (ret != 0) {
-				CAM_ERR(CAM_CDM,
-					"Get ioremap change base failed %x",
-					change_base_cmd->base);
-				break;
+
+			reg_cont = (struct cdm_regcontinuous_cmd *)
+				&out[ctx->out_used];
+			memset(reg_cont, 0, sizeof(*reg_cont));
+			reg_cont->count = run;
+			reg_cont->cmd = CAM_CDM_CMD_REG_CONT;
+			reg_cont->offset = w[i].offset;
+			ctx->out_used += cdm_get_cmd_header_size(
+				CAM_CDM_CMD_REG_CONT);
+			for (k = 0; k < run; k++)
+				out[ctx->out_used++] = w[i + k].value;
+			i += run;
+			continue;
+		}
+
+		if (random_cnt == CAM_CMD_LENGTH_MASK) {
+			((struct cdm_regrandom_cmd *)
+				&out[random_hdr])->count = random_cnt;
+			random_cnt = 0;
+		}
+
+		if (!random_cnt) {
+			if ((ctx->out_size - ctx->out_used) <
+				cdm_required_size_reg_random(1)) {
+				rc = -ENOSPC;
+				goto end;
 			}
-			CAM_DBG(CAM_CDM, "Got ioremap for %x addr=%pK",
-				change_base_cmd->base,
-				current_device_base);
-			cmd_buf_size -= (4 *
-				cdm_required_size_changebase());
-			cmd_buf += cdm_required_size_changebase();
+			random_hdr = ctx->out_used;
+			out[random_hdr] = 0;
+			((struct cdm_regrandom_cmd *)&out[random_hdr])->cmd =
+				CAM_CDM_CMD_REG_RANDOM;
+			ctx->out_used += cdm_get_cmd_header_size(
+				CAM_CDM_CMD_REG_RANDOM);
+		} else if ((ctx->out_size - ctx->out_used) < 2) {
+			rc = -ENOSPC;
+			goto end;
+		}
+
+		out[ctx->out_used++] = w[i].offset;
+		out[ctx->out_used++] = w[i].value;
+		random_cnt++;
+		i++;
+	}
+
+	if (random_cnt)
+		((struct cdm_regrandom_cmd *)&out[random_hdr])->count =
+			random_cnt;
+
+end:
+	ctx->num_writes = 0;
+	ctx->seg_start = NULL;
+	ctx->seg_size = 0;
+	return rc;
+}
+
+static void cam_cdm_util_opt_add_write(struct cam_cdm_opt_ctx *ctx,
+	uint32_t offset, uint32_t value)
+{
+	struct cam_cdm_opt_write *w = &ctx->writes[ctx->num_writes];
+
+	w->offset = offset;
+	w->value = value;
+	w->pos = ctx->num_writes;
+	w->dead = 0;
+	ctx->num_writes++;
+}
+
+int cam_cdm_util_optimize_cmd_buf(uint32_t *cmd_buf,
+	uint32_t *cmd_buf_size, uint32_t flags)
+{
+	int rc = 0;
+	uint32_t *cmd, *cmd_end, cmd_type, cmd_len, i;
+	uint32_t num_dwords, pad;
+	struct cam_cdm_opt_ctx ctx = {0};
+	struct cdm_regcontinuous_cmd *reg_cont = NULL;
+	struct cdm_regrandom_cmd *reg_random = NULL;
+	struct cdm_changebase_cmd *change_base;
+	void *scratch;
+
+	if (!cmd_buf || !cmd_buf_size || !flags)
+		return -EINVAL;
+
+	if (!(*cmd_buf_size) || (*cmd_buf_size % CAM_CDM_DWORD) ||
+		(*cmd_buf_size > CAM_CDM_OPT_MAX_BL_SIZE))
+		return 0;
+
+	num_dwords = *cmd_buf_size / CAM_CDM_DWORD;
+
+	/* Every register write takes at least one input dword */
+	scratch = kvmalloc((num_dwords * sizeof(uint32_t)) +
+		(2 * num_dwords * sizeof(struct cam_cdm_opt_write)),
+		GFP_KERNEL);
+	if (!scratch)
+		return -ENOMEM;
+
+	ctx.flags = flags;
+	ctx.writes = scratch;
+	ctx.sorted = ctx.writes + num_dwords;
+	ctx.out = (uint32_t *)(ctx.sorted + num_dwords);
+	ctx.out_size = num_dwords;
+
+	cmd = cmd_buf;
+	cmd_end = cmd_buf + num_dwords;
+	while (cmd < cmd_end) {
+		cmd_type = *cmd >> CAM_CDM_COMMAND_OFFSET;
+		switch (cmd_type) {
+		case CAM_CDM_CMD_REG_CONT:
+			reg_cont = (struct cdm_regcontinuous_cmd *)cmd;
+			if ((cmd_end - cmd) <
+				cdm_get_cmd_header_size(CAM_CDM_CMD_REG_CONT)) {
+				rc = -EINVAL;
+				goto free_scratch;
 			}
+			cmd_len = cdm_required_size_reg_continuous(
+				reg_cont->count);
 			break;
-		default:
-			CAM_ERR(CAM_CDM, "unsupported cdm_cmd_type type 0%x",
-			cdm_cmd_type);
-			ret = -EINVAL;
+		case CAM_CDM_CMD_REG_RANDOM:
+			reg_random = (struct cdm_regrandom_cmd *)cmd;
+			cmd_len = cdm_required_size_reg_random(
+				reg_random->count);
+			break;
+		case CAM_CDM_CMD_DMI:
+		case CAM_CDM_CMD_BUFF_INDIRECT:
+		case CAM_CDM_CMD_GEN_IRQ:
+		case CAM_CDM_CMD_WAIT_EVENT:
+		case CAM_CDM_CMD_CHANGE_BASE:
+		case CAM_CDM_CMD_PERF_CTRL:
+		case CAM_CDM_CMD_DMI_32:
+		case CAM_CDM_CMD_DMI_64:
+		case CAM_CDM_CMD_COMP_WAIT:
+		case CAM_CDM_CLEAR_COMP_WAIT:
+		case CAM_CDM_WAIT_PREFETCH_DISABLE:
+			cmd_len = cdm_get_cmd_header_size(cmd_type);
 			break;
+		default:
+			CAM_DBG(CAM_CDM, "Unsupported cmd 0x%x, skip optimize",
+				cmd_type);
+			rc = -EINVAL;
+			goto free_scratch;
 		}
 
-		if (ret < 0)
-			break;
+		if ((cmd_end - cmd) < cmd_len) {
+			CAM_DBG(CAM_CDM, "Cmd 0x%x overruns BL, skip optimize",
+				cmd_type);
+			rc = -EINVAL;
+			goto free_scratch;
+		}
+
+		if ((cmd_type == CAM_CDM_CMD_REG_CONT) ||
+			(cmd_type == CAM_CDM_CMD_REG_RANDOM)) {
+			/* Writes need the base they were queued under */
+			if (!ctx.num_writes) {
+				rc = cam_cdm_util_opt_emit_base(&ctx);
+				if (rc)
+					goto free_scratch;
+				ctx.seg_start = cmd;
+			}
+
+			if (cmd_type == CAM_CDM_CMD_REG_CONT) {
+				for (i = 0; i < reg_cont->count; i++)
+					cam_cdm_util_opt_add_write(&ctx,
+						reg_cont->offset + (4 * i),
+						cmd[cdm_get_cmd_header_size(
+						CAM_CDM_CMD_REG_CONT) + i]);
+			} else {
+				for (i = 0; i < reg_random->count; i++)
+					cam_cdm_util_opt_add_write(&ctx,
+						cmd[1 + (2 * i)],
+						cmd[2 + (2 * i)]);
+			}
+			ctx.seg_size += cmd_len;
+			cmd += cmd_len;
+			continue;
+		}
+
+		rc = cam_cdm_util_opt_flush_writes(&ctx);
+		if (rc)
+			goto free_scratch;
+
+		if (cmd_type == CAM_CDM_CMD_CHANGE_BASE) {
+			change_base = (struct cdm_changebase_cmd *)cmd;
+			if (ctx.flags & CAM_CDM_OPT_CHANGE_BASE) {
+				ctx.pending_base = change_base->base;
+				ctx.base_pending = true;
+				cmd += cmd_len;
+				continue;
+			}
+			ctx.base = change_base->base;
+			ctx.base_valid = true;
+		} else {
+			rc = cam_cdm_util_opt_emit_base(&ctx);
+			if (rc)
+				goto free_scratch;
+		}
+
+		rc = cam_cdm_util_opt_emit(&ctx, cmd, cmd_len);
+		if (rc)
+			goto free_scratch;
+		cmd += cmd_len;
 	}
 
-	return ret;
+	rc = cam_cdm_util_opt_flush_writes(&ctx);
+	if (rc)
+		goto free_scratch;
+
+	rc = cam_cdm_util_opt_emit_base(&ctx);
+	if (rc)
+		goto free_scratch;
+
+	/* Padding needs a base to re-select, and the BL has to shrink */
+	if (!ctx.base_valid || (ctx.out_used >= num_dwords))
+		goto free_scratch;
+
+	CAM_DBG(CAM_CDM, "BL optimized from %u to %u dwords",
+		num_dwords, ctx.out_used);
+
+	memcpy(cmd_buf, ctx.out, ctx.out_used * sizeof(uint32_t));
+	for (pad = ctx.out_used; pad < num_dwords;
+		pad += cdm_required_size_changebase())
+		cdm_write_changebase(cmd_buf + pad, ctx.base);
+	*cmd_buf_size = ctx.out_used * CAM_CDM_DWORD;
+
+free_scratch:
+	kvfree(scratch);
+	if (rc == -ENOSPC)
+		rc = 0;
+	return rc;
 }
 
 static long cam_cdm_util_dump_dmi_cmd(uint32_t *cmd_buf_addr,
@@ -252,4 +252,38 @@ int cam_cdm_util_dump_cmd_bufs_v2(
 	struct cam_cdm_cmd_buf_dump_info *dump_info);
 
 
+/* Command buffer optimizer stages, see cam_cdm_util_optimize_cmd_buf */
+#define CAM_CDM_OPT_MERGE_REG          BIT(0)
+#define CAM_CDM_OPT_CHANGE_BASE        BIT(1)
+#define CAM_CDM_OPT_DEAD_WRITE         BIT(2)
+
+/* Largest BL in bytes the optimizer will process */
+#define CAM_CDM_OPT_MAX_BL_SIZE        0x10000
+
+/**
+ * cam_cdm_util_optimize_cmd_buf()
+ *
+ * @brief:        Rewrite a hw CDM command buffer in place with fewer
+ *                commands. Depending on @flags, runs of reg-random writes
+ *                to consecutive registers are merged into reg-continuous
+ *                commands, redundant change-base commands are dropped and
+ *                writes overwritten later in the same register segment are
+ *                removed. Dead write removal is only safe for buffers with
+ *                no fifo or trigger registers and has to be requested
+ *                explicitly. The freed tail of the buffer is padded with
+ *                change-base commands to the final base so the buffer stays
+ *                valid if it is submitted again with its original length.
+ *                The buffer is left untouched if it can not be parsed, has
+ *                no change-base command, or would not shrink.
+ *
+ * @cmd_buf:      CPU address of the command buffer
+ * @cmd_buf_size: Size of the command buffer in bytes, updated with the size
+ *                of the optimized commands
+ * @flags:        CAM_CDM_OPT_* stages to run
+ *
+ * return SUCCESS/FAILURE
+ */
+int cam_cdm_util_optimize_cmd_buf(uint32_t *cmd_buf,
+	uint32_t *cmd_buf_size, uint32_t flags);
+
 #endif /* _CAM_CDM_UTIL_H_ */
@@ -3,6 +3,7 @@
  * Copyright (c) 2017-2021, The Linux Foundation. All rights reserved.
  */
 
+#include <linux/debugfs.h>
 #include <linux/device.h>
 #include <linux/platform_device.h>
 #include <linux/of.h>
@@ -606,21 +607,20 @@ static int cam_cpas_util_translate_client_paths(
 
 static int cam_cpas_axi_consolidate_path_votes(
 	struct cam_cpas_client *cpas_client,
-	struct cam_axi_vote *axi_vote)
+	struct cam_axi_vote *axi_vote, struct cam_axi_vote *con_axi_vote)
 {
-	int rc = 0, i, k, l;
-	struct cam_axi_vote *con_axi_vote = &cpas_client->axi_vote;
-	bool path_found = false, cons_entry_found;
-	struct cam_cpas_tree_node *curr_tree_node = NULL;
-	struct cam_cpas_tree_node *sum_tree_node = NULL;
+	int i;
+	struct cam_cpas_client_path_slot *path_slot;
+	struct cam_axi_per_path_bw_vote *axi_path;
+	int8_t con_idx[CAM_CPAS_MAX_CLIENT_PATH_SLOTS];
 	uint32_t transac_type;
 	uint32_t path_data_type;
-	struct cam_axi_per_path_bw_vote *axi_path;
+	uint8_t slot_idx;
 
 	con_axi_vote->num_paths = 0;
+	memset(con_idx, -1, sizeof(con_idx));
 
 	for (i = 0; i < axi_vote->num_paths; i++) {
-		path_found = false;
 		path_data_type = axi_vote->axi_path[i].path_data_type;
 		transac_type = axi_vote->axi_path[i].transac_type;
 
@@ -631,82 +631,130 @@ static int cam_cpas_axi_consolidate_path_votes(
 			return -EINVAL;
 		}
 
-		axi_path = &con_axi_vote->axi_path[con_axi_vote->num_paths];
+		slot_idx = cpas_client->path_slot_idx[path_data_type]
+			[transac_type];
+		if (slot_idx == CAM_CPAS_INVALID_PATH_SLOT) {
+			CAM_ERR(CAM_CPAS,
+				"Client [%s][%d] Consolidated path not found for path=%d, transac=%d",
+				cpas_client->data.identifier,
+				cpas_client->data.cell_index,
+				path_data_type, transac_type);
+			return -EINVAL;
+		}
+
+		/*
+		 * A path with its own tree node and the constituent paths of
+		 * that node all add up into the same consolidated entry, so
+		 * the result does not depend on the order of the paths.
+		 */
+		if (con_idx[slot_idx] < 0) {
+			if (con_axi_vote->num_paths >=
+				CAM_CPAS_MAX_PATHS_PER_CLIENT) {
+				CAM_ERR(CAM_CPAS,
+					"Client [%s][%d] too many consolidated paths",
+					cpas_client->data.identifier,
+					cpas_client->data.cell_index);
+				return -EINVAL;
+			}
 
-		curr_tree_node =
-			cpas_client->tree_node[path_data_type][transac_type];
-		if (curr_tree_node) {
-			path_found = true;
-			memcpy(axi_path, &axi_vote->axi_path[i],
+			con_idx[slot_idx] = con_axi_vote->num_paths++;
+			axi_path = &con_axi_vote->axi_path[con_idx[slot_idx]];
+			path_slot = &cpas_client->path_slot[slot_idx];
+			memset(axi_path, 0,
 				sizeof(struct cam_axi_per_path_bw_vote));
-			con_axi_vote->num_paths++;
-			continue;
+			axi_path->path_data_type = path_slot->path_data_type;
+			axi_path->transac_type = transac_type;
+		} else {
+			axi_path = &con_axi_vote->axi_path[con_idx[slot_idx]];
 		}
 
-		for (k = 0; k < CAM_CPAS_PATH_DATA_MAX; k++) {
-			sum_tree_node = cpas_client->tree_node[k][transac_type];
+		if (cpas_client->tree_node[path_data_type][transac_type])
+			axi_path->usage_data =
+				axi_vote->axi_path[i].usage_data;
 
-			if (!sum_tree_node)
-				continue;
+		axi_path->camnoc_bw += axi_vote->axi_path[i].camnoc_bw;
+		axi_path->mnoc_ab_bw += axi_vote->axi_path[i].mnoc_ab_bw;
+		axi_path->mnoc_ib_bw += axi_vote->axi_path[i].mnoc_ib_bw;
+	}
 
-			if (sum_tree_node->constituent_paths[path_data_type]) {
-				path_found = true;
-				/*
-				 * Check if corresponding consolidated path
-				 * entry is already added into consolidated list
-				 */
-				cons_entry_found = false;
-				for (l = 0; l < con_axi_vote->num_paths; l++) {
-					if ((con_axi_vote->axi_path[l]
-					.path_data_type == k) &&
-					(con_axi_vote->axi_path[l]
-					.transac_type == transac_type)) {
-						cons_entry_found = true;
-						con_axi_vote->axi_path[l]
-						.camnoc_bw +=
-						axi_vote->axi_path[i]
-						.camnoc_bw;
-
-						con_axi_vote->axi_path[l]
-						.mnoc_ab_bw +=
-						axi_vote->axi_path[i]
-						.mnoc_ab_bw;
-
-						con_axi_vote->axi_path[l]
-						.mnoc_ib_bw +=
-						axi_vote->axi_path[i]
-						.mnoc_ib_bw;
+	return 0;
+}
+
+static int cam_cpas_util_build_client_path_table(
+	struct cam_cpas_client *cpas_client)
+{
+	struct cam_cpas_client_path_slot *path_slot;
+	struct cam_cpas_tree_node *tree_node, *node;
+	uint32_t path_data_type, transac_type, k, slot;
+
+	memset(cpas_client->path_slot_idx, CAM_CPAS_INVALID_PATH_SLOT,
+		sizeof(cpas_client->path_slot_idx));
+	cpas_client->num_path_slots = 0;
+
+	if (!cpas_client->tree_node_valid)
+		return 0;
+
+	for (path_data_type = 0; path_data_type < CAM_CPAS_PATH_DATA_MAX;
+		path_data_type++) {
+		for (transac_type = 0; transac_type < CAM_CPAS_TRANSACTION_MAX;
+			transac_type++) {
+			/* Own node first, else the first node summing it */
+			k = path_data_type;
+			tree_node = cpas_client->tree_node[k][transac_type];
+			if (!tree_node) {
+				for (k = 0; k < CAM_CPAS_PATH_DATA_MAX; k++) {
+					node = cpas_client->tree_node[k]
+						[transac_type];
+					if (node && node->constituent_paths[
+						path_data_type]) {
+						tree_node = node;
 						break;
 					}
 				}
+			}
+
+			if (!tree_node)
+				continue;
 
-				/* If not found, add a new entry */
-				if (!cons_entry_found) {
-					axi_path->path_data_type = k;
-					axi_path->transac_type = transac_type;
-					axi_path->camnoc_bw =
-					axi_vote->axi_path[i].camnoc_bw;
-					axi_path->mnoc_ab_bw =
-					axi_vote->axi_path[i].mnoc_ab_bw;
-					axi_path->mnoc_ib_bw =
-					axi_vote->axi_path[i].mnoc_ib_bw;
-					con_axi_vote->num_paths++;
+			for (slot = 0; slot < cpas_client->num_path_slots;
+				slot++) {
+				if (cpas_client->path_slot[slot].tree_node ==
+					tree_node)
+					break;
+			}
+
+			if (slot == cpas_client->num_path_slots) {
+				path_slot = &cpas_client->path_slot[slot];
+				path_slot->tree_node = tree_node;
+				path_slot->path_data_type = k;
+				path_slot->num_ancestors = 0;
+				for (node = tree_node->parent_node; node;
+					node = node->parent_node) {
+					if (path_slot->num_ancestors >=
+						CAM_CPAS_MAX_TREE_LEVELS) {
+						CAM_ERR(CAM_CPAS,
+							"Client [%s][%d] tree too deep",
+							cpas_client->data.identifier,
+							cpas_client->data.cell_index);
+						return -EINVAL;
+					}
+					path_slot->ancestors[
+						path_slot->num_ancestors++] =
+						node;
 				}
-				break;
+				cpas_client->num_path_slots++;
 			}
-		}
 
-		if (!path_found) {
-			CAM_ERR(CAM_CPAS,
-				"Client [%s][%d] Consolidated path not found for path=%d, transac=%d",
-				cpas_client->data.identifier,
-				cpas_client->data.cell_index,
-				path_data_type, transac_type);
-			return -EINVAL;
+			cpas_client->path_slot_idx[path_data_type]
+				[transac_type] = slot;
 		}
 	}
 
-	return rc;
+	CAM_DBG(CAM_CPAS, "Client [%s][%d] num path slots %u",
+		cpas_client->data.identifier, cpas_client->data.cell_index,
+		cpas_client->num_path_slots);
+
+	return 0;
 }
 
 static int cam_cpas_update_axi_vote_bw(
@@ -819,6 +867,7 @@ static int cam_cpas_util_apply_client_axi_vote(
 	struct cam_cpas_axi_port *mnoc_axi_port = NULL;
 	struct cam_cpas_tree_node *curr_tree_node = NULL;
 	struct cam_cpas_tree_node *par_tree_node = NULL;
+	struct cam_cpas_client_path_slot *path_slot = NULL;
 	uint32_t transac_type;
 	uint32_t path_data_type;
 	bool mnoc_axi_port_updated[CAM_CPAS_MAX_AXI_PORTS] = {false};
@@ -826,7 +875,7 @@ static int cam_cpas_util_apply_client_axi_vote(
 	uint64_t mnoc_ab_bw = 0, mnoc_ib_bw = 0,
 		curr_camnoc_old = 0, curr_mnoc_ab_old = 0, curr_mnoc_ib_old = 0,
 		par_camnoc_old = 0, par_mnoc_ab_old = 0, par_mnoc_ib_old = 0;
-	int rc = 0, i = 0;
+	int rc = 0, i = 0, j = 0;
 	uint64_t applied_ab = 0, applied_ib = 0;
 
 	mutex_lock(&cpas_core->tree_lock);
@@ -865,7 +914,8 @@ static int cam_cpas_util_apply_client_axi_vote(
 		goto vote_start_clients;
 	}
 
-	rc = cam_cpas_axi_consolidate_path_votes(cpas_client, axi_vote);
+	rc = cam_cpas_axi_consolidate_path_votes(cpas_client, axi_vote,
+		&cpas_client->axi_vote);
 	if (rc) {
 		CAM_ERR(CAM_PERF, "Failed in bw consolidation, Client [%s][%d]",
 			cpas_client->data.identifier,
@@ -884,8 +934,10 @@ static int cam_cpas_util_apply_client_axi_vote(
 		con_axi_vote->axi_path[i].path_data_type;
 		transac_type =
 		con_axi_vote->axi_path[i].transac_type;
-		curr_tree_node = cpas_client->tree_node[path_data_type]
-			[transac_type];
+		path_slot = &cpas_client->path_slot[
+			cpas_client->path_slot_idx[path_data_type]
+			[transac_type]];
+		curr_tree_node = path_slot->tree_node;
 
 		if (con_axi_vote->axi_path[i].mnoc_ab_bw == 0)
 			con_axi_vote->axi_path[i].mnoc_ab_bw =
@@ -913,8 +965,8 @@ static int cam_cpas_util_apply_client_axi_vote(
 		curr_tree_node->mnoc_ib_bw =
 			con_axi_vote->axi_path[i].mnoc_ib_bw;
 
-		while (curr_tree_node->parent_node) {
-			par_tree_node = curr_tree_node->parent_node;
+		for (j = 0; j < path_slot->num_ancestors; j++) {
+			par_tree_node = path_slot->ancestors[j];
 			par_camnoc_old = par_tree_node->camnoc_bw;
 			par_mnoc_ab_old = par_tree_node->mnoc_ab_bw;
 			par_mnoc_ib_old = par_tree_node->mnoc_ib_bw;
@@ -1067,6 +1119,252 @@ unlock_tree:
 	return rc;
 }
 
+static void cam_cpas_bw_gov_drop_pending(struct cam_cpas *cpas_core,
+	uint32_t client_indx)
+{
+	struct cam_cpas_client *cpas_client = cpas_core->cpas_client[client_indx];
+
+	spin_lock(&cpas_client->vote_lock);
+	clear_bit(client_indx, cpas_core->bw_gov.pending);
+	cpas_client->gov_apply_rc = 0;
+	spin_unlock(&cpas_client->vote_lock);
+}
+
+static bool cam_cpas_bw_gov_bw_within_hysteresis(uint64_t applied_bw,
+	uint64_t new_bw, uint32_t hysteresis_pct)
+{
+	/* Increases are always applied to avoid starving the hw */
+	if (new_bw > applied_bw)
+		return false;
+
+	return ((applied_bw - new_bw) * 100) <= (applied_bw * hysteresis_pct);
+}
+
+/*
+ * Client's applied axi_vote is kept consolidated, and whichever path applied
+ * it (sync or governor) updated it, so consolidate the new vote into
+ * con_vote and compare like with like.
+ */
+static bool cam_cpas_bw_gov_vote_within_hysteresis(
+	struct cam_cpas_client *cpas_client, struct cam_axi_vote *axi_vote,
+	struct cam_axi_vote *con_vote, uint32_t hysteresis_pct)
+{
+	struct cam_axi_vote *applied_vote = &cpas_client->axi_vote;
+	struct cam_axi_per_path_bw_vote *applied_path, *new_path;
+	struct cam_axi_vote *new_vote = con_vote;
+	int i;
+
+	if (cam_cpas_axi_consolidate_path_votes(cpas_client, axi_vote,
+		con_vote))
+		return false;
+
+	if (applied_vote->num_paths != new_vote->num_paths)
+		return false;
+
+	for (i = 0; i < new_vote->num_paths; i++) {
+		applied_path = &applied_vote->axi_path[i];
+		new_path = &new_vote->axi_path[i];
+
+		/* Same defaults as cam_cpas_util_apply_client_axi_vote */
+		if (new_path->mnoc_ab_bw == 0)
+			new_path->mnoc_ab_bw = new_path->camnoc_bw;
+		if (new_path->camnoc_bw == 0)
+			new_path->camnoc_bw = new_path->mnoc_ab_bw;
+
+		if ((applied_path->path_data_type !=
+			new_path->path_data_type) ||
+			(applied_path->transac_type != new_path->transac_type))
+			return false;
+
+		if (!cam_cpas_bw_gov_bw_within_hysteresis(
+			applied_path->camnoc_bw, new_path->camnoc_bw,
+			hysteresis_pct) ||
+			!cam_cpas_bw_gov_bw_within_hysteresis(
+			applied_path->mnoc_ab_bw, new_path->mnoc_ab_bw,
+			hysteresis_pct) ||
+			!cam_cpas_bw_gov_bw_within_hysteresis(
+			applied_path->mnoc_ib_bw, new_path->mnoc_ib_bw,
+			hysteresis_pct))
+			return false;
+	}
+
+	return true;
+}
+
+static void cam_cpas_bw_gov_work(struct work_struct *work)
+{
+	struct cam_cpas_bw_governor *bw_gov =
+		container_of(to_delayed_work(work),
+		struct cam_cpas_bw_governor, work);
+	struct cam_hw_info *cpas_hw = bw_gov->cpas_hw;
+	struct cam_cpas *cpas_core = (struct cam_cpas *) cpas_hw->core_info;
+	struct cam_cpas_client *cpas_client;
+	struct cam_axi_vote *axi_vote;
+	uint32_t client_indx;
+	uint64_t latency_us;
+	ktime_t pending_ts;
+	int rc;
+
+	/* Pending vote and its consolidated form */
+	axi_vote = kcalloc(2, sizeof(struct cam_axi_vote), GFP_KERNEL);
+	if (!axi_vote) {
+		CAM_ERR(CAM_CPAS, "Out of memory, retry pending votes");
+		queue_delayed_work(bw_gov->work_queue, &bw_gov->work,
+			usecs_to_jiffies(bw_gov->window_us));
+		return;
+	}
+
+	mutex_lock(&cpas_hw->hw_mutex);
+	for_each_set_bit(client_indx, bw_gov->pending, CAM_CPAS_MAX_CLIENTS) {
+		mutex_lock(&cpas_core->client_mutex[client_indx]);
+		cpas_client = cpas_core->cpas_client[client_indx];
+
+		spin_lock(&cpas_client->vote_lock);
+		if (!test_and_clear_bit(client_indx, bw_gov->pending)) {
+			spin_unlock(&cpas_client->vote_lock);
+			goto unlock_client;
+		}
+		memcpy(axi_vote, &cpas_client->pending_axi_vote,
+			sizeof(struct cam_axi_vote));
+		pending_ts = cpas_client->pending_ts;
+		spin_unlock(&cpas_client->vote_lock);
+
+		if (!CAM_CPAS_CLIENT_STARTED(cpas_core, client_indx)) {
+			CAM_DBG(CAM_CPAS,
+				"Drop vote of stopped client=[%d][%s][%d]",
+				client_indx, cpas_client->data.identifier,
+				cpas_client->data.cell_index);
+			goto unlock_client;
+		}
+
+		if (cam_cpas_bw_gov_vote_within_hysteresis(cpas_client,
+			axi_vote, &axi_vote[1], bw_gov->hysteresis_pct)) {
+			bw_gov->stats.hysteresis_skips++;
+			goto unlock_client;
+		}
+
+		rc = cam_cpas_util_apply_client_axi_vote(cpas_hw,
+			cpas_client, axi_vote);
+		if (rc) {
+			CAM_ERR(CAM_CPAS,
+				"Failed to apply vote client=[%d][%s][%d] rc=%d",
+				client_indx, cpas_client->data.identifier,
+				cpas_client->data.cell_index, rc);
+			bw_gov->stats.apply_fail++;
+			spin_lock(&cpas_client->vote_lock);
+			cpas_client->gov_apply_rc = rc;
+			spin_unlock(&cpas_client->vote_lock);
+			goto unlock_client;
+		}
+
+		latency_us = ktime_us_delta(ktime_get(), pending_ts);
+		bw_gov->stats.bus_updates++;
+		bw_gov->stats.last_latency_us = latency_us;
+		bw_gov->stats.total_latency_us += latency_us;
+		if (latency_us > bw_gov->stats.max_latency_us)
+			bw_gov->stats.max_latency_us = latency_us;
+
+		cam_cpas_update_monitor_array(cpas_hw, "CPAS AXI gov-update",
+			client_indx);
+unlock_client:
+		mutex_unlock(&cpas_core->client_mutex[client_indx]);
+	}
+	mutex_unlock(&cpas_hw->hw_mutex);
+
+	kfree(axi_vote);
+}
+
+/*
+ * Queue a vote for the governor. Apply happens later in the worker, so a
+ * failure there is returned by the client's next vote.
+ */
+static int cam_cpas_bw_gov_queue_vote(struct cam_hw_info *cpas_hw,
+	uint32_t client_indx, struct cam_axi_vote *client_axi_vote)
+{
+	struct cam_cpas *cpas_core = (struct cam_cpas *) cpas_hw->core_info;
+	struct cam_cpas_bw_governor *bw_gov = &cpas_core->bw_gov;
+	struct cam_cpas_client *cpas_client;
+	struct cam_axi_vote *axi_vote;
+	unsigned long delay;
+	bool decrease;
+	int rc = 0;
+
+	if (client_axi_vote->num_paths > CAM_CPAS_MAX_PATHS_PER_CLIENT) {
+		CAM_ERR(CAM_CPAS, "Invalid num_paths %d",
+			client_axi_vote->num_paths);
+		return -EINVAL;
+	}
+
+	cpas_client = cpas_core->cpas_client[client_indx];
+
+	/* Incoming vote and its consolidated form */
+	axi_vote = kcalloc(2, sizeof(struct cam_axi_vote), GFP_KERNEL);
+	if (!axi_vote) {
+		CAM_ERR(CAM_CPAS, "Out of memory");
+		return -ENOMEM;
+	}
+	memcpy(axi_vote, client_axi_vote, sizeof(struct cam_axi_vote));
+
+	rc = cam_cpas_util_translate_client_paths(axi_vote);
+	if (rc) {
+		CAM_ERR(CAM_CPAS,
+			"Unable to translate per path votes rc: %d", rc);
+		goto free_vote;
+	}
+
+	cam_cpas_dump_axi_vote_info(cpas_client, "Queued Vote", axi_vote);
+
+	/*
+	 * client_mutex orders this against stop, which drops pending votes
+	 * under it, so no vote is queued for a stopped client.
+	 */
+	mutex_lock(&cpas_core->client_mutex[client_indx]);
+	if (!CAM_CPAS_CLIENT_STARTED(cpas_core, client_indx)) {
+		mutex_unlock(&cpas_core->client_mutex[client_indx]);
+		CAM_ERR(CAM_CPAS, "client=[%d] has not started", client_indx);
+		rc = -EPERM;
+		goto free_vote;
+	}
+
+	/* Only decreases wait for the window, any increase goes out now */
+	decrease = cam_cpas_bw_gov_vote_within_hysteresis(cpas_client,
+		axi_vote, &axi_vote[1], 100);
+	delay = decrease ? usecs_to_jiffies(bw_gov->window_us) : 0;
+
+	atomic64_inc(&bw_gov->stats.votes_received);
+
+	spin_lock(&cpas_client->vote_lock);
+	memcpy(&cpas_client->pending_axi_vote, axi_vote,
+		sizeof(struct cam_axi_vote));
+	if (test_and_set_bit(client_indx, bw_gov->pending))
+		atomic64_inc(&bw_gov->stats.votes_coalesced);
+	else
+		cpas_client->pending_ts = ktime_get();
+	rc = cpas_client->gov_apply_rc;
+	cpas_client->gov_apply_rc = 0;
+	spin_unlock(&cpas_client->vote_lock);
+	mutex_unlock(&cpas_core->client_mutex[client_indx]);
+
+	if (rc)
+		CAM_ERR(CAM_CPAS,
+			"Previous vote of client=[%d][%s][%d] failed rc=%d",
+			client_indx, cpas_client->data.identifier,
+			cpas_client->data.cell_index, rc);
+
+	/*
+	 * An increase pulls an already queued work in, otherwise this is a
+	 * no-op if the work is queued and the vote rides along.
+	 */
+	if (delay)
+		queue_delayed_work(bw_gov->work_queue, &bw_gov->work, delay);
+	else
+		mod_delayed_work(bw_gov->work_queue, &bw_gov->work, 0);
+
+free_vote:
+	kzfree(axi_vote);
+	return rc;
+}
+
 static int cam_cpas_hw_update_axi_vote(struct cam_hw_info *cpas_hw,
 	uint32_t client_handle, struct cam_axi_vote *client_axi_vote)
 {
@@ -1085,6 +1383,10 @@ static int cam_cpas_hw_update_axi_vote(struct cam_hw_info *cpas_hw,
 	if (!CAM_CPAS_CLIENT_VALID(client_indx))
 		return -EINVAL;
 
+	if (cpas_core->bw_gov.enable)
+		return cam_cpas_bw_gov_queue_vote(cpas_hw, client_indx,
+			client_axi_vote);
+
 	mutex_lock(&cpas_hw->hw_mutex);
 	mutex_lock(&cpas_core->client_mutex[client_indx]);
 
@@ -1120,6 +1422,9 @@ static int cam_cpas_hw_update_axi_vote(struct cam_hw_info *cpas_hw,
 	cam_cpas_dump_axi_vote_info(cpas_core->cpas_client[client_indx],
 		"Translated Vote", axi_vote);
 
+	/* A stale governor vote must not override this one */
+	cam_cpas_bw_gov_drop_pending(cpas_core, client_indx);
+
 	rc = cam_cpas_util_apply_client_axi_vote(cpas_hw,
 		cpas_core->cpas_client[client_indx], axi_vote);
 
@@ -1593,6 +1898,7 @@ static int cam_cpas_hw_stop(void *hw_priv, void *stop_args,
 
 	cpas_client->started = false;
 	cpas_core->streamon_clients--;
+	cam_cpas_bw_gov_drop_pending(cpas_core, client_indx);
 
 	if (cpas_core->streamon_clients == 0) {
 		if (cpas_core->internal_ops.power_off) {
@@ -1766,6 +2072,15 @@ static int cam_cpas_hw_register_client(struct cam_hw_info *cpas_hw,
 		CAM_CPAS_GET_CLIENT_HANDLE(client_indx);
 	memcpy(&cpas_core->cpas_client[client_indx]->data, register_params,
 		sizeof(struct cam_cpas_register_params));
+
+	rc = cam_cpas_util_build_client_path_table(
+		cpas_core->cpas_client[client_indx]);
+	if (rc) {
+		mutex_unlock(&cpas_core->client_mutex[client_indx]);
+		mutex_unlock(&cpas_hw->hw_mutex);
+		return rc;
+	}
+
 	cpas_core->registered_clients++;
 	cpas_core->cpas_client[client_indx]->registered = true;
 
@@ -1945,6 +2260,15 @@ static int cam_cpas_log_vote(struct cam_hw_info *cpas_hw)
 	CAM_INFO(CAM_CPAS, "ahb client curr vote level[%d]",
 		cpas_core->ahb_bus_client.curr_vote_level);
 
+	if (cpas_core->bw_gov.enable)
+		CAM_INFO(CAM_CPAS,
+			"bw gov votes[%lld] coalesced[%lld] bus_updates[%llu] skips[%llu] max_latency_us[%llu]",
+			atomic64_read(&cpas_core->bw_gov.stats.votes_received),
+			atomic64_read(&cpas_core->bw_gov.stats.votes_coalesced),
+			cpas_core->bw_gov.stats.bus_updates,
+			cpas_core->bw_gov.stats.hysteresis_skips,
+			cpas_core->bw_gov.stats.max_latency_us);
+
 	if (!cpas_core->full_state_dump) {
 		CAM_DBG(CAM_CPAS, "CPAS full state dump not enabled");
 		return 0;
@@ -2338,6 +2662,8 @@ static int cam_cpas_util_client_setup(struct cam_hw_info *cpas_hw)
 
 	for (i = 0; i < CAM_CPAS_MAX_CLIENTS; i++) {
 		mutex_init(&cpas_core->client_mutex[i]);
+		if (cpas_core->cpas_client[i])
+			spin_lock_init(&cpas_core->cpas_client[i]->vote_lock);
 	}
 
 	return 0;
@@ -2389,6 +2715,32 @@ static int cam_cpas_util_get_internal_ops(struct platform_device *pdev,
 	return rc;
 }
 
+static ssize_t cam_cpas_bw_gov_stats_read(struct file *file,
+	char __user *ubuf, size_t size, loff_t *loff)
+{
+	struct cam_cpas *cpas_core = file->private_data;
+	struct cam_cpas_bw_gov_stats *stats = &cpas_core->bw_gov.stats;
+	char buf[256];
+	int len;
+
+	len = scnprintf(buf, sizeof(buf),
+		"received %lld coalesced %lld bus_updates %llu hysteresis_skips %llu apply_fail %llu\n"
+		"latency_us last %llu max %llu avg %llu\n",
+		atomic64_read(&stats->votes_received),
+		atomic64_read(&stats->votes_coalesced),
+		stats->bus_updates, stats->hysteresis_skips, stats->apply_fail,
+		stats->last_latency_us, stats->max_latency_us,
+		stats->bus_updates ? div64_u64(stats->total_latency_us,
+		stats->bus_updates) : 0);
+
+	return simple_read_from_buffer(ubuf, size, loff, buf, len);
+}
+
+static const struct file_operations cam_cpas_bw_gov_stats_fops = {
+	.open = simple_open,
+	.read = cam_cpas_bw_gov_stats_read,
+};
+
 static int cam_cpas_util_create_debugfs(struct cam_cpas *cpas_core)
 {
 	int rc = 0;
@@ -2409,6 +2761,18 @@ static int cam_cpas_util_create_debugfs(struct cam_cpas *cpas_core)
 	dbgfileptr = debugfs_create_bool("full_state_dump", 0644,
 		cpas_core->dentry, &cpas_core->full_state_dump);
 
+	dbgfileptr = debugfs_create_bool("bw_gov_enable", 0644,
+		cpas_core->dentry, &cpas_core->bw_gov.enable);
+
+	dbgfileptr = debugfs_create_u32("bw_gov_window_us", 0644,
+		cpas_core->dentry, &cpas_core->bw_gov.window_us);
+
+	dbgfileptr = debugfs_create_u32("bw_gov_hysteresis_pct", 0644,
+		cpas_core->dentry, &cpas_core->bw_gov.hysteresis_pct);
+
+	dbgfileptr = debugfs_create_file("bw_gov_stats", 0444,
+		cpas_core->dentry, cpas_core, &cam_cpas_bw_gov_stats_fops);
+
 	if (IS_ERR(dbgfileptr)) {
 		if (PTR_ERR(dbgfileptr) == -ENODEV)
 			CAM_WARN(CAM_CPAS, "DebugFS not enabled in kernel!");
@@ -2486,6 +2850,18 @@ int cam_cpas_hw_probe(struct platform_device *pdev,
 		goto release_mem;
 	}
 
+	cpas_core->bw_gov.enable = false;
+	cpas_core->bw_gov.window_us = CAM_CPAS_BW_GOV_WINDOW_US;
+	cpas_core->bw_gov.hysteresis_pct = CAM_CPAS_BW_GOV_HYSTERESIS_PCT;
+	cpas_core->bw_gov.cpas_hw = cpas_hw;
+	INIT_DELAYED_WORK(&cpas_core->bw_gov.work, cam_cpas_bw_gov_work);
+	cpas_core->bw_gov.work_queue = alloc_workqueue("cam-cpas-bw-gov",
+		WQ_UNBOUND | WQ_HIGHPRI, 1);
+	if (!cpas_core->bw_gov.work_queue) {
+		rc = -ENOMEM;
+		goto release_workq;
+	}
+
 	internal_ops = &cpas_core->internal_ops;
 	rc = cam_cpas_util_get_internal_ops(pdev, cpas_hw_intf, internal_ops);
 	if (rc)
@@ -2585,6 +2961,8 @@ client_cleanup:
 deinit_platform_res:
 	cam_cpas_soc_deinit_resources(&cpas_hw->soc_info);
 release_workq:
+	if (cpas_core->bw_gov.work_queue)
+		destroy_workqueue(cpas_core->bw_gov.work_queue);
 	flush_workqueue(cpas_core->work_queue);
 	destroy_workqueue(cpas_core->work_queue);
 release_mem:
@@ -2614,6 +2992,8 @@ int cam_cpas_hw_remove(struct cam_hw_intf *cpas_hw_intf)
 		return -EINVAL;
 	}
 
+	cancel_delayed_work_sync(&cpas_core->bw_gov.work);
+	destroy_workqueue(cpas_core->bw_gov.work_queue);
 	cam_cpas_util_axi_cleanup(cpas_core, &cpas_hw->soc_info);
 	cam_cpas_node_tree_cleanup(cpas_core, cpas_hw->soc_info.soc_private);
 	cam_cpas_util_unregister_bus_client(&cpas_core->ahb_bus_client);
@@ -6,6 +6,9 @@
 #ifndef _CAM_CPAS_HW_H_
 #define _CAM_CPAS_HW_H_
 
+#include <linux/ktime.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
 #include <dt-bindings/msm/msm-camera.h>
 #include "cam_cpas_api.h"
 #include "cam_cpas_hw_intf.h"
@@ -46,6 +49,14 @@
 #define CAM_RPMH_BCM_INFO_MAX   5
 
 #define CAM_CPAS_MONITOR_MAX_ENTRIES   60
+
+#define CAM_CPAS_MAX_CLIENT_PATH_SLOTS \
+	(CAM_CPAS_PATH_DATA_MAX * CAM_CPAS_TRANSACTION_MAX)
+#define CAM_CPAS_INVALID_PATH_SLOT     0xFF
+
+/* BW governor defaults, see struct cam_cpas_bw_governor */
+#define CAM_CPAS_BW_GOV_WINDOW_US      1000
+#define CAM_CPAS_BW_GOV_HYSTERESIS_PCT 5
 #define CAM_CPAS_INC_MONITOR_HEAD(head, ret) \
 	div_u64_rem(atomic64_add_return(1, head),\
 	CAM_CPAS_MONITOR_MAX_ENTRIES, (ret))
@@ -113,6 +124,22 @@ struct cam_cpas_reg {
 	uint32_t value;
 };
 
+/**
+ * struct cam_cpas_client_path_slot : Precomputed vote path of a client
+ *
+ * @tree_node: Client tree node votes of this slot are consolidated into
+ * @path_data_type: Path data type @tree_node is indexed with in the client
+ * @ancestors: Ancestors of @tree_node, from its parent up to the root node
+ * @num_ancestors: Number of valid entries in @ancestors
+ *
+ */
+struct cam_cpas_client_path_slot {
+	struct cam_cpas_tree_node *tree_node;
+	uint32_t path_data_type;
+	struct cam_cpas_tree_node *ancestors[CAM_CPAS_MAX_TREE_LEVELS];
+	uint32_t num_ancestors;
+};
+
 /**
  * struct cam_cpas_client : CPAS Client structure info
  *
@@ -124,6 +151,17 @@ struct cam_cpas_reg {
  * @axi_vote: Determined/Applied axi vote for the client
  * @axi_port: Client's parent axi port
  * @tree_node: All granular path voting nodes for the client
+ * @path_slot_idx: Index into path_slot for each incoming path data type and
+ *                 transaction type, CAM_CPAS_INVALID_PATH_SLOT if the client
+ *                 can not vote on the path
+ * @path_slot: Consolidated vote paths of the client, built at registration
+ * @num_path_slots: Number of valid entries in path_slot
+ * @vote_lock: Spinlock protecting pending_axi_vote, pending_ts and
+ *             gov_apply_rc
+ * @pending_axi_vote: Latest translated vote not yet applied by bw governor
+ * @pending_ts: Time the oldest vote coalesced into pending_axi_vote arrived
+ * @gov_apply_rc: Error of the last failed bw governor apply, reported to the
+ *                client on its next vote
  *
  */
 struct cam_cpas_client {
@@ -136,6 +174,15 @@ struct cam_cpas_client {
 	struct cam_cpas_axi_port *axi_port;
 	struct cam_cpas_tree_node *tree_node[CAM_CPAS_PATH_DATA_MAX]
 		[CAM_CPAS_TRANSACTION_MAX];
+	uint8_t path_slot_idx[CAM_CPAS_PATH_DATA_MAX]
+		[CAM_CPAS_TRANSACTION_MAX];
+	struct cam_cpas_client_path_slot
+		path_slot[CAM_CPAS_MAX_CLIENT_PATH_SLOTS];
+	uint32_t num_path_slots;
+	spinlock_t vote_lock;
+	struct cam_axi_vote pending_axi_vote;
+	ktime_t pending_ts;
+	int gov_apply_rc;
 };
 
 /**
@@ -235,6 +282,52 @@ struct cam_cpas_monitor {
 	uint32_t                            camnoc_fill_level[5];
 };
 
+/**
+ * struct cam_cpas_bw_gov_stats : BW governor statistics
+ *
+ * @votes_received: Number of axi votes queued to the governor
+ * @votes_coalesced: Votes overwritten by a newer vote before being applied
+ * @bus_updates: Number of votes applied to the bus
+ * @hysteresis_skips: Votes dropped as within hysteresis of applied vote
+ * @apply_fail: Number of votes that failed to apply
+ * @last_latency_us: Receive to apply latency of the last applied vote
+ * @max_latency_us: Max receive to apply latency
+ * @total_latency_us: Sum of receive to apply latencies
+ */
+struct cam_cpas_bw_gov_stats {
+	atomic64_t votes_received;
+	atomic64_t votes_coalesced;
+	uint64_t   bus_updates;
+	uint64_t   hysteresis_skips;
+	uint64_t   apply_fail;
+	uint64_t   last_latency_us;
+	uint64_t   max_latency_us;
+	uint64_t   total_latency_us;
+};
+
+/**
+ * struct cam_cpas_bw_governor : Asynchronous axi vote governor
+ *
+ * @enable: Whether client axi votes are applied asynchronously
+ * @window_us: Time votes are coalesced before applying them
+ * @hysteresis_pct: BW decrease in percent below which a vote is dropped
+ * @cpas_hw: CPAS hw info the governor belongs to
+ * @work_queue: Dedicated work queue applying the votes
+ * @work: Delayed work applying all pending votes
+ * @pending: Bitmap of clients with a pending vote
+ * @stats: Governor statistics
+ */
+struct cam_cpas_bw_governor {
+	bool enable;
+	uint32_t window_us;
+	uint32_t hysteresis_pct;
+	struct cam_hw_info *cpas_hw;
+	struct workqueue_struct *work_queue;
+	struct delayed_work work;
+	DECLARE_BITMAP(pending, CAM_CPAS_MAX_CLIENTS);
+	struct cam_cpas_bw_gov_stats stats;
+};
+
 /**
  * struct cam_cpas : CPAS core data structure info
  *
@@ -261,6 +354,7 @@ struct cam_cpas_monitor {
  * @monitor_head: Monitor array head
  * @monitor_entries: cpas monitor array
  * @full_state_dump: Whether to enable full cpas state dump or not
+ * @bw_gov: Asynchronous axi vote governor
  */
 struct cam_cpas {
 	struct cam_cpas_hw_caps hw_caps;
@@ -286,6 +380,7 @@ struct cam_cpas {
 	atomic64_t  monitor_head;
 	struct cam_cpas_monitor monitor_entries[CAM_CPAS_MONITOR_MAX_ENTRIES];
 	bool full_state_dump;
+	struct cam_cpas_bw_governor bw_gov;
 };
 
 int cam_camsstop_get_internal_ops(struct cam_cpas_internal_ops *internal_ops);
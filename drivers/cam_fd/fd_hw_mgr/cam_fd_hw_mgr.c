@@ -222,41 +222,47 @@ static int cam_fd_mgr_util_release_device(struct cam_fd_hw_mgr *hw_mgr,
 {
 	struct cam_fd_device *hw_device;
 	struct cam_fd_hw_release_args hw_release_args;
-	int rc;
+	int i, rc = 0, rc_release;
 
-	rc = cam_fd_mgr_util_get_device(hw_mgr, hw_ctx, &hw_device);
-	if (rc) {
-		CAM_ERR(CAM_FD, "Error in getting device %d", rc);
-		return rc;
-	}
+	for (i = 0; i < hw_mgr->num_devices; i++) {
+		if (!(hw_ctx->device_mask & BIT(i)))
+			continue;
 
-	if (hw_device->hw_intf->hw_ops.release) {
-		hw_release_args.hw_ctx = hw_ctx;
-		hw_release_args.ctx_hw_private = hw_ctx->ctx_hw_private;
-		rc = hw_device->hw_intf->hw_ops.release(
-			hw_device->hw_intf->hw_priv, &hw_release_args,
-			sizeof(hw_release_args));
-		if (rc) {
-			CAM_ERR(CAM_FD, "Failed in HW release %d", rc);
-			return rc;
+		hw_device = &hw_mgr->hw_device[i];
+
+		if (hw_device->hw_intf->hw_ops.release) {
+			hw_release_args.hw_ctx = hw_ctx;
+			hw_release_args.ctx_hw_private =
+				hw_ctx->ctx_hw_private[i];
+			rc_release = hw_device->hw_intf->hw_ops.release(
+				hw_device->hw_intf->hw_priv, &hw_release_args,
+				sizeof(hw_release_args));
+			if (rc_release) {
+				CAM_ERR(CAM_FD, "Failed in HW release %d, dev %d",
+					rc_release, i);
+				rc = rc_release;
+			}
+		} else {
+			CAM_ERR(CAM_FD, "Invalid release function");
 		}
-	} else {
-		CAM_ERR(CAM_FD, "Invalid release function");
-	}
 
-	mutex_lock(&hw_mgr->hw_mgr_mutex);
-	hw_device->num_ctxts--;
+		hw_ctx->ctx_hw_private[i] = NULL;
 
-	if (!hw_device->num_ctxts) {
-		mutex_lock(&hw_device->lock);
-		hw_device->ready_to_process = true;
-		hw_device->req_id = -1;
-		hw_device->cur_hw_ctx = NULL;
-		mutex_unlock(&hw_device->lock);
-	}
+		mutex_lock(&hw_mgr->hw_mgr_mutex);
+		hw_device->num_ctxts--;
 
-	mutex_unlock(&hw_mgr->hw_mgr_mutex);
+		if (!hw_device->num_ctxts) {
+			mutex_lock(&hw_device->lock);
+			hw_device->ready_to_process = true;
+			hw_device->req_id = -1;
+			hw_device->cur_hw_ctx = NULL;
+			mutex_unlock(&hw_device->lock);
+		}
+
+		mutex_unlock(&hw_mgr->hw_mgr_mutex);
+	}
 
+	hw_ctx->device_mask = 0;
 	hw_ctx->device_index = -1;
 
 	return rc;
@@ -266,7 +272,9 @@ static int cam_fd_mgr_util_select_device(struct cam_fd_hw_mgr *hw_mgr,
 	struct cam_fd_hw_mgr_ctx *hw_ctx,
 	struct cam_fd_acquire_dev_info *fd_acquire_args)
 {
-	int i, rc;
+	int i, rc = 0, reserve_rc = -EBUSY;
+	int32_t default_index = -1;
+	uint32_t min_ctxts = 0;
 	struct cam_fd_hw_reserve_args hw_reserve_args;
 	struct cam_fd_device *hw_device = NULL;
 
@@ -276,9 +284,18 @@ static int cam_fd_mgr_util_select_device(struct cam_fd_hw_mgr *hw_mgr,
 		return -EINVAL;
 	}
 
+	hw_ctx->device_mask = 0;
+
 	mutex_lock(&hw_mgr->hw_mgr_mutex);
 
-	/* Check if a device is free which can satisfy the requirements */
+	/*
+	 * Reserve every HW which meets the acquire requirements, frames
+	 * of this context are then scheduled on whichever of these devices
+	 * is free first. The least shared device is the default one used
+	 * to build kmd commands while preparing frames. A device which
+	 * fails to reserve is skipped, acquire fails only if none could be
+	 * reserved.
+	 */
 	for (i = 0; i < hw_mgr->num_devices; i++) {
 		hw_device = &hw_mgr->hw_device[i];
 		CAM_DBG(CAM_FD,
@@ -286,75 +303,70 @@ static int cam_fd_mgr_util_select_device(struct cam_fd_hw_mgr *hw_mgr,
 			i, hw_device->num_ctxts,
 			hw_device->hw_caps.supported_modes,
 			hw_device->hw_caps.raw_results_available);
-		if ((hw_device->num_ctxts == 0) &&
-			(fd_acquire_args->mode &
-			hw_device->hw_caps.supported_modes) &&
-			(!fd_acquire_args->get_raw_results ||
-			hw_device->hw_caps.raw_results_available)) {
-			CAM_DBG(CAM_FD, "Found dedicated HW Index=%d", i);
+
+		if (!(fd_acquire_args->mode &
+			hw_device->hw_caps.supported_modes) ||
+			(fd_acquire_args->get_raw_results &&
+			!hw_device->hw_caps.raw_results_available))
+			continue;
+
+		if (!hw_device->hw_intf->hw_ops.reserve) {
+			CAM_ERR(CAM_FD, "Invalid reserve function");
+			rc = -EPERM;
+			break;
+		}
+
+		hw_reserve_args.hw_ctx = hw_ctx;
+		hw_reserve_args.mode = fd_acquire_args->mode;
+		reserve_rc = hw_device->hw_intf->hw_ops.reserve(
+			hw_device->hw_intf->hw_priv, &hw_reserve_args,
+			sizeof(hw_reserve_args));
+		if (reserve_rc) {
+			CAM_WARN(CAM_FD, "Failed in HW reserve %d, dev %d",
+				reserve_rc, i);
+			continue;
+		}
+
+		hw_ctx->ctx_hw_private[i] = hw_reserve_args.ctx_hw_private;
+		hw_ctx->device_mask |= BIT(i);
+
+		if (!hw_device->num_ctxts) {
 			mutex_lock(&hw_device->lock);
 			hw_device->ready_to_process = true;
 			hw_device->req_id = -1;
 			hw_device->cur_hw_ctx = NULL;
 			mutex_unlock(&hw_device->lock);
-			hw_device->num_ctxts++;
-			break;
 		}
-	}
 
-	/*
-	 * We couldn't find a free HW which meets requirement, now check if
-	 * there is a HW which meets acquire requirements
-	 */
-	if (i == hw_mgr->num_devices) {
-		for (i = 0; i < hw_mgr->num_devices; i++) {
-			hw_device = &hw_mgr->hw_device[i];
-			if ((fd_acquire_args->mode &
-				hw_device->hw_caps.supported_modes) &&
-				(!fd_acquire_args->get_raw_results ||
-				hw_device->hw_caps.raw_results_available)) {
-				hw_device->num_ctxts++;
-				CAM_DBG(CAM_FD,
-					"Found sharing HW Index=%d, num_ctxts=%d",
-					i, hw_device->num_ctxts);
-				break;
-			}
+		if ((default_index < 0) || (hw_device->num_ctxts < min_ctxts)) {
+			default_index = i;
+			min_ctxts = hw_device->num_ctxts;
 		}
+
+		hw_device->num_ctxts++;
+		CAM_DBG(CAM_FD, "Reserved HW Index=%d, num_ctxts=%d",
+			i, hw_device->num_ctxts);
 	}
 
 	mutex_unlock(&hw_mgr->hw_mgr_mutex);
 
-	if ((i == hw_mgr->num_devices) || !hw_device) {
-		CAM_ERR(CAM_FD, "Couldn't acquire HW %d %d",
-			fd_acquire_args->mode,
-			fd_acquire_args->get_raw_results);
-		return -EBUSY;
+	if (rc) {
+		cam_fd_mgr_util_release_device(hw_mgr, hw_ctx);
+		return rc;
 	}
 
-	CAM_DBG(CAM_FD, "Device index %d selected for this acquire", i);
-
-	/* Check if we can reserve this HW */
-	if (hw_device->hw_intf->hw_ops.reserve) {
-		hw_reserve_args.hw_ctx = hw_ctx;
-		hw_reserve_args.mode = fd_acquire_args->mode;
-		rc = hw_device->hw_intf->hw_ops.reserve(
-			hw_device->hw_intf->hw_priv, &hw_reserve_args,
-			sizeof(hw_reserve_args));
-		if (rc) {
-			CAM_ERR(CAM_FD, "Failed in HW reserve %d", rc);
-			return rc;
-		}
-		hw_ctx->ctx_hw_private = hw_reserve_args.ctx_hw_private;
-	} else {
-		CAM_ERR(CAM_FD, "Invalid reserve function");
-		return -EPERM;
+	if (default_index < 0) {
+		CAM_ERR(CAM_FD, "Couldn't acquire HW %d %d, rc %d",
+			fd_acquire_args->mode,
+			fd_acquire_args->get_raw_results, reserve_rc);
+		return reserve_rc;
 	}
 
 	/* Update required info in hw context */
-	hw_ctx->device_index = i;
+	hw_ctx->device_index = default_index;
 
-	CAM_DBG(CAM_FD, "ctx index=%u, device_index=%d", hw_ctx->ctx_index,
-		hw_ctx->device_index);
+	CAM_DBG(CAM_FD, "ctx index=%u, device_index=%d, device_mask=0x%x",
+		hw_ctx->ctx_index, hw_ctx->device_index, hw_ctx->device_mask);
 
 	return 0;
 }
@@ -857,57 +869,191 @@ static int cam_fd_mgr_util_prepare_hw_update_entries(
 	return rc;
 }
 
-static int cam_fd_mgr_util_submit_frame(void *priv, void *data)
+static bool cam_fd_mgr_util_ctx_in_processing(struct cam_fd_hw_mgr *hw_mgr,
+	struct cam_fd_hw_mgr_ctx *hw_ctx)
+{
+	struct cam_fd_mgr_frame_request *frame_req;
+
+	list_for_each_entry(frame_req, &hw_mgr->frame_processing_list, list) {
+		if (frame_req->hw_ctx == hw_ctx)
+			return true;
+	}
+
+	return false;
+}
+
+static bool cam_fd_mgr_util_is_device_free(struct cam_fd_hw_mgr *hw_mgr,
+	struct cam_fd_hw_mgr_ctx *hw_ctx, int32_t device_index)
 {
 	struct cam_fd_device *hw_device;
-	struct cam_fd_hw_mgr *hw_mgr;
+	bool ready;
+
+	if ((device_index < 0) || (device_index >= hw_mgr->num_devices) ||
+		!(hw_ctx->device_mask & BIT(device_index)))
+		return false;
+
+	hw_device = &hw_mgr->hw_device[device_index];
+	mutex_lock(&hw_device->lock);
+	ready = hw_device->ready_to_process;
+	mutex_unlock(&hw_device->lock);
+
+	return ready;
+}
+
+static struct cam_fd_device *cam_fd_mgr_util_get_free_device(
+	struct cam_fd_hw_mgr *hw_mgr,
+	struct cam_fd_mgr_frame_request *frame_req)
+{
+	int i;
+
+	/*
+	 * Prefer the device for which kmd commands of this frame are
+	 * already built, so that change base need not be updated.
+	 */
+	if (cam_fd_mgr_util_is_device_free(hw_mgr, frame_req->hw_ctx,
+		frame_req->device_index))
+		return &hw_mgr->hw_device[frame_req->device_index];
+
+	for (i = 0; i < hw_mgr->num_devices; i++) {
+		if (i == frame_req->device_index)
+			continue;
+
+		if (cam_fd_mgr_util_is_device_free(hw_mgr, frame_req->hw_ctx,
+			i))
+			return &hw_mgr->hw_device[i];
+	}
+
+	return NULL;
+}
+
+static int cam_fd_mgr_util_get_next_frame(struct cam_fd_hw_mgr *hw_mgr,
+	struct cam_fd_mgr_frame_request **next_frame_req,
+	struct cam_fd_device **next_hw_device)
+{
+	struct list_head *pending_list[] = {
+		&hw_mgr->frame_pending_list_high,
+		&hw_mgr->frame_pending_list_normal,
+	};
 	struct cam_fd_mgr_frame_request *frame_req;
-	struct cam_fd_hw_mgr_ctx *hw_ctx;
-	struct cam_fd_hw_cmd_start_args start_args;
-	int rc;
+	struct cam_fd_device *hw_device;
+	int i;
 
-	if (!priv) {
-		CAM_ERR(CAM_FD, "Invalid data");
-		return -EINVAL;
+	/*
+	 * Pick the oldest frame, high priority list first, whose context has
+	 * no frame with HW and which can run on a free device. Only one frame
+	 * per context is given to HW at a time, this keeps the results of a
+	 * context in order even though its frames may run on any device.
+	 */
+	for (i = 0; i < ARRAY_SIZE(pending_list); i++) {
+		list_for_each_entry(frame_req, pending_list[i], list) {
+			if (cam_fd_mgr_util_ctx_in_processing(hw_mgr,
+				frame_req->hw_ctx))
+				continue;
+
+			hw_device = cam_fd_mgr_util_get_free_device(hw_mgr,
+				frame_req);
+			if (!hw_device)
+				continue;
+
+			*next_frame_req = frame_req;
+			*next_hw_device = hw_device;
+			return 0;
+		}
 	}
 
-	hw_mgr = (struct cam_fd_hw_mgr *)priv;
-	mutex_lock(&hw_mgr->frame_req_mutex);
+	return -EBUSY;
+}
 
-	/* Check if we have any frames pending in high priority list */
-	if (!list_empty(&hw_mgr->frame_pending_list_high)) {
-		CAM_DBG(CAM_FD, "Pending frames in high priority list");
-		frame_req = list_first_entry(&hw_mgr->frame_pending_list_high,
-			struct cam_fd_mgr_frame_request, list);
-	} else if (!list_empty(&hw_mgr->frame_pending_list_normal)) {
-		CAM_DBG(CAM_FD, "Pending frames in normal priority list");
-		frame_req = list_first_entry(&hw_mgr->frame_pending_list_normal,
-			struct cam_fd_mgr_frame_request, list);
-	} else {
-		mutex_unlock(&hw_mgr->frame_req_mutex);
-		CAM_DBG(CAM_FD, "No pending frames");
-		return 0;
+static int cam_fd_mgr_util_update_change_base(
+	struct cam_fd_mgr_frame_request *frame_req,
+	struct cam_fd_device *hw_device)
+{
+	struct cam_hw_update_entry *kmd_entry;
+	struct cam_fd_hw_cmd_change_base_args change_base_args;
+	uint32_t *cpu_addr;
+	size_t len;
+	int rc;
+
+	if (!hw_device->hw_intf->hw_ops.process_cmd) {
+		CAM_ERR(CAM_FD, "Invalid hw_ops.process_cmd");
+		return -EPERM;
 	}
 
-	CAM_DBG(CAM_FD, "FrameSubmit : Frame[%lld]", frame_req->request_id);
-	hw_ctx = frame_req->hw_ctx;
-	rc = cam_fd_mgr_util_get_device(hw_mgr, hw_ctx, &hw_device);
+	/*
+	 * First hw update entry is always the kmd pre config buffer which
+	 * starts with change base command, see prepare_hw_update_entries.
+	 */
+	kmd_entry = &frame_req->hw_update_entries[0];
+
+	rc = cam_packet_util_get_cmd_mem_addr(kmd_entry->handle, &cpu_addr,
+		&len);
 	if (rc) {
-		mutex_unlock(&hw_mgr->frame_req_mutex);
-		CAM_ERR(CAM_FD, "Error in getting device %d", rc);
+		CAM_ERR(CAM_FD, "Failed to get kmd buf addr, rc=%d", rc);
 		return rc;
 	}
 
+	if (((size_t)kmd_entry->offset >= len) ||
+		((size_t)kmd_entry->len > (len - (size_t)kmd_entry->offset))) {
+		CAM_ERR(CAM_FD, "Invalid kmd entry offset %u len %u buf len %zu",
+			kmd_entry->offset, kmd_entry->len, len);
+		rc = -EINVAL;
+		goto put_cpu_buf;
+	}
+
+	change_base_args.ctx_hw_private =
+		frame_req->hw_ctx->ctx_hw_private[hw_device->index];
+	change_base_args.cmd_buf_addr = cpu_addr + (kmd_entry->offset / 4);
+	change_base_args.size = kmd_entry->len;
+
+	rc = hw_device->hw_intf->hw_ops.process_cmd(
+		hw_device->hw_intf->hw_priv, CAM_FD_HW_CMD_UPDATE_CHANGE_BASE,
+		&change_base_args, sizeof(change_base_args));
+	if (rc) {
+		CAM_ERR(CAM_FD, "Failed in CMD_UPDATE_CHANGE_BASE %d", rc);
+		goto put_cpu_buf;
+	}
+
+	CAM_DBG(CAM_FD, "Frame[%lld] moved from device %d to %d",
+		frame_req->request_id, frame_req->device_index,
+		hw_device->index);
+	frame_req->device_index = hw_device->index;
+
+put_cpu_buf:
+	cam_mem_put_cpu_buf(kmd_entry->handle);
+
+	return rc;
+}
+
+static int cam_fd_mgr_util_start_frame(struct cam_fd_hw_mgr *hw_mgr,
+	struct cam_fd_mgr_frame_request *frame_req,
+	struct cam_fd_device *hw_device)
+{
+	struct cam_fd_hw_mgr_ctx *hw_ctx = frame_req->hw_ctx;
+	struct cam_fd_hw_cmd_start_args start_args;
+	int rc;
+
+	CAM_DBG(CAM_FD, "FrameSubmit : Frame[%lld] on device %d",
+		frame_req->request_id, hw_device->index);
+
+	if (!hw_device->hw_intf->hw_ops.start) {
+		CAM_ERR(CAM_FD, "Invalid hw_ops.start");
+		return -EPERM;
+	}
+
+	if (frame_req->device_index != hw_device->index) {
+		rc = cam_fd_mgr_util_update_change_base(frame_req, hw_device);
+		if (rc)
+			return rc;
+	}
+
+	/* Results are read through the private data of the running device */
+	frame_req->hw_req_private.ctx_hw_private =
+		hw_ctx->ctx_hw_private[hw_device->index];
+
 	mutex_lock(&hw_device->lock);
 	if (hw_device->ready_to_process == false) {
-		if (hw_mgr->num_pending_frames > 6) {
-			CAM_WARN(CAM_FD,
-				"Device busy for longer time with cur_hw_ctx=%pK, ReqId=%lld",
-				hw_device->cur_hw_ctx, hw_device->req_id);
-		}
 		mutex_unlock(&hw_device->lock);
-		mutex_unlock(&hw_mgr->frame_req_mutex);
-		return -EBUSY;
+		return -EAGAIN;
 	}
 
 	trace_cam_submit_to_hw("FD", frame_req->request_id);
@@ -916,42 +1062,77 @@ static int cam_fd_mgr_util_submit_frame(void *priv, void *data)
 	hw_mgr->num_pending_frames--;
 	list_add_tail(&frame_req->list, &hw_mgr->frame_processing_list);
 
-	if (hw_device->hw_intf->hw_ops.start) {
-		start_args.hw_ctx = hw_ctx;
-		start_args.ctx_hw_private = hw_ctx->ctx_hw_private;
-		start_args.hw_req_private = &frame_req->hw_req_private;
-		start_args.hw_update_entries = frame_req->hw_update_entries;
-		start_args.num_hw_update_entries =
-			frame_req->num_hw_update_entries;
-
-		rc = hw_device->hw_intf->hw_ops.start(
-			hw_device->hw_intf->hw_priv, &start_args,
-			sizeof(start_args));
-		if (rc) {
-			CAM_ERR(CAM_FD, "Failed in HW Start %d", rc);
-			list_del_init(&frame_req->list);
-			mutex_unlock(&hw_device->lock);
-			mutex_unlock(&hw_mgr->frame_req_mutex);
-			goto put_req_into_free_list;
-		}
-	} else {
-		CAM_ERR(CAM_FD, "Invalid hw_ops.start");
+	start_args.hw_ctx = hw_ctx;
+	start_args.ctx_hw_private = hw_ctx->ctx_hw_private[hw_device->index];
+	start_args.hw_req_private = &frame_req->hw_req_private;
+	start_args.hw_update_entries = frame_req->hw_update_entries;
+	start_args.num_hw_update_entries = frame_req->num_hw_update_entries;
+
+	rc = hw_device->hw_intf->hw_ops.start(hw_device->hw_intf->hw_priv,
+		&start_args, sizeof(start_args));
+	if (rc) {
+		CAM_ERR(CAM_FD, "Failed in HW Start %d", rc);
 		list_del_init(&frame_req->list);
 		mutex_unlock(&hw_device->lock);
-		mutex_unlock(&hw_mgr->frame_req_mutex);
-		rc = -EPERM;
-		goto put_req_into_free_list;
+		return rc;
 	}
 
 	hw_device->ready_to_process = false;
 	hw_device->cur_hw_ctx = hw_ctx;
 	hw_device->req_id = frame_req->request_id;
 	mutex_unlock(&hw_device->lock);
-	mutex_unlock(&hw_mgr->frame_req_mutex);
 
-	return rc;
-put_req_into_free_list:
-	cam_fd_mgr_util_put_frame_req(&hw_mgr->frame_free_list, &frame_req);
+	return 0;
+}
+
+static int cam_fd_mgr_util_submit_frame(void *priv, void *data)
+{
+	struct cam_fd_device *hw_device;
+	struct cam_fd_hw_mgr *hw_mgr;
+	struct cam_fd_mgr_frame_request *frame_req;
+	int rc = 0;
+
+	if (!priv) {
+		CAM_ERR(CAM_FD, "Invalid data");
+		return -EINVAL;
+	}
+
+	hw_mgr = (struct cam_fd_hw_mgr *)priv;
+	mutex_lock(&hw_mgr->frame_req_mutex);
+
+	if (list_empty(&hw_mgr->frame_pending_list_high) &&
+		list_empty(&hw_mgr->frame_pending_list_normal)) {
+		mutex_unlock(&hw_mgr->frame_req_mutex);
+		CAM_DBG(CAM_FD, "No pending frames");
+		return 0;
+	}
+
+	/* Keep submitting until no device is free or no frame can run */
+	while (!cam_fd_mgr_util_get_next_frame(hw_mgr, &frame_req,
+		&hw_device)) {
+		rc = cam_fd_mgr_util_start_frame(hw_mgr, frame_req, hw_device);
+		if (rc == -EAGAIN) {
+			rc = 0;
+			break;
+		} else if (rc) {
+			if (!list_empty(&frame_req->list)) {
+				list_del_init(&frame_req->list);
+				hw_mgr->num_pending_frames--;
+			}
+			list_add_tail(&frame_req->list,
+				&hw_mgr->frame_free_list);
+			mutex_unlock(&hw_mgr->frame_req_mutex);
+			return rc;
+		}
+	}
+
+	if (hw_mgr->num_pending_frames > 6) {
+		CAM_WARN(CAM_FD,
+			"Devices busy for longer time, pending frames %d",
+			hw_mgr->num_pending_frames);
+	}
+
+	mutex_unlock(&hw_mgr->frame_req_mutex);
 
 	return rc;
 }
@@ -978,6 +1159,30 @@ static int cam_fd_mgr_util_schedule_frame_worker_task(
 	return rc;
 }
 
+static int cam_fd_mgr_util_get_processing_frame(struct cam_fd_hw_mgr *hw_mgr,
+	struct cam_fd_device *hw_device,
+	struct cam_fd_mgr_frame_request **frame_req)
+{
+	struct cam_fd_mgr_frame_request *req_ptr;
+	int rc = -EPERM;
+
+	*frame_req = NULL;
+
+	mutex_lock(&hw_mgr->frame_req_mutex);
+	list_for_each_entry(req_ptr, &hw_mgr->frame_processing_list, list) {
+		if (req_ptr->device_index != hw_device->index)
+			continue;
+
+		list_del_init(&req_ptr->list);
+		*frame_req = req_ptr;
+		rc = 0;
+		break;
+	}
+	mutex_unlock(&hw_mgr->frame_req_mutex);
+
+	return rc;
+}
+
 static int32_t cam_fd_mgr_workq_irq_cb(void *priv, void *data)
 {
 	struct cam_fd_device *hw_device = NULL;
@@ -996,8 +1201,15 @@ static int32_t cam_fd_mgr_workq_irq_cb(void *priv, void *data)
 	hw_mgr = (struct cam_fd_hw_mgr *)priv;
 	work_data = (struct cam_fd_mgr_work_data *)data;
 	irq_type = work_data->irq_type;
+	hw_device = work_data->hw_device;
 
-	CAM_DBG(CAM_FD, "FD IRQ type=%d", irq_type);
+	if (!hw_device) {
+		CAM_ERR(CAM_FD, "Invalid hw device for irq type %d", irq_type);
+		return -EINVAL;
+	}
+
+	CAM_DBG(CAM_FD, "FD IRQ type=%d, device=%d", irq_type,
+		hw_device->index);
 
 	if (irq_type == CAM_FD_IRQ_HALT_DONE) {
 		/* HALT would be followed by a RESET, ignore this */
@@ -1005,8 +1217,8 @@ static int32_t cam_fd_mgr_workq_irq_cb(void *priv, void *data)
 		return 0;
 	}
 
-	/* Get the frame from processing list */
-	rc = cam_fd_mgr_util_get_frame_req(&hw_mgr->frame_processing_list,
+	/* Get the frame running on this device from processing list */
+	rc = cam_fd_mgr_util_get_processing_frame(hw_mgr, hw_device,
 		&frame_req);
 	if (rc || !frame_req) {
 		/*
@@ -1024,12 +1236,6 @@ static int32_t cam_fd_mgr_workq_irq_cb(void *priv, void *data)
 		goto put_req_in_free_list;
 	}
 
-	rc = cam_fd_mgr_util_get_device(hw_mgr, frame_req->hw_ctx, &hw_device);
-	if (rc) {
-		CAM_ERR(CAM_FD, "Error in getting device %d", rc);
-		goto put_req_in_free_list;
-	}
-
 	/* Read frame results first */
 	if (irq_type == CAM_FD_IRQ_FRAME_DONE) {
 		struct cam_fd_hw_frame_done_args frame_done_args;
@@ -1039,7 +1245,7 @@ static int32_t cam_fd_mgr_workq_irq_cb(void *priv, void *data)
 
 		frame_done_args.hw_ctx = frame_req->hw_ctx;
 		frame_done_args.ctx_hw_private =
-			frame_req->hw_ctx->ctx_hw_private;
+			frame_req->hw_ctx->ctx_hw_private[hw_device->index];
 		frame_done_args.request_id = frame_req->request_id;
 		frame_done_args.hw_req_private = &frame_req->hw_req_private;
 
@@ -1132,6 +1338,7 @@ static int cam_fd_mgr_irq_cb(void *data, enum cam_fd_hw_irq_type irq_type)
 	work_data = (struct cam_fd_mgr_work_data *)task->payload;
 	work_data->type = CAM_FD_WORK_IRQ;
 	work_data->irq_type = irq_type;
+	work_data->hw_device = (struct cam_fd_device *)data;
 
 	task->process_cb = cam_fd_mgr_workq_irq_cb;
 	rc = cam_req_mgr_workq_enqueue_task(task, hw_mgr, CRM_TASK_PRIORITY_0);
@@ -1280,9 +1487,43 @@ static int cam_fd_mgr_hw_release(void *hw_mgr_priv, void *hw_release_args)
 	return 0;
 }
 
+static int cam_fd_mgr_util_deinit_devices(struct cam_fd_hw_mgr *hw_mgr,
+	struct cam_fd_hw_mgr_ctx *hw_ctx, uint32_t device_mask)
+{
+	struct cam_fd_device *hw_device;
+	struct cam_fd_hw_deinit_args hw_deinit_args;
+	int i, rc = 0, rc_deinit;
+
+	for (i = 0; i < hw_mgr->num_devices; i++) {
+		if (!(device_mask & BIT(i)))
+			continue;
+
+		hw_device = &hw_mgr->hw_device[i];
+
+		CAM_DBG(CAM_FD, "FD Device[%d] ready_to_process = %d", i,
+			hw_device->ready_to_process);
+
+		if (!hw_device->hw_intf->hw_ops.deinit)
+			continue;
+
+		hw_deinit_args.hw_ctx = hw_ctx;
+		hw_deinit_args.ctx_hw_private = hw_ctx->ctx_hw_private[i];
+		rc_deinit = hw_device->hw_intf->hw_ops.deinit(
+			hw_device->hw_intf->hw_priv, &hw_deinit_args,
+			sizeof(hw_deinit_args));
+		if (rc_deinit) {
+			CAM_ERR(CAM_FD, "Failed in HW DeInit %d, dev %d",
+				rc_deinit, i);
+			rc = rc_deinit;
+		}
+	}
+
+	return rc;
+}
+
 static int cam_fd_mgr_hw_start(void *hw_mgr_priv, void *mgr_start_args)
 {
-	int rc = 0;
+	int i, rc = 0;
 	struct cam_fd_hw_mgr *hw_mgr = (struct cam_fd_hw_mgr *)hw_mgr_priv;
 	struct cam_hw_start_args *hw_mgr_start_args =
 		(struct cam_hw_start_args *)mgr_start_args;
@@ -1291,6 +1532,7 @@ static int cam_fd_mgr_hw_start(void *hw_mgr_priv, void *mgr_start_args)
 	struct cam_fd_hw_init_args hw_init_args;
 	struct cam_hw_info *fd_hw;
 	struct cam_fd_core *fd_core;
+	uint32_t init_mask = 0;
 
 	if (!hw_mgr_priv || !hw_mgr_start_args) {
 		CAM_ERR(CAM_FD, "Invalid arguments %pK %pK",
@@ -1304,21 +1546,26 @@ static int cam_fd_mgr_hw_start(void *hw_mgr_priv, void *mgr_start_args)
 		return -EPERM;
 	}
 
-	CAM_DBG(CAM_FD, "ctx index=%u, device_index=%d", hw_ctx->ctx_index,
-		hw_ctx->device_index);
+	CAM_DBG(CAM_FD, "ctx index=%u, device_index=%d, device_mask=0x%x",
+		hw_ctx->ctx_index, hw_ctx->device_index, hw_ctx->device_mask);
 
-	rc = cam_fd_mgr_util_get_device(hw_mgr, hw_ctx, &hw_device);
-	if (rc) {
-		CAM_ERR(CAM_FD, "Error in getting device %d", rc);
-		return rc;
-	}
+	/* Frames of this context can run on any reserved device */
+	for (i = 0; i < hw_mgr->num_devices; i++) {
+		if (!(hw_ctx->device_mask & BIT(i)))
+			continue;
 
-	fd_hw = (struct cam_hw_info *)hw_device->hw_intf->hw_priv;
-	fd_core = (struct cam_fd_core *)fd_hw->core_info;
+		hw_device = &hw_mgr->hw_device[i];
+		fd_hw = (struct cam_hw_info *)hw_device->hw_intf->hw_priv;
+		fd_core = (struct cam_fd_core *)fd_hw->core_info;
+
+		if (!hw_device->hw_intf->hw_ops.init) {
+			CAM_ERR(CAM_FD, "Invalid init function");
+			rc = -EINVAL;
+			goto deinit;
+		}
 
-	if (hw_device->hw_intf->hw_ops.init) {
 		hw_init_args.hw_ctx = hw_ctx;
-		hw_init_args.ctx_hw_private = hw_ctx->ctx_hw_private;
+		hw_init_args.ctx_hw_private = hw_ctx->ctx_hw_private[i];
 		hw_init_args.is_hw_reset = false;
 		if (fd_core->hw_static_info->enable_errata_wa.skip_reset)
 			hw_init_args.reset_required = false;
@@ -1329,10 +1576,12 @@ static int cam_fd_mgr_hw_start(void *hw_mgr_priv, void *mgr_start_args)
 			hw_device->hw_intf->hw_priv, &hw_init_args,
 			sizeof(hw_init_args));
 		if (rc) {
-			CAM_ERR(CAM_FD, "Failed in HW Init %d", rc);
-			return rc;
+			CAM_ERR(CAM_FD, "Failed in HW Init %d, dev %d", rc, i);
+			goto deinit;
 		}
 
+		init_mask |= BIT(i);
+
 		if (hw_init_args.is_hw_reset) {
 			mutex_lock(&hw_device->lock);
 			hw_device->ready_to_process = true;
@@ -1340,11 +1589,13 @@ static int cam_fd_mgr_hw_start(void *hw_mgr_priv, void *mgr_start_args)
 			hw_device->cur_hw_ctx = NULL;
 			mutex_unlock(&hw_device->lock);
 		}
-	} else {
-		CAM_ERR(CAM_FD, "Invalid init function");
-		return -EINVAL;
 	}
 
+	return rc;
+
+deinit:
+	cam_fd_mgr_util_deinit_devices(hw_mgr, hw_ctx, init_mask);
+
 	return rc;
 }
 
@@ -1368,12 +1619,6 @@ static int cam_fd_mgr_hw_flush_req(void *hw_mgr_priv,
 	CAM_DBG(CAM_FD, "ctx index=%u, hw_ctx=%d", hw_ctx->ctx_index,
 		hw_ctx->device_index);
 
-	rc = cam_fd_mgr_util_get_device(hw_mgr, hw_ctx, &hw_device);
-	if (rc) {
-		CAM_ERR(CAM_FD, "Error in getting device %d", rc);
-		return rc;
-	}
-
 	mutex_lock(&hw_mgr->frame_req_mutex);
 	for (i = 0; i < flush_args->num_req_active; i++) {
 		flush_req = (struct cam_fd_mgr_frame_request *)
@@ -1415,6 +1660,7 @@ static int cam_fd_mgr_hw_flush_req(void *hw_mgr_priv,
 
 			list_del_init(&frame_req->list);
 
+			hw_device = &hw_mgr->hw_device[frame_req->device_index];
 			mutex_lock(&hw_device->lock);
 			if ((hw_device->ready_to_process == true) ||
 				(hw_device->cur_hw_ctx != hw_ctx))
@@ -1471,12 +1717,6 @@ static int cam_fd_mgr_hw_flush_ctx(void *hw_mgr_priv,
 	CAM_DBG(CAM_FD, "ctx index=%u, hw_ctx=%d", hw_ctx->ctx_index,
 		hw_ctx->device_index);
 
-	rc = cam_fd_mgr_util_get_device(hw_mgr, hw_ctx, &hw_device);
-	if (rc) {
-		CAM_ERR(CAM_FD, "Error in getting device %d", rc);
-		return rc;
-	}
-
 	mutex_lock(&hw_mgr->frame_req_mutex);
 	list_for_each_entry_safe(frame_req, req_temp,
 		&hw_mgr->frame_pending_list_high, list) {
@@ -1502,6 +1742,7 @@ static int cam_fd_mgr_hw_flush_ctx(void *hw_mgr_priv,
 			continue;
 
 		list_del_init(&frame_req->list);
+		hw_device = &hw_mgr->hw_device[frame_req->device_index];
 		mutex_lock(&hw_device->lock);
 		if ((hw_device->ready_to_process == true) ||
 			(hw_device->cur_hw_ctx != hw_ctx))
@@ -1609,23 +1850,19 @@ static int cam_fd_mgr_hw_dump(
 		return -EINVAL;
 	}
 
-	rc = cam_fd_mgr_util_get_device(hw_mgr, hw_ctx, &hw_device);
-
-	if (rc) {
-		CAM_ERR(CAM_FD, "Error in getting device %d", rc);
-		return rc;
-	}
-
 	list_for_each_entry_safe(frame_req, req_temp,
 		&hw_mgr->frame_processing_list, list) {
-		if (frame_req->request_id == dump_args->request_id)
+		if ((frame_req->hw_ctx == hw_ctx) &&
+			(frame_req->request_id == dump_args->request_id))
 			goto hw_dump;
 	}
 
 	CAM_DBG(CAM_FD, "fd dump cannot find req %llu",
 		dump_args->request_id);
-	return rc;
+	return 0;
 hw_dump:
+	/* Dump the device this request is running on */
+	hw_device = &hw_mgr->hw_device[frame_req->device_index];
 	cur_time = ktime_get();
 	diff = ktime_us_delta(frame_req->submit_timestamp, cur_time);
 	cur_ts = ktime_to_timespec64(cur_time);
@@ -1714,8 +1951,6 @@ static int cam_fd_mgr_hw_stop(void *hw_mgr_priv, void *mgr_stop_args)
 	struct cam_hw_stop_args *hw_mgr_stop_args =
 		(struct cam_hw_stop_args *)mgr_stop_args;
 	struct cam_fd_hw_mgr_ctx *hw_ctx;
-	struct cam_fd_device *hw_device;
-	struct cam_fd_hw_deinit_args hw_deinit_args;
 	int rc = 0;
 
 	if (!hw_mgr_priv || !hw_mgr_stop_args) {
@@ -1729,29 +1964,11 @@ static int cam_fd_mgr_hw_stop(void *hw_mgr_priv, void *mgr_stop_args)
 		CAM_ERR(CAM_FD, "Invalid context is used, hw_ctx=%pK", hw_ctx);
 		return -EPERM;
 	}
-	CAM_DBG(CAM_FD, "ctx index=%u, hw_ctx=%d", hw_ctx->ctx_index,
-		hw_ctx->device_index);
-
-	rc = cam_fd_mgr_util_get_device(hw_mgr, hw_ctx, &hw_device);
-	if (rc) {
-		CAM_ERR(CAM_FD, "Error in getting device %d", rc);
-		return rc;
-	}
-
-	CAM_DBG(CAM_FD, "FD Device ready_to_process = %d",
-		hw_device->ready_to_process);
+	CAM_DBG(CAM_FD, "ctx index=%u, hw_ctx=%d, device_mask=0x%x",
+		hw_ctx->ctx_index, hw_ctx->device_index, hw_ctx->device_mask);
 
-	if (hw_device->hw_intf->hw_ops.deinit) {
-		hw_deinit_args.hw_ctx = hw_ctx;
-		hw_deinit_args.ctx_hw_private = hw_ctx->ctx_hw_private;
-		rc = hw_device->hw_intf->hw_ops.deinit(
-			hw_device->hw_intf->hw_priv, &hw_deinit_args,
-			sizeof(hw_deinit_args));
-		if (rc) {
-			CAM_ERR(CAM_FD, "Failed in HW DeInit %d", rc);
-			return rc;
-		}
-	}
+	rc = cam_fd_mgr_util_deinit_devices(hw_mgr, hw_ctx,
+		hw_ctx->device_mask);
 
 	return rc;
 }
@@ -1807,14 +2024,15 @@ static int cam_fd_mgr_hw_prepare_update(void *hw_mgr_priv,
 
 	/* We do not expect any patching, but just do it anyway */
 	rc = cam_packet_util_process_patches(prepare->packet,
-		hw_mgr->device_iommu.non_secure, -1);
+		hw_mgr->device_iommu.non_secure, -1, &hw_ctx->iova_cache);
 	if (rc) {
 		CAM_ERR(CAM_FD, "Patch FD packet failed, rc=%d", rc);
 		return rc;
 	}
 
 	memset(&prestart_args, 0x0, sizeof(prestart_args));
-	prestart_args.ctx_hw_private = hw_ctx->ctx_hw_private;
+	prestart_args.ctx_hw_private =
+		hw_ctx->ctx_hw_private[hw_device->index];
 	prestart_args.hw_ctx = hw_ctx;
 	prestart_args.request_id = prepare->packet->header.request_id;
 
@@ -1854,6 +2072,8 @@ static int cam_fd_mgr_hw_prepare_update(void *hw_mgr_priv,
 	/* Setup frame request info and queue to pending list */
 	frame_req->hw_ctx = hw_ctx;
 	frame_req->request_id = prepare->packet->header.request_id;
+	/* kmd commands are built for default device, may move at submit */
+	frame_req->device_index = hw_device->index;
 	/* This has to be passed to HW while calling hw_ops->start */
 	frame_req->hw_req_private = prestart_args.hw_req_private;
 
@@ -2035,6 +2255,7 @@ int cam_fd_hw_mgr_init(struct device_node *of_node,
 		mutex_init(&hw_device->lock);
 
 		hw_device->valid = true;
+		hw_device->index = i;
 		hw_device->hw_intf = hw_intf;
 		hw_device->ready_to_process = true;
 		hw_device->req_id = -1;
@@ -2119,6 +2340,7 @@ int cam_fd_hw_mgr_init(struct device_node *of_node,
 
 		hw_mgr_ctx->ctx_index = i;
 		hw_mgr_ctx->device_index = -1;
+		hw_mgr_ctx->device_mask = 0;
 		hw_mgr_ctx->hw_mgr = &g_fd_hw_mgr;
 
 		list_add_tail(&hw_mgr_ctx->list, &g_fd_hw_mgr.free_ctx_list);
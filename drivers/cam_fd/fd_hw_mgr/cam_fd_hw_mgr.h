@@ -17,8 +17,9 @@
 #include "cam_hw_mgr_intf.h"
 #include "cam_req_mgr_workq.h"
 #include "cam_fd_hw_intf.h"
+#include "cam_packet_util.h"
 
-#define CAM_FD_HW_MAX            1
+#define CAM_FD_HW_MAX            2
 #define CAM_FD_WORKQ_NUM_TASK    10
 
 /*
@@ -52,9 +53,14 @@ enum cam_fd_mgr_work_type {
  * @hw_mgr          : Pointer to hw manager
  * @get_raw_results : Whether this context needs raw results
  * @mode            : Mode in which this context runs
- * @device_index    : HW Device used by this context
- * @ctx_hw_private  : HW layer's private context pointer for this context
+ * @device_index    : Default HW device of this context, kmd commands are
+ *                    built for this device while preparing a frame
+ * @device_mask     : Mask of HW devices reserved by this context, a frame
+ *                    can be scheduled on any free device in this mask
+ * @ctx_hw_private  : HW layer's private context pointer for this context,
+ *                    one per reserved device
  * @priority        : Priority of this context
+ * @iova_cache      : Patch source buffer iova cache
  */
 struct cam_fd_hw_mgr_ctx {
 	struct list_head               list;
@@ -66,8 +72,10 @@ struct cam_fd_hw_mgr_ctx {
 	bool                           get_raw_results;
 	enum cam_fd_hw_mode            mode;
 	int32_t                        device_index;
-	void                          *ctx_hw_private;
+	uint32_t                       device_mask;
+	void                          *ctx_hw_private[CAM_FD_HW_MAX];
 	uint32_t                       priority;
+	struct cam_packet_iova_cache   iova_cache;
 };
 
 /**
@@ -81,6 +89,7 @@ struct cam_fd_hw_mgr_ctx {
  * @lock             : Lock used for protectin
  * @cur_hw_ctx       : current hw context running in the device
  * @req_id           : current processing req id
+ * @index            : Index of this device in hw mgr device array
  */
 struct cam_fd_device {
 	struct cam_fd_hw_caps     hw_caps;
@@ -91,6 +100,7 @@ struct cam_fd_device {
 	struct mutex              lock;
 	struct cam_fd_hw_mgr_ctx *cur_hw_ctx;
 	int64_t                   req_id;
+	int32_t                   index;
 };
 
 /**
@@ -107,6 +117,9 @@ struct cam_fd_device {
  *                          which needs to be submitted to HW through CDM
  * @num_hw_update_entries : Number of HW update entries
  * @submit_timestamp      : Time stamp for submit req with hw
+ * @device_index          : HW device for which the kmd commands of this
+ *                          request are currently built, and on which the
+ *                          request runs once it is in processing list
  */
 struct cam_fd_mgr_frame_request {
 	struct list_head               list;
@@ -116,17 +129,20 @@ struct cam_fd_mgr_frame_request {
 	struct cam_hw_update_entry     hw_update_entries[CAM_FD_MAX_HW_ENTRIES];
 	uint32_t                       num_hw_update_entries;
 	ktime_t                        submit_timestamp;
+	int32_t                        device_index;
 };
 
 /**
  * struct cam_fd_mgr_work_data : HW Mgr work data information
  *
- * @type     : Type of work
- * @irq_type : IRQ type when this work is queued because of irq callback
+ * @type      : Type of work
+ * @irq_type  : IRQ type when this work is queued because of irq callback
+ * @hw_device : HW device which raised the irq
  */
 struct cam_fd_mgr_work_data {
 	enum cam_fd_mgr_work_type      type;
 	enum cam_fd_hw_irq_type        irq_type;
+	struct cam_fd_device          *hw_device;
 };
 
 /**
@@ -140,8 +156,9 @@ struct cam_fd_mgr_work_data {
  * @frame_pending_list_normal : List of normal priority frame requests pending
  *                              for processing
  * @frame_processing_list     : List of frame requests currently being
- *                              processed currently. Generally maximum one
- *                              request would be present in this list
+ *                              processed. At most one request per device
+ *                              and one request per context would be
+ *                              present in this list
  * @hw_mgr_mutex              : Mutex to protect hw mgr data when accessed
  *                              from multiple threads
  * @hw_mgr_slock              : Spin lock to protect hw mgr data when accessed
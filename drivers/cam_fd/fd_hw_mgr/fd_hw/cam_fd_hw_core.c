@@ -409,6 +409,44 @@ static int cam_fd_hw_util_processcmd_prestart(struct cam_hw_info *fd_hw,
 	return 0;
 }
 
+static int cam_fd_hw_util_processcmd_change_base(struct cam_hw_info *fd_hw,
+	struct cam_fd_hw_cmd_change_base_args *change_base_args)
+{
+	struct cam_hw_soc_info *soc_info = &fd_hw->soc_info;
+	struct cam_fd_ctx_hw_private *ctx_hw_private =
+		change_base_args->ctx_hw_private;
+	uint32_t size, mem_base;
+
+	if (!ctx_hw_private || !change_base_args->cmd_buf_addr) {
+		CAM_ERR(CAM_FD, "Invalid input change base args %pK %pK",
+			ctx_hw_private, change_base_args->cmd_buf_addr);
+		return -EINVAL;
+	}
+
+	if (ctx_hw_private->fd_hw != fd_hw) {
+		CAM_ERR(CAM_FD, "ctx private %pK not reserved on this HW",
+			ctx_hw_private);
+		return -EINVAL;
+	}
+
+	size = ctx_hw_private->cdm_ops->cdm_required_size_changebase();
+	/* cdm util returns dwords, need to convert to bytes */
+	if ((size * 4) > change_base_args->size) {
+		CAM_ERR(CAM_FD, "Insufficient size:%d , expected size:%d",
+			change_base_args->size, size * 4);
+		return -ENOMEM;
+	}
+
+	mem_base = CAM_SOC_GET_REG_MAP_CAM_BASE(soc_info,
+		((struct cam_fd_soc_private *)soc_info->soc_private)->
+		regbase_index[CAM_FD_REG_CORE]);
+
+	ctx_hw_private->cdm_ops->cdm_write_changebase(
+		change_base_args->cmd_buf_addr, mem_base);
+
+	return 0;
+}
+
 static int cam_fd_hw_util_processcmd_frame_done(struct cam_hw_info *fd_hw,
 	struct cam_fd_hw_frame_done_args *frame_done_args)
 {
@@ -1241,6 +1279,22 @@ int cam_fd_hw_process_cmd(void *hw_priv, uint32_t cmd_type,
 			cmd_args);
 		break;
 	}
+	case CAM_FD_HW_CMD_UPDATE_CHANGE_BASE: {
+		struct cam_fd_hw_cmd_change_base_args *change_base_args;
+
+		if (sizeof(struct cam_fd_hw_cmd_change_base_args) !=
+			arg_size) {
+			CAM_ERR(CAM_FD, "cmd_type %d, size mismatch %d",
+				cmd_type, arg_size);
+			break;
+		}
+
+		change_base_args =
+			(struct cam_fd_hw_cmd_change_base_args *)cmd_args;
+		rc = cam_fd_hw_util_processcmd_change_base(fd_hw,
+			change_base_args);
+		break;
+	}
 	default:
 		break;
 	}
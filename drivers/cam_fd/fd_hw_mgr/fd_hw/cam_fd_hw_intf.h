@@ -84,6 +84,9 @@ enum cam_fd_hw_irq_type {
  * @CAM_FD_HW_CMD_REGISTER_CALLBACK : Command to set hw mgr callback
  * @CAM_FD_HW_CMD_MAX               : Indicates max cmd
  * @CAM_FD_HW_CMD_HW_DUMP           : Command to dump fd hw information
+ * @CAM_FD_HW_CMD_UPDATE_CHANGE_BASE: Command to rewrite the change base
+ *                                    command of a prepared request for
+ *                                    this HW
  */
 enum cam_fd_hw_cmd_type {
 	CAM_FD_HW_CMD_PRESTART,
@@ -91,6 +94,7 @@ enum cam_fd_hw_cmd_type {
 	CAM_FD_HW_CMD_UPDATE_SOC,
 	CAM_FD_HW_CMD_REGISTER_CALLBACK,
 	CAM_FD_HW_CMD_HW_DUMP,
+	CAM_FD_HW_CMD_UPDATE_CHANGE_BASE,
 	CAM_FD_HW_CMD_MAX,
 };
 
@@ -276,6 +280,20 @@ struct cam_fd_hw_reset_args {
 	void    *ctx_hw_private;
 };
 
+/**
+ * struct cam_fd_hw_cmd_change_base_args : Update change base command args
+ *
+ * @ctx_hw_private : HW layer's private information specific to this hw
+ *                   context on this HW
+ * @cmd_buf_addr   : Address of the change base command written by prestart
+ * @size           : Size available at cmd_buf_addr in bytes
+ */
+struct cam_fd_hw_cmd_change_base_args {
+	void       *ctx_hw_private;
+	uint32_t   *cmd_buf_addr;
+	uint32_t    size;
+};
+
 /**
  * struct cam_fd_hw_cmd_set_irq_cb : Set IRQ callback command args
  *
@@ -67,6 +67,19 @@ struct hfi_ops {
  */
 int hfi_write_cmd(void *cmd_ptr);
 
+/**
+ * hfi_write_cmd_batch() - function for batched hfi write
+ * @cmd_ptrs: array of pointers to command data for hfi write
+ * @num_cmds: number of commands in cmd_ptrs
+ *
+ * All commands are written into the command queue under a single
+ * lock hold and firmware is interrupted once. Either the whole batch
+ * is queued or none of it is.
+ *
+ * Returns success(zero)/failure(non zero)
+ */
+int hfi_write_cmd_batch(void **cmd_ptrs, uint32_t num_cmds);
+
 /**
  * hfi_read_message() - function for hfi read
  * @pmsg: buffer to place read message for hfi queue
@@ -134,19 +134,51 @@ void cam_hfi_queue_dump(void)
 	hfi_queue_dump(dwords, num_dwords);
 }
 
-int hfi_write_cmd(void *cmd_ptr)
+static uint32_t hfi_copy_cmd(struct hfi_q_hdr *q, uint32_t *write_q,
+	uint32_t write_idx, void *cmd_ptr, uint32_t size_in_words)
 {
-	uint32_t size_in_words, empty_space, new_write_idx, read_idx, temp;
-	uint32_t *write_q, *write_ptr;
+	uint32_t new_write_idx, temp;
+	uint32_t *write_ptr;
+
+	new_write_idx = write_idx + size_in_words;
+	write_ptr = (uint32_t *)(write_q + write_idx);
+
+	if (new_write_idx < q->qhdr_q_size) {
+		memcpy(write_ptr, (uint8_t *)cmd_ptr,
+			size_in_words << BYTE_WORD_SHIFT);
+	} else {
+		new_write_idx -= q->qhdr_q_size;
+		temp = (size_in_words - new_write_idx) << BYTE_WORD_SHIFT;
+		memcpy(write_ptr, (uint8_t *)cmd_ptr, temp);
+		memcpy(write_q, (uint8_t *)cmd_ptr + temp,
+			new_write_idx << BYTE_WORD_SHIFT);
+	}
+
+	return new_write_idx;
+}
+
+int hfi_write_cmd_batch(void **cmd_ptrs, uint32_t num_cmds)
+{
+	uint32_t size_in_words, total_words = 0;
+	uint32_t empty_space, write_idx, read_idx;
+	uint32_t *write_q;
 	struct hfi_qtbl *q_tbl;
 	struct hfi_q_hdr *q;
-	int rc = 0;
+	int i, rc = 0;
 
-	if (!cmd_ptr) {
-		CAM_ERR(CAM_HFI, "command is null");
+	if (!cmd_ptrs || !num_cmds) {
+		CAM_ERR(CAM_HFI, "Invalid commands %pK %u", cmd_ptrs,
+			num_cmds);
 		return -EINVAL;
 	}
 
+	for (i = 0; i < num_cmds; i++) {
+		if (!cmd_ptrs[i]) {
+			CAM_ERR(CAM_HFI, "command %d is null", i);
+			return -EINVAL;
+		}
+	}
+
 	mutex_lock(&hfi_cmd_q_mutex);
 	if (!g_hfi) {
 		CAM_ERR(CAM_HFI, "HFI interface not setup");
@@ -167,36 +199,35 @@ int hfi_write_cmd(void *cmd_ptr)
 
 	write_q = (uint32_t *)g_hfi->map.cmd_q.kva;
 
-	size_in_words = (*(uint32_t *)cmd_ptr) >> BYTE_WORD_SHIFT;
-	if (!size_in_words) {
-		CAM_DBG(CAM_HFI, "failed");
-		rc = -EINVAL;
-		goto err;
+	for (i = 0; i < num_cmds; i++) {
+		size_in_words = (*(uint32_t *)cmd_ptrs[i]) >> BYTE_WORD_SHIFT;
+		if (!size_in_words || (size_in_words >= q->qhdr_q_size)) {
+			CAM_ERR(CAM_HFI, "invalid size_in_words %u, cmd %d",
+				size_in_words, i);
+			rc = -EINVAL;
+			goto err;
+		}
+		total_words += size_in_words;
 	}
 
+	/* Whole batch must fit, a partial batch is never made visible */
 	read_idx = q->qhdr_read_idx;
-	empty_space = (q->qhdr_write_idx >= read_idx) ?
-		(q->qhdr_q_size - (q->qhdr_write_idx - read_idx)) :
-		(read_idx - q->qhdr_write_idx);
-	if (empty_space <= size_in_words) {
-		CAM_ERR(CAM_HFI, "failed: empty space %u, size_in_words %u",
-			empty_space, size_in_words);
+	write_idx = q->qhdr_write_idx;
+	empty_space = (write_idx >= read_idx) ?
+		(q->qhdr_q_size - (write_idx - read_idx)) :
+		(read_idx - write_idx);
+	if (empty_space <= total_words) {
+		CAM_ERR(CAM_HFI,
+			"failed: empty space %u, size_in_words %u, num cmds %u",
+			empty_space, total_words, num_cmds);
 		rc = -EIO;
 		goto err;
 	}
 
-	new_write_idx = q->qhdr_write_idx + size_in_words;
-	write_ptr = (uint32_t *)(write_q + q->qhdr_write_idx);
-
-	if (new_write_idx < q->qhdr_q_size) {
-		memcpy(write_ptr, (uint8_t *)cmd_ptr,
-			size_in_words << BYTE_WORD_SHIFT);
-	} else {
-		new_write_idx -= q->qhdr_q_size;
-		temp = (size_in_words - new_write_idx) << BYTE_WORD_SHIFT;
-		memcpy(write_ptr, (uint8_t *)cmd_ptr, temp);
-		memcpy(write_q, (uint8_t *)cmd_ptr + temp,
-			new_write_idx << BYTE_WORD_SHIFT);
+	for (i = 0; i < num_cmds; i++) {
+		size_in_words = (*(uint32_t *)cmd_ptrs[i]) >> BYTE_WORD_SHIFT;
+		write_idx = hfi_copy_cmd(q, write_q, write_idx, cmd_ptrs[i],
+			size_in_words);
 	}
 
 	/*
@@ -205,7 +236,7 @@ int hfi_write_cmd(void *cmd_ptr)
 	 */
 	wmb();
 
-	q->qhdr_write_idx = new_write_idx;
+	q->qhdr_write_idx = write_idx;
 
 	/*
 	 * Before raising interrupt make sure command data is ready for
@@ -218,6 +249,16 @@ err:
 	return rc;
 }
 
+int hfi_write_cmd(void *cmd_ptr)
+{
+	if (!cmd_ptr) {
+		CAM_ERR(CAM_HFI, "command is null");
+		return -EINVAL;
+	}
+
+	return hfi_write_cmd_batch(&cmd_ptr, 1);
+}
+
 int hfi_read_message(uint32_t *pmsg, uint8_t q_id,
 	uint32_t *words_read)
 {
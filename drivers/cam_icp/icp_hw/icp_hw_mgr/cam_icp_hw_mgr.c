@@ -274,19 +274,60 @@ static int cam_icp_supported_clk_rates(struct cam_icp_hw_mgr *hw_mgr,
 	return 0;
 }
 
-static int cam_icp_clk_idx_from_req_id(struct cam_icp_hw_ctx_data *ctx_data,
-	uint64_t req_id)
+static void cam_icp_frame_req_table_init(
+	struct hfi_frame_process_info *frame_process)
 {
-	struct hfi_frame_process_info *frame_process;
 	int i;
 
-	frame_process = &ctx_data->hfi_frame_process;
+	hash_init(frame_process->req_table);
+	for (i = 0; i < CAM_FRAME_CMD_MAX; i++) {
+		INIT_HLIST_NODE(&frame_process->req_entry[i].hentry);
+		frame_process->req_entry[i].idx = i;
+	}
+}
 
-	for (i = 0; i < CAM_FRAME_CMD_MAX; i++)
-		if (frame_process->request_id[i] == req_id)
-			return i;
+static void cam_icp_frame_req_add(
+	struct hfi_frame_process_info *frame_process, int idx,
+	uint64_t request_id)
+{
+	frame_process->request_id[idx] = request_id;
+	hash_add(frame_process->req_table,
+		&frame_process->req_entry[idx].hentry, request_id);
+}
 
-	return 0;
+static void cam_icp_frame_req_del(
+	struct hfi_frame_process_info *frame_process, int idx)
+{
+	struct hlist_node *hentry = &frame_process->req_entry[idx].hentry;
+
+	if (hash_hashed(hentry))
+		hash_del(hentry);
+}
+
+static int cam_icp_frame_req_find(
+	struct hfi_frame_process_info *frame_process, uint64_t request_id)
+{
+	struct hfi_frame_req_entry *entry;
+
+	hash_for_each_possible(frame_process->req_table, entry, hentry,
+		request_id) {
+		if (frame_process->request_id[entry->idx] == request_id)
+			return entry->idx;
+	}
+
+	return -ENOENT;
+}
+
+static int cam_icp_clk_idx_from_req_id(struct cam_icp_hw_ctx_data *ctx_data,
+	uint64_t req_id)
+{
+	int idx;
+
+	idx = cam_icp_frame_req_find(&ctx_data->hfi_frame_process, req_id);
+	if (idx < 0)
+		return 0;
+
+	return idx;
 }
 
 static int cam_icp_ctx_clk_info_init(struct cam_icp_hw_ctx_data *ctx_data)
@@ -875,7 +916,8 @@ static bool cam_icp_busy_prev_reqs(struct hfi_frame_process_info *frm_process,
 	int i;
 	int cnt;
 
-	for (i = 0, cnt = 0; i < CAM_FRAME_CMD_MAX; i++) {
+	cnt = 0;
+	for_each_set_bit(i, frm_process->bitmap, CAM_FRAME_CMD_MAX) {
 		if (frm_process->request_id[i]) {
 			if (frm_process->fw_process_flag[i]) {
 				CAM_DBG(CAM_PERF, "r id = %lld busy = %d",
@@ -1965,6 +2007,48 @@ static int cam_icp_mgr_process_cmd(void *priv, void *data)
 	return rc;
 }
 
+static int cam_icp_mgr_process_frame_cmds(void *priv, void *data)
+{
+	int i, rc = 0;
+	uint32_t num_cmds;
+	unsigned long flags;
+	void **frame_cmds;
+	struct cam_icp_hw_mgr *hw_mgr;
+
+	if (!data || !priv) {
+		CAM_ERR(CAM_ICP, "Invalid params%pK %pK", data, priv);
+		return -EINVAL;
+	}
+
+	hw_mgr = priv;
+	frame_cmds = hw_mgr->frame_cmds_drain;
+
+	spin_lock_irqsave(&hw_mgr->frame_cmd_lock, flags);
+	num_cmds = hw_mgr->num_frame_cmds;
+	memcpy(frame_cmds, hw_mgr->frame_cmds, num_cmds * sizeof(void *));
+	hw_mgr->num_frame_cmds = 0;
+	spin_unlock_irqrestore(&hw_mgr->frame_cmd_lock, flags);
+
+	/* Commands already drained by an earlier task */
+	if (!num_cmds)
+		return 0;
+
+	CAM_DBG(CAM_ICP, "writing %u frame cmds", num_cmds);
+	rc = hfi_write_cmd_batch(frame_cmds, num_cmds);
+	if (!rc)
+		return 0;
+
+	/* Nothing of a failed batch is written, retry one by one */
+	for (i = 0; i < num_cmds; i++) {
+		rc = hfi_write_cmd(frame_cmds[i]);
+		if (rc)
+			CAM_ERR(CAM_ICP, "frame cmd %d/%u write failed %d",
+				i, num_cmds, rc);
+	}
+
+	return rc;
+}
+
 static int cam_icp_mgr_cleanup_ctx(struct cam_icp_hw_ctx_data *ctx_data)
 {
 	int i;
@@ -1972,12 +2056,13 @@ static int cam_icp_mgr_cleanup_ctx(struct cam_icp_hw_ctx_data *ctx_data)
 	struct cam_hw_done_event_data buf_data;
 
 	hfi_frame_process = &ctx_data->hfi_frame_process;
-	for (i = 0; i < CAM_FRAME_CMD_MAX; i++) {
+	for_each_set_bit(i, hfi_frame_process->bitmap, CAM_FRAME_CMD_MAX) {
 		if (!hfi_frame_process->request_id[i])
 			continue;
 		buf_data.request_id = hfi_frame_process->request_id[i];
 		ctx_data->ctxt_event_cb(ctx_data->context_priv,
 			CAM_CTX_EVT_ID_SUCCESS, &buf_data);
+		cam_icp_frame_req_del(hfi_frame_process, i);
 		hfi_frame_process->request_id[i] = 0;
 		if (ctx_data->hfi_frame_process.in_resource[i] > 0) {
 			CAM_DBG(CAM_ICP, "Delete merged sync in object: %d",
@@ -2108,11 +2193,8 @@ static int cam_icp_mgr_handle_frame_process(uint32_t *msg_ptr, int flag)
 	cam_icp_device_timer_reset(&icp_hw_mgr, clk_type);
 
 	hfi_frame_process = &ctx_data->hfi_frame_process;
-	for (i = 0; i < CAM_FRAME_CMD_MAX; i++)
-		if (hfi_frame_process->request_id[i] == request_id)
-			break;
-
-	if (i >= CAM_FRAME_CMD_MAX) {
+	i = cam_icp_frame_req_find(hfi_frame_process, request_id);
+	if (i < 0) {
 		CAM_ERR(CAM_ICP, "pkt not found in ctx data for req_id =%lld",
 			request_id);
 		mutex_unlock(&ctx_data->ctx_mutex);
@@ -2145,6 +2227,7 @@ static int cam_icp_mgr_handle_frame_process(uint32_t *msg_ptr, int flag)
 
 	buf_data.request_id = hfi_frame_process->request_id[idx];
 	ctx_data->ctxt_event_cb(ctx_data->context_priv, event_id, &buf_data);
+	cam_icp_frame_req_del(hfi_frame_process, idx);
 	hfi_frame_process->request_id[idx] = 0;
 	if (ctx_data->hfi_frame_process.in_resource[idx] > 0) {
 		CAM_DBG(CAM_ICP, "Delete merged sync in object: %d",
@@ -3433,8 +3516,11 @@ static int cam_icp_mgr_release_ctx(struct cam_icp_hw_mgr *hw_mgr, int ctx_id)
 	hw_mgr->ctx_data[ctx_id].fw_handle = 0;
 	hw_mgr->ctx_data[ctx_id].scratch_mem_size = 0;
 	hw_mgr->ctx_data[ctx_id].last_flush_req = 0;
-	for (i = 0; i < CAM_FRAME_CMD_MAX; i++)
+	for (i = 0; i < CAM_FRAME_CMD_MAX; i++) {
+		cam_icp_frame_req_del(&hw_mgr->ctx_data[ctx_id].hfi_frame_process,
+			i);
 		clear_bit(i, hw_mgr->ctx_data[ctx_id].hfi_frame_process.bitmap);
+	}
 	kfree(hw_mgr->ctx_data[ctx_id].hfi_frame_process.bitmap);
 	hw_mgr->ctx_data[ctx_id].hfi_frame_process.bitmap = NULL;
 	cam_icp_hw_mgr_clk_info_update(hw_mgr, &hw_mgr->ctx_data[ctx_id]);
@@ -3890,6 +3976,7 @@ static int cam_icp_mgr_handle_config_err(
 	ctx_data->ctxt_event_cb(ctx_data->context_priv, CAM_CTX_EVT_ID_SUCCESS,
 		&buf_data);
 
+	cam_icp_frame_req_del(&ctx_data->hfi_frame_process, idx);
 	ctx_data->hfi_frame_process.request_id[idx] = 0;
 	ctx_data->hfi_frame_process.fw_process_flag[idx] = false;
 	clear_bit(idx, ctx_data->hfi_frame_process.bitmap);
@@ -3900,8 +3987,9 @@ static int cam_icp_mgr_handle_config_err(
 static int cam_icp_mgr_enqueue_config(struct cam_icp_hw_mgr *hw_mgr,
 	struct cam_hw_config_args *config_args)
 {
-	int rc = 0;
+	int i, rc = 0;
 	uint64_t request_id = 0;
+	unsigned long flags;
 	struct crm_workq_task *task;
 	struct hfi_cmd_work_data *task_data;
 	struct hfi_cmd_ipebps_async *hfi_cmd;
@@ -3919,14 +4007,43 @@ static int cam_icp_mgr_enqueue_config(struct cam_icp_hw_mgr *hw_mgr,
 		return -ENOMEM;
 	}
 
+	/*
+	 * Every pending command holds a cmd_work task until it is drained,
+	 * so the pending array cannot outgrow the task pool.
+	 */
+	spin_lock_irqsave(&hw_mgr->frame_cmd_lock, flags);
+	hw_mgr->frame_cmds[hw_mgr->num_frame_cmds++] =
+		(void *)hw_update_entries->addr;
+	spin_unlock_irqrestore(&hw_mgr->frame_cmd_lock, flags);
+
 	task_data = (struct hfi_cmd_work_data *)task->payload;
 	task_data->data = (void *)hw_update_entries->addr;
 	hfi_cmd = (struct hfi_cmd_ipebps_async *)hw_update_entries->addr;
 	task_data->request_id = request_id;
 	task_data->type = ICP_WORKQ_TASK_CMD_TYPE;
-	task->process_cb = cam_icp_mgr_process_cmd;
+	task->process_cb = cam_icp_mgr_process_frame_cmds;
 	rc = cam_req_mgr_workq_enqueue_task(task, &icp_hw_mgr,
 		CRM_TASK_PRIORITY_0);
+	if (rc) {
+		/*
+		 * Drop the command unless a task already in the
+		 * workq has picked it up with its batch.
+		 */
+		spin_lock_irqsave(&hw_mgr->frame_cmd_lock, flags);
+		for (i = 0; i < hw_mgr->num_frame_cmds; i++) {
+			if (hw_mgr->frame_cmds[i] == task_data->data)
+				break;
+		}
+		if (i < hw_mgr->num_frame_cmds) {
+			hw_mgr->num_frame_cmds--;
+			memmove(&hw_mgr->frame_cmds[i],
+				&hw_mgr->frame_cmds[i + 1],
+				(hw_mgr->num_frame_cmds - i) * sizeof(void *));
+		} else {
+			rc = 0;
+		}
+		spin_unlock_irqrestore(&hw_mgr->frame_cmd_lock, flags);
+	}
 
 	return rc;
 }
@@ -4735,14 +4852,15 @@ static int cam_icp_mgr_update_hfi_frame_process(
 	}
 	set_bit(index, ctx_data->hfi_frame_process.bitmap);
 
-	ctx_data->hfi_frame_process.request_id[index] =
-		packet->header.request_id;
+	cam_icp_frame_req_add(&ctx_data->hfi_frame_process, index,
+		packet->header.request_id);
 	ctx_data->hfi_frame_process.frame_info[index].request_id =
 		packet->header.request_id;
 	ctx_data->hfi_frame_process.frame_info[index].io_config = 0;
 	rc = cam_icp_process_generic_cmd_buffer(packet, ctx_data, index,
 		&ctx_data->hfi_frame_process.frame_info[index].io_config);
 	if (rc) {
+		cam_icp_frame_req_del(&ctx_data->hfi_frame_process, index);
 		clear_bit(index, ctx_data->hfi_frame_process.bitmap);
 		ctx_data->hfi_frame_process.request_id[index] = -1;
 		return rc;
@@ -4938,7 +5056,7 @@ static int cam_icp_mgr_prepare_hw_update(void *hw_mgr_priv,
 		packet->header.request_id, ctx_data->ctx_id);
 	/* Update Buffer Address from handles and patch information */
 	rc = cam_packet_util_process_patches(packet, hw_mgr->iommu_hdl,
-		hw_mgr->iommu_sec_hdl);
+		hw_mgr->iommu_sec_hdl, &ctx_data->iova_cache);
 	if (rc) {
 		mutex_unlock(&ctx_data->ctx_mutex);
 		return rc;
@@ -4957,6 +5075,7 @@ static int cam_icp_mgr_prepare_hw_update(void *hw_mgr_priv,
 		if (ctx_data->hfi_frame_process.in_resource[idx] > 0)
 			cam_sync_destroy(
 				ctx_data->hfi_frame_process.in_resource[idx]);
+		cam_icp_frame_req_del(&ctx_data->hfi_frame_process, idx);
 		clear_bit(idx, ctx_data->hfi_frame_process.bitmap);
 		ctx_data->hfi_frame_process.request_id[idx] = -1;
 		mutex_unlock(&ctx_data->ctx_mutex);
@@ -4986,7 +5105,7 @@ static int cam_icp_mgr_send_abort_status(struct cam_icp_hw_ctx_data *ctx_data)
 
 	mutex_lock(&ctx_data->ctx_mutex);
 	hfi_frame_process = &ctx_data->hfi_frame_process;
-	for (idx = 0; idx < CAM_FRAME_CMD_MAX; idx++) {
+	for_each_set_bit(idx, hfi_frame_process->bitmap, CAM_FRAME_CMD_MAX) {
 		if (!hfi_frame_process->request_id[idx])
 			continue;
 
@@ -4995,6 +5114,7 @@ static int cam_icp_mgr_send_abort_status(struct cam_icp_hw_ctx_data *ctx_data)
 			&hfi_frame_process->request_id[idx]);
 
 		/* now release memory for hfi frame process command */
+		cam_icp_frame_req_del(hfi_frame_process, idx);
 		hfi_frame_process->request_id[idx] = 0;
 		if (ctx_data->hfi_frame_process.in_resource[idx] > 0) {
 			CAM_DBG(CAM_ICP, "Delete merged sync in object: %d",
@@ -5073,11 +5193,12 @@ static int cam_icp_mgr_flush_all(struct cam_icp_hw_ctx_data *ctx_data,
 	bool clear_in_resource = false;
 
 	hfi_frame_process = &ctx_data->hfi_frame_process;
-	for (idx = 0; idx < CAM_FRAME_CMD_MAX; idx++) {
+	for_each_set_bit(idx, hfi_frame_process->bitmap, CAM_FRAME_CMD_MAX) {
 		if (!hfi_frame_process->request_id[idx])
 			continue;
 
 		/* now release memory for hfi frame process command */
+		cam_icp_frame_req_del(hfi_frame_process, idx);
 		hfi_frame_process->request_id[idx] = 0;
 		if (ctx_data->hfi_frame_process.in_resource[idx] > 0) {
 			ctx_data->hfi_frame_process.in_free_resource[idx] =
@@ -5104,14 +5225,10 @@ static int cam_icp_mgr_flush_req(struct cam_icp_hw_ctx_data *ctx_data,
 
 	hfi_frame_process = &ctx_data->hfi_frame_process;
 	request_id = *(int64_t *)flush_args->flush_req_pending[0];
-	for (idx = 0; idx < CAM_FRAME_CMD_MAX; idx++) {
-		if (!hfi_frame_process->request_id[idx])
-			continue;
-
-		if (hfi_frame_process->request_id[idx] != request_id)
-			continue;
-
+	idx = cam_icp_frame_req_find(hfi_frame_process, request_id);
+	if ((idx >= 0) && hfi_frame_process->request_id[idx]) {
 		/* now release memory for hfi frame process command */
+		cam_icp_frame_req_del(hfi_frame_process, idx);
 		hfi_frame_process->request_id[idx] = 0;
 		if (ctx_data->hfi_frame_process.in_resource[idx] > 0) {
 			ctx_data->hfi_frame_process.in_free_resource[idx] =
@@ -5217,14 +5334,10 @@ static int cam_icp_mgr_hw_dump(void *hw_priv, void *hw_dump_args)
 	ctx_data = dump_args->ctxt_to_hw_map;
 	CAM_DBG(CAM_ICP, "Req %lld", dump_args->request_id);
 	frm_process = &ctx_data->hfi_frame_process;
-	for (i = 0; i < CAM_FRAME_CMD_MAX; i++) {
-		if ((frm_process->request_id[i] ==
-			dump_args->request_id) &&
-			frm_process->fw_process_flag[i])
-			goto hw_dump;
-	}
-	return 0;
-hw_dump:
+	i = cam_icp_frame_req_find(frm_process, dump_args->request_id);
+	if ((i < 0) || !frm_process->fw_process_flag[i])
+		return 0;
+
 	cur_time = ktime_get();
 	diff = ktime_us_delta(frm_process->submit_timestamp[i], cur_time);
 	cur_ts = ktime_to_timespec64(cur_time);
@@ -5765,6 +5878,7 @@ static int cam_icp_mgr_acquire_hw(void *hw_mgr_priv, void *acquire_hw_args)
 	}
 
 	ctx_data->hfi_frame_process.bits = bitmap_size * BITS_PER_BYTE;
+	cam_icp_frame_req_table_init(&ctx_data->hfi_frame_process);
 	hw_mgr->ctx_data[ctx_id].ctxt_event_cb = args->event_cb;
 	icp_dev_acquire_info->scratch_mem_size = ctx_data->scratch_mem_size;
 
@@ -6173,6 +6287,7 @@ int cam_icp_hw_mgr_init(struct device_node *of_node, uint64_t *hw_mgr_hdl,
 	icp_hw_mgr.secure_mode = CAM_SECURE_MODE_NON_SECURE;
 	mutex_init(&icp_hw_mgr.hw_mgr_mutex);
 	spin_lock_init(&icp_hw_mgr.hw_mgr_lock);
+	spin_lock_init(&icp_hw_mgr.frame_cmd_lock);
 
 	for (i = 0; i < CAM_ICP_CTX_MAX; i++)
 		mutex_init(&icp_hw_mgr.ctx_data[i].ctx_mutex);
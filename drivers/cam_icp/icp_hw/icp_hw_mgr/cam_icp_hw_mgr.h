@@ -8,6 +8,7 @@
 
 #include <linux/types.h>
 #include <linux/completion.h>
+#include <linux/hashtable.h>
 #include <media/cam_icp.h>
 #include "cam_icp_hw_intf.h"
 #include "cam_hw_mgr_intf.h"
@@ -19,11 +20,13 @@
 #include "cam_smmu_api.h"
 #include "cam_soc_util.h"
 #include "cam_req_mgr_timer.h"
+#include "cam_packet_util.h"
 
 #define CAM_ICP_ROLE_PARENT     1
 #define CAM_ICP_ROLE_CHILD      2
 
 #define CAM_FRAME_CMD_MAX       40
+#define CAM_FRAME_REQ_HASH_BITS 6
 
 #define CAM_MAX_OUT_RES         6
 #define CAM_MAX_IN_RES          8
@@ -164,6 +167,16 @@ struct cam_icp_clk_bw_req_internal_v2 {
 	struct cam_axi_per_path_bw_vote axi_path[CAM_ICP_MAX_PER_PATH_VOTES];
 };
 
+/**
+ * struct hfi_frame_req_entry
+ * @hentry: Node in request table of hfi frame process info
+ * @idx: Index of hfi_frame_cmd this entry stands for
+ */
+struct hfi_frame_req_entry {
+	struct hlist_node hentry;
+	uint32_t idx;
+};
+
 /**
  * struct hfi_frame_process_info
  * @hfi_frame_cmd: Frame process command info
@@ -178,6 +191,9 @@ struct cam_icp_clk_bw_req_internal_v2 {
  * @clk_info_v2: Clock info for AXI bw voting v2
  * @frame_info: information needed to process request
  * @submit_timestamp: Submit timestamp to hw
+ * @req_entry: Request table entries, one per hfi_frame_cmd
+ * @req_table: Request table of pending frames keyed by request id, which
+ *             is also the user data cookie echoed back by HFI acks
  */
 struct hfi_frame_process_info {
 	struct hfi_cmd_ipebps_async hfi_frame_cmd[CAM_FRAME_CMD_MAX];
@@ -194,6 +210,8 @@ struct hfi_frame_process_info {
 	struct cam_icp_clk_bw_req_internal_v2 clk_info_v2[CAM_FRAME_CMD_MAX];
 	struct icp_frame_info frame_info[CAM_FRAME_CMD_MAX];
 	ktime_t submit_timestamp[CAM_FRAME_CMD_MAX];
+	struct hfi_frame_req_entry req_entry[CAM_FRAME_CMD_MAX];
+	DECLARE_HASHTABLE(req_table, CAM_FRAME_REQ_HASH_BITS);
 };
 
 /**
@@ -243,6 +261,7 @@ struct cam_ctx_clk_info {
  * @watch_dog_reset_counter: Counter for watch dog reset
  * @icp_dev_io_info: io config resource
  * @last_flush_req: last flush req for this ctx
+ * @iova_cache: Patch source buffer iova cache
  */
 struct cam_icp_hw_ctx_data {
 	void *context_priv;
@@ -265,6 +284,7 @@ struct cam_icp_hw_ctx_data {
 	uint32_t watch_dog_reset_counter;
 	struct cam_icp_acquire_dev_info icp_dev_io_info;
 	uint64_t last_flush_req;
+	struct cam_packet_iova_cache iova_cache;
 };
 
 /**
@@ -356,6 +376,10 @@ struct cam_icp_clk_info {
  * @recovery: Flag to validate if in previous session FW
  *            reported a fatal error or wdt. If set FW is
  *            re-downloaded for new camera session.
+ * @frame_cmd_lock: Lock for pending frame commands
+ * @frame_cmds: Frame process commands waiting to be written to HFI
+ * @num_frame_cmds: Number of pending frame commands
+ * @frame_cmds_drain: Frame commands drained by the cmd workq worker
  */
 struct cam_icp_hw_mgr {
 	struct mutex hw_mgr_mutex;
@@ -403,6 +427,10 @@ struct cam_icp_hw_mgr {
 	bool bps_clk_state;
 	bool disable_ubwc_comp;
 	atomic_t recovery;
+	spinlock_t frame_cmd_lock;
+	void *frame_cmds[ICP_WORKQ_NUM_TASK];
+	uint32_t num_frame_cmds;
+	void *frame_cmds_drain[ICP_WORKQ_NUM_TASK];
 };
 
 static int cam_icp_mgr_hw_close(void *hw_priv, void *hw_close_args);
@@ -38,6 +38,9 @@ static int cam_isp_context_dump_requests(void *data,
 static int cam_isp_context_handle_message(void *context,
 	uint32_t msg_type, uint32_t *data);
 
+static int __cam_isp_ctx_schedule_apply_req_offline(
+	struct cam_isp_context *ctx_isp);
+
 static int __cam_isp_ctx_start_dev_in_ready(struct cam_context *ctx,
 	struct cam_start_stop_dev_cmd *cmd);
 
@@ -816,6 +819,35 @@ static void __cam_isp_ctx_handle_buf_done_fail_log(
 	}
 }
 
+static inline int32_t __cam_isp_ctx_offline_depth(void)
+{
+	if (!isp_ctx_debug.offline_depth)
+		return CAM_ISP_CTX_OFFLINE_DEFAULT_DEPTH;
+
+	return min_t(uint32_t, isp_ctx_debug.offline_depth,
+		CAM_ISP_CTX_OFFLINE_MAX_DEPTH);
+}
+
+static void __cam_isp_ctx_offline_req_done(
+	struct cam_isp_context *ctx_isp)
+{
+	struct cam_isp_ctx_offline_stats *stats = &ctx_isp->offline_stats;
+	ktime_t cur_time = ktime_get();
+
+	if (!stats->num_frames)
+		stats->first_done_ts = cur_time;
+	stats->last_done_ts = cur_time;
+	stats->num_frames++;
+
+	/*
+	 * An apply skipped because the depth was exhausted is not retried
+	 * on the next epoch if nothing else got applied, retry it here.
+	 */
+	if (atomic_read(&ctx_isp->rxd_epoch) &&
+		!list_empty(&ctx_isp->base->pending_req_list))
+		__cam_isp_ctx_schedule_apply_req_offline(ctx_isp);
+}
+
 static int __cam_isp_ctx_handle_buf_done_for_req_list(
 	struct cam_isp_context *ctx_isp,
 	struct cam_ctx_request *req)
@@ -883,11 +915,16 @@ static int __cam_isp_ctx_handle_buf_done_for_req_list(
 			req_isp->bubble_detected = false;
 		}
 
+		cam_common_lat_stamp(&ctx_isp->lat_tracker, buf_done_req_id,
+			CAM_COMMON_LAT_FENCE_SIGNAL);
 		CAM_DBG(CAM_REQ,
 			"Move active request %lld to free list(cnt = %d) [all fences done], ctx %u",
 			buf_done_req_id, ctx_isp->active_req_cnt, ctx->ctx_id);
 		ctx_isp->req_info.last_bufdone_req_id = req->request_id;
 		ctx_isp->last_bufdone_err_apply_req_id = 0;
+
+		if (ctx_isp->offline_context)
+			__cam_isp_ctx_offline_req_done(ctx_isp);
 	}
 
 	cam_cpas_notify_event("IFE BufDone", buf_done_req_id);
@@ -943,6 +980,8 @@ static int __cam_isp_ctx_handle_buf_done_for_request(
 	trace_cam_buf_done("ISP", ctx, req);
 
 	req_isp = (struct cam_isp_ctx_req *) req->req_priv;
+	cam_common_lat_stamp(&ctx_isp->lat_tracker, req->request_id,
+		CAM_COMMON_LAT_BUF_DONE);
 
 	CAM_DBG(CAM_ISP,
 		"Enter with bubble_state %d, req_bubble_detected %d evt_param = %d",
@@ -1176,6 +1215,8 @@ static int __cam_isp_ctx_handle_buf_done_for_request_verify_addr(
 	trace_cam_buf_done("ISP", ctx, req);
 
 	req_isp = (struct cam_isp_ctx_req *) req->req_priv;
+	cam_common_lat_stamp(&ctx_isp->lat_tracker, req->request_id,
+		CAM_COMMON_LAT_BUF_DONE);
 
 	CAM_DBG(CAM_ISP,
 		"Enter with bubble_state %d, req_bubble_detected %d evt_param %d",
@@ -1655,7 +1696,7 @@ static int __cam_isp_ctx_apply_req_offline(
 		(ctx_isp->substate_activated == CAM_ISP_CTX_ACTIVATED_APPLIED))
 		goto end;
 
-	if (ctx_isp->active_req_cnt >= 2)
+	if (ctx_isp->active_req_cnt >= __cam_isp_ctx_offline_depth())
 		goto end;
 
 	spin_lock_bh(&ctx->lock);
@@ -1694,6 +1735,8 @@ static int __cam_isp_ctx_apply_req_offline(
 
 	spin_unlock_bh(&ctx->lock);
 
+	cam_common_lat_stamp(&ctx_isp->lat_tracker, req->request_id,
+		CAM_COMMON_LAT_APPLY);
 	rc = ctx->hw_mgr_intf->hw_config(ctx->hw_mgr_intf->hw_mgr_priv, &cfg);
 	if (rc) {
 		CAM_ERR_RATE_LIMIT(CAM_ISP, "Can not apply the configuration");
@@ -1709,6 +1752,8 @@ static int __cam_isp_ctx_apply_req_offline(
 		spin_unlock_bh(&ctx->lock);
 	} else {
 		atomic_set(&ctx_isp->apply_in_progress, 0);
+		cam_common_lat_stamp(&ctx_isp->lat_tracker, req->request_id,
+			CAM_COMMON_LAT_CDM_SUBMIT);
 		CAM_DBG(CAM_ISP, "New substate state %d, applied req %lld",
 			CAM_ISP_CTX_ACTIVATED_APPLIED,
 			ctx_isp->last_applied_req_id);
@@ -2059,11 +2104,10 @@ static int __cam_isp_ctx_sof_in_activated_state(
 	 * from wait to active list. This could happen if REG_UPDATE to sw
 	 * is coming immediately after SOF
 	 */
-	if (request_id == 0) {
+	if ((request_id == 0) && !list_empty(&ctx->wait_req_list)) {
 		req = list_first_entry(&ctx->wait_req_list,
 			struct cam_ctx_request, list);
-		if (req)
-			request_id = req->request_id;
+		request_id = req->request_id;
 	}
 
 	if (!evt_data) {
@@ -2077,6 +2121,8 @@ static int __cam_isp_ctx_sof_in_activated_state(
 
 	__cam_isp_ctx_update_state_monitor_array(ctx_isp,
 		CAM_ISP_STATE_CHANGE_TRIGGER_SOF, request_id);
+	cam_common_lat_stamp(&ctx_isp->lat_tracker, request_id,
+		CAM_COMMON_LAT_SOF);
 
 	CAM_DBG(CAM_ISP, "frame id: %lld time stamp:0x%llx, ctx %u",
 		ctx_isp->frame_id, ctx_isp->sof_timestamp_val, ctx->ctx_id);
@@ -2316,12 +2362,15 @@ static int __cam_isp_ctx_sof_in_epoch(struct cam_isp_context *ctx_isp,
 	else
 		CAM_DBG(CAM_ISP, "Still need to wait for the buf done");
 
-	req = list_last_entry(&ctx->active_req_list,
-		struct cam_ctx_request, list);
-	if (req)
+	if (!list_empty(&ctx->active_req_list)) {
+		req = list_last_entry(&ctx->active_req_list,
+			struct cam_ctx_request, list);
 		__cam_isp_ctx_update_state_monitor_array(ctx_isp,
 			CAM_ISP_STATE_CHANGE_TRIGGER_SOF,
 			req->request_id);
+		cam_common_lat_stamp(&ctx_isp->lat_tracker, req->request_id,
+			CAM_COMMON_LAT_SOF);
+	}
 
 	if (ctx_isp->frame_id == 1)
 		CAM_INFO(CAM_ISP,
@@ -3341,8 +3390,12 @@ static int __cam_isp_ctx_apply_req_in_activated_state(
 
 	atomic_set(&ctx_isp->apply_in_progress, 1);
 
+	cam_common_lat_stamp(&ctx_isp->lat_tracker, req->request_id,
+		CAM_COMMON_LAT_APPLY);
 	rc = ctx->hw_mgr_intf->hw_config(ctx->hw_mgr_intf->hw_mgr_priv, &cfg);
 	if (!rc) {
+		cam_common_lat_stamp(&ctx_isp->lat_tracker, req->request_id,
+			CAM_COMMON_LAT_CDM_SUBMIT);
 		spin_lock_bh(&ctx->lock);
 		ctx_isp->substate_activated = next_state;
 		ctx_isp->last_applied_req_id = apply->request_id;
@@ -3512,6 +3565,66 @@ static int __cam_isp_ctx_dump_req_info(
 	return rc;
 }
 
+static int __cam_isp_ctx_dump_offline_stats(
+	struct cam_isp_context *ctx_isp,
+	uintptr_t               cpu_addr,
+	size_t                  buf_len,
+	size_t                 *offset)
+{
+	uint8_t                            *dst;
+	uint64_t                           *addr, *start;
+	uint64_t                            window_us, fps_x100 = 0;
+	uint32_t                            min_len;
+	size_t                              remain_len;
+	struct cam_isp_ctx_offline_stats   *stats = &ctx_isp->offline_stats;
+	struct cam_isp_context_dump_header *hdr;
+
+	if (buf_len <= *offset) {
+		CAM_WARN(CAM_ISP, "Dump buffer overshoot len %zu offset %zu",
+			buf_len, *offset);
+		return -ENOSPC;
+	}
+
+	remain_len = buf_len - *offset;
+	min_len = sizeof(struct cam_isp_context_dump_header) +
+		(CAM_ISP_CTX_DUMP_OFFLINE_NUM_WORDS * sizeof(uint64_t));
+
+	if (remain_len < min_len) {
+		CAM_WARN(CAM_ISP, "Dump buffer exhaust remain %zu min %u",
+			remain_len, min_len);
+		return -ENOSPC;
+	}
+
+	window_us = ktime_us_delta(stats->last_done_ts, stats->first_done_ts);
+	if ((stats->num_frames > 1) && window_us)
+		fps_x100 = div64_u64((stats->num_frames - 1) *
+			USEC_PER_SEC * 100, window_us);
+
+	CAM_INFO(CAM_ISP,
+		"Offline ctx %u frames %llu fps %llu.%02llu depth %d active %d",
+		ctx_isp->base->ctx_id, stats->num_frames, fps_x100 / 100,
+		fps_x100 % 100, __cam_isp_ctx_offline_depth(),
+		ctx_isp->active_req_cnt);
+
+	dst = (uint8_t *)cpu_addr + *offset;
+	hdr = (struct cam_isp_context_dump_header *)dst;
+	scnprintf(hdr->tag, CAM_ISP_CONTEXT_DUMP_TAG_MAX_LEN,
+		"ISP_OFFLINE_STATS:");
+	hdr->word_size = sizeof(uint64_t);
+	addr = (uint64_t *)(dst +
+		sizeof(struct cam_isp_context_dump_header));
+	start = addr;
+	*addr++ = stats->num_frames;
+	*addr++ = fps_x100;
+	*addr++ = window_us;
+	*addr++ = __cam_isp_ctx_offline_depth();
+	*addr++ = ctx_isp->active_req_cnt;
+	hdr->size = hdr->word_size * (addr - start);
+	*offset += hdr->size + sizeof(struct cam_isp_context_dump_header);
+
+	return 0;
+}
+
 static int __cam_isp_ctx_dump_in_top_state(
 	struct cam_context           *ctx,
 	struct cam_req_mgr_dump_info *dump_info)
@@ -3613,6 +3726,16 @@ hw_dump:
 	dump_info->offset += hdr->size +
 		sizeof(struct cam_isp_context_dump_header);
 
+	if (ctx_isp->offline_context) {
+		rc = __cam_isp_ctx_dump_offline_stats(ctx_isp, cpu_addr,
+			buf_len, &dump_info->offset);
+		if (rc) {
+			CAM_ERR(CAM_ISP, "Dump offline stats fail %lld",
+				req->request_id);
+			goto end;
+		}
+	}
+
 	rc = __cam_isp_ctx_dump_event_record(ctx_isp, cpu_addr,
 		buf_len, &dump_info->offset);
 	if (rc) {
@@ -3651,6 +3774,36 @@ end:
 	return rc;
 }
 
+/*
+ * WM register shadow follows what was prepared, not what was applied.
+ * Once a prepared request is dropped the shadow may hold values that never
+ * reached HW, so program all WM registers for requests prepared after it.
+ */
+static void __cam_isp_ctx_invalidate_wm_shadow(struct cam_context *ctx)
+{
+	int rc;
+	struct cam_hw_cmd_args       hw_cmd_args;
+	struct cam_isp_hw_cmd_args   isp_hw_cmd_args;
+	struct cam_isp_context      *ctx_isp =
+		(struct cam_isp_context *) ctx->ctx_priv;
+
+	/* No HW acquired yet, nothing has been prepared */
+	if (!ctx_isp->hw_ctx)
+		return;
+
+	memset(&hw_cmd_args, 0, sizeof(hw_cmd_args));
+	memset(&isp_hw_cmd_args, 0, sizeof(isp_hw_cmd_args));
+	hw_cmd_args.ctxt_to_hw_map = ctx_isp->hw_ctx;
+	hw_cmd_args.cmd_type = CAM_HW_MGR_CMD_INTERNAL;
+	isp_hw_cmd_args.cmd_type = CAM_ISP_HW_MGR_CMD_WM_SHADOW_INVALIDATE;
+	hw_cmd_args.u.internal_args = (void *)&isp_hw_cmd_args;
+	rc = ctx->hw_mgr_intf->hw_cmd(ctx->hw_mgr_intf->hw_mgr_priv,
+		&hw_cmd_args);
+	if (rc)
+		CAM_ERR(CAM_ISP, "WM shadow invalidate failed ctx %u rc %d",
+			ctx->ctx_id, rc);
+}
+
 static int __cam_isp_ctx_flush_req_in_flushed_state(
 	struct cam_context               *ctx,
 	struct cam_req_mgr_flush_request *flush_req)
@@ -3767,6 +3920,7 @@ static int __cam_isp_ctx_flush_req_in_top_state(
 	spin_lock_bh(&ctx->lock);
 	rc = __cam_isp_ctx_flush_req(ctx, &ctx->pending_req_list, flush_req);
 	spin_unlock_bh(&ctx->lock);
+	__cam_isp_ctx_invalidate_wm_shadow(ctx);
 
 	if (flush_req->type == CAM_REQ_MGR_FLUSH_TYPE_ALL) {
 		if (ctx->state <= CAM_CTX_READY) {
@@ -3855,6 +4009,7 @@ static int __cam_isp_ctx_flush_req_in_ready(
 	if (list_empty(&ctx->pending_req_list))
 		ctx->state = CAM_CTX_ACQUIRED;
 	spin_unlock_bh(&ctx->lock);
+	__cam_isp_ctx_invalidate_wm_shadow(ctx);
 
 	trace_cam_context_state("ISP", ctx);
 
@@ -4858,6 +5013,7 @@ static int __cam_isp_ctx_config_dev_in_top_state(
 	if (rc != 0) {
 		CAM_ERR(CAM_ISP, "Prepare config packet failed in HW layer");
 		rc = -EFAULT;
+		__cam_isp_ctx_invalidate_wm_shadow(ctx);
 		goto free_req;
 	}
 
@@ -4869,6 +5025,7 @@ static int __cam_isp_ctx_config_dev_in_top_state(
 	req_isp->bubble_detected = false;
 	req_isp->cdm_reset_before_apply = false;
 	req_isp->hw_update_data.packet = packet;
+	req_isp->hw_update_data.lat_tracker = &ctx_isp->lat_tracker;
 
 	for (i = 0; i < req_isp->num_fence_map_out; i++) {
 		rc = cam_sync_get_obj_ref(req_isp->fence_map_out[i].sync_id);
@@ -4930,6 +5087,9 @@ static int __cam_isp_ctx_config_dev_in_top_state(
 	if (rc)
 		goto put_ref;
 
+	cam_common_lat_stamp(&ctx_isp->lat_tracker, req->request_id,
+		CAM_COMMON_LAT_CONFIG_DEV);
+
 	CAM_DBG(CAM_REQ,
 		"Preprocessing Config req_id %lld successful on ctx %u",
 		req->request_id, ctx->ctx_id);
@@ -4947,6 +5107,8 @@ put_ref:
 			CAM_ERR(CAM_CTXT, "Failed to put ref of fence %d",
 				req_isp->fence_map_out[i].sync_id);
 	}
+	/* Prepared but never queued for apply */
+	__cam_isp_ctx_invalidate_wm_shadow(ctx);
 free_req:
 	spin_lock_bh(&ctx->lock);
 	list_add_tail(&req->list, &ctx->free_req_list);
@@ -5641,6 +5803,7 @@ static int __cam_isp_ctx_start_dev_in_ready(struct cam_context *ctx,
 	ctx_isp->active_req_cnt = 0;
 	ctx_isp->reported_req_id = 0;
 	ctx_isp->bubble_frame_cnt = 0;
+	memset(&ctx_isp->offline_stats, 0, sizeof(ctx_isp->offline_stats));
 	ctx_isp->substate_activated = ctx_isp->rdi_only_context ?
 		CAM_ISP_CTX_ACTIVATED_APPLIED :
 		(req_isp->num_fence_map_out) ? CAM_ISP_CTX_ACTIVATED_EPOCH :
@@ -6344,6 +6507,8 @@ static int cam_isp_context_debug_register(void)
 		isp_ctx_debug.dentry, &isp_ctx_debug.enable_state_monitor_dump);
 	dbgfileptr = debugfs_create_u8("enable_cdm_cmd_buffer_dump", 0644,
 		isp_ctx_debug.dentry, &isp_ctx_debug.enable_cdm_cmd_buff_dump);
+	dbgfileptr = debugfs_create_u32("offline_apply_depth", 0644,
+		isp_ctx_debug.dentry, &isp_ctx_debug.offline_depth);
 	if (IS_ERR(dbgfileptr)) {
 		if (PTR_ERR(dbgfileptr) == -ENODEV)
 			CAM_WARN(CAM_ISP, "DebugFS not enabled in kernel!");
@@ -6364,6 +6529,7 @@ int cam_isp_context_init(struct cam_isp_context *ctx,
 {
 	int rc = -1;
 	int i;
+	char name[CAM_COMMON_LAT_NAME_LEN];
 
 	if (!ctx || !ctx_base) {
 		CAM_ERR(CAM_ISP, "Invalid Context");
@@ -6419,6 +6585,11 @@ int cam_isp_context_init(struct cam_isp_context *ctx,
 	if (!isp_ctx_debug.dentry)
 		cam_isp_context_debug_register();
 
+	snprintf(name, sizeof(name), "%s_ctx%u",
+		(isp_device_type == CAM_TFE_DEVICE_TYPE) ? "tfe" : "ife",
+		ctx_id);
+	cam_common_lat_register(&ctx->lat_tracker, name);
+
 err:
 	return rc;
 }
@@ -6433,6 +6604,7 @@ int cam_isp_context_deinit(struct cam_isp_context *ctx)
 			__cam_isp_ctx_substate_val_to_type(
 			ctx->substate_activated));
 
+	cam_common_lat_unregister(&ctx->lat_tracker);
 	debugfs_remove_recursive(isp_ctx_debug.dentry);
 	isp_ctx_debug.dentry = NULL;
 	memset(ctx, 0, sizeof(*ctx));
@@ -49,6 +49,13 @@
 /* Number of words for dumping request info*/
 #define CAM_ISP_CTX_DUMP_REQUEST_NUM_WORDS  2
 
+/* Number of words for dumping offline context stats */
+#define CAM_ISP_CTX_DUMP_OFFLINE_NUM_WORDS  5
+
+/* Default and maximum number of offline requests in flight */
+#define CAM_ISP_CTX_OFFLINE_DEFAULT_DEPTH   2
+#define CAM_ISP_CTX_OFFLINE_MAX_DEPTH       8
+
 /* Maximum entries in event record */
 #define CAM_ISP_CTX_EVENT_RECORD_MAX_ENTRIES   20
 
@@ -112,12 +119,15 @@ enum cam_isp_state_change_trigger {
  * @dentry:                     Debugfs entry
  * @enable_state_monitor_dump:  Enable isp state monitor dump
  * @enable_cdm_cmd_buff_dump: Enable CDM Command buffer dump
+ * @offline_depth:              Max requests in flight for offline IFE,
+ *                              0 selects the default depth
  *
  */
 struct cam_isp_ctx_debug {
 	struct dentry  *dentry;
 	uint32_t        enable_state_monitor_dump;
 	uint8_t         enable_cdm_cmd_buff_dump;
+	uint32_t        offline_depth;
 };
 
 /**
@@ -232,6 +242,20 @@ struct cam_isp_context_event_record {
 	ktime_t                          timestamp;
 };
 
+/**
+ * struct cam_isp_ctx_offline_stats - Offline context throughput stats
+ *
+ * @num_frames:         Number of requests completed since start
+ * @first_done_ts:      Completion time of the first request
+ * @last_done_ts:       Completion time of the latest request
+ *
+ */
+struct cam_isp_ctx_offline_stats {
+	uint64_t   num_frames;
+	ktime_t    first_done_ts;
+	ktime_t    last_done_ts;
+};
+
 /**
  * struct cam_isp_context   -  ISP context object
  *
@@ -276,6 +300,8 @@ struct cam_isp_context_event_record {
  * @rxd_epoch:                 Indicate whether epoch has been received. Used to
  *                             decide whether to apply request in offline ctx
  * @workq:                     Worker thread for offline ife
+ * @offline_stats:             Throughput stats for offline ife
+ * @lat_tracker:               Per request stage latency accounting
  * @trigger_id:                ID provided by CRM for each ctx on the link
  * @last_bufdone_err_apply_req_id:  last bufdone error apply request id
  *
@@ -323,6 +349,8 @@ struct cam_isp_context {
 	uint32_t                              isp_device_type;
 	atomic_t                              rxd_epoch;
 	struct cam_req_mgr_core_workq        *workq;
+	struct cam_isp_ctx_offline_stats      offline_stats;
+	struct cam_common_lat_tracker         lat_tracker;
 	int32_t                               trigger_id;
 	int64_t                               last_bufdone_err_apply_req_id;
 };
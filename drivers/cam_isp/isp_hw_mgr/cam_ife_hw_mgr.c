@@ -26,6 +26,7 @@
 #include "cam_cpas_api.h"
 #include "cam_mem_mgr_api.h"
 #include "cam_common_util.h"
+#include "cam_io_util.h"
 
 #define CAM_IFE_SAFE_DISABLE 0
 #define CAM_IFE_SAFE_ENABLE 1
@@ -2893,6 +2894,8 @@ void cam_ife_cam_cdm_callback(uint32_t handle, void *userdata,
 		reg_dump_done = atomic_read(&ctx->cdm_done);
 		atomic_set(&ctx->cdm_done, 1);
 		ctx->last_cdm_done_req = cookie;
+		cam_common_lat_stamp(hw_update_data->lat_tracker, cookie,
+			CAM_COMMON_LAT_CDM_DONE);
 		if ((g_ife_hw_mgr.debug_cfg.per_req_reg_dump) &&
 			(!reg_dump_done))
 			cam_ife_mgr_handle_reg_dump(ctx,
@@ -3903,6 +3906,27 @@ static int cam_isp_blob_bw_update(
 	return rc;
 }
 
+static void cam_ife_mgr_invalidate_wm_shadow(struct cam_ife_hw_mgr *hw_mgr,
+	uint32_t hw_idx)
+{
+	uint32_t i = 0, dummy_args = 0;
+	struct cam_hw_intf *vfe_hw_intf;
+
+	for (i = 0; i < CAM_VFE_HW_NUM_MAX; i++) {
+		if (!hw_mgr->ife_devices[i])
+			continue;
+
+		if (hw_idx != hw_mgr->ife_devices[i]->hw_intf->hw_idx)
+			continue;
+
+		vfe_hw_intf = hw_mgr->ife_devices[i]->hw_intf;
+		vfe_hw_intf->hw_ops.process_cmd(vfe_hw_intf->hw_priv,
+			CAM_ISP_HW_CMD_WM_SHADOW_INVALIDATE,
+			&dummy_args, sizeof(dummy_args));
+		break;
+	}
+}
+
 /* entry function: config_hw */
 static int cam_ife_mgr_config_hw(void *hw_mgr_priv,
 					void *config_hw_args)
@@ -3975,6 +3999,16 @@ static int cam_ife_mgr_config_hw(void *hw_mgr_priv,
 		ctx->last_cdm_done_req = 0;
 	}
 
+	/*
+	 * Bubble recovery, program all WM registers for the requests
+	 * prepared from here on.
+	 */
+	if (cfg->reapply) {
+		for (i = 0; i < ctx->num_base; i++)
+			cam_ife_mgr_invalidate_wm_shadow(ctx->hw_mgr,
+				ctx->base[i].idx);
+	}
+
 	for (i = 0; i < CAM_IFE_HW_NUM_MAX; i++) {
 		if (hw_update_data->bw_config_valid[i] == true) {
 
@@ -4388,6 +4422,9 @@ static int cam_ife_mgr_reset_vfe_hw(struct cam_ife_hw_mgr *hw_mgr,
 		break;
 	}
 
+	/* Reset clears the WM registers, program all of them again */
+	cam_ife_mgr_invalidate_wm_shadow(hw_mgr, hw_idx);
+
 	CAM_DBG(CAM_ISP, "Exit Successfully");
 	return 0;
 }
@@ -6528,11 +6565,13 @@ static int cam_ife_mgr_prepare_hw_update(void *hw_mgr_priv,
 	if (ctx->internal_cdm)
 		rc = cam_packet_util_process_patches(prepare->packet,
 			hw_mgr->mgr_common.img_iommu_hdl,
-			hw_mgr->mgr_common.img_iommu_hdl_secure);
+			hw_mgr->mgr_common.img_iommu_hdl_secure,
+			&ctx->common.iova_cache);
 	else
 		rc = cam_packet_util_process_patches(prepare->packet,
 			hw_mgr->mgr_common.cmd_iommu_hdl,
-			hw_mgr->mgr_common.cmd_iommu_hdl_secure);
+			hw_mgr->mgr_common.cmd_iommu_hdl_secure,
+			&ctx->common.iova_cache);
 
 	if (rc) {
 		CAM_ERR(CAM_ISP, "Patch ISP packet failed.");
@@ -7028,7 +7067,7 @@ outportlog:
 
 static int cam_ife_mgr_cmd(void *hw_mgr_priv, void *cmd_args)
 {
-	int rc = 0;
+	int rc = 0, i;
 	struct cam_hw_cmd_args *hw_cmd_args = cmd_args;
 	struct cam_ife_hw_mgr  *hw_mgr = hw_mgr_priv;
 	struct cam_ife_hw_mgr_ctx *ctx = (struct cam_ife_hw_mgr_ctx *)
@@ -7094,6 +7133,11 @@ static int cam_ife_mgr_cmd(void *hw_mgr_priv, void *cmd_args)
 			isp_hw_cmd_args->u.last_cdm_done =
 				ctx->last_cdm_done_req;
 			break;
+		case CAM_ISP_HW_MGR_CMD_WM_SHADOW_INVALIDATE:
+			for (i = 0; i < ctx->num_base; i++)
+				cam_ife_mgr_invalidate_wm_shadow(ctx->hw_mgr,
+					ctx->base[i].idx);
+			break;
 		default:
 			CAM_ERR(CAM_ISP, "Invalid HW mgr command:0x%x",
 				hw_cmd_args->cmd_type);
@@ -7751,6 +7795,8 @@ static int cam_ife_hw_mgr_handle_hw_err(
 	else if (event_info->res_type == CAM_ISP_RESOURCE_VFE_OUT)
 		error_event_data.error_type = CAM_ISP_HW_ERROR_BUSIF_OVERFLOW;
 
+	cam_io_trace_dump();
+
 	spin_lock(&g_ife_hw_mgr.ctx_lock);
 	if ((event_info->err_type == CAM_ISP_HW_ERROR_CSID_FATAL) ||
 		(event_info->err_type == CAM_ISP_HW_ERROR_CSID_OVERFLOW)) {
@@ -10,6 +10,7 @@
 #include "cam_isp_hw_mgr_intf.h"
 #include "cam_tasklet_util.h"
 #include "cam_isp_hw.h"
+#include "cam_packet_util.h"
 
 #define CAM_ISP_HW_NUM_MAX                       7
 
@@ -21,12 +22,14 @@
  *                         acquire device
  * @cb_priv:               first argument for the call back function
  *                         set during acquire device
+ * @iova_cache:            patch source buffer iova cache
  *
  */
 struct cam_isp_hw_mgr_ctx {
 	void                           *tasklet_info;
 	cam_hw_event_cb_func            event_cb[CAM_ISP_HW_EVENT_MAX];
 	void                           *cb_priv;
+	struct cam_packet_iova_cache    iova_cache;
 };
 
 /**
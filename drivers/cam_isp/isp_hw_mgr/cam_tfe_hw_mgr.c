@@ -1855,6 +1855,8 @@ void cam_tfe_cam_cdm_callback(uint32_t handle, void *userdata,
 		complete_all(&ctx->config_done_complete);
 		atomic_set(&ctx->cdm_done, 1);
 		ctx->last_cdm_done_req = cookie;
+		cam_common_lat_stamp(hw_update_data->lat_tracker, cookie,
+			CAM_COMMON_LAT_CDM_DONE);
 		if (g_tfe_hw_mgr.debug_cfg.per_req_reg_dump)
 			cam_tfe_mgr_handle_reg_dump(ctx,
 				hw_update_data->reg_dump_buf_desc,
@@ -2638,6 +2640,27 @@ end:
 	return rc;
 }
 
+static void cam_tfe_mgr_invalidate_wm_shadow(struct cam_tfe_hw_mgr *hw_mgr,
+	uint32_t hw_idx)
+{
+	uint32_t i = 0, dummy_args = 0;
+	struct cam_hw_intf *tfe_hw_intf;
+
+	for (i = 0; i < CAM_TFE_HW_NUM_MAX; i++) {
+		if (!hw_mgr->tfe_devices[i])
+			continue;
+
+		if (hw_idx != hw_mgr->tfe_devices[i]->hw_intf->hw_idx)
+			continue;
+
+		tfe_hw_intf = hw_mgr->tfe_devices[i]->hw_intf;
+		tfe_hw_intf->hw_ops.process_cmd(tfe_hw_intf->hw_priv,
+			CAM_ISP_HW_CMD_WM_SHADOW_INVALIDATE,
+			&dummy_args, sizeof(dummy_args));
+		break;
+	}
+}
+
 /* entry function: config_hw */
 static int cam_tfe_mgr_config_hw(void *hw_mgr_priv,
 	void *config_hw_args)
@@ -2698,6 +2721,16 @@ static int cam_tfe_mgr_config_hw(void *hw_mgr_priv,
 		ctx->last_cdm_done_req = 0;
 	}
 
+	/*
+	 * Bubble recovery, program all WM registers for the requests
+	 * prepared from here on.
+	 */
+	if (cfg->reapply) {
+		for (i = 0; i < ctx->num_base; i++)
+			cam_tfe_mgr_invalidate_wm_shadow(ctx->hw_mgr,
+				ctx->base[i].idx);
+	}
+
 	for (i = 0; i < CAM_TFE_HW_NUM_MAX; i++) {
 		if (hw_update_data->bw_config_valid[i] == true) {
 
@@ -3136,6 +3169,9 @@ static int cam_tfe_mgr_reset_tfe_hw(struct cam_tfe_hw_mgr *hw_mgr,
 		break;
 	}
 
+	/* Reset clears the WM registers, program all of them again */
+	cam_tfe_mgr_invalidate_wm_shadow(hw_mgr, hw_idx);
+
 	CAM_DBG(CAM_ISP, "Exit Successfully");
 	return 0;
 }
@@ -4469,7 +4505,8 @@ static int cam_tfe_mgr_prepare_hw_update(void *hw_mgr_priv,
 
 	rc = cam_packet_util_process_patches(prepare->packet,
 		hw_mgr->mgr_common.cmd_iommu_hdl,
-		hw_mgr->mgr_common.cmd_iommu_hdl_secure);
+		hw_mgr->mgr_common.cmd_iommu_hdl_secure,
+		&ctx->common.iova_cache);
 	if (rc) {
 		CAM_ERR(CAM_ISP, "Patch ISP packet failed.");
 		return rc;
@@ -4919,7 +4956,7 @@ outportlog:
 
 static int cam_tfe_mgr_cmd(void *hw_mgr_priv, void *cmd_args)
 {
-	int rc = 0;
+	int rc = 0, i;
 	struct cam_hw_cmd_args *hw_cmd_args = cmd_args;
 	struct cam_tfe_hw_mgr  *hw_mgr = hw_mgr_priv;
 	struct cam_tfe_hw_mgr_ctx *ctx = (struct cam_tfe_hw_mgr_ctx *)
@@ -4979,6 +5016,11 @@ static int cam_tfe_mgr_cmd(void *hw_mgr_priv, void *cmd_args)
 			isp_hw_cmd_args->u.last_cdm_done =
 				ctx->last_cdm_done_req;
 			break;
+		case CAM_ISP_HW_MGR_CMD_WM_SHADOW_INVALIDATE:
+			for (i = 0; i < ctx->num_base; i++)
+				cam_tfe_mgr_invalidate_wm_shadow(ctx->hw_mgr,
+					ctx->base[i].idx);
+			break;
 		case CAM_ISP_HW_MGR_CMD_UPDATE_CLOCK:
 			rc = cam_tfe_cshiphy_callback(ctx, isp_hw_cmd_args->cmd_data);
 			break;
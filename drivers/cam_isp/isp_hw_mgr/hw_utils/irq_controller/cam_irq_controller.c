@@ -7,10 +7,36 @@
 #include <linux/spinlock.h>
 #include <linux/list.h>
 #include <linux/ratelimit.h>
+#include <linux/bitops.h>
+#include <linux/ktime.h>
 
 #include "cam_io_util.h"
 #include "cam_irq_controller.h"
 #include "cam_debug_util.h"
+#include "cam_trace.h"
+
+#define CAM_IRQ_BITS_PER_REG      32
+#define CAM_IRQ_TH_MATCH_ARR_STEP 16
+#define CAM_IRQ_TH_MATCH_ARR_INIT 64
+
+struct cam_irq_evt_handler;
+
+/**
+ * struct cam_irq_bit_node:
+ * @Brief:                  Links an event handler into the dispatch list of
+ *                          one of its subscribed status bits
+ *
+ * @list:                   list_head struct used for the per bit list
+ * @evt_handler:            Event handler owning this node
+ * @reg_index:              Index of the status register of the bit
+ * @bit:                    Bit position in the status register
+ */
+struct cam_irq_bit_node {
+	struct list_head                   list;
+	struct cam_irq_evt_handler        *evt_handler;
+	uint32_t                           reg_index;
+	uint32_t                           bit;
+};
 
 /**
  * struct cam_irq_evt_handler:
@@ -28,7 +54,11 @@
  * @bottom_half_enqueue_func:
  *                          Function used to enqueue the bottom_half event
  * @list_node:              list_head struct used for overall handler List
- * @th_list_node:           list_head struct used for top half handler List
+ * @bit_nodes:              Array of nodes, one per subscribed status bit
+ * @num_bit_nodes:          Number of entries in bit_nodes
+ * @enabled:                Whether bit_nodes are linked in the dispatch index
+ * @th_seq:                 Subscribe order, top halves are invoked in it
+ * @dispatch_seq:           Last top half dispatch that matched this handler
  */
 struct cam_irq_evt_handler {
 	enum cam_irq_priority_level        priority;
@@ -39,7 +69,11 @@ struct cam_irq_evt_handler {
 	void                              *bottom_half;
 	struct cam_irq_bh_api              irq_bh_api;
 	struct list_head                   list_node;
-	struct list_head                   th_list_node;
+	struct cam_irq_bit_node           *bit_nodes;
+	uint32_t                           num_bit_nodes;
+	bool                               enabled;
+	uint64_t                           th_seq;
+	uint32_t                           dispatch_seq;
 	int                                index;
 };
 
@@ -83,7 +117,13 @@ struct cam_irq_register_obj {
  * @global_clear_bitmask:   Bitmask needed to be used in Global Clear register
  *                          for Clear IRQ cmd to take effect
  * @evt_handler_list_head:  List of all event handlers
- * @th_list_head:           List of handlers sorted by priority
+ * @bit_list_arr:           Dispatch index, list of enabled handler bit nodes
+ *                          per priority, register and bit
+ * @th_match_arr:           Scratch array of handlers matched by one top half
+ * @th_match_max:           Number of entries in th_match_arr
+ * @num_handlers:           Number of subscribed handlers
+ * @th_seq:                 Subscribe order counter
+ * @dispatch_seq:           Top half dispatch counter
  * @hdl_idx:                Unique identity of handler assigned on Subscribe.
  *                          Used to Unsubscribe.
  * @lock:                   Lock for use by controller
@@ -99,13 +139,69 @@ struct cam_irq_controller {
 	uint32_t                        global_clear_offset;
 	uint32_t                        global_clear_bitmask;
 	struct list_head                evt_handler_list_head;
-	struct list_head                th_list_head[CAM_IRQ_PRIORITY_MAX];
+	struct list_head               *bit_list_arr;
+	struct cam_irq_evt_handler    **th_match_arr;
+	uint32_t                        th_match_max;
+	uint32_t                        num_handlers;
+	uint64_t                        th_seq;
+	uint32_t                        dispatch_seq;
 	uint32_t                        hdl_idx;
 	spinlock_t                      lock;
 	struct cam_irq_th_payload       th_payload;
 	bool                            clear_all;
 };
 
+static inline struct list_head *cam_irq_controller_bit_list(
+	struct cam_irq_controller *controller,
+	enum cam_irq_priority_level priority, uint32_t reg_index, uint32_t bit)
+{
+	return &controller->bit_list_arr[((priority *
+		controller->num_registers + reg_index) *
+		CAM_IRQ_BITS_PER_REG) + bit];
+}
+
+static void cam_irq_controller_link_handler(
+	struct cam_irq_controller   *controller,
+	struct cam_irq_evt_handler  *evt_handler)
+{
+	struct cam_irq_bit_node *node;
+	uint32_t i;
+
+	if (evt_handler->enabled)
+		return;
+
+	for (i = 0; i < evt_handler->num_bit_nodes; i++) {
+		node = &evt_handler->bit_nodes[i];
+		list_add_tail(&node->list, cam_irq_controller_bit_list(
+			controller, evt_handler->priority, node->reg_index,
+			node->bit));
+	}
+
+	evt_handler->enabled = true;
+}
+
+static void cam_irq_controller_unlink_handler(
+	struct cam_irq_evt_handler  *evt_handler)
+{
+	uint32_t i;
+
+	if (!evt_handler->enabled)
+		return;
+
+	for (i = 0; i < evt_handler->num_bit_nodes; i++)
+		list_del_init(&evt_handler->bit_nodes[i].list);
+
+	evt_handler->enabled = false;
+}
+
+static void cam_irq_controller_free_handler(
+	struct cam_irq_evt_handler  *evt_handler)
+{
+	kfree(evt_handler->bit_nodes);
+	kfree(evt_handler->evt_bit_mask_arr);
+	kfree(evt_handler);
+}
+
 int cam_irq_controller_deinit(void **irq_controller)
 {
 	struct cam_irq_controller *controller = *irq_controller;
@@ -116,10 +212,11 @@ int cam_irq_controller_deinit(void **irq_controller)
 			&controller->evt_handler_list_head,
 			struct cam_irq_evt_handler, list_node);
 		list_del_init(&evt_handler->list_node);
-		kfree(evt_handler->evt_bit_mask_arr);
-		kfree(evt_handler);
+		cam_irq_controller_free_handler(evt_handler);
 	}
 
+	kfree(controller->th_match_arr);
+	kfree(controller->bit_list_arr);
 	kfree(controller->th_payload.evt_status_arr);
 	kfree(controller->irq_status_arr);
 	kfree(controller->irq_register_arr);
@@ -136,6 +233,7 @@ int cam_irq_controller_init(const char       *name,
 {
 	struct cam_irq_controller *controller = NULL;
 	int i, rc = 0;
+	int num_bit_lists;
 
 	*irq_controller = NULL;
 
@@ -178,6 +276,32 @@ int cam_irq_controller_init(const char       *name,
 		goto evt_mask_alloc_error;
 	}
 
+	num_bit_lists = register_info->num_registers * CAM_IRQ_PRIORITY_MAX *
+		CAM_IRQ_BITS_PER_REG;
+	controller->bit_list_arr = kcalloc(num_bit_lists,
+		sizeof(struct list_head), GFP_KERNEL);
+	if (!controller->bit_list_arr) {
+		CAM_DBG(CAM_IRQ_CTRL, "Failed to allocate IRQ dispatch index");
+		rc = -ENOMEM;
+		goto bit_list_alloc_error;
+	}
+
+	for (i = 0; i < num_bit_lists; i++)
+		INIT_LIST_HEAD(&controller->bit_list_arr[i]);
+
+	/*
+	 * Sized up front, subscribers running in a top half cannot grow it
+	 * while that top half is walking it.
+	 */
+	controller->th_match_arr = kcalloc(CAM_IRQ_TH_MATCH_ARR_INIT,
+		sizeof(struct cam_irq_evt_handler *), GFP_KERNEL);
+	if (!controller->th_match_arr) {
+		CAM_DBG(CAM_IRQ_CTRL, "Failed to allocate match array");
+		rc = -ENOMEM;
+		goto match_arr_alloc_error;
+	}
+	controller->th_match_max = CAM_IRQ_TH_MATCH_ARR_INIT;
+
 	controller->name = name;
 
 	CAM_DBG(CAM_IRQ_CTRL, "num_registers: %d",
@@ -211,8 +335,6 @@ int cam_irq_controller_init(const char       *name,
 		(void __iomem *)controller->mem_base);
 
 	INIT_LIST_HEAD(&controller->evt_handler_list_head);
-	for (i = 0; i < CAM_IRQ_PRIORITY_MAX; i++)
-		INIT_LIST_HEAD(&controller->th_list_head[i]);
 
 	spin_lock_init(&controller->lock);
 
@@ -221,6 +343,10 @@ int cam_irq_controller_init(const char       *name,
 
 	return rc;
 
+match_arr_alloc_error:
+	kfree(controller->bit_list_arr);
+bit_list_alloc_error:
+	kfree(controller->th_payload.evt_status_arr);
 evt_mask_alloc_error:
 	kfree(controller->irq_status_arr);
 status_alloc_error:
@@ -242,11 +368,16 @@ int cam_irq_controller_subscribe_irq(void *irq_controller,
 {
 	struct cam_irq_controller  *controller  = irq_controller;
 	struct cam_irq_evt_handler *evt_handler = NULL;
+	struct cam_irq_evt_handler **th_match_arr = NULL;
+	uint32_t                    th_match_max = 0;
 	int                         i;
 	int                         rc = 0;
 	uint32_t                    irq_mask;
+	uint32_t                    num_bits = 0;
+	uint32_t                    bit_mask;
 	unsigned long               flags = 0;
 	bool                        need_lock;
+	gfp_t                       gfp;
 
 	if (!controller || !handler_priv || !evt_bit_mask_arr) {
 		CAM_ERR(CAM_IRQ_CTRL,
@@ -288,14 +419,17 @@ int cam_irq_controller_subscribe_irq(void *irq_controller,
 		return -EINVAL;
 	}
 
-	evt_handler = kzalloc(sizeof(struct cam_irq_evt_handler), GFP_KERNEL);
+	need_lock = !in_irq();
+	gfp = need_lock ? GFP_KERNEL : GFP_ATOMIC;
+
+	evt_handler = kzalloc(sizeof(struct cam_irq_evt_handler), gfp);
 	if (!evt_handler) {
 		CAM_DBG(CAM_IRQ_CTRL, "Error allocating hlist_node");
 		return -ENOMEM;
 	}
 
 	evt_handler->evt_bit_mask_arr = kzalloc(sizeof(uint32_t) *
-		controller->num_registers, GFP_KERNEL);
+		controller->num_registers, gfp);
 	if (!evt_handler->evt_bit_mask_arr) {
 		CAM_DBG(CAM_IRQ_CTRL, "Error allocating hlist_node");
 		rc = -ENOMEM;
@@ -303,10 +437,35 @@ int cam_irq_controller_subscribe_irq(void *irq_controller,
 	}
 
 	INIT_LIST_HEAD(&evt_handler->list_node);
-	INIT_LIST_HEAD(&evt_handler->th_list_node);
 
-	for (i = 0; i < controller->num_registers; i++)
+	for (i = 0; i < controller->num_registers; i++) {
 		evt_handler->evt_bit_mask_arr[i] = evt_bit_mask_arr[i];
+		num_bits += hweight32(evt_bit_mask_arr[i]);
+	}
+
+	if (num_bits) {
+		evt_handler->bit_nodes = kcalloc(num_bits,
+			sizeof(struct cam_irq_bit_node), gfp);
+		if (!evt_handler->bit_nodes) {
+			CAM_DBG(CAM_IRQ_CTRL, "Error allocating bit nodes");
+			rc = -ENOMEM;
+			goto free_evt_mask;
+		}
+	}
+
+	for (i = 0; i < controller->num_registers; i++) {
+		bit_mask = evt_bit_mask_arr[i];
+		while (bit_mask) {
+			struct cam_irq_bit_node *node = &evt_handler->bit_nodes[
+				evt_handler->num_bit_nodes++];
+
+			INIT_LIST_HEAD(&node->list);
+			node->evt_handler = evt_handler;
+			node->reg_index = i;
+			node->bit = __ffs(bit_mask);
+			bit_mask &= ~BIT(node->bit);
+		}
+	}
 
 	evt_handler->priority                 = priority;
 	evt_handler->handler_priv             = handler_priv;
@@ -322,9 +481,45 @@ int cam_irq_controller_subscribe_irq(void *irq_controller,
 	if (controller->hdl_idx > 0x3FFFFFFF)
 		controller->hdl_idx = 1;
 
-	need_lock = !in_irq();
+retry:
 	if (need_lock)
 		spin_lock_irqsave(&controller->lock, flags);
+
+	/*
+	 * Top half scratch array must fit every subscribed handler, capacity
+	 * is only trusted under the lock since subscribers may race. It is
+	 * never replaced from irq context, the top half we run in may be
+	 * walking it.
+	 */
+	if (controller->num_handlers + 1 > controller->th_match_max) {
+		if (!need_lock) {
+			CAM_ERR(CAM_IRQ_CTRL,
+				"%s: cannot grow match array past %u in irq",
+				controller->name, controller->th_match_max);
+			rc = -ENOMEM;
+			goto free_bit_nodes;
+		}
+
+		if (th_match_max < controller->num_handlers + 1) {
+			th_match_max = controller->num_handlers +
+				CAM_IRQ_TH_MATCH_ARR_STEP;
+			spin_unlock_irqrestore(&controller->lock, flags);
+			kfree(th_match_arr);
+			th_match_arr = kcalloc(th_match_max,
+				sizeof(struct cam_irq_evt_handler *),
+				GFP_KERNEL);
+			if (!th_match_arr) {
+				CAM_DBG(CAM_IRQ_CTRL,
+					"Error allocating match array");
+				rc = -ENOMEM;
+				goto free_bit_nodes;
+			}
+			goto retry;
+		}
+		swap(controller->th_match_arr, th_match_arr);
+		controller->th_match_max = th_match_max;
+	}
+
 	for (i = 0; i < controller->num_registers; i++) {
 		controller->irq_register_arr[i].top_half_enable_mask[priority]
 			|= evt_bit_mask_arr[i];
@@ -340,16 +535,24 @@ int cam_irq_controller_subscribe_irq(void *irq_controller,
 			controller->irq_register_arr[i].mask_reg_offset);
 	}
 
+	evt_handler->th_seq = controller->th_seq++;
+	controller->num_handlers++;
 	list_add_tail(&evt_handler->list_node,
 		&controller->evt_handler_list_head);
-	list_add_tail(&evt_handler->th_list_node,
-		&controller->th_list_head[priority]);
+	cam_irq_controller_link_handler(controller, evt_handler);
 
 	if (need_lock)
 		spin_unlock_irqrestore(&controller->lock, flags);
 
+	/* Previous, smaller match array or an unused allocation */
+	kfree(th_match_arr);
+
 	return evt_handler->index;
 
+free_bit_nodes:
+	kfree(evt_handler->bit_nodes);
+free_evt_mask:
+	kfree(evt_handler->evt_bit_mask_arr);
 free_evt_handler:
 	kfree(evt_handler);
 	evt_handler = NULL;
@@ -395,6 +598,7 @@ int cam_irq_controller_enable_irq(void *irq_controller, uint32_t handle)
 	}
 
 	priority = evt_handler->priority;
+	cam_irq_controller_link_handler(controller, evt_handler);
 	for (i = 0; i < controller->num_registers; i++) {
 		irq_register = &controller->irq_register_arr[i];
 		irq_register->top_half_enable_mask[priority] |=
@@ -451,6 +655,7 @@ int cam_irq_controller_disable_irq(void *irq_controller, uint32_t handle)
 	}
 
 	priority = evt_handler->priority;
+	cam_irq_controller_unlink_handler(evt_handler);
 	for (i = 0; i < controller->num_registers; i++) {
 		irq_register = &controller->irq_register_arr[i];
 		irq_register->top_half_enable_mask[priority] &=
@@ -508,7 +713,8 @@ int cam_irq_controller_unsubscribe_irq(void *irq_controller,
 		if (evt_handler->index == handle) {
 			CAM_DBG(CAM_IRQ_CTRL, "unsubscribe item %d", handle);
 			list_del_init(&evt_handler->list_node);
-			list_del_init(&evt_handler->th_list_node);
+			cam_irq_controller_unlink_handler(evt_handler);
+			controller->num_handlers--;
 			found = 1;
 			rc = 0;
 			break;
@@ -540,8 +746,7 @@ int cam_irq_controller_unsubscribe_irq(void *irq_controller,
 					controller->global_clear_offset);
 		}
 
-		kfree(evt_handler->evt_bit_mask_arr);
-		kfree(evt_handler);
+		cam_irq_controller_free_handler(evt_handler);
 	}
 
 	if (need_lock)
@@ -551,57 +756,77 @@ int cam_irq_controller_unsubscribe_irq(void *irq_controller,
 }
 
 /**
- * cam_irq_controller_match_bit_mask()
+ * cam_irq_controller_collect_handlers()
  *
- * @Brief:                This function checks if any of the enabled IRQ bits
- *                        for a certain handler is Set in the Status values
- *                        of the controller.
+ * @Brief:                This function looks up the enabled handlers of a
+ *                        priority through the per bit dispatch index for the
+ *                        status bits that are set. Each handler is collected
+ *                        once, in subscribe order.
  *
  * @controller:           IRQ Controller structure
- * @evt_handler:          Event handler structure
+ * @priority:             Priority level to collect handlers for
  *
- * @Return:               True: If any interested IRQ Bit is Set
- *                        False: Otherwise
+ * @Return:               Number of handlers collected in th_match_arr
  */
-static bool cam_irq_controller_match_bit_mask(
+static uint32_t cam_irq_controller_collect_handlers(
 	struct cam_irq_controller   *controller,
-	struct cam_irq_evt_handler  *evt_handler)
+	enum cam_irq_priority_level  priority)
 {
-	int i;
+	struct cam_irq_evt_handler **match_arr = controller->th_match_arr;
+	struct cam_irq_evt_handler  *evt_handler;
+	struct cam_irq_bit_node     *node;
+	uint32_t                     num_match = 0;
+	uint32_t                     status, bit, seq;
+	uint32_t                     i, j;
+
+	seq = ++controller->dispatch_seq;
+	if (!seq)
+		seq = controller->dispatch_seq = 1;
 
 	for (i = 0; i < controller->num_registers; i++) {
-		if (evt_handler->evt_bit_mask_arr[i] &
-			controller->irq_status_arr[i])
-			return true;
+		status = controller->irq_status_arr[i];
+		while (status) {
+			bit = __ffs(status);
+			status &= ~BIT(bit);
+
+			list_for_each_entry(node, cam_irq_controller_bit_list(
+				controller, priority, i, bit), list) {
+				evt_handler = node->evt_handler;
+				if (evt_handler->dispatch_seq == seq)
+					continue;
+
+				evt_handler->dispatch_seq = seq;
+				for (j = num_match; j > 0 &&
+					match_arr[j - 1]->th_seq >
+					evt_handler->th_seq; j--)
+					match_arr[j] = match_arr[j - 1];
+				match_arr[j] = evt_handler;
+				num_match++;
+			}
+		}
 	}
 
-	return false;
+	return num_match;
 }
 
-static void cam_irq_controller_th_processing(
+static uint32_t cam_irq_controller_th_processing(
 	struct cam_irq_controller      *controller,
-	struct list_head               *th_list_head)
+	enum cam_irq_priority_level     priority)
 {
 	struct cam_irq_evt_handler     *evt_handler = NULL;
 	struct cam_irq_th_payload      *th_payload = &controller->th_payload;
-	bool                            is_irq_match;
 	int                             rc = -EINVAL;
 	int                             i;
+	uint32_t                        k, num_match;
 	void                           *bh_cmd = NULL;
 	struct cam_irq_bh_api          *irq_bh_api = NULL;
 
 	CAM_DBG(CAM_IRQ_CTRL, "Enter");
 
-	if (list_empty(th_list_head))
-		return;
-
-	list_for_each_entry(evt_handler, th_list_head, th_list_node) {
-		is_irq_match = cam_irq_controller_match_bit_mask(controller,
-			evt_handler);
-
-		if (!is_irq_match)
-			continue;
+	num_match = cam_irq_controller_collect_handlers(controller, priority);
 
+	for (k = 0; k < num_match; k++) {
+		evt_handler = controller->th_match_arr[k];
 		CAM_DBG(CAM_IRQ_CTRL, "match found");
 
 		cam_irq_th_payload_init(th_payload);
@@ -655,6 +880,8 @@ static void cam_irq_controller_th_processing(
 	}
 
 	CAM_DBG(CAM_IRQ_CTRL, "Exit");
+
+	return num_match;
 }
 
 irqreturn_t cam_irq_controller_clear_and_mask(int irq_num, void *priv)
@@ -689,12 +916,19 @@ irqreturn_t cam_irq_controller_handle_irq(int irq_num, void *priv)
 	struct cam_irq_controller   *controller  = priv;
 	struct cam_irq_register_obj *irq_register;
 	bool         need_th_processing[CAM_IRQ_PRIORITY_MAX] = {false};
+	bool         trace_th;
+	uint64_t     th_start = 0;
+	uint32_t     num_handlers = 0;
 	int          i;
 	int          j;
 
 	if (!controller)
 		return IRQ_NONE;
 
+	trace_th = trace_cam_irq_th_duration_enabled();
+	if (trace_th)
+		th_start = ktime_get_ns();
+
 	CAM_DBG(CAM_IRQ_CTRL,
 		"Locking: %s IRQ Controller: [%pK], lock handle: %pK",
 		controller->name, controller, &controller->lock);
@@ -748,11 +982,15 @@ irqreturn_t cam_irq_controller_handle_irq(int irq_num, void *priv)
 	for (i = 0; i < CAM_IRQ_PRIORITY_MAX; i++) {
 		if (need_th_processing[i]) {
 			CAM_DBG(CAM_IRQ_CTRL, "Invoke TH processing");
-			cam_irq_controller_th_processing(controller,
-				&controller->th_list_head[i]);
+			num_handlers += cam_irq_controller_th_processing(
+				controller, i);
 		}
 	}
 	spin_unlock(&controller->lock);
+
+	if (trace_th)
+		trace_cam_irq_th_duration(controller->name,
+			ktime_get_ns() - th_start, num_handlers);
 	CAM_DBG(CAM_IRQ_CTRL,
 		"Unlocked: %s IRQ Controller: %pK, lock handle: %pK",
 		controller->name, controller, &controller->lock);
@@ -11,6 +11,7 @@
 #include <linux/list.h>
 #include <media/cam_isp.h>
 #include "cam_hw_mgr_intf.h"
+#include "cam_common_util.h"
 
 /* MAX IFE instance */
 #define CAM_IFE_HW_NUM_MAX   7
@@ -134,6 +135,7 @@ struct cam_isp_bw_config_internal {
  * @reg_dump_buf_desc:     cmd buffer descriptors for reg dump
  * @num_reg_dump_buf:      Count of descriptors in reg_dump_buf_desc
  * @packet                 CSL packet from user mode driver
+ * @lat_tracker:           Latency tracker of the owning context
  *
  */
 struct cam_isp_prepare_hw_update_data {
@@ -150,6 +152,7 @@ struct cam_isp_prepare_hw_update_data {
 						CAM_REG_DUMP_MAX_BUF_ENTRIES];
 	uint32_t                              num_reg_dump_buf;
 	struct cam_packet                     *packet;
+	struct cam_common_lat_tracker         *lat_tracker;
 };
 
 
@@ -242,6 +245,7 @@ enum cam_isp_hw_mgr_command {
 	CAM_ISP_HW_MGR_GET_PACKET_OPCODE,
 	CAM_ISP_HW_MGR_GET_LAST_CDM_DONE,
 	CAM_ISP_HW_MGR_CMD_UPDATE_CLOCK,
+	CAM_ISP_HW_MGR_CMD_WM_SHADOW_INVALIDATE,
 	CAM_ISP_HW_MGR_CMD_MAX,
 };
 
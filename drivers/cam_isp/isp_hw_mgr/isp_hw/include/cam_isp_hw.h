@@ -139,6 +139,7 @@ enum cam_isp_hw_cmd_type {
 	CAM_ISP_HW_CMD_DYNAMIC_CLOCK_UPDATE,
 	CAM_ISP_HW_DUMP_HW_SRC_CLK_RATE,
 	CAM_ISP_HW_CMD_TPG_SET_PATTERN,
+	CAM_ISP_HW_CMD_WM_SHADOW_INVALIDATE,
 	CAM_ISP_HW_CMD_MAX,
 };
 
@@ -398,4 +399,120 @@ struct cam_isp_hw_bus_cap {
 	uint32_t                max_vfe_out_res_type;
 };
 
+/*
+ * enum cam_isp_wm_shadow_reg:
+ *
+ * @Brief:         Write master registers tracked by the WM shadow. Image
+ *                 address is not tracked since it is written every frame
+ *                 and on some targets feeds an address fifo.
+ */
+enum cam_isp_wm_shadow_reg {
+	CAM_ISP_WM_SHADOW_CFG,
+	CAM_ISP_WM_SHADOW_IMAGE_CFG_0,
+	CAM_ISP_WM_SHADOW_IMAGE_CFG_1,
+	CAM_ISP_WM_SHADOW_IMAGE_CFG_2,
+	CAM_ISP_WM_SHADOW_FRAME_INCR,
+	CAM_ISP_WM_SHADOW_MAX,
+};
+
+/**
+ * struct cam_isp_wm_shadow:
+ *
+ * @Brief:         Last value queued to CDM for each tracked WM register
+ *
+ * @val:           Last queued value per register
+ * @valid_mask:    Bit mask of registers holding a valid shadow value,
+ *                 cleared to force full programming on the next update
+ * @queued_mask:   Bit mask of registers queued since the WM was reserved,
+ *                 kept across invalidation. Requests already prepared may
+ *                 rely on these, so start restores them after a reset.
+ * @regs_written:  Number of tracked register writes queued
+ * @regs_skipped:  Number of tracked register writes dropped as unchanged
+ */
+struct cam_isp_wm_shadow {
+	uint32_t                val[CAM_ISP_WM_SHADOW_MAX];
+	uint32_t                valid_mask;
+	uint32_t                queued_mask;
+	uint64_t                regs_written;
+	uint64_t                regs_skipped;
+};
+
+/*
+ * cam_isp_wm_shadow_invalidate()
+ *
+ * @brief:         Force the next update of this WM to program all tracked
+ *                 registers, used on init, reset and recovery
+ *
+ * @shadow:        WM shadow
+ */
+static inline void cam_isp_wm_shadow_invalidate(
+	struct cam_isp_wm_shadow *shadow)
+{
+	shadow->valid_mask = 0;
+}
+
+/*
+ * cam_isp_wm_shadow_reset()
+ *
+ * @brief:         Drop all shadow state, used when the WM is released
+ *
+ * @shadow:        WM shadow
+ */
+static inline void cam_isp_wm_shadow_reset(
+	struct cam_isp_wm_shadow *shadow)
+{
+	shadow->valid_mask = 0;
+	shadow->queued_mask = 0;
+}
+
+/*
+ * cam_isp_wm_shadow_get()
+ *
+ * @brief:         Get the last queued value of a tracked WM register
+ *
+ * @shadow:        WM shadow
+ * @reg:           Tracked register
+ * @val:           Last queued value
+ *
+ * @return:        true if a value was queued since the WM was reserved
+ */
+static inline bool cam_isp_wm_shadow_get(
+	struct cam_isp_wm_shadow *shadow,
+	enum cam_isp_wm_shadow_reg reg, uint32_t *val)
+{
+	if (!(shadow->queued_mask & BIT(reg)))
+		return false;
+
+	*val = shadow->val[reg];
+	return true;
+}
+
+/*
+ * cam_isp_wm_shadow_update()
+ *
+ * @brief:         Check a tracked WM register against its shadow and
+ *                 update the shadow with the new value
+ *
+ * @shadow:        WM shadow
+ * @reg:           Tracked register
+ * @val:           Value to be programmed
+ *
+ * @return:        true if the register needs to be programmed
+ */
+static inline bool cam_isp_wm_shadow_update(
+	struct cam_isp_wm_shadow *shadow,
+	enum cam_isp_wm_shadow_reg reg, uint32_t val)
+{
+	if ((shadow->valid_mask & BIT(reg)) && (shadow->val[reg] == val)) {
+		shadow->regs_skipped++;
+		return false;
+	}
+
+	shadow->val[reg] = val;
+	shadow->valid_mask |= BIT(reg);
+	shadow->queued_mask |= BIT(reg);
+	shadow->regs_written++;
+	return true;
+}
+
 #endif /* _CAM_ISP_HW_H_ */
@@ -123,6 +123,8 @@ struct cam_sfe_bus_wr_wm_resource_data {
 
 	uint32_t             acquired_width;
 	uint32_t             acquired_height;
+
+	struct cam_isp_wm_shadow  shadow;
 };
 
 struct cam_sfe_bus_wr_comp_grp_data {
@@ -511,6 +513,7 @@ static int cam_sfe_bus_release_wm(void   *bus_priv,
 	rsrc_data->hfr_cfg_done = false;
 	rsrc_data->en_cfg = 0;
 	rsrc_data->is_dual = 0;
+	cam_isp_wm_shadow_reset(&rsrc_data->shadow);
 
 	wm_res->tasklet_info = NULL;
 	wm_res->res_state = CAM_ISP_RESOURCE_STATE_AVAILABLE;
@@ -521,6 +524,27 @@ static int cam_sfe_bus_release_wm(void   *bus_priv,
 	return 0;
 }
 
+/*
+ * Prepared requests leave out WM registers matching the shadow, restore
+ * the last queued values since a reset may have cleared them.
+ */
+static void cam_sfe_bus_restore_wm_shadow(
+	struct cam_sfe_bus_wr_wm_resource_data *rsrc_data)
+{
+	void __iomem *mem_base = rsrc_data->common_data->mem_base;
+	uint32_t val;
+
+	if (cam_isp_wm_shadow_get(&rsrc_data->shadow,
+		CAM_ISP_WM_SHADOW_IMAGE_CFG_1, &val))
+		cam_io_w(val, mem_base + rsrc_data->hw_regs->image_cfg_1);
+	if (cam_isp_wm_shadow_get(&rsrc_data->shadow,
+		CAM_ISP_WM_SHADOW_IMAGE_CFG_2, &val))
+		cam_io_w(val, mem_base + rsrc_data->hw_regs->image_cfg_2);
+	if (cam_isp_wm_shadow_get(&rsrc_data->shadow,
+		CAM_ISP_WM_SHADOW_FRAME_INCR, &val))
+		cam_io_w(val, mem_base + rsrc_data->hw_regs->frame_incr);
+}
+
 static int cam_sfe_bus_start_wm(struct cam_isp_resource_node *wm_res)
 {
 	const uint32_t image_cfg_height_shift_val = 16;
@@ -534,6 +558,7 @@ static int cam_sfe_bus_start_wm(struct cam_isp_resource_node *wm_res)
 		rsrc_data->hw_regs->image_cfg_0);
 	cam_io_w(rsrc_data->pack_fmt,
 		common_data->mem_base + rsrc_data->hw_regs->packer_cfg);
+	cam_sfe_bus_restore_wm_shadow(rsrc_data);
 
 	/* Enable WM */
 	cam_io_w_mb(rsrc_data->en_cfg, common_data->mem_base +
@@ -568,6 +593,11 @@ static int cam_sfe_bus_stop_wm(struct cam_isp_resource_node *wm_res)
 	wm_res->res_state = CAM_ISP_RESOURCE_STATE_RESERVED;
 	rsrc_data->init_cfg_done = false;
 	rsrc_data->hfr_cfg_done = false;
+	cam_isp_wm_shadow_invalidate(&rsrc_data->shadow);
+	CAM_DBG(CAM_SFE, "SFE:%d WM:%d shadow regs written:%llu skipped:%llu",
+		rsrc_data->common_data->core_index, rsrc_data->index,
+		rsrc_data->shadow.regs_written,
+		rsrc_data->shadow.regs_skipped);
 
 	return 0;
 }
@@ -1693,6 +1723,7 @@ static int cam_sfe_bus_wr_update_wm(void *priv, void *cmd_args,
 	uint32_t  i, j, k, size = 0;
 	uint32_t  frame_inc = 0, val;
 	uint32_t loop_size = 0, stride = 0, slice_h = 0;
+	uint64_t  skipped;
 
 	bus_priv = (struct cam_sfe_bus_wr_priv  *) priv;
 	update_buf =  (struct cam_isp_hw_get_cmd_update *) cmd_args;
@@ -1728,17 +1759,16 @@ static int cam_sfe_bus_wr_update_wm(void *priv, void *cmd_args,
 
 		wm_data = (struct cam_sfe_bus_wr_wm_resource_data *)
 			sfe_out_data->wm_res[i].res_priv;
-
-		CAM_SFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
-			wm_data->hw_regs->cfg, wm_data->en_cfg);
-		CAM_DBG(CAM_SFE, "WM:%d en_cfg 0x%X",
-			wm_data->index, reg_val_pair[j-1]);
+		skipped = wm_data->shadow.regs_skipped;
 
 		val = (wm_data->height << 16) | wm_data->width;
-		CAM_SFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
-			wm_data->hw_regs->image_cfg_0, val);
-		CAM_DBG(CAM_SFE, "WM:%d image height and width 0x%X",
-			wm_data->index, reg_val_pair[j-1]);
+		if (cam_isp_wm_shadow_update(&wm_data->shadow,
+			CAM_ISP_WM_SHADOW_IMAGE_CFG_0, val)) {
+			CAM_SFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
+				wm_data->hw_regs->image_cfg_0, val);
+			CAM_DBG(CAM_SFE, "WM:%d image height and width 0x%X",
+				wm_data->index, reg_val_pair[j-1]);
+		}
 
 		/* For initial configuration program all bus registers */
 		if (update_buf->use_scratch_cfg) {
@@ -1757,18 +1787,21 @@ static int cam_sfe_bus_wr_update_wm(void *priv, void *cmd_args,
 			CAM_WARN(CAM_SFE, "Warning stride %u expected %u",
 				stride, val);
 
-		if (wm_data->stride != val || !wm_data->init_cfg_done) {
+		if (cam_isp_wm_shadow_update(&wm_data->shadow,
+			CAM_ISP_WM_SHADOW_IMAGE_CFG_2, stride)) {
 			CAM_SFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
 				wm_data->hw_regs->image_cfg_2,
 				stride);
-			wm_data->stride = val;
 			CAM_DBG(CAM_SFE, "WM:%d image stride 0x%X",
 				wm_data->index, reg_val_pair[j-1]);
 		}
+		wm_data->stride = val;
 
 		frame_inc = stride * slice_h;
 
-		if (!(wm_data->en_cfg & (0x3 << 16))) {
+		if (!(wm_data->en_cfg & (0x3 << 16)) &&
+			cam_isp_wm_shadow_update(&wm_data->shadow,
+			CAM_ISP_WM_SHADOW_IMAGE_CFG_1, wm_data->h_init)) {
 			CAM_SFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
 				wm_data->hw_regs->image_cfg_1, wm_data->h_init);
 			CAM_DBG(CAM_SFE, "WM:%d h_init 0x%X",
@@ -1797,15 +1830,26 @@ static int cam_sfe_bus_wr_update_wm(void *priv, void *cmd_args,
 				wm_data->index, reg_val_pair[j-1]);
 		}
 
-		CAM_SFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
-			wm_data->hw_regs->frame_incr, frame_inc);
-		CAM_DBG(CAM_SFE, "WM:%d frame_inc %d",
-			wm_data->index, reg_val_pair[j-1]);
+		if (cam_isp_wm_shadow_update(&wm_data->shadow,
+			CAM_ISP_WM_SHADOW_FRAME_INCR, frame_inc)) {
+			CAM_SFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
+				wm_data->hw_regs->frame_incr, frame_inc);
+			CAM_DBG(CAM_SFE, "WM:%d frame_inc %d",
+				wm_data->index, reg_val_pair[j-1]);
+		}
 
 		/* enable the WM */
-		CAM_SFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
-			wm_data->hw_regs->cfg,
-			wm_data->en_cfg);
+		if (cam_isp_wm_shadow_update(&wm_data->shadow,
+			CAM_ISP_WM_SHADOW_CFG, wm_data->en_cfg)) {
+			CAM_SFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
+				wm_data->hw_regs->cfg,
+				wm_data->en_cfg);
+			CAM_DBG(CAM_SFE, "WM:%d en_cfg 0x%X",
+				wm_data->index, reg_val_pair[j-1]);
+		}
+
+		CAM_DBG(CAM_SFE, "WM:%d skipped %llu unchanged regs",
+			wm_data->index, wm_data->shadow.regs_skipped - skipped);
 
 		/* set initial configuration done */
 		if (!wm_data->init_cfg_done)
@@ -2050,6 +2094,31 @@ static int cam_sfe_bus_wr_stop_hw(void *hw_priv,
 	return cam_sfe_bus_stop_sfe_out(hw_priv);
 }
 
+static int cam_sfe_bus_wr_invalidate_wm_shadow(
+	struct cam_sfe_bus_wr_priv *bus_priv)
+{
+	int                                       i, j;
+	struct cam_sfe_bus_wr_out_data           *out_data;
+	struct cam_sfe_bus_wr_wm_resource_data   *wm_data;
+
+	for (i = 0; i < bus_priv->num_out; i++) {
+		out_data = bus_priv->sfe_out[i].res_priv;
+		if (!out_data || !out_data->wm_res)
+			continue;
+
+		for (j = 0; j < out_data->num_wm; j++) {
+			wm_data = out_data->wm_res[j].res_priv;
+			if (wm_data)
+				cam_isp_wm_shadow_invalidate(&wm_data->shadow);
+		}
+	}
+
+	CAM_DBG(CAM_SFE, "SFE:%d WM shadow invalidated",
+		bus_priv->common_data.core_index);
+
+	return 0;
+}
+
 static int cam_sfe_bus_wr_init_hw(void *hw_priv,
 	void *init_hw_args, uint32_t arg_size)
 {
@@ -2184,6 +2253,10 @@ static int cam_sfe_bus_wr_process_cmd(
 	case CAM_ISP_HW_CMD_WM_CONFIG_UPDATE:
 		rc = cam_sfe_bus_wr_update_wm_config(cmd_args);
 		break;
+	case CAM_ISP_HW_CMD_WM_SHADOW_INVALIDATE:
+		bus_priv = (struct cam_sfe_bus_wr_priv  *) priv;
+		rc = cam_sfe_bus_wr_invalidate_wm_shadow(bus_priv);
+		break;
 	default:
 		CAM_ERR_RATE_LIMIT(CAM_SFE, "Invalid HW command type:%d",
 			cmd_type);
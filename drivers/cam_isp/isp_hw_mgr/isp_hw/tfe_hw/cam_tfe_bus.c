@@ -103,6 +103,8 @@ struct cam_tfe_bus_wm_resource_data {
 	uint32_t             acquired_width;
 	uint32_t             acquired_height;
 	uint32_t             acquired_stride;
+
+	struct cam_isp_wm_shadow  shadow;
 };
 
 struct cam_tfe_bus_comp_grp_data {
@@ -726,6 +728,7 @@ static int cam_tfe_bus_release_wm(void   *bus_priv,
 	rsrc_data->framedrop_pattern = 0;
 	rsrc_data->en_cfg = 0;
 	rsrc_data->is_dual = 0;
+	cam_isp_wm_shadow_reset(&rsrc_data->shadow);
 
 	wm_res->tasklet_info = NULL;
 	wm_res->res_state = CAM_ISP_RESOURCE_STATE_AVAILABLE;
@@ -736,6 +739,27 @@ static int cam_tfe_bus_release_wm(void   *bus_priv,
 	return 0;
 }
 
+/*
+ * Prepared requests leave out WM registers matching the shadow, restore
+ * the last queued values since a reset may have cleared them.
+ */
+static void cam_tfe_bus_restore_wm_shadow(
+	struct cam_tfe_bus_wm_resource_data *rsrc_data)
+{
+	void __iomem *mem_base = rsrc_data->common_data->mem_base;
+	uint32_t val;
+
+	if (cam_isp_wm_shadow_get(&rsrc_data->shadow,
+		CAM_ISP_WM_SHADOW_IMAGE_CFG_1, &val))
+		cam_io_w(val, mem_base + rsrc_data->hw_regs->image_cfg_1);
+	if (cam_isp_wm_shadow_get(&rsrc_data->shadow,
+		CAM_ISP_WM_SHADOW_IMAGE_CFG_2, &val))
+		cam_io_w(val, mem_base + rsrc_data->hw_regs->image_cfg_2);
+	if (cam_isp_wm_shadow_get(&rsrc_data->shadow,
+		CAM_ISP_WM_SHADOW_FRAME_INCR, &val))
+		cam_io_w(val, mem_base + rsrc_data->hw_regs->frame_incr);
+}
+
 static int cam_tfe_bus_start_wm(struct cam_isp_resource_node *wm_res)
 {
 	struct cam_tfe_bus_wm_resource_data   *rsrc_data =
@@ -749,6 +773,7 @@ static int cam_tfe_bus_start_wm(struct cam_isp_resource_node *wm_res)
 		common_data->mem_base + rsrc_data->hw_regs->image_cfg_0);
 	cam_io_w(rsrc_data->pack_fmt,
 		common_data->mem_base + rsrc_data->hw_regs->packer_cfg);
+	cam_tfe_bus_restore_wm_shadow(rsrc_data);
 
 	/* Configure stride for RDIs on full TFE and TFE lite  */
 	if ((rsrc_data->index > 6) &&
@@ -794,6 +819,11 @@ static int cam_tfe_bus_stop_wm(struct cam_isp_resource_node *wm_res)
 		rsrc_data->common_data->core_index, rsrc_data->index);
 
 	wm_res->res_state = CAM_ISP_RESOURCE_STATE_RESERVED;
+	cam_isp_wm_shadow_invalidate(&rsrc_data->shadow);
+	CAM_DBG(CAM_ISP, "TFE:%d WM:%d shadow regs written:%llu skipped:%llu",
+		rsrc_data->common_data->core_index, rsrc_data->index,
+		rsrc_data->shadow.regs_written,
+		rsrc_data->shadow.regs_skipped);
 
 	return 0;
 }
@@ -1884,6 +1914,7 @@ static int cam_tfe_bus_update_wm(void *priv, void *cmd_args,
 	uint32_t *reg_val_pair;
 	uint32_t i, j, size = 0;
 	uint32_t frame_inc = 0, val;
+	uint64_t skipped;
 
 	bus_priv = (struct cam_tfe_bus_priv  *) priv;
 	update_buf = (struct cam_isp_hw_get_cmd_update *) cmd_args;
@@ -1915,22 +1946,32 @@ static int cam_tfe_bus_update_wm(void *priv, void *cmd_args,
 		}
 
 		wm_data = tfe_out_data->wm_res[i]->res_priv;
+		skipped = wm_data->shadow.regs_skipped;
 		/* update width register */
 		val = ((wm_data->height << 16) | (wm_data->width & 0xFFFF));
-		CAM_TFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
-			wm_data->hw_regs->image_cfg_0, val);
-		CAM_DBG(CAM_ISP, "WM:%d image height and width 0x%x",
-			wm_data->index, reg_val_pair[j-1]);
+		if (cam_isp_wm_shadow_update(&wm_data->shadow,
+			CAM_ISP_WM_SHADOW_IMAGE_CFG_0, val)) {
+			CAM_TFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
+				wm_data->hw_regs->image_cfg_0, val);
+			CAM_DBG(CAM_ISP, "WM:%d image height and width 0x%x",
+				wm_data->index, reg_val_pair[j-1]);
+		}
 
 		val = wm_data->offset;
-		CAM_TFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
-			wm_data->hw_regs->image_cfg_1, val);
-		CAM_DBG(CAM_ISP, "WM:%d xinit 0x%x",
-			wm_data->index, reg_val_pair[j-1]);
+		if (cam_isp_wm_shadow_update(&wm_data->shadow,
+			CAM_ISP_WM_SHADOW_IMAGE_CFG_1, val)) {
+			CAM_TFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
+				wm_data->hw_regs->image_cfg_1, val);
+			CAM_DBG(CAM_ISP, "WM:%d xinit 0x%x",
+				wm_data->index, reg_val_pair[j-1]);
+		}
 
-		if ((wm_data->index < 7) || ((wm_data->index >= 7) &&
+		if (((wm_data->index < 7) || ((wm_data->index >= 7) &&
 			(wm_data->mode == CAM_ISP_TFE_WM_LINE_BASED_MODE)) ||
-			(wm_data->out_id == CAM_TFE_BUS_TFE_OUT_PDAF)) {
+			(wm_data->out_id == CAM_TFE_BUS_TFE_OUT_PDAF)) &&
+			cam_isp_wm_shadow_update(&wm_data->shadow,
+			CAM_ISP_WM_SHADOW_IMAGE_CFG_2,
+			io_cfg->planes[i].plane_stride)) {
 			CAM_TFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
 				wm_data->hw_regs->image_cfg_2,
 				io_cfg->planes[i].plane_stride);
@@ -1949,15 +1990,23 @@ static int cam_tfe_bus_update_wm(void *priv, void *cmd_args,
 			wm_data->index, reg_val_pair[j-1]);
 		update_buf->wm_update->image_buf_offset[i] = 0;
 
-		CAM_TFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
-			wm_data->hw_regs->frame_incr, frame_inc);
-		CAM_DBG(CAM_ISP, "WM %d frame_inc %d",
-			wm_data->index, reg_val_pair[j-1]);
+		if (cam_isp_wm_shadow_update(&wm_data->shadow,
+			CAM_ISP_WM_SHADOW_FRAME_INCR, frame_inc)) {
+			CAM_TFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
+				wm_data->hw_regs->frame_incr, frame_inc);
+			CAM_DBG(CAM_ISP, "WM %d frame_inc %d",
+				wm_data->index, reg_val_pair[j-1]);
+		}
 
 		/* enable the WM */
-		CAM_TFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
-			wm_data->hw_regs->cfg,
-			wm_data->en_cfg);
+		if (cam_isp_wm_shadow_update(&wm_data->shadow,
+			CAM_ISP_WM_SHADOW_CFG, wm_data->en_cfg))
+			CAM_TFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
+				wm_data->hw_regs->cfg,
+				wm_data->en_cfg);
+
+		CAM_DBG(CAM_ISP, "WM %d skipped %llu unchanged regs",
+			wm_data->index, wm_data->shadow.regs_skipped - skipped);
 	}
 
 	size = tfe_out_data->cdm_util_ops->cdm_required_size_reg_random(j/2);
@@ -2209,6 +2258,24 @@ static int cam_tfe_bus_dump_bus_info(
 	return 0;
 }
 
+static int cam_tfe_bus_invalidate_wm_shadow(void *priv)
+{
+	struct cam_tfe_bus_priv                *bus_priv = priv;
+	struct cam_tfe_bus_wm_resource_data    *wm_data;
+	int                                     i;
+
+	for (i = 0; i < bus_priv->num_client; i++) {
+		wm_data = bus_priv->bus_client[i].res_priv;
+		if (wm_data)
+			cam_isp_wm_shadow_invalidate(&wm_data->shadow);
+	}
+
+	CAM_DBG(CAM_ISP, "TFE:%d WM shadow invalidated",
+		bus_priv->common_data.core_index);
+
+	return 0;
+}
+
 static int cam_tfe_bus_init_hw(void *hw_priv,
 	void *init_hw_args, uint32_t arg_size)
 {
@@ -2314,6 +2381,9 @@ static int cam_tfe_bus_process_cmd(void *priv,
 	case CAM_ISP_HW_CMD_DUMP_BUS_INFO:
 		rc = cam_tfe_bus_dump_bus_info(priv, cmd_args, arg_size);
 		break;
+	case CAM_ISP_HW_CMD_WM_SHADOW_INVALIDATE:
+		rc = cam_tfe_bus_invalidate_wm_shadow(priv);
+		break;
 	default:
 		CAM_ERR_RATE_LIMIT(CAM_ISP, "Invalid camif process command:%d",
 			cmd_type);
@@ -152,6 +152,8 @@ struct cam_vfe_bus_ver2_wm_resource_data {
 	uint32_t             ubwc_bandwidth_limit;
 	uint32_t             acquired_width;
 	uint32_t             acquired_height;
+
+	struct cam_isp_wm_shadow  shadow;
 };
 
 struct cam_vfe_bus_ver2_comp_grp_data {
@@ -1406,6 +1408,7 @@ static int cam_vfe_bus_release_wm(void   *bus_priv,
 	rsrc_data->hfr_cfg_done = false;
 	rsrc_data->en_cfg = 0;
 	rsrc_data->is_dual = 0;
+	cam_isp_wm_shadow_reset(&rsrc_data->shadow);
 
 	rsrc_data->ubwc_lossy_threshold_0 = 0;
 	rsrc_data->ubwc_lossy_threshold_1 = 0;
@@ -1416,6 +1419,28 @@ static int cam_vfe_bus_release_wm(void   *bus_priv,
 	return 0;
 }
 
+/*
+ * Prepared requests leave out WM registers matching the shadow, restore
+ * the last queued values since a reset may have cleared them. WM enable
+ * is part of the shadow here, start does not program it.
+ */
+static void cam_vfe_bus_restore_wm_shadow(
+	struct cam_vfe_bus_ver2_wm_resource_data *rsrc_data)
+{
+	void __iomem *mem_base = rsrc_data->common_data->mem_base;
+	uint32_t val;
+
+	if (cam_isp_wm_shadow_get(&rsrc_data->shadow,
+		CAM_ISP_WM_SHADOW_IMAGE_CFG_2, &val))
+		cam_io_w(val, mem_base + rsrc_data->hw_regs->stride);
+	if (cam_isp_wm_shadow_get(&rsrc_data->shadow,
+		CAM_ISP_WM_SHADOW_FRAME_INCR, &val))
+		cam_io_w(val, mem_base + rsrc_data->hw_regs->frame_inc);
+	if (cam_isp_wm_shadow_get(&rsrc_data->shadow,
+		CAM_ISP_WM_SHADOW_CFG, &val))
+		cam_io_w_mb(val, mem_base + rsrc_data->hw_regs->cfg);
+}
+
 static int cam_vfe_bus_start_wm(
 	struct cam_isp_resource_node *wm_res,
 	uint32_t                     *bus_irq_reg_mask)
@@ -1512,6 +1537,7 @@ static int cam_vfe_bus_start_wm(
 	/* enabling Wm configuratons are taken care in update_wm().
 	 * i.e enable wm only if io buffers are allocated
 	 */
+	cam_vfe_bus_restore_wm_shadow(rsrc_data);
 
 	CAM_DBG(CAM_ISP, "WM res %d width = %d, height = %d", rsrc_data->index,
 		rsrc_data->width, rsrc_data->height);
@@ -1545,6 +1571,10 @@ static int cam_vfe_bus_stop_wm(struct cam_isp_resource_node *wm_res)
 	wm_res->res_state = CAM_ISP_RESOURCE_STATE_RESERVED;
 	rsrc_data->init_cfg_done = false;
 	rsrc_data->hfr_cfg_done = false;
+	cam_isp_wm_shadow_invalidate(&rsrc_data->shadow);
+	CAM_DBG(CAM_ISP, "WM %d shadow regs written:%llu skipped:%llu",
+		rsrc_data->index, rsrc_data->shadow.regs_written,
+		rsrc_data->shadow.regs_skipped);
 
 	return rc;
 }
@@ -3222,6 +3252,7 @@ static int cam_vfe_bus_update_wm(void *priv, void *cmd_args,
 	uint32_t  i, j, k, size = 0;
 	uint32_t  frame_inc = 0, val;
 	uint32_t loop_size = 0;
+	uint64_t  skipped;
 
 	bus_priv = (struct cam_vfe_bus_ver2_priv  *) priv;
 	update_buf =  (struct cam_isp_hw_get_cmd_update *) cmd_args;
@@ -3254,12 +3285,16 @@ static int cam_vfe_bus_update_wm(void *priv, void *cmd_args,
 
 		wm_data = vfe_out_data->wm_res[i]->res_priv;
 		ubwc_client = wm_data->hw_regs->ubwc_regs;
+		skipped = wm_data->shadow.regs_skipped;
 		/* update width register */
-		CAM_VFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
-			wm_data->hw_regs->buffer_width_cfg,
-			wm_data->width);
-		CAM_DBG(CAM_ISP, "WM %d image width 0x%x",
-			wm_data->index, reg_val_pair[j-1]);
+		if (cam_isp_wm_shadow_update(&wm_data->shadow,
+			CAM_ISP_WM_SHADOW_IMAGE_CFG_0, wm_data->width)) {
+			CAM_VFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
+				wm_data->hw_regs->buffer_width_cfg,
+				wm_data->width);
+			CAM_DBG(CAM_ISP, "WM %d image width 0x%x",
+				wm_data->index, reg_val_pair[j-1]);
+		}
 
 		/* For initial configuration program all bus registers */
 		val = io_cfg->planes[i].plane_stride;
@@ -3272,8 +3307,10 @@ static int cam_vfe_bus_update_wm(void *priv, void *cmd_args,
 				io_cfg->planes[i].plane_stride,
 				val);
 
-		if ((wm_data->stride != val ||
-			!wm_data->init_cfg_done) && (wm_data->index >= 3)) {
+		if ((wm_data->index >= 3) &&
+			cam_isp_wm_shadow_update(&wm_data->shadow,
+			CAM_ISP_WM_SHADOW_IMAGE_CFG_2,
+			io_cfg->planes[i].plane_stride)) {
 			CAM_VFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
 				wm_data->hw_regs->stride,
 				io_cfg->planes[i].plane_stride);
@@ -3341,16 +3378,23 @@ static int cam_vfe_bus_update_wm(void *priv, void *cmd_args,
 				wm_data->index, reg_val_pair[j-1]);
 		}
 
-		CAM_VFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
-			wm_data->hw_regs->frame_inc, frame_inc);
-		CAM_DBG(CAM_ISP, "WM %d frame_inc %d",
-			wm_data->index, reg_val_pair[j-1]);
-
+		if (cam_isp_wm_shadow_update(&wm_data->shadow,
+			CAM_ISP_WM_SHADOW_FRAME_INCR, frame_inc)) {
+			CAM_VFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
+				wm_data->hw_regs->frame_inc, frame_inc);
+			CAM_DBG(CAM_ISP, "WM %d frame_inc %d",
+				wm_data->index, reg_val_pair[j-1]);
+		}
 
 		/* enable the WM */
-		CAM_VFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
-			wm_data->hw_regs->cfg,
-			wm_data->en_cfg);
+		if (cam_isp_wm_shadow_update(&wm_data->shadow,
+			CAM_ISP_WM_SHADOW_CFG, wm_data->en_cfg))
+			CAM_VFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
+				wm_data->hw_regs->cfg,
+				wm_data->en_cfg);
+
+		CAM_DBG(CAM_ISP, "WM %d skipped %llu unchanged regs",
+			wm_data->index, wm_data->shadow.regs_skipped - skipped);
 
 		/* set initial configuration done */
 		if (!wm_data->init_cfg_done)
@@ -3776,6 +3820,24 @@ static int cam_vfe_bus_update_stripe_cfg(void *priv, void *cmd_args,
 	return 0;
 }
 
+static int cam_vfe_bus_invalidate_wm_shadow(
+	struct cam_vfe_bus_ver2_priv *bus_priv)
+{
+	int                                          i;
+	struct cam_vfe_bus_ver2_wm_resource_data    *wm_data;
+
+	for (i = 0; i < bus_priv->num_client; i++) {
+		wm_data = bus_priv->bus_client[i].res_priv;
+		if (wm_data)
+			cam_isp_wm_shadow_invalidate(&wm_data->shadow);
+	}
+
+	CAM_DBG(CAM_ISP, "VFE:%d WM shadow invalidated",
+		bus_priv->common_data.core_index);
+
+	return 0;
+}
+
 static int cam_vfe_bus_start_hw(void *hw_priv,
 	void *start_hw_args, uint32_t arg_size)
 {
@@ -4057,6 +4119,10 @@ static int cam_vfe_bus_process_cmd(
 		vfe_bus_cap->support_consumed_addr =
 			bus_priv->common_data.support_consumed_addr;
 
+		break;
+	case CAM_ISP_HW_CMD_WM_SHADOW_INVALIDATE:
+		bus_priv = (struct cam_vfe_bus_ver2_priv *) priv;
+		rc = cam_vfe_bus_invalidate_wm_shadow(bus_priv);
 		break;
 	default:
 		CAM_ERR_RATE_LIMIT(CAM_ISP, "Invalid camif process command:%d",
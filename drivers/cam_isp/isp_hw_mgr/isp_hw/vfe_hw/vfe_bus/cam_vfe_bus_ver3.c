@@ -148,6 +148,8 @@ struct cam_vfe_bus_ver3_wm_resource_data {
 	uint32_t             ubwc_bandwidth_limit;
 	uint32_t             acquired_width;
 	uint32_t             acquired_height;
+
+	struct cam_isp_wm_shadow  shadow;
 };
 
 struct cam_vfe_bus_ver3_comp_grp_data {
@@ -1393,6 +1395,7 @@ static int cam_vfe_bus_ver3_release_wm(void   *bus_priv,
 	rsrc_data->ubwc_updated = false;
 	rsrc_data->en_cfg = 0;
 	rsrc_data->is_dual = 0;
+	cam_isp_wm_shadow_reset(&rsrc_data->shadow);
 
 	rsrc_data->ubwc_lossy_threshold_0 = 0;
 	rsrc_data->ubwc_lossy_threshold_1 = 0;
@@ -1407,6 +1410,27 @@ static int cam_vfe_bus_ver3_release_wm(void   *bus_priv,
 	return 0;
 }
 
+/*
+ * Prepared requests leave out WM registers matching the shadow, restore
+ * the last queued values since a reset may have cleared them.
+ */
+static void cam_vfe_bus_ver3_restore_wm_shadow(
+	struct cam_vfe_bus_ver3_wm_resource_data *rsrc_data)
+{
+	void __iomem *mem_base = rsrc_data->common_data->mem_base;
+	uint32_t val;
+
+	if (cam_isp_wm_shadow_get(&rsrc_data->shadow,
+		CAM_ISP_WM_SHADOW_IMAGE_CFG_1, &val))
+		cam_io_w(val, mem_base + rsrc_data->hw_regs->image_cfg_1);
+	if (cam_isp_wm_shadow_get(&rsrc_data->shadow,
+		CAM_ISP_WM_SHADOW_IMAGE_CFG_2, &val))
+		cam_io_w(val, mem_base + rsrc_data->hw_regs->image_cfg_2);
+	if (cam_isp_wm_shadow_get(&rsrc_data->shadow,
+		CAM_ISP_WM_SHADOW_FRAME_INCR, &val))
+		cam_io_w(val, mem_base + rsrc_data->hw_regs->frame_incr);
+}
+
 static int cam_vfe_bus_ver3_start_wm(struct cam_isp_resource_node *wm_res)
 {
 	const uint32_t enable_debug_status_1 = 11 << 8;
@@ -1427,6 +1451,7 @@ static int cam_vfe_bus_ver3_start_wm(struct cam_isp_resource_node *wm_res)
 		common_data->mem_base + rsrc_data->hw_regs->image_cfg_0);
 	cam_io_w(rsrc_data->pack_fmt,
 		common_data->mem_base + rsrc_data->hw_regs->packer_cfg);
+	cam_vfe_bus_ver3_restore_wm_shadow(rsrc_data);
 
 	/* enable ubwc if needed*/
 	if (rsrc_data->en_ubwc) {
@@ -1488,6 +1513,11 @@ static int cam_vfe_bus_ver3_stop_wm(struct cam_isp_resource_node *wm_res)
 	rsrc_data->init_cfg_done = false;
 	rsrc_data->hfr_cfg_done = false;
 	rsrc_data->ubwc_updated = false;
+	cam_isp_wm_shadow_invalidate(&rsrc_data->shadow);
+	CAM_DBG(CAM_ISP, "VFE:%d WM:%d shadow regs written:%llu skipped:%llu",
+		rsrc_data->common_data->core_index, rsrc_data->index,
+		rsrc_data->shadow.regs_written,
+		rsrc_data->shadow.regs_skipped);
 
 	return 0;
 }
@@ -2956,6 +2986,7 @@ static int cam_vfe_bus_ver3_update_wm(void *priv, void *cmd_args,
 	uint32_t *reg_val_pair;
 	uint32_t  i, j, size = 0;
 	uint32_t  frame_inc = 0, val;
+	uint64_t  skipped;
 
 	bus_priv = (struct cam_vfe_bus_ver3_priv  *) priv;
 	update_buf =  (struct cam_isp_hw_get_cmd_update *) cmd_args;
@@ -2988,6 +3019,7 @@ static int cam_vfe_bus_ver3_update_wm(void *priv, void *cmd_args,
 
 		wm_data = vfe_out_data->wm_res[i].res_priv;
 		ubwc_client = wm_data->hw_regs->ubwc_regs;
+		skipped = wm_data->shadow.regs_skipped;
 
 		/* Disable frame header in case it was previously enabled */
 		if ((wm_data->en_cfg) & (1 << 2))
@@ -3012,16 +3044,14 @@ static int cam_vfe_bus_ver3_update_wm(void *priv, void *cmd_args,
 			}
 		}
 
-		CAM_VFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
-			wm_data->hw_regs->cfg, wm_data->en_cfg);
-		CAM_DBG(CAM_ISP, "WM:%d en_cfg 0x%X",
-			wm_data->index, reg_val_pair[j-1]);
-
 		val = (wm_data->height << 16) | wm_data->width;
-		CAM_VFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
-			wm_data->hw_regs->image_cfg_0, val);
-		CAM_DBG(CAM_ISP, "WM:%d image height and width 0x%X",
-			wm_data->index, reg_val_pair[j-1]);
+		if (cam_isp_wm_shadow_update(&wm_data->shadow,
+			CAM_ISP_WM_SHADOW_IMAGE_CFG_0, val)) {
+			CAM_VFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
+				wm_data->hw_regs->image_cfg_0, val);
+			CAM_DBG(CAM_ISP, "WM:%d image height and width 0x%X",
+				wm_data->index, reg_val_pair[j-1]);
+		}
 
 		/* For initial configuration program all bus registers */
 		val = io_cfg->planes[i].plane_stride;
@@ -3032,14 +3062,16 @@ static int cam_vfe_bus_ver3_update_wm(void *priv, void *cmd_args,
 			CAM_WARN(CAM_ISP, "Warning stride %u expected %u",
 				io_cfg->planes[i].plane_stride, val);
 
-		if (wm_data->stride != val || !wm_data->init_cfg_done) {
+		if (cam_isp_wm_shadow_update(&wm_data->shadow,
+			CAM_ISP_WM_SHADOW_IMAGE_CFG_2,
+			io_cfg->planes[i].plane_stride)) {
 			CAM_VFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
 				wm_data->hw_regs->image_cfg_2,
 				io_cfg->planes[i].plane_stride);
-			wm_data->stride = val;
 			CAM_DBG(CAM_ISP, "WM:%d image stride 0x%X",
 				wm_data->index, reg_val_pair[j-1]);
 		}
+		wm_data->stride = val;
 
 		if (wm_data->en_ubwc) {
 			if (!wm_data->hw_regs->ubwc_regs) {
@@ -3078,7 +3110,9 @@ static int cam_vfe_bus_ver3_update_wm(void *priv, void *cmd_args,
 				io_cfg->planes[i].slice_height;
 		}
 
-		if (!(wm_data->en_cfg & (0x3 << 16))) {
+		if (!(wm_data->en_cfg & (0x3 << 16)) &&
+			cam_isp_wm_shadow_update(&wm_data->shadow,
+			CAM_ISP_WM_SHADOW_IMAGE_CFG_1, wm_data->h_init)) {
 			CAM_VFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
 				wm_data->hw_regs->image_cfg_1, wm_data->h_init);
 			CAM_DBG(CAM_ISP, "WM:%d h_init 0x%X",
@@ -3110,16 +3144,26 @@ static int cam_vfe_bus_ver3_update_wm(void *priv, void *cmd_args,
 		CAM_DBG(CAM_ISP, "WM:%d image address 0x%X",
 			wm_data->index, reg_val_pair[j-1]);
 
-		CAM_VFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
-			wm_data->hw_regs->frame_incr, frame_inc);
-		CAM_DBG(CAM_ISP, "WM:%d frame_inc %d",
-			wm_data->index, reg_val_pair[j-1]);
-
+		if (cam_isp_wm_shadow_update(&wm_data->shadow,
+			CAM_ISP_WM_SHADOW_FRAME_INCR, frame_inc)) {
+			CAM_VFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
+				wm_data->hw_regs->frame_incr, frame_inc);
+			CAM_DBG(CAM_ISP, "WM:%d frame_inc %d",
+				wm_data->index, reg_val_pair[j-1]);
+		}
 
 		/* enable the WM */
-		CAM_VFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
-			wm_data->hw_regs->cfg,
-			wm_data->en_cfg);
+		if (cam_isp_wm_shadow_update(&wm_data->shadow,
+			CAM_ISP_WM_SHADOW_CFG, wm_data->en_cfg)) {
+			CAM_VFE_ADD_REG_VAL_PAIR(reg_val_pair, j,
+				wm_data->hw_regs->cfg,
+				wm_data->en_cfg);
+			CAM_DBG(CAM_ISP, "WM:%d en_cfg 0x%X",
+				wm_data->index, reg_val_pair[j-1]);
+		}
+
+		CAM_DBG(CAM_ISP, "WM:%d skipped %llu unchanged regs",
+			wm_data->index, wm_data->shadow.regs_skipped - skipped);
 
 		/* set initial configuration done */
 		if (!wm_data->init_cfg_done)
@@ -3486,6 +3530,24 @@ static int cam_vfe_bus_ver3_update_wm_config(
 	return 0;
 }
 
+static int cam_vfe_bus_ver3_invalidate_wm_shadow(
+	struct cam_vfe_bus_ver3_priv *bus_priv)
+{
+	int                                          i;
+	struct cam_vfe_bus_ver3_wm_resource_data    *wm_data;
+
+	for (i = 0; i < bus_priv->num_client; i++) {
+		wm_data = bus_priv->bus_client[i].res_priv;
+		if (wm_data)
+			cam_isp_wm_shadow_invalidate(&wm_data->shadow);
+	}
+
+	CAM_DBG(CAM_ISP, "VFE:%d WM shadow invalidated",
+		bus_priv->common_data.core_index);
+
+	return 0;
+}
+
 static int cam_vfe_bus_ver3_start_hw(void *hw_priv,
 	void *start_hw_args, uint32_t arg_size)
 {
@@ -3761,6 +3823,10 @@ static int cam_vfe_bus_ver3_process_cmd(
 		vfe_bus_cap->support_consumed_addr =
 			bus_priv->common_data.support_consumed_addr;
 		break;
+	case CAM_ISP_HW_CMD_WM_SHADOW_INVALIDATE:
+		bus_priv = (struct cam_vfe_bus_ver3_priv *) priv;
+		rc = cam_vfe_bus_ver3_invalidate_wm_shadow(bus_priv);
+		break;
 	default:
 		CAM_ERR_RATE_LIMIT(CAM_ISP, "Invalid camif process command:%d",
 			cmd_type);
@@ -13,6 +13,7 @@
 #include <linux/spinlock.h>
 #include <linux/timer.h>
 #include <linux/debugfs.h>
+#include <linux/math64.h>
 #include <media/cam_defs.h>
 #include <media/cam_jpeg.h>
 #include <media/cam_sync.h>
@@ -42,49 +43,131 @@ static int32_t cam_jpeg_hw_mgr_cb(uint32_t irq_status,
 static int cam_jpeg_mgr_process_cmd(void *priv, void *data);
 static int cam_jpeg_insert_cdm_change_base(
 	struct cam_hw_config_args *config_args,
-	struct cam_jpeg_hw_ctx_data *ctx_data,
-	struct cam_jpeg_hw_mgr *hw_mgr);
+	struct cam_cdm_bl_request *cdm_cmd,
+	struct cam_jpeg_hw_mgr *hw_mgr, uint32_t dev_type, uint32_t dev_idx);
 
-static int cam_jpeg_process_next_hw_update(void *priv, void *data,
-	struct cam_hw_done_event_data *buf_data)
+static int cam_jpeg_mgr_get_free_dev(struct cam_jpeg_hw_mgr *hw_mgr,
+	uint32_t dev_type)
+{
+	int i;
+
+	for (i = 0; i < hw_mgr->num_devices[dev_type]; i++) {
+		if (!hw_mgr->device_in_use[dev_type][i])
+			return i;
+	}
+
+	return -EBUSY;
+}
+
+static int cam_jpeg_mgr_update_output_size(
+	struct cam_jpeg_hw_cfg_req *p_cfg_req)
 {
 	int rc;
-	int i = 0;
-	struct cam_jpeg_hw_mgr *hw_mgr = priv;
-	struct cam_hw_update_entry *cmd;
-	struct cam_cdm_bl_request *cdm_cmd;
-	struct cam_hw_config_args *config_args = NULL;
-	struct cam_jpeg_hw_ctx_data *ctx_data = NULL;
-	uint32_t dev_type;
-	struct cam_jpeg_hw_cfg_req *p_cfg_req = NULL;
-	uint32_t cdm_cfg_to_insert = 0;
+	int mem_hdl;
+	uintptr_t kaddr;
+	uint32_t *cmd_buf_kaddr;
+	size_t cmd_buf_len;
+	struct cam_jpeg_config_inout_param_info *p_params;
 
-	if (!data || !priv) {
-		CAM_ERR(CAM_JPEG, "Invalid data");
+	mem_hdl =
+		p_cfg_req->hw_cfg_args.hw_update_entries[CAM_JPEG_PARAM].handle;
+	rc = cam_mem_get_cpu_buf(mem_hdl, &kaddr, &cmd_buf_len);
+	if (rc) {
+		CAM_ERR(CAM_JPEG, "unable to get info for cmd buf: %x %d",
+			g_jpeg_hw_mgr.iommu_hdl, rc);
+		return rc;
+	}
+
+	cmd_buf_kaddr = (uint32_t *)kaddr;
+
+	if ((p_cfg_req->hw_cfg_args.hw_update_entries[CAM_JPEG_PARAM].offset /
+			sizeof(uint32_t)) >= cmd_buf_len) {
+		CAM_ERR(CAM_JPEG, "Invalid offset: %u cmd buf len: %zu",
+			p_cfg_req->hw_cfg_args.hw_update_entries[
+			CAM_JPEG_PARAM].offset, cmd_buf_len);
+		cam_mem_put_cpu_buf(mem_hdl);
 		return -EINVAL;
 	}
 
-	ctx_data = (struct cam_jpeg_hw_ctx_data *)data;
-	dev_type = ctx_data->jpeg_dev_acquire_info.dev_type;
-	p_cfg_req = hw_mgr->dev_hw_cfg_args[dev_type][0];
-	config_args = (struct cam_hw_config_args *)&p_cfg_req->hw_cfg_args;
+	cmd_buf_kaddr =
+		(cmd_buf_kaddr +
+		(p_cfg_req->hw_cfg_args.hw_update_entries[CAM_JPEG_PARAM].offset
+			/ sizeof(uint32_t)));
 
-	if (!hw_mgr->devices[dev_type][0]->hw_ops.reset) {
-		CAM_ERR(CAM_JPEG, "op reset null ");
-		buf_data->evt_param = CAM_SYNC_JPEG_EVENT_INVLD_CMD;
-		rc = -EFAULT;
-		goto end_error;
+	p_params = (struct cam_jpeg_config_inout_param_info *)cmd_buf_kaddr;
+
+	p_params->output_size = p_cfg_req->result_size;
+	cam_mem_put_cpu_buf(mem_hdl);
+
+	return 0;
+}
+
+/*
+ * Requests of one context may finish out of order when they run on
+ * different device instances, while the context expects buf dones in
+ * submission order. Report every finished request at the head of the
+ * in flight list, a request finishing behind an older one stays parked
+ * until the older one is done.
+ */
+static void cam_jpeg_mgr_retire_done_reqs(struct cam_jpeg_hw_mgr *hw_mgr,
+	struct cam_jpeg_hw_ctx_data *ctx_data)
+{
+	int i;
+	struct cam_jpeg_hw_cfg_req *p_cfg_req;
+	struct cam_hw_done_event_data buf_data;
+
+	mutex_lock(&hw_mgr->hw_mgr_mutex);
+	if (ctx_data->retire_in_progress) {
+		mutex_unlock(&hw_mgr->hw_mgr_mutex);
+		return;
 	}
-	rc = hw_mgr->devices[dev_type][0]->hw_ops.reset(
-		hw_mgr->devices[dev_type][0]->hw_priv,
-		NULL, 0);
-	if (rc) {
-		CAM_ERR(CAM_JPEG, "jpeg hw reset failed %d", rc);
-		buf_data->evt_param = CAM_SYNC_JPEG_EVENT_HW_RESET_FAILED;
-		goto end_error;
+	ctx_data->retire_in_progress = true;
+
+	while (!list_empty(&ctx_data->inflight_req_list)) {
+		p_cfg_req = list_first_entry(&ctx_data->inflight_req_list,
+			struct cam_jpeg_hw_cfg_req, ctx_list);
+		if (!p_cfg_req->done)
+			break;
+
+		list_del_init(&p_cfg_req->ctx_list);
+		mutex_unlock(&hw_mgr->hw_mgr_mutex);
+
+		if (p_cfg_req->done_evt_id == CAM_CTX_EVT_ID_SUCCESS)
+			cam_jpeg_mgr_update_output_size(p_cfg_req);
+
+		buf_data.num_handles =
+			p_cfg_req->hw_cfg_args.num_out_map_entries;
+		for (i = 0; i < buf_data.num_handles; i++) {
+			buf_data.resource_handle[i] =
+			p_cfg_req->hw_cfg_args.out_map_entries[i].resource_handle;
+		}
+		buf_data.request_id =
+			PTR_TO_U64(p_cfg_req->hw_cfg_args.priv);
+		buf_data.evt_param = p_cfg_req->done_evt_param;
+		ctx_data->ctxt_event_cb(ctx_data->context_priv,
+			p_cfg_req->done_evt_id, &buf_data);
+
+		mutex_lock(&hw_mgr->hw_mgr_mutex);
+		list_add_tail(&p_cfg_req->list, &hw_mgr->free_req_list);
 	}
 
-	cdm_cmd = ctx_data->cdm_cmd;
+	ctx_data->retire_in_progress = false;
+	mutex_unlock(&hw_mgr->hw_mgr_mutex);
+}
+
+static int cam_jpeg_mgr_build_cdm_cmd(struct cam_jpeg_hw_mgr *hw_mgr,
+	struct cam_jpeg_hw_cfg_req *p_cfg_req,
+	struct cam_cdm_bl_request *cdm_cmd,
+	struct cam_hw_done_event_data *buf_data)
+{
+	int rc;
+	int i = 0;
+	struct cam_hw_update_entry *cmd;
+	struct cam_hw_config_args *config_args = NULL;
+	uint32_t cdm_cfg_to_insert = 0;
+
+	config_args = (struct cam_hw_config_args *)&p_cfg_req->hw_cfg_args;
+
 	cdm_cmd->type = CAM_CDM_BL_CMD_TYPE_MEM_HANDLE;
 	cdm_cmd->flag = false;
 	cdm_cmd->userdata = NULL;
@@ -92,12 +175,12 @@ static int cam_jpeg_process_next_hw_update(void *priv, void *data,
 	cdm_cmd->cmd_arrary_count = 0;
 
 	/* insert cdm chage base cmd */
-	rc = cam_jpeg_insert_cdm_change_base(config_args,
-		ctx_data, hw_mgr);
+	rc = cam_jpeg_insert_cdm_change_base(config_args, cdm_cmd,
+		hw_mgr, p_cfg_req->dev_type, p_cfg_req->dev_idx);
 	if (rc) {
 		CAM_ERR(CAM_JPEG, "insert change base failed %d", rc);
 		buf_data->evt_param = CAM_SYNC_JPEG_EVENT_CDM_CHANGE_BASE_ERR;
-		goto end_error;
+		return rc;
 	}
 
 	/* insert next cdm payload at index */
@@ -108,11 +191,12 @@ static int cam_jpeg_process_next_hw_update(void *priv, void *data,
 	else
 		cdm_cfg_to_insert = p_cfg_req->num_hw_entry_processed + 2;
 
-	CAM_DBG(CAM_JPEG, "processed %d total %d using cfg entry %d for %pK",
+	CAM_DBG(CAM_JPEG,
+		"processed %d total %d using cfg entry %d for %pK on dev %u",
 		p_cfg_req->num_hw_entry_processed,
 		config_args->num_hw_update_entries,
 		cdm_cfg_to_insert,
-		p_cfg_req);
+		p_cfg_req, p_cfg_req->dev_idx);
 
 	cmd = (config_args->hw_update_entries + cdm_cfg_to_insert);
 	cdm_cmd->cmd[cdm_cmd->cmd_arrary_count].bl_addr.mem_handle =
@@ -125,67 +209,225 @@ static int cam_jpeg_process_next_hw_update(void *priv, void *data,
 		i, cmd->handle, cmd->offset, cmd->len);
 	cdm_cmd->cmd_arrary_count++;
 
+	return 0;
+}
+
+static int cam_jpeg_mgr_kick_dev(struct cam_jpeg_hw_mgr *hw_mgr,
+	struct cam_jpeg_hw_cfg_req *p_cfg_req,
+	struct cam_cdm_bl_request *cdm_cmd,
+	struct cam_hw_done_event_data *buf_data)
+{
+	int rc;
+	uint32_t dev_type = p_cfg_req->dev_type;
+	uint32_t dev_idx = p_cfg_req->dev_idx;
+	struct cam_hw_intf *dev_intf = hw_mgr->devices[dev_type][dev_idx];
+
+	if (!dev_intf->hw_ops.reset) {
+		CAM_ERR(CAM_JPEG, "op reset null ");
+		buf_data->evt_param = CAM_SYNC_JPEG_EVENT_INVLD_CMD;
+		return -EFAULT;
+	}
+	rc = dev_intf->hw_ops.reset(dev_intf->hw_priv, NULL, 0);
+	if (rc) {
+		CAM_ERR(CAM_JPEG, "jpeg hw reset failed %d", rc);
+		buf_data->evt_param = CAM_SYNC_JPEG_EVENT_HW_RESET_FAILED;
+		return rc;
+	}
+
 	rc = cam_cdm_submit_bls(
-		hw_mgr->cdm_info[dev_type][0].cdm_handle,
+		hw_mgr->cdm_info[dev_type][dev_idx].cdm_handle,
 		cdm_cmd);
 	if (rc) {
 		CAM_ERR(CAM_JPEG, "Failed to apply the configs %d", rc);
 		buf_data->evt_param = CAM_SYNC_JPEG_EVENT_CDM_CONFIG_ERR;
-		goto end_error;
+		return rc;
 	}
 
-	if (!hw_mgr->devices[dev_type][0]->hw_ops.start) {
+	if (!dev_intf->hw_ops.start) {
 		CAM_ERR(CAM_JPEG, "op start null ");
 		buf_data->evt_param = CAM_SYNC_JPEG_EVENT_INVLD_CMD;
-		rc = -EINVAL;
-		goto end_error;
+		return -EINVAL;
 	}
 
-	CAM_TRACE(CAM_JPEG, "Start JPEG ENC Req %llu", config_args->request_id);
+	CAM_TRACE(CAM_JPEG, "Start JPEG ENC Req %llu",
+		p_cfg_req->hw_cfg_args.request_id);
 
 	if (g_jpeg_hw_mgr.camnoc_misr_test) {
 		/* configure jpeg hw and camnoc misr */
-		rc = hw_mgr->devices[dev_type][0]->hw_ops.process_cmd(
-			hw_mgr->devices[dev_type][0]->hw_priv,
+		rc = dev_intf->hw_ops.process_cmd(
+			dev_intf->hw_priv,
 			CAM_JPEG_CMD_CONFIG_HW_MISR,
 			&g_jpeg_hw_mgr.camnoc_misr_test,
 			sizeof(g_jpeg_hw_mgr.camnoc_misr_test));
 		if (rc) {
 			CAM_ERR(CAM_JPEG, "Failed to apply the configs %d", rc);
-			goto end_error;
+			return rc;
 		}
 	}
 
-	rc = hw_mgr->devices[dev_type][0]->hw_ops.start(
-		hw_mgr->devices[dev_type][0]->hw_priv, NULL, 0);
+	rc = dev_intf->hw_ops.start(dev_intf->hw_priv, NULL, 0);
 	if (rc) {
 		CAM_ERR(CAM_JPEG, "Failed to apply the configs %d",
 			rc);
 		buf_data->evt_param = CAM_SYNC_JPEG_EVENT_START_HW_ERR;
-		goto end_error;
+		return rc;
 	}
 
 	return 0;
-end_error:
-	return rc;
+}
+
+static int cam_jpeg_process_next_hw_update(void *priv,
+	struct cam_jpeg_hw_cfg_req *p_cfg_req,
+	struct cam_hw_done_event_data *buf_data)
+{
+	int rc;
+	struct cam_jpeg_hw_mgr *hw_mgr = priv;
+	struct cam_jpeg_hw_ctx_data *ctx_data = NULL;
+
+	if (!p_cfg_req || !priv) {
+		CAM_ERR(CAM_JPEG, "Invalid data");
+		return -EINVAL;
+	}
+
+	ctx_data = (struct cam_jpeg_hw_ctx_data *)
+		p_cfg_req->hw_cfg_args.ctxt_to_hw_map;
+
+	rc = cam_jpeg_mgr_build_cdm_cmd(hw_mgr, p_cfg_req, ctx_data->cdm_cmd,
+		buf_data);
+	if (rc)
+		return rc;
+
+	return cam_jpeg_mgr_kick_dev(hw_mgr, p_cfg_req, ctx_data->cdm_cmd,
+		buf_data);
+}
+
+static bool cam_jpeg_mgr_has_queued_req(struct cam_jpeg_hw_mgr *hw_mgr,
+	uint32_t dev_type)
+{
+	struct cam_jpeg_hw_cfg_req *cfg_req;
+
+	list_for_each_entry(cfg_req, &hw_mgr->hw_config_req_list, list) {
+		if (cfg_req->dev_type == dev_type)
+			return true;
+	}
+
+	return false;
+}
+
+static void cam_jpeg_mgr_update_idle_gap(struct cam_jpeg_hw_mgr *hw_mgr,
+	uint32_t dev_type, uint32_t dev_idx)
+{
+	struct cam_jpeg_hw_dev_idle_stats *stats =
+		&hw_mgr->idle_stats[dev_type][dev_idx];
+	bool work_pending = stats->work_pending;
+	int64_t gap_us;
+	int i;
+
+	/*
+	 * The pending work may have been picked up by another instance of
+	 * this type, so once nothing of this type is left queued no instance
+	 * is waiting for work anymore.
+	 */
+	stats->work_pending = false;
+	if (!cam_jpeg_mgr_has_queued_req(hw_mgr, dev_type)) {
+		for (i = 0; i < hw_mgr->num_devices[dev_type]; i++)
+			hw_mgr->idle_stats[dev_type][i].work_pending = false;
+	}
+
+	/* only a gap with work waiting is idle time worth measuring */
+	if (!work_pending)
+		return;
+
+	gap_us = ktime_us_delta(ktime_get(), stats->last_done_ts);
+	if (gap_us < 0)
+		gap_us = 0;
+
+	stats->num_gaps++;
+	stats->total_gap_us += gap_us;
+	stats->last_gap_us = gap_us;
+	if (gap_us > stats->max_gap_us)
+		stats->max_gap_us = gap_us;
+
+	CAM_DBG(CAM_JPEG, "dev type %u idx %u idle gap %lld us",
+		dev_type, dev_idx, gap_us);
+}
+
+/*
+ * Stage the oldest queued request that has a busy device without a
+ * staged job, so the done path can start it without a workq round trip.
+ * Its cdm payload is built here, only reset, cdm submit and start are
+ * left for the done path.
+ */
+static void cam_jpeg_mgr_stage_req(struct cam_jpeg_hw_mgr *hw_mgr)
+{
+	int i;
+	uint32_t dev_type;
+	struct cam_jpeg_hw_cfg_req *p_cfg_req = NULL;
+	struct cam_jpeg_hw_ctx_data *ctx_data;
+	struct cam_hw_done_event_data buf_data;
+
+	if (hw_mgr->disable_job_preload)
+		return;
+
+	list_for_each_entry(p_cfg_req, &hw_mgr->hw_config_req_list, list) {
+		dev_type = p_cfg_req->dev_type;
+		for (i = 0; i < hw_mgr->num_devices[dev_type]; i++) {
+			if (hw_mgr->device_in_use[dev_type][i] &&
+				!hw_mgr->dev_staged_cfg_req[dev_type][i])
+				goto stage;
+		}
+	}
+
+	return;
+
+stage:
+	ctx_data = (struct cam_jpeg_hw_ctx_data *)
+		p_cfg_req->hw_cfg_args.ctxt_to_hw_map;
+	/* leave invalid requests to the regular path for error reporting */
+	if (!ctx_data->in_use || !p_cfg_req->hw_cfg_args.num_hw_update_entries)
+		return;
+
+	p_cfg_req->dev_idx = i;
+	if (cam_jpeg_mgr_build_cdm_cmd(hw_mgr, p_cfg_req,
+		hw_mgr->staged_cdm_cmd[dev_type][i], &buf_data))
+		return;
+
+	list_del_init(&p_cfg_req->list);
+	hw_mgr->dev_staged_cfg_req[dev_type][i] = p_cfg_req;
+	CAM_DBG(CAM_JPEG, "staged req %zd on dev type %u idx %d",
+		p_cfg_req->req_id, dev_type, i);
+}
+
+static void cam_jpeg_mgr_unstage_req(struct cam_jpeg_hw_mgr *hw_mgr,
+	uint32_t dev_type, uint32_t dev_idx)
+{
+	struct cam_jpeg_hw_cfg_req *p_cfg_req =
+		hw_mgr->dev_staged_cfg_req[dev_type][dev_idx];
+
+	if (!p_cfg_req)
+		return;
+
+	/* staged request is the oldest pending one, back to the head */
+	hw_mgr->dev_staged_cfg_req[dev_type][dev_idx] = NULL;
+	list_add(&p_cfg_req->list, &hw_mgr->hw_config_req_list);
 }
 
 static int cam_jpeg_mgr_process_irq(void *priv, void *data)
 {
 	int rc = 0;
-	int mem_hdl = 0;
 	struct cam_jpeg_process_irq_work_data_t *task_data;
 	struct cam_jpeg_hw_mgr *hw_mgr;
-	int32_t i;
 	struct cam_jpeg_hw_ctx_data *ctx_data = NULL;
 	struct cam_hw_done_event_data buf_data;
 	struct cam_jpeg_set_irq_cb irq_cb;
+	struct cam_jpeg_hw_dev_cb_data *dev_cb_data;
 	uintptr_t dev_type = 0;
-	uintptr_t kaddr;
-	uint32_t *cmd_buf_kaddr;
-	size_t cmd_buf_len;
-	struct cam_jpeg_config_inout_param_info *p_params;
+	uint32_t dev_idx;
+	struct cam_hw_intf *dev_intf;
 	struct cam_jpeg_hw_cfg_req *p_cfg_req = NULL;
+	struct cam_jpeg_hw_cfg_req *staged_req = NULL;
+	struct cam_jpeg_hw_ctx_data *staged_ctx_data = NULL;
+	struct cam_jpeg_hw_dev_idle_stats *idle_stats;
 	struct crm_workq_task *task;
 	struct cam_jpeg_process_frame_work_data_t *wq_task_data;
 	struct cam_jpeg_misr_dump_args misr_args;
@@ -198,28 +440,35 @@ static int cam_jpeg_mgr_process_irq(void *priv, void *data)
 	task_data = data;
 	hw_mgr = &g_jpeg_hw_mgr;
 
-	ctx_data = (struct cam_jpeg_hw_ctx_data *)task_data->data;
-	if (!ctx_data->in_use) {
-		CAM_ERR(CAM_JPEG, "ctx is not in use");
-		return -EINVAL;
-	}
-
-	dev_type = ctx_data->jpeg_dev_acquire_info.dev_type;
+	dev_cb_data = (struct cam_jpeg_hw_dev_cb_data *)task_data->data;
+	dev_type = dev_cb_data->dev_type;
+	dev_idx = dev_cb_data->dev_idx;
+	dev_intf = hw_mgr->devices[dev_type][dev_idx];
 
 	mutex_lock(&g_jpeg_hw_mgr.hw_mgr_mutex);
 
-	p_cfg_req = hw_mgr->dev_hw_cfg_args[dev_type][0];
+	p_cfg_req = hw_mgr->dev_hw_cfg_args[dev_type][dev_idx];
 
-	if (hw_mgr->device_in_use[dev_type][0] == false ||
+	if (hw_mgr->device_in_use[dev_type][dev_idx] == false ||
 		p_cfg_req == NULL) {
-		CAM_ERR(CAM_JPEG, "irq for old request %d", rc);
+		CAM_ERR(CAM_JPEG, "irq for old request dev %lu idx %u",
+			dev_type, dev_idx);
+		mutex_unlock(&g_jpeg_hw_mgr.hw_mgr_mutex);
+		return -EINVAL;
+	}
+
+	ctx_data = (struct cam_jpeg_hw_ctx_data *)
+		p_cfg_req->hw_cfg_args.ctxt_to_hw_map;
+	if (!ctx_data->in_use) {
+		CAM_ERR(CAM_JPEG, "ctx is not in use");
 		mutex_unlock(&g_jpeg_hw_mgr.hw_mgr_mutex);
 		return -EINVAL;
 	}
 
 	p_cfg_req->num_hw_entry_processed++;
-	CAM_DBG(CAM_JPEG, "hw entry processed %d Encoded size :%d",
-		p_cfg_req->num_hw_entry_processed, task_data->result_size);
+	CAM_DBG(CAM_JPEG, "hw entry processed %d Encoded size :%d dev %u",
+		p_cfg_req->num_hw_entry_processed, task_data->result_size,
+		dev_idx);
 
 	if (g_jpeg_hw_mgr.camnoc_misr_test) {
 		misr_args.req_id = p_cfg_req->req_id;
@@ -228,8 +477,8 @@ static int cam_jpeg_mgr_process_irq(void *priv, void *data)
 			misr_args.req_id, misr_args.enable_bug);
 
 		/* dump jpeg hw and camnoc misr */
-		rc = hw_mgr->devices[dev_type][0]->hw_ops.process_cmd(
-			hw_mgr->devices[dev_type][0]->hw_priv,
+		rc = dev_intf->hw_ops.process_cmd(
+			dev_intf->hw_priv,
 			CAM_JPEG_CMD_DUMP_HW_MISR_VAL, &misr_args,
 			sizeof(struct cam_jpeg_misr_dump_args));
 	}
@@ -238,7 +487,7 @@ static int cam_jpeg_mgr_process_irq(void *priv, void *data)
 		(p_cfg_req->num_hw_entry_processed <
 			p_cfg_req->hw_cfg_args.num_hw_update_entries - 2)) {
 		/* start processing next entry before marking device free */
-		rc  = cam_jpeg_process_next_hw_update(priv, ctx_data,
+		rc  = cam_jpeg_process_next_hw_update(priv, p_cfg_req,
 			&buf_data);
 		if (!rc) {
 			mutex_unlock(&g_jpeg_hw_mgr.hw_mgr_mutex);
@@ -246,16 +495,51 @@ static int cam_jpeg_mgr_process_irq(void *priv, void *data)
 		}
 	}
 
+	p_cfg_req->result_size = task_data->result_size;
+	p_cfg_req->done_evt_id = CAM_CTX_EVT_ID_SUCCESS;
+	p_cfg_req->done_evt_param = 0;
+	p_cfg_req->done = true;
+
+	idle_stats = &hw_mgr->idle_stats[dev_type][dev_idx];
+	idle_stats->last_done_ts = task_data->irq_timestamp;
+	staged_req = hw_mgr->dev_staged_cfg_req[dev_type][dev_idx];
+	idle_stats->work_pending = staged_req ||
+		cam_jpeg_mgr_has_queued_req(hw_mgr, dev_type);
+
+	if (staged_req) {
+		/* device stays powered with its irq cb, just kick next job */
+		hw_mgr->dev_staged_cfg_req[dev_type][dev_idx] = NULL;
+		hw_mgr->dev_hw_cfg_args[dev_type][dev_idx] = staged_req;
+		buf_data.evt_param = 0;
+		rc = cam_jpeg_mgr_kick_dev(hw_mgr, staged_req,
+			hw_mgr->staged_cdm_cmd[dev_type][dev_idx], &buf_data);
+		if (!rc) {
+			staged_req->submit_timestamp = ktime_get();
+			cam_jpeg_mgr_update_idle_gap(hw_mgr, dev_type, dev_idx);
+			mutex_unlock(&g_jpeg_hw_mgr.hw_mgr_mutex);
+			goto enqueue_cmd;
+		}
+
+		CAM_ERR(CAM_JPEG, "staged req %zd start failed %d",
+			staged_req->req_id, rc);
+		staged_req->done_evt_id = CAM_CTX_EVT_ID_ERROR;
+		staged_req->done_evt_param = buf_data.evt_param;
+		staged_req->done = true;
+		staged_ctx_data = (struct cam_jpeg_hw_ctx_data *)
+			staged_req->hw_cfg_args.ctxt_to_hw_map;
+		hw_mgr->dev_hw_cfg_args[dev_type][dev_idx] = p_cfg_req;
+	}
+
 	irq_cb.jpeg_hw_mgr_cb = cam_jpeg_hw_mgr_cb;
 	irq_cb.data = NULL;
 	irq_cb.b_set_cb = false;
-	if (!hw_mgr->devices[dev_type][0]->hw_ops.process_cmd) {
+	if (!dev_intf->hw_ops.process_cmd) {
 		CAM_ERR(CAM_JPEG, "process_cmd null ");
 		mutex_unlock(&g_jpeg_hw_mgr.hw_mgr_mutex);
 		return -EINVAL;
 	}
-	rc = hw_mgr->devices[dev_type][0]->hw_ops.process_cmd(
-		hw_mgr->devices[dev_type][0]->hw_priv,
+	rc = dev_intf->hw_ops.process_cmd(
+		dev_intf->hw_priv,
 		CAM_JPEG_CMD_SET_IRQ_CB,
 		&irq_cb, sizeof(irq_cb));
 	if (rc) {
@@ -264,85 +548,42 @@ static int cam_jpeg_mgr_process_irq(void *priv, void *data)
 		return rc;
 	}
 
-	if (hw_mgr->devices[dev_type][0]->hw_ops.deinit) {
-		rc = hw_mgr->devices[dev_type][0]->hw_ops.deinit(
-			hw_mgr->devices[dev_type][0]->hw_priv, NULL, 0);
+	if (dev_intf->hw_ops.deinit) {
+		rc = dev_intf->hw_ops.deinit(dev_intf->hw_priv, NULL, 0);
 		if (rc)
-			CAM_ERR(CAM_JPEG, "Failed to Deinit %lu HW", dev_type);
+			CAM_ERR(CAM_JPEG, "Failed to Deinit %lu HW %u",
+				dev_type, dev_idx);
 	}
 
-	hw_mgr->device_in_use[dev_type][0] = false;
-	hw_mgr->dev_hw_cfg_args[dev_type][0] = NULL;
+	hw_mgr->device_in_use[dev_type][dev_idx] = false;
+	hw_mgr->dev_hw_cfg_args[dev_type][dev_idx] = NULL;
 	mutex_unlock(&g_jpeg_hw_mgr.hw_mgr_mutex);
 
+enqueue_cmd:
+
 	task = cam_req_mgr_workq_get_task(
 		g_jpeg_hw_mgr.work_process_frame);
 	if (!task) {
 		CAM_ERR(CAM_JPEG, "no empty task");
-		return -EINVAL;
+		rc = -EINVAL;
+		goto retire;
 	}
 
 	wq_task_data = (struct cam_jpeg_process_frame_work_data_t *)
 		task->payload;
-	if (!task_data) {
-		CAM_ERR(CAM_JPEG, "task_data is NULL");
-		return -EINVAL;
-	}
 	wq_task_data->data = (void *)dev_type;
 	wq_task_data->request_id = 0;
 	wq_task_data->type = CAM_JPEG_WORKQ_TASK_CMD_TYPE;
 	task->process_cb = cam_jpeg_mgr_process_cmd;
 	rc = cam_req_mgr_workq_enqueue_task(task, &g_jpeg_hw_mgr,
 		CRM_TASK_PRIORITY_0);
-	if (rc) {
+	if (rc)
 		CAM_ERR(CAM_JPEG, "could not enque task %d", rc);
-		return rc;
-	}
 
-	mem_hdl =
-		p_cfg_req->hw_cfg_args.hw_update_entries[CAM_JPEG_PARAM].handle;
-	rc = cam_mem_get_cpu_buf(mem_hdl, &kaddr, &cmd_buf_len);
-	if (rc) {
-		CAM_ERR(CAM_JPEG, "unable to get info for cmd buf: %x %d",
-			hw_mgr->iommu_hdl, rc);
-		return rc;
-	}
-
-	cmd_buf_kaddr = (uint32_t *)kaddr;
-
-	if ((p_cfg_req->hw_cfg_args.hw_update_entries[CAM_JPEG_PARAM].offset /
-			sizeof(uint32_t)) >= cmd_buf_len) {
-		CAM_ERR(CAM_JPEG, "Invalid offset: %u cmd buf len: %zu",
-			p_cfg_req->hw_cfg_args.hw_update_entries[
-			CAM_JPEG_PARAM].offset, cmd_buf_len);
-		cam_mem_put_cpu_buf(mem_hdl);
-		return -EINVAL;
-	}
-
-	cmd_buf_kaddr =
-		(cmd_buf_kaddr +
-		(p_cfg_req->hw_cfg_args.hw_update_entries[CAM_JPEG_PARAM].offset
-			/ sizeof(uint32_t)));
-
-	p_params = (struct cam_jpeg_config_inout_param_info *)cmd_buf_kaddr;
-
-	p_params->output_size = task_data->result_size;
-
-	buf_data.num_handles =
-		p_cfg_req->hw_cfg_args.num_out_map_entries;
-	for (i = 0; i < buf_data.num_handles; i++) {
-		buf_data.resource_handle[i] =
-		p_cfg_req->hw_cfg_args.out_map_entries[i].resource_handle;
-	}
-	buf_data.request_id =
-		PTR_TO_U64(p_cfg_req->hw_cfg_args.priv);
-	ctx_data->ctxt_event_cb(ctx_data->context_priv, CAM_CTX_EVT_ID_SUCCESS,
-		&buf_data);
-
-	mutex_lock(&g_jpeg_hw_mgr.hw_mgr_mutex);
-	list_add_tail(&p_cfg_req->list, &hw_mgr->free_req_list);
-	mutex_unlock(&g_jpeg_hw_mgr.hw_mgr_mutex);
-	cam_mem_put_cpu_buf(mem_hdl);
+retire:
+	cam_jpeg_mgr_retire_done_reqs(hw_mgr, ctx_data);
+	if (staged_ctx_data && staged_ctx_data != ctx_data)
+		cam_jpeg_mgr_retire_done_reqs(hw_mgr, staged_ctx_data);
 	return rc;
 }
 
@@ -368,6 +609,7 @@ static int cam_jpeg_hw_mgr_cb(
 	task_data->data = data;
 	task_data->irq_status = irq_status;
 	task_data->result_size = result_size;
+	task_data->irq_timestamp = ktime_get();
 	task_data->type = CAM_JPEG_WORKQ_TASK_MSG_TYPE;
 	task->process_cb = cam_jpeg_mgr_process_irq;
 
@@ -420,12 +662,10 @@ static int cam_jpeg_mgr_release_ctx(
 
 static int cam_jpeg_insert_cdm_change_base(
 	struct cam_hw_config_args *config_args,
-	struct cam_jpeg_hw_ctx_data *ctx_data,
-	struct cam_jpeg_hw_mgr *hw_mgr)
+	struct cam_cdm_bl_request *cdm_cmd,
+	struct cam_jpeg_hw_mgr *hw_mgr, uint32_t dev_type, uint32_t dev_idx)
 {
 	int rc = 0;
-	uint32_t dev_type;
-	struct cam_cdm_bl_request *cdm_cmd;
 	uint32_t size;
 	uint32_t mem_cam_base;
 	uintptr_t iova_addr;
@@ -458,14 +698,12 @@ static int cam_jpeg_insert_cdm_change_base(
 		(config_args->hw_update_entries[CAM_JPEG_CHBASE].offset /
 		sizeof(uint32_t)));
 
-	dev_type = ctx_data->jpeg_dev_acquire_info.dev_type;
-	mem_cam_base = hw_mgr->cdm_reg_map[dev_type][0]->mem_cam_base;
-	size =
-	hw_mgr->cdm_info[dev_type][0].cdm_ops->cdm_required_size_changebase();
-	hw_mgr->cdm_info[dev_type][0].cdm_ops->cdm_write_changebase(
+	mem_cam_base = hw_mgr->cdm_reg_map[dev_type][dev_idx]->mem_cam_base;
+	size = hw_mgr->cdm_info[dev_type][dev_idx].cdm_ops->
+		cdm_required_size_changebase();
+	hw_mgr->cdm_info[dev_type][dev_idx].cdm_ops->cdm_write_changebase(
 		ch_base_iova_addr, mem_cam_base);
 
-	cdm_cmd = ctx_data->cdm_cmd;
 	cdm_cmd->cmd[cdm_cmd->cmd_arrary_count].bl_addr.mem_handle =
 		config_args->hw_update_entries[CAM_JPEG_CHBASE].handle;
 	cdm_cmd->cmd[cdm_cmd->cmd_arrary_count].offset =
@@ -488,7 +726,7 @@ static int cam_jpeg_insert_cdm_change_base(
 static int cam_jpeg_mgr_process_cmd(void *priv, void *data)
 {
 	int rc;
-	int i = 0;
+	int dev_idx = -EBUSY;
 	struct cam_jpeg_hw_mgr *hw_mgr = priv;
 	struct cam_hw_config_args *config_args = NULL;
 	struct cam_jpeg_hw_ctx_data *ctx_data = NULL;
@@ -496,10 +734,11 @@ static int cam_jpeg_mgr_process_cmd(void *priv, void *data)
 	struct cam_jpeg_process_frame_work_data_t *task_data =
 		(struct cam_jpeg_process_frame_work_data_t *)data;
 	uint32_t dev_type;
+	struct cam_hw_intf *dev_intf;
 	struct cam_jpeg_set_irq_cb irq_cb;
 	struct cam_jpeg_hw_cfg_req *p_cfg_req = NULL;
+	struct cam_jpeg_hw_cfg_req *cfg_req = NULL;
 	struct cam_hw_done_event_data buf_data;
-	struct cam_hw_config_args *hw_cfg_args = NULL;
 
 	if (!hw_mgr || !task_data) {
 		CAM_ERR(CAM_JPEG, "Invalid arguments %pK %pK",
@@ -515,24 +754,27 @@ static int cam_jpeg_mgr_process_cmd(void *priv, void *data)
 		goto end;
 	}
 
-	p_cfg_req = list_first_entry(&hw_mgr->hw_config_req_list,
-		struct cam_jpeg_hw_cfg_req, list);
-	if (!p_cfg_req) {
-		CAM_ERR(CAM_JPEG, "no request");
-		rc = -EFAULT;
-		goto end;
+	/* oldest request which has an idle instance of its device type */
+	list_for_each_entry(cfg_req, &hw_mgr->hw_config_req_list, list) {
+		dev_idx = cam_jpeg_mgr_get_free_dev(hw_mgr, cfg_req->dev_type);
+		if (dev_idx >= 0) {
+			p_cfg_req = cfg_req;
+			break;
+		}
 	}
 
-	if (false == hw_mgr->device_in_use[p_cfg_req->dev_type][0]) {
-		hw_mgr->device_in_use[p_cfg_req->dev_type][0] = true;
-		hw_mgr->dev_hw_cfg_args[p_cfg_req->dev_type][0] = p_cfg_req;
-		list_del_init(&p_cfg_req->list);
-	} else {
+	if (!p_cfg_req) {
 		CAM_DBG(CAM_JPEG, "Not dequeing, just return");
+		cam_jpeg_mgr_stage_req(hw_mgr);
 		rc = -EFAULT;
 		goto end;
 	}
 
+	p_cfg_req->dev_idx = dev_idx;
+	hw_mgr->device_in_use[p_cfg_req->dev_type][dev_idx] = true;
+	hw_mgr->dev_hw_cfg_args[p_cfg_req->dev_type][dev_idx] = p_cfg_req;
+	list_del_init(&p_cfg_req->list);
+
 	config_args = (struct cam_hw_config_args *)&p_cfg_req->hw_cfg_args;
 	request_id = task_data->request_id;
 	if (request_id != (uintptr_t)config_args->priv) {
@@ -560,31 +802,32 @@ static int cam_jpeg_mgr_process_cmd(void *priv, void *data)
 	if (dev_type != p_cfg_req->dev_type)
 		CAM_WARN(CAM_JPEG, "dev types not same something wrong");
 
-	if (!hw_mgr->devices[dev_type][0]->hw_ops.init) {
+	dev_intf = hw_mgr->devices[p_cfg_req->dev_type][dev_idx];
+	if (!dev_intf->hw_ops.init) {
 		CAM_ERR(CAM_JPEG, "hw op init null ");
+		buf_data.evt_param = CAM_SYNC_JPEG_EVENT_INVLD_CMD;
 		rc = -EFAULT;
-		goto end;
+		goto end_callcb;
 	}
-	rc = hw_mgr->devices[dev_type][0]->hw_ops.init(
-		hw_mgr->devices[dev_type][0]->hw_priv,
+	rc = dev_intf->hw_ops.init(dev_intf->hw_priv,
 		ctx_data,
 		sizeof(ctx_data));
 	if (rc) {
-		CAM_ERR(CAM_JPEG, "Failed to Init %d HW", dev_type);
-		goto end;
+		CAM_ERR(CAM_JPEG, "Failed to Init %d HW %d", dev_type, dev_idx);
+		buf_data.evt_param = CAM_SYNC_JPEG_EVENT_UNKNOWN;
+		goto end_callcb;
 	}
 
 	irq_cb.jpeg_hw_mgr_cb = cam_jpeg_hw_mgr_cb;
-	irq_cb.data = (void *)ctx_data;
+	irq_cb.data = &hw_mgr->dev_cb_data[p_cfg_req->dev_type][dev_idx];
 	irq_cb.b_set_cb = true;
-	if (!hw_mgr->devices[dev_type][0]->hw_ops.process_cmd) {
+	if (!dev_intf->hw_ops.process_cmd) {
 		CAM_ERR(CAM_JPEG, "op process_cmd null ");
 		buf_data.evt_param = CAM_SYNC_JPEG_EVENT_INVLD_CMD;
 		rc = -EFAULT;
 		goto end_callcb;
 	}
-	rc = hw_mgr->devices[dev_type][0]->hw_ops.process_cmd(
-		hw_mgr->devices[dev_type][0]->hw_priv,
+	rc = dev_intf->hw_ops.process_cmd(dev_intf->hw_priv,
 		CAM_JPEG_CMD_SET_IRQ_CB,
 		&irq_cb, sizeof(irq_cb));
 	if (rc) {
@@ -594,36 +837,35 @@ static int cam_jpeg_mgr_process_cmd(void *priv, void *data)
 	}
 
 	/* insert one of the cdm payloads */
-	rc = cam_jpeg_process_next_hw_update(priv, ctx_data, &buf_data);
+	buf_data.evt_param = 0;
+	rc = cam_jpeg_process_next_hw_update(priv, p_cfg_req, &buf_data);
 	if (rc) {
 		CAM_ERR(CAM_JPEG, "next hw update failed %d", rc);
 		goto end_callcb;
 	}
 
 	p_cfg_req->submit_timestamp = ktime_get();
+	cam_jpeg_mgr_update_idle_gap(hw_mgr, p_cfg_req->dev_type, dev_idx);
 
 	mutex_unlock(&hw_mgr->hw_mgr_mutex);
 	return rc;
 
 end_callcb:
+	hw_mgr->device_in_use[p_cfg_req->dev_type][dev_idx] = false;
+	hw_mgr->dev_hw_cfg_args[p_cfg_req->dev_type][dev_idx] = NULL;
+	p_cfg_req->done_evt_id = CAM_CTX_EVT_ID_ERROR;
+	p_cfg_req->done_evt_param = buf_data.evt_param;
+	p_cfg_req->done = true;
 	mutex_unlock(&hw_mgr->hw_mgr_mutex);
-	if (p_cfg_req) {
-		hw_cfg_args = &p_cfg_req->hw_cfg_args;
-		buf_data.num_handles =
-			hw_cfg_args->num_out_map_entries;
-		for (i = 0; i < buf_data.num_handles; i++) {
-			buf_data.resource_handle[i] =
-			hw_cfg_args->out_map_entries[i].resource_handle;
-		}
-		buf_data.request_id =
-			(uintptr_t)p_cfg_req->hw_cfg_args.priv;
-		ctx_data->ctxt_event_cb(ctx_data->context_priv,
-			CAM_CTX_EVT_ID_ERROR, &buf_data);
-	}
+	cam_jpeg_mgr_retire_done_reqs(hw_mgr, ctx_data);
+	return rc;
+
 end_unusedev:
 	mutex_lock(&hw_mgr->hw_mgr_mutex);
-	hw_mgr->device_in_use[p_cfg_req->dev_type][0] = false;
-	hw_mgr->dev_hw_cfg_args[p_cfg_req->dev_type][0] = NULL;
+	hw_mgr->device_in_use[p_cfg_req->dev_type][dev_idx] = false;
+	hw_mgr->dev_hw_cfg_args[p_cfg_req->dev_type][dev_idx] = NULL;
+	list_del_init(&p_cfg_req->ctx_list);
+	list_add_tail(&p_cfg_req->list, &hw_mgr->free_req_list);
 
 end:
 	mutex_unlock(&hw_mgr->hw_mgr_mutex);
@@ -679,6 +921,9 @@ static int cam_jpeg_mgr_config_hw(void *hw_mgr_priv, void *config_hw_args)
 	request_id = (uintptr_t)config_args->priv;
 	p_cfg_req->req_id = request_id;
 	p_cfg_req->num_hw_entry_processed = 0;
+	p_cfg_req->dev_idx = 0;
+	p_cfg_req->done = false;
+	p_cfg_req->result_size = 0;
 	hw_update_entries = config_args->hw_update_entries;
 	CAM_DBG(CAM_JPEG, "ctx_data = %pK req_id = %lld %zd",
 		ctx_data, request_id, (uintptr_t)config_args->priv);
@@ -704,6 +949,7 @@ static int cam_jpeg_mgr_config_hw(void *hw_mgr_priv, void *config_hw_args)
 		p_cfg_req->hw_cfg_args.num_hw_update_entries);
 
 	list_add_tail(&p_cfg_req->list, &hw_mgr->hw_config_req_list);
+	list_add_tail(&p_cfg_req->ctx_list, &ctx_data->inflight_req_list);
 	mutex_unlock(&hw_mgr->hw_mgr_mutex);
 
 	task_data->data = (void *)(uintptr_t)p_cfg_req->dev_type;
@@ -722,6 +968,7 @@ static int cam_jpeg_mgr_config_hw(void *hw_mgr_priv, void *config_hw_args)
 
 err_after_get_task:
 	list_del_init(&p_cfg_req->list);
+	list_del_init(&p_cfg_req->ctx_list);
 err_after_dq_free_list:
 	list_add_tail(&p_cfg_req->list, &hw_mgr->free_req_list);
 
@@ -793,7 +1040,8 @@ static int cam_jpeg_mgr_prepare_hw_update(void *hw_mgr_priv,
 		(void *)packet, (void *)cmd_desc,
 		sizeof(struct cam_cmd_buf_desc));
 
-	rc = cam_packet_util_process_patches(packet, hw_mgr->iommu_hdl, -1);
+	rc = cam_packet_util_process_patches(packet, hw_mgr->iommu_hdl, -1,
+		&ctx_data->iova_cache);
 	if (rc) {
 		CAM_ERR(CAM_JPEG, "Patch processing failed %d", rc);
 		return rc;
@@ -864,15 +1112,17 @@ static void cam_jpeg_mgr_stop_deinit_dev(struct cam_jpeg_hw_mgr *hw_mgr,
 	struct cam_jpeg_hw_cfg_req *p_cfg_req, uint32_t dev_type)
 {
 	int rc = 0;
+	uint32_t dev_idx = p_cfg_req->dev_idx;
+	struct cam_hw_intf *dev_intf = hw_mgr->devices[dev_type][dev_idx];
 	struct cam_jpeg_set_irq_cb irq_cb;
 
 	/* stop reset Unregister CB and deinit */
 	irq_cb.jpeg_hw_mgr_cb = cam_jpeg_hw_mgr_cb;
 	irq_cb.data = NULL;
 	irq_cb.b_set_cb = false;
-	if (hw_mgr->devices[dev_type][0]->hw_ops.process_cmd) {
-		rc = hw_mgr->devices[dev_type][0]->hw_ops.process_cmd(
-			hw_mgr->devices[dev_type][0]->hw_priv,
+	if (dev_intf->hw_ops.process_cmd) {
+		rc = dev_intf->hw_ops.process_cmd(
+			dev_intf->hw_priv,
 			CAM_JPEG_CMD_SET_IRQ_CB,
 			&irq_cb, sizeof(irq_cb));
 		if (rc)
@@ -881,34 +1131,32 @@ static void cam_jpeg_mgr_stop_deinit_dev(struct cam_jpeg_hw_mgr *hw_mgr,
 		CAM_ERR(CAM_JPEG, "process_cmd null %d", dev_type);
 	}
 
-	if (hw_mgr->devices[dev_type][0]->hw_ops.stop) {
-		rc = hw_mgr->devices[dev_type][0]->hw_ops.stop(
-			hw_mgr->devices[dev_type][0]->hw_priv,
-			NULL, 0);
+	if (dev_intf->hw_ops.stop) {
+		rc = dev_intf->hw_ops.stop(dev_intf->hw_priv, NULL, 0);
 		if (rc)
 			CAM_ERR(CAM_JPEG, "stop fail %d", rc);
 	} else {
 		CAM_ERR(CAM_JPEG, "op stop null %d", dev_type);
 	}
 
-	if (hw_mgr->devices[dev_type][0]->hw_ops.deinit) {
-		rc = hw_mgr->devices[dev_type][0]->hw_ops.deinit(
-			hw_mgr->devices[dev_type][0]->hw_priv,
-			NULL, 0);
+	if (dev_intf->hw_ops.deinit) {
+		rc = dev_intf->hw_ops.deinit(dev_intf->hw_priv, NULL, 0);
 		if (rc)
-			CAM_ERR(CAM_JPEG, "Failed to Deinit %d HW %d",
-				dev_type, rc);
+			CAM_ERR(CAM_JPEG, "Failed to Deinit %d HW %u rc %d",
+				dev_type, dev_idx, rc);
 	} else {
 		CAM_ERR(CAM_JPEG, "op deinit null %d", dev_type);
 	}
 
-	hw_mgr->device_in_use[dev_type][0] = false;
-	hw_mgr->dev_hw_cfg_args[dev_type][0] = NULL;
+	hw_mgr->device_in_use[dev_type][dev_idx] = false;
+	hw_mgr->dev_hw_cfg_args[dev_type][dev_idx] = NULL;
+	cam_jpeg_mgr_unstage_req(hw_mgr, dev_type, dev_idx);
 }
 
 static int cam_jpeg_mgr_flush(void *hw_mgr_priv,
 	struct cam_jpeg_hw_ctx_data *ctx_data)
 {
+	int i;
 	struct cam_jpeg_hw_mgr *hw_mgr = hw_mgr_priv;
 	uint32_t dev_type;
 	struct cam_jpeg_hw_cfg_req *p_cfg_req = NULL;
@@ -923,17 +1171,24 @@ static int cam_jpeg_mgr_flush(void *hw_mgr_priv,
 
 	dev_type = ctx_data->jpeg_dev_acquire_info.dev_type;
 
-	p_cfg_req = hw_mgr->dev_hw_cfg_args[dev_type][0];
-	if (hw_mgr->device_in_use[dev_type][0] == true &&
-		p_cfg_req != NULL) {
+	for (i = 0; i < hw_mgr->num_devices[dev_type]; i++) {
+		p_cfg_req = hw_mgr->dev_staged_cfg_req[dev_type][i];
+		if (p_cfg_req && (struct cam_jpeg_hw_ctx_data *)
+			p_cfg_req->hw_cfg_args.ctxt_to_hw_map == ctx_data)
+			cam_jpeg_mgr_unstage_req(hw_mgr, dev_type, i);
+
+		p_cfg_req = hw_mgr->dev_hw_cfg_args[dev_type][i];
+		if (hw_mgr->device_in_use[dev_type][i] == false ||
+			p_cfg_req == NULL)
+			continue;
+
 		if ((struct cam_jpeg_hw_ctx_data *)
-			p_cfg_req->hw_cfg_args.ctxt_to_hw_map == ctx_data) {
-			cam_jpeg_mgr_stop_deinit_dev(hw_mgr, p_cfg_req,
-				dev_type);
-			list_del_init(&p_cfg_req->list);
-			list_add_tail(&p_cfg_req->list,
-				&hw_mgr->free_req_list);
-		}
+			p_cfg_req->hw_cfg_args.ctxt_to_hw_map != ctx_data)
+			continue;
+
+		cam_jpeg_mgr_stop_deinit_dev(hw_mgr, p_cfg_req, dev_type);
+		list_del_init(&p_cfg_req->list);
+		list_add_tail(&p_cfg_req->list, &hw_mgr->free_req_list);
 	}
 
 	list_for_each_entry_safe(cfg_req, req_temp,
@@ -946,6 +1201,14 @@ static int cam_jpeg_mgr_flush(void *hw_mgr_priv,
 		list_add_tail(&cfg_req->list, &hw_mgr->free_req_list);
 	}
 
+	/* drop finished requests still waiting on an older one */
+	list_for_each_entry_safe(cfg_req, req_temp,
+		&ctx_data->inflight_req_list, ctx_list) {
+		list_del_init(&cfg_req->ctx_list);
+		if (cfg_req->done)
+			list_add_tail(&cfg_req->list, &hw_mgr->free_req_list);
+	}
+
 	CAM_DBG(CAM_JPEG, "X: JPEG flush ctx");
 
 	return 0;
@@ -955,6 +1218,7 @@ static int cam_jpeg_mgr_flush_req(void *hw_mgr_priv,
 	struct cam_jpeg_hw_ctx_data *ctx_data,
 	struct cam_hw_flush_args *flush_args)
 {
+	int i;
 	struct cam_jpeg_hw_mgr *hw_mgr = hw_mgr_priv;
 	struct cam_jpeg_hw_cfg_req *cfg_req = NULL;
 	struct cam_jpeg_hw_cfg_req *req_temp = NULL;
@@ -985,19 +1249,29 @@ static int cam_jpeg_mgr_flush_req(void *hw_mgr_priv,
 
 	dev_type = ctx_data->jpeg_dev_acquire_info.dev_type;
 
-	p_cfg_req = hw_mgr->dev_hw_cfg_args[dev_type][0];
-	if (hw_mgr->device_in_use[dev_type][0] == true &&
-		p_cfg_req != NULL) {
-		if (((struct cam_jpeg_hw_ctx_data *)
+	for (i = 0; i < hw_mgr->num_devices[dev_type]; i++) {
+		p_cfg_req = hw_mgr->dev_staged_cfg_req[dev_type][i];
+		if (p_cfg_req && ((struct cam_jpeg_hw_ctx_data *)
 			p_cfg_req->hw_cfg_args.ctxt_to_hw_map == ctx_data) &&
-			(p_cfg_req->req_id == request_id)) {
-			cam_jpeg_mgr_stop_deinit_dev(hw_mgr, p_cfg_req,
-				dev_type);
-			list_del_init(&p_cfg_req->list);
-			list_add_tail(&p_cfg_req->list,
-				&hw_mgr->free_req_list);
-			b_req_found = true;
-		}
+			(p_cfg_req->req_id == request_id))
+			cam_jpeg_mgr_unstage_req(hw_mgr, dev_type, i);
+
+		p_cfg_req = hw_mgr->dev_hw_cfg_args[dev_type][i];
+		if (hw_mgr->device_in_use[dev_type][i] == false ||
+			p_cfg_req == NULL)
+			continue;
+
+		if (((struct cam_jpeg_hw_ctx_data *)
+			p_cfg_req->hw_cfg_args.ctxt_to_hw_map != ctx_data) ||
+			(p_cfg_req->req_id != request_id))
+			continue;
+
+		cam_jpeg_mgr_stop_deinit_dev(hw_mgr, p_cfg_req, dev_type);
+		list_del_init(&p_cfg_req->list);
+		list_del_init(&p_cfg_req->ctx_list);
+		list_add_tail(&p_cfg_req->list, &hw_mgr->free_req_list);
+		b_req_found = true;
+		break;
 	}
 
 	list_for_each_entry_safe(cfg_req, req_temp,
@@ -1010,6 +1284,18 @@ static int cam_jpeg_mgr_flush_req(void *hw_mgr_priv,
 			continue;
 
 		list_del_init(&cfg_req->list);
+		list_del_init(&cfg_req->ctx_list);
+		list_add_tail(&cfg_req->list, &hw_mgr->free_req_list);
+		b_req_found = true;
+		break;
+	}
+
+	list_for_each_entry_safe(cfg_req, req_temp,
+		&ctx_data->inflight_req_list, ctx_list) {
+		if (!cfg_req->done || cfg_req->req_id != request_id)
+			continue;
+
+		list_del_init(&cfg_req->ctx_list);
 		list_add_tail(&cfg_req->list, &hw_mgr->free_req_list);
 		b_req_found = true;
 		break;
@@ -1070,6 +1356,10 @@ static int cam_jpeg_mgr_hw_flush(void *hw_mgr_priv, void *flush_hw_args)
 
 	mutex_unlock(&hw_mgr->hw_mgr_mutex);
 
+	/* requests parked behind a flushed one can be reported now */
+	if (flush_args->flush_type == CAM_FLUSH_TYPE_REQ)
+		cam_jpeg_mgr_retire_done_reqs(hw_mgr, ctx_data);
+
 	return rc;
 }
 
@@ -1103,9 +1393,88 @@ static int cam_jpeg_mgr_hw_stop(void *hw_mgr_priv, void *stop_hw_args)
 	return rc;
 }
 
+static int cam_jpeg_mgr_get_cdm(struct cam_jpeg_hw_mgr *hw_mgr,
+	struct cam_jpeg_hw_ctx_data *ctx_data, uint32_t dev_type,
+	uint32_t dev_idx)
+{
+	int rc;
+	struct cam_cdm_acquire_data cdm_acquire;
+	struct cam_jpeg_hw_cdm_info_t *cdm_info =
+		&hw_mgr->cdm_info[dev_type][dev_idx];
+
+	if (cdm_info->ref_cnt) {
+		cdm_info->ref_cnt++;
+		return 0;
+	}
+
+	if (dev_type == CAM_JPEG_RES_TYPE_ENC) {
+		memcpy(cdm_acquire.identifier,
+			"jpegenc", sizeof("jpegenc"));
+	} else {
+		memcpy(cdm_acquire.identifier,
+			"jpegdma", sizeof("jpegdma"));
+	}
+	cdm_acquire.cell_index = 0;
+	cdm_acquire.handle = 0;
+	cdm_acquire.userdata = ctx_data;
+	if (hw_mgr->cdm_reg_map[dev_type][dev_idx]) {
+		cdm_acquire.base_array[0] =
+			hw_mgr->cdm_reg_map[dev_type][dev_idx];
+	}
+	cdm_acquire.base_array_cnt = 1;
+	cdm_acquire.id = CAM_CDM_VIRTUAL;
+	cdm_acquire.cam_cdm_callback = NULL;
+	cdm_acquire.priority = CAM_CDM_BL_FIFO_0;
+
+	rc = cam_cdm_acquire(&cdm_acquire);
+	if (rc) {
+		CAM_ERR(CAM_JPEG, "Failed to acquire the CDM HW %d dev %u",
+			rc, dev_idx);
+		return -EFAULT;
+	}
+
+	rc = cam_cdm_stream_on(cdm_acquire.handle);
+	if (rc) {
+		CAM_ERR(CAM_JPEG, "Can not start cdm (%d)!",
+			cdm_acquire.handle);
+		cam_cdm_release(cdm_acquire.handle);
+		return -EFAULT;
+	}
+
+	cdm_info->cdm_handle = cdm_acquire.handle;
+	cdm_info->cdm_ops = cdm_acquire.ops;
+	cdm_info->ref_cnt++;
+
+	return 0;
+}
+
+static void cam_jpeg_mgr_put_cdm(struct cam_jpeg_hw_mgr *hw_mgr,
+	uint32_t dev_type, uint32_t dev_idx)
+{
+	struct cam_jpeg_hw_cdm_info_t *cdm_info =
+		&hw_mgr->cdm_info[dev_type][dev_idx];
+
+	if (!cdm_info->ref_cnt) {
+		CAM_ERR(CAM_JPEG, "Unbalanced cdm put dev %u", dev_idx);
+		return;
+	}
+
+	cdm_info->ref_cnt--;
+	if (cdm_info->ref_cnt)
+		return;
+
+	if (cam_cdm_stream_off(cdm_info->cdm_handle))
+		CAM_ERR(CAM_JPEG, "CDM stream off failed %d",
+			cdm_info->cdm_handle);
+
+	/* release cdm handle */
+	cam_cdm_release(cdm_info->cdm_handle);
+}
+
 static int cam_jpeg_mgr_release_hw(void *hw_mgr_priv, void *release_hw_args)
 {
 	int rc;
+	int i;
 	struct cam_hw_release_args *release_hw = release_hw_args;
 	struct cam_jpeg_hw_mgr *hw_mgr = hw_mgr_priv;
 	struct cam_jpeg_hw_ctx_data *ctx_data = NULL;
@@ -1131,16 +1500,8 @@ static int cam_jpeg_mgr_release_hw(void *hw_mgr_priv, void *release_hw_args)
 		return -EFAULT;
 	}
 
-	hw_mgr->cdm_info[dev_type][0].ref_cnt--;
-	if (!(hw_mgr->cdm_info[dev_type][0].ref_cnt)) {
-		if (cam_cdm_stream_off(
-			hw_mgr->cdm_info[dev_type][0].cdm_handle)) {
-			CAM_ERR(CAM_JPEG, "CDM stream off failed %d",
-				hw_mgr->cdm_info[dev_type][0].cdm_handle);
-		}
-		/* release cdm handle */
-		cam_cdm_release(hw_mgr->cdm_info[dev_type][0].cdm_handle);
-	}
+	for (i = 0; i < hw_mgr->num_devices[dev_type]; i++)
+		cam_jpeg_mgr_put_cdm(hw_mgr, dev_type, i);
 
 	mutex_unlock(&hw_mgr->hw_mgr_mutex);
 
@@ -1164,14 +1525,13 @@ static int cam_jpeg_mgr_release_hw(void *hw_mgr_priv, void *release_hw_args)
 static int cam_jpeg_mgr_acquire_hw(void *hw_mgr_priv, void *acquire_hw_args)
 {
 	int rc = 0;
+	int i;
 	int32_t ctx_id = 0;
 	struct cam_jpeg_hw_mgr *hw_mgr = hw_mgr_priv;
 	struct cam_jpeg_hw_ctx_data *ctx_data = NULL;
 	struct cam_hw_acquire_args *args = acquire_hw_args;
 	struct cam_jpeg_acquire_dev_info jpeg_dev_acquire_info;
-	struct cam_cdm_acquire_data cdm_acquire;
 	uint32_t dev_type;
-	uint32_t size = 0;
 
 	if ((!hw_mgr_priv) || (!acquire_hw_args)) {
 		CAM_ERR(CAM_JPEG, "Invalid params: %pK %pK", hw_mgr_priv,
@@ -1222,52 +1582,14 @@ static int cam_jpeg_mgr_acquire_hw(void *hw_mgr_priv, void *acquire_hw_args)
 		goto acq_cdm_hdl_failed;
 	}
 	dev_type = ctx_data->jpeg_dev_acquire_info.dev_type;
-	if (!hw_mgr->cdm_info[dev_type][0].ref_cnt) {
-
-		if (dev_type == CAM_JPEG_RES_TYPE_ENC) {
-			memcpy(cdm_acquire.identifier,
-				"jpegenc", sizeof("jpegenc"));
-		} else {
-			memcpy(cdm_acquire.identifier,
-				"jpegdma", sizeof("jpegdma"));
-		}
-		cdm_acquire.cell_index = 0;
-		cdm_acquire.handle = 0;
-		cdm_acquire.userdata = ctx_data;
-		if (hw_mgr->cdm_reg_map[dev_type][0]) {
-			cdm_acquire.base_array[0] =
-				hw_mgr->cdm_reg_map[dev_type][0];
-		}
-		cdm_acquire.base_array_cnt = 1;
-		cdm_acquire.id = CAM_CDM_VIRTUAL;
-		cdm_acquire.cam_cdm_callback = NULL;
-		cdm_acquire.priority = CAM_CDM_BL_FIFO_0;
-
-		rc = cam_cdm_acquire(&cdm_acquire);
-		if (rc) {
-			CAM_ERR(CAM_JPEG, "Failed to acquire the CDM HW %d",
-				rc);
-			rc = -EFAULT;
-			goto acq_cdm_hdl_failed;
-		}
-		hw_mgr->cdm_info[dev_type][0].cdm_handle = cdm_acquire.handle;
-		hw_mgr->cdm_info[dev_type][0].cdm_ops = cdm_acquire.ops;
-		hw_mgr->cdm_info[dev_type][0].ref_cnt++;
-	} else {
-		hw_mgr->cdm_info[dev_type][0].ref_cnt++;
+	for (i = 0; i < hw_mgr->num_devices[dev_type]; i++) {
+		rc = cam_jpeg_mgr_get_cdm(hw_mgr, ctx_data, dev_type, i);
+		if (rc)
+			goto put_cdm;
 	}
 
-	size =
-	hw_mgr->cdm_info[dev_type][0].cdm_ops->cdm_required_size_changebase();
-
-	if (hw_mgr->cdm_info[dev_type][0].ref_cnt == 1)
-		if (cam_cdm_stream_on(
-			hw_mgr->cdm_info[dev_type][0].cdm_handle)) {
-			CAM_ERR(CAM_JPEG, "Can not start cdm (%d)!",
-				hw_mgr->cdm_info[dev_type][0].cdm_handle);
-			rc = -EFAULT;
-			goto start_cdm_hdl_failed;
-		}
+	INIT_LIST_HEAD(&ctx_data->inflight_req_list);
+	ctx_data->retire_in_progress = false;
 
 	mutex_lock(&ctx_data->ctx_mutex);
 	ctx_data->context_priv = args->context_data;
@@ -1292,12 +1614,10 @@ static int cam_jpeg_mgr_acquire_hw(void *hw_mgr_priv, void *acquire_hw_args)
 	return rc;
 
 copy_to_user_failed:
-	if (hw_mgr->cdm_info[dev_type][0].ref_cnt == 1)
-		cam_cdm_stream_off(hw_mgr->cdm_info[dev_type][0].cdm_handle);
-start_cdm_hdl_failed:
-	if (hw_mgr->cdm_info[dev_type][0].ref_cnt == 1)
-		cam_cdm_release(hw_mgr->cdm_info[dev_type][0].cdm_handle);
-	hw_mgr->cdm_info[dev_type][0].ref_cnt--;
+	i = hw_mgr->num_devices[dev_type];
+put_cdm:
+	while (--i >= 0)
+		cam_jpeg_mgr_put_cdm(hw_mgr, dev_type, i);
 acq_cdm_hdl_failed:
 	kfree(ctx_data->cdm_cmd);
 jpeg_release_ctx:
@@ -1402,6 +1722,7 @@ static int cam_jpeg_setup_workqs(void)
 	INIT_LIST_HEAD(&g_jpeg_hw_mgr.free_req_list);
 	for (i = 0; i < CAM_JPEG_HW_CFG_Q_MAX; i++) {
 		INIT_LIST_HEAD(&(g_jpeg_hw_mgr.req_list[i].list));
+		INIT_LIST_HEAD(&(g_jpeg_hw_mgr.req_list[i].ctx_list));
 		list_add_tail(&(g_jpeg_hw_mgr.req_list[i].list),
 			&(g_jpeg_hw_mgr.free_req_list));
 	}
@@ -1426,14 +1747,12 @@ static int cam_jpeg_init_devices(struct device_node *of_node,
 	int count, i, rc;
 	uint32_t num_dev;
 	uint32_t num_dma_dev;
+	uint32_t dev_type;
 	const char *name = NULL;
 	struct device_node *child_node = NULL;
 	struct platform_device *child_pdev = NULL;
 	struct cam_hw_intf *child_dev_intf = NULL;
-	struct cam_hw_info *enc_hw = NULL;
-	struct cam_hw_info *dma_hw = NULL;
-	struct cam_hw_soc_info *enc_soc_info = NULL;
-	struct cam_hw_soc_info *dma_soc_info = NULL;
+	struct cam_hw_info *jpeg_hw = NULL;
 
 	if (!p_num_enc_dev || !p_num_dma_dev) {
 		rc = -EINVAL;
@@ -1453,6 +1772,11 @@ static int cam_jpeg_init_devices(struct device_node *of_node,
 		CAM_ERR(CAM_JPEG, "read num enc devices failed %d", rc);
 		goto num_enc_failed;
 	}
+	if (!num_dev || num_dev > CAM_JPEG_HW_MGR_MAX_DEV_PER_TYPE) {
+		CAM_ERR(CAM_JPEG, "Invalid num enc devices %u", num_dev);
+		rc = -EINVAL;
+		goto num_enc_failed;
+	}
 	g_jpeg_hw_mgr.devices[CAM_JPEG_DEV_ENC] = kzalloc(
 		sizeof(struct cam_hw_intf *) * num_dev, GFP_KERNEL);
 	if (!g_jpeg_hw_mgr.devices[CAM_JPEG_DEV_ENC]) {
@@ -1466,6 +1790,11 @@ static int cam_jpeg_init_devices(struct device_node *of_node,
 		CAM_ERR(CAM_JPEG, "get num dma dev nodes failed %d", rc);
 		goto num_dma_failed;
 	}
+	if (!num_dma_dev || num_dma_dev > CAM_JPEG_HW_MGR_MAX_DEV_PER_TYPE) {
+		CAM_ERR(CAM_JPEG, "Invalid num dma devices %u", num_dma_dev);
+		rc = -EINVAL;
+		goto num_dma_failed;
+	}
 
 	g_jpeg_hw_mgr.devices[CAM_JPEG_DEV_DMA] = kzalloc(
 		sizeof(struct cam_hw_intf *) * num_dma_dev, GFP_KERNEL);
@@ -1526,16 +1855,26 @@ static int cam_jpeg_init_devices(struct device_node *of_node,
 		of_node_put(child_node);
 	}
 
-	enc_hw = (struct cam_hw_info *)
-		g_jpeg_hw_mgr.devices[CAM_JPEG_DEV_ENC][0]->hw_priv;
-	enc_soc_info = &enc_hw->soc_info;
-	g_jpeg_hw_mgr.cdm_reg_map[CAM_JPEG_DEV_ENC][0] =
-		&enc_soc_info->reg_map[0];
-	dma_hw = (struct cam_hw_info *)
-		g_jpeg_hw_mgr.devices[CAM_JPEG_DEV_DMA][0]->hw_priv;
-	dma_soc_info = &dma_hw->soc_info;
-	g_jpeg_hw_mgr.cdm_reg_map[CAM_JPEG_DEV_DMA][0] =
-		&dma_soc_info->reg_map[0];
+	g_jpeg_hw_mgr.num_devices[CAM_JPEG_DEV_ENC] = num_dev;
+	g_jpeg_hw_mgr.num_devices[CAM_JPEG_DEV_DMA] = num_dma_dev;
+	for (dev_type = 0; dev_type < CAM_JPEG_DEV_TYPE_MAX; dev_type++) {
+		for (i = 0; i < g_jpeg_hw_mgr.num_devices[dev_type]; i++) {
+			if (!g_jpeg_hw_mgr.devices[dev_type][i]) {
+				CAM_ERR(CAM_JPEG, "dev type %u idx %d missing",
+					dev_type, i);
+				rc = -ENODEV;
+				goto compat_hw_name_failed;
+			}
+
+			jpeg_hw = (struct cam_hw_info *)
+				g_jpeg_hw_mgr.devices[dev_type][i]->hw_priv;
+			g_jpeg_hw_mgr.cdm_reg_map[dev_type][i] =
+				&jpeg_hw->soc_info.reg_map[0];
+			g_jpeg_hw_mgr.dev_cb_data[dev_type][i].dev_type =
+				dev_type;
+			g_jpeg_hw_mgr.dev_cb_data[dev_type][i].dev_idx = i;
+		}
+	}
 
 	rc = g_jpeg_hw_mgr.devices[CAM_JPEG_DEV_ENC][0]->hw_ops.process_cmd(
 		g_jpeg_hw_mgr.devices[CAM_JPEG_DEV_ENC][0]->hw_priv,
@@ -1567,6 +1906,7 @@ num_dev_failed:
 static int cam_jpeg_mgr_hw_dump(void *hw_mgr_priv, void *dump_hw_args)
 {
 	int                             rc;
+	int                             i;
 	uint8_t                        *dst;
 	ktime_t                         cur_time;
 	size_t                          remain_len;
@@ -1582,6 +1922,7 @@ static int cam_jpeg_mgr_hw_dump(void *hw_mgr_priv, void *dump_hw_args)
 	struct cam_jpeg_hw_ctx_data    *ctx_data;
 	struct cam_jpeg_hw_dump_args    jpeg_dump_args;
 	struct cam_jpeg_hw_dump_header *hdr;
+	struct cam_hw_intf             *dev_intf = NULL;
 
 	if (!hw_mgr_priv || !dump_hw_args) {
 		CAM_ERR(CAM_JPEG, "Invalid args %pK %pK",
@@ -1608,11 +1949,18 @@ static int cam_jpeg_mgr_hw_dump(void *hw_mgr_priv, void *dump_hw_args)
 
 	dev_type = ctx_data->jpeg_dev_acquire_info.dev_type;
 
-	if (true == hw_mgr->device_in_use[dev_type][0]) {
-		p_cfg_req = hw_mgr->dev_hw_cfg_args[dev_type][0];
+	for (i = 0; i < hw_mgr->num_devices[dev_type]; i++) {
+		if (false == hw_mgr->device_in_use[dev_type][i])
+			continue;
+
+		p_cfg_req = hw_mgr->dev_hw_cfg_args[dev_type][i];
 		if (p_cfg_req  && p_cfg_req->req_id ==
-			    (uintptr_t)dump_args->request_id)
+			    (uintptr_t)dump_args->request_id &&
+			(struct cam_jpeg_hw_ctx_data *)
+			p_cfg_req->hw_cfg_args.ctxt_to_hw_map == ctx_data) {
+			dev_intf = hw_mgr->devices[dev_type][i];
 			goto hw_dump;
+		}
 	}
 
 	mutex_unlock(&hw_mgr->hw_mgr_mutex);
@@ -1689,9 +2037,9 @@ hw_dump:
 	jpeg_dump_args.request_id = dump_args->request_id;
 	jpeg_dump_args.offset = dump_args->offset;
 
-	if (hw_mgr->devices[dev_type][0]->hw_ops.process_cmd) {
-		rc = hw_mgr->devices[dev_type][0]->hw_ops.process_cmd(
-			hw_mgr->devices[dev_type][0]->hw_priv,
+	if (dev_intf->hw_ops.process_cmd) {
+		rc = dev_intf->hw_ops.process_cmd(
+			dev_intf->hw_priv,
 			CAM_JPEG_CMD_HW_DUMP,
 			&jpeg_dump_args, sizeof(jpeg_dump_args));
 	}
@@ -1732,13 +2080,20 @@ static void cam_jpeg_mgr_dump_pf_data(
 		goto iodump;
 	}
 
-	rc = hw_mgr->devices[dev_type][0]->hw_ops.process_cmd(
-		hw_mgr->devices[dev_type][0]->hw_priv,
-		CAM_JPEG_CMD_MATCH_PID_MID,
-		&jpeg_pid_mid_args, sizeof(jpeg_pid_mid_args));
-	if (rc) {
-		CAM_ERR(CAM_JPEG, "CAM_JPEG_CMD_MATCH_PID_MID failed %d", rc);
-		return;
+	for (i = 0; i < hw_mgr->num_devices[dev_type]; i++) {
+		rc = hw_mgr->devices[dev_type][i]->hw_ops.process_cmd(
+			hw_mgr->devices[dev_type][i]->hw_priv,
+			CAM_JPEG_CMD_MATCH_PID_MID,
+			&jpeg_pid_mid_args, sizeof(jpeg_pid_mid_args));
+		if (rc) {
+			CAM_ERR(CAM_JPEG,
+				"CAM_JPEG_CMD_MATCH_PID_MID failed %d dev %d",
+				rc, i);
+			return;
+		}
+
+		if (jpeg_pid_mid_args.pid_match_found)
+			break;
 	}
 
 	if (!jpeg_pid_mid_args.pid_match_found) {
@@ -1858,6 +2213,64 @@ static int cam_jpeg_get_bug_on_misr(void *data, u64 *val)
 DEFINE_DEBUGFS_ATTRIBUTE(bug_on_misr_mismatch, cam_jpeg_get_bug_on_misr,
 	cam_jpeg_set_bug_on_misr, "%08llu");
 
+static int cam_jpeg_set_disable_job_preload(void *data, u64 val)
+{
+	g_jpeg_hw_mgr.disable_job_preload = val;
+	return 0;
+}
+
+static int cam_jpeg_get_disable_job_preload(void *data, u64 *val)
+{
+	*val = g_jpeg_hw_mgr.disable_job_preload;
+	return 0;
+}
+DEFINE_DEBUGFS_ATTRIBUTE(disable_job_preload, cam_jpeg_get_disable_job_preload,
+	cam_jpeg_set_disable_job_preload, "%08llu");
+
+static ssize_t cam_jpeg_dev_idle_gap_read(struct file *file,
+	char __user *ubuf, size_t size, loff_t *ppos)
+{
+	int i;
+	uint32_t dev_type;
+	char buf[512];
+	int len = 0;
+	struct cam_jpeg_hw_dev_idle_stats *stats;
+
+	mutex_lock(&g_jpeg_hw_mgr.hw_mgr_mutex);
+	for (dev_type = 0; dev_type < CAM_JPEG_DEV_TYPE_MAX; dev_type++) {
+		for (i = 0; i < g_jpeg_hw_mgr.num_devices[dev_type]; i++) {
+			stats = &g_jpeg_hw_mgr.idle_stats[dev_type][i];
+			len += scnprintf(buf + len, sizeof(buf) - len,
+				"%s%d: gaps %llu avg %llu us max %llu us last %llu us\n",
+				(dev_type == CAM_JPEG_DEV_ENC) ? "enc" : "dma",
+				i, stats->num_gaps,
+				stats->num_gaps ?
+				div64_u64(stats->total_gap_us,
+				stats->num_gaps) : 0,
+				stats->max_gap_us, stats->last_gap_us);
+		}
+	}
+	mutex_unlock(&g_jpeg_hw_mgr.hw_mgr_mutex);
+
+	return simple_read_from_buffer(ubuf, size, ppos, buf, len);
+}
+
+static ssize_t cam_jpeg_dev_idle_gap_write(struct file *file,
+	const char __user *ubuf, size_t size, loff_t *ppos)
+{
+	mutex_lock(&g_jpeg_hw_mgr.hw_mgr_mutex);
+	memset(g_jpeg_hw_mgr.idle_stats, 0, sizeof(g_jpeg_hw_mgr.idle_stats));
+	mutex_unlock(&g_jpeg_hw_mgr.hw_mgr_mutex);
+
+	return size;
+}
+
+static const struct file_operations cam_jpeg_dev_idle_gap_fops = {
+	.open = simple_open,
+	.read = cam_jpeg_dev_idle_gap_read,
+	.write = cam_jpeg_dev_idle_gap_write,
+};
+
 static int cam_jpeg_mgr_create_debugfs_entry(void)
 {
 	int rc = 0;
@@ -1878,6 +2291,12 @@ static int cam_jpeg_mgr_create_debugfs_entry(void)
 	dbgfileptr = debugfs_create_file("bug_on_misr_mismatch", 0644,
 		g_jpeg_hw_mgr.dentry, NULL, &bug_on_misr_mismatch);
 
+	dbgfileptr = debugfs_create_file("disable_job_preload", 0644,
+		g_jpeg_hw_mgr.dentry, NULL, &disable_job_preload);
+
+	dbgfileptr = debugfs_create_file("dev_idle_gap", 0644,
+		g_jpeg_hw_mgr.dentry, NULL, &cam_jpeg_dev_idle_gap_fops);
+
 	if (IS_ERR(dbgfileptr)) {
 		if (PTR_ERR(dbgfileptr) == -ENODEV)
 			CAM_WARN(CAM_JPEG, "DebugFS not enabled in kernel!");
@@ -1888,6 +2307,40 @@ err:
 	return rc;
 }
 
+static void cam_jpeg_mgr_free_staged_cdm_cmds(void)
+{
+	int i;
+	uint32_t dev_type;
+
+	for (dev_type = 0; dev_type < CAM_JPEG_DEV_TYPE_MAX; dev_type++) {
+		for (i = 0; i < CAM_JPEG_HW_MGR_MAX_DEV_PER_TYPE; i++) {
+			kfree(g_jpeg_hw_mgr.staged_cdm_cmd[dev_type][i]);
+			g_jpeg_hw_mgr.staged_cdm_cmd[dev_type][i] = NULL;
+		}
+	}
+}
+
+static int cam_jpeg_mgr_alloc_staged_cdm_cmds(void)
+{
+	int i;
+	uint32_t dev_type;
+
+	for (dev_type = 0; dev_type < CAM_JPEG_DEV_TYPE_MAX; dev_type++) {
+		for (i = 0; i < g_jpeg_hw_mgr.num_devices[dev_type]; i++) {
+			g_jpeg_hw_mgr.staged_cdm_cmd[dev_type][i] =
+				kzalloc(((sizeof(struct cam_cdm_bl_request)) +
+				((CAM_JPEG_HW_ENTRIES_MAX - 1) *
+				sizeof(struct cam_cdm_bl_cmd))), GFP_KERNEL);
+			if (!g_jpeg_hw_mgr.staged_cdm_cmd[dev_type][i]) {
+				cam_jpeg_mgr_free_staged_cdm_cmds();
+				return -ENOMEM;
+			}
+		}
+	}
+
+	return 0;
+}
+
 int cam_jpeg_hw_mgr_init(struct device_node *of_node, uint64_t *hw_mgr_hdl,
 	int *iommu_hdl)
 {
@@ -1919,8 +2372,10 @@ int cam_jpeg_hw_mgr_init(struct device_node *of_node, uint64_t *hw_mgr_hdl,
 	mutex_init(&g_jpeg_hw_mgr.hw_mgr_mutex);
 	spin_lock_init(&g_jpeg_hw_mgr.hw_mgr_lock);
 
-	for (i = 0; i < CAM_JPEG_CTX_MAX; i++)
+	for (i = 0; i < CAM_JPEG_CTX_MAX; i++) {
 		mutex_init(&g_jpeg_hw_mgr.ctx_data[i].ctx_mutex);
+		INIT_LIST_HEAD(&g_jpeg_hw_mgr.ctx_data[i].inflight_req_list);
+	}
 
 	rc = cam_jpeg_init_devices(of_node, &num_dev, &num_dma_dev);
 	if (rc) {
@@ -1928,6 +2383,12 @@ int cam_jpeg_hw_mgr_init(struct device_node *of_node, uint64_t *hw_mgr_hdl,
 		goto smmu_get_failed;
 	}
 
+	rc = cam_jpeg_mgr_alloc_staged_cdm_cmds();
+	if (rc) {
+		CAM_ERR(CAM_JPEG, "staged cdm cmd alloc failed %d", rc);
+		goto smmu_get_failed;
+	}
+
 	rc = cam_smmu_get_handle("jpeg", &g_jpeg_hw_mgr.iommu_hdl);
 	if (rc) {
 		CAM_ERR(CAM_JPEG, "jpeg get iommu handle failed %d", rc);
@@ -1982,6 +2443,7 @@ cdm_iommu_failed:
 	cam_smmu_destroy_handle(g_jpeg_hw_mgr.iommu_hdl);
 	g_jpeg_hw_mgr.iommu_hdl = 0;
 smmu_get_failed:
+	cam_jpeg_mgr_free_staged_cdm_cmds();
 	mutex_destroy(&g_jpeg_hw_mgr.hw_mgr_mutex);
 	for (i = 0; i < CAM_JPEG_CTX_MAX; i++)
 		mutex_destroy(&g_jpeg_hw_mgr.ctx_data[i].ctx_mutex);
@@ -15,12 +15,16 @@
 #include "cam_hw_intf.h"
 #include "cam_req_mgr_workq.h"
 #include "cam_mem_mgr.h"
+#include "cam_packet_util.h"
 
 #define CAM_JPEG_WORKQ_NUM_TASK      30
 #define CAM_JPEG_WORKQ_TASK_CMD_TYPE 1
 #define CAM_JPEG_WORKQ_TASK_MSG_TYPE 2
 #define CAM_JPEG_HW_CFG_Q_MAX        50
 
+/* Max instances of one JPEG device type the hw manager schedules on */
+#define CAM_JPEG_HW_MGR_MAX_DEV_PER_TYPE 4
+
 /*
  * Response time threshold in ms beyond which a request is not expected
  * to be with JPEG hw
@@ -47,12 +51,14 @@ struct cam_jpeg_process_frame_work_data_t {
  * @data: Pointer to message data
  * @result_size: Result size of enc/dma
  * @irq_status: IRQ status
+ * @irq_timestamp: Time the IRQ was received
  */
 struct cam_jpeg_process_irq_work_data_t {
 	uint32_t type;
 	void *data;
 	int32_t result_size;
 	uint32_t irq_status;
+	ktime_t irq_timestamp;
 };
 
 /**
@@ -68,23 +74,66 @@ struct cam_jpeg_hw_cdm_info_t {
 	struct cam_cdm_utils_ops *cdm_ops;
 };
 
+/**
+ * struct cam_jpeg_hw_dev_cb_data
+ *
+ * @dev_type: Device type of the instance
+ * @dev_idx: Index of the instance within its device type
+ */
+struct cam_jpeg_hw_dev_cb_data {
+	uint32_t dev_type;
+	uint32_t dev_idx;
+};
+
+/**
+ * struct cam_jpeg_hw_dev_idle_stats
+ *
+ * @last_done_ts: IRQ timestamp of the last job done on the device
+ * @work_pending: Work of this device type was queued when the last job
+ *                was done and has not been dispatched yet
+ * @num_gaps: Number of idle gaps measured between back to back jobs
+ * @total_gap_us: Sum of the measured idle gaps
+ * @max_gap_us: Largest measured idle gap
+ * @last_gap_us: Last measured idle gap
+ */
+struct cam_jpeg_hw_dev_idle_stats {
+	ktime_t last_done_ts;
+	bool work_pending;
+	uint64_t num_gaps;
+	uint64_t total_gap_us;
+	uint64_t max_gap_us;
+	uint64_t last_gap_us;
+};
+
 /**
  * struct cam_jpeg_hw_cfg_req_t
  *
  * @list_head: List head
+ * @ctx_list: Node in the in flight list of the owning context
  * @hw_cfg_args: Hw config args
  * @dev_type: Dev type for cfg request
+ * @dev_idx: Device instance the request is scheduled on
  * @req_id: Request Id
  * @submit_timestamp: Timestamp of submitting request
  * @num_hw_entry_processed: Cdm payloads already processed
+ * @done: Hw is done with the request, buf done not yet reported
+ * @done_evt_id: Context event to report for the request
+ * @done_evt_param: Event param to report on error
+ * @result_size: Result size of enc/dma
  */
 struct cam_jpeg_hw_cfg_req {
 	struct list_head list;
+	struct list_head ctx_list;
 	struct cam_hw_config_args hw_cfg_args;
 	uint32_t dev_type;
+	uint32_t dev_idx;
 	uintptr_t req_id;
 	ktime_t    submit_timestamp;
 	uint32_t num_hw_entry_processed;
+	bool done;
+	uint32_t done_evt_id;
+	uint32_t done_evt_param;
+	int32_t result_size;
 };
 
 /**
@@ -98,6 +147,10 @@ struct cam_jpeg_hw_cfg_req {
  * @in_use: Flag for context usage
  * @wait_complete: Completion info
  * @cdm_cmd: Cdm cmd submitted for that context.
+ * @iova_cache: Patch source buffer iova cache
+ * @inflight_req_list: Requests of the context in submission order,
+ *     from config until buf done is reported
+ * @retire_in_progress: Buf done of finished requests is being reported
  */
 struct cam_jpeg_hw_ctx_data {
 	void *context_priv;
@@ -107,6 +160,9 @@ struct cam_jpeg_hw_ctx_data {
 	bool in_use;
 	struct completion wait_complete;
 	struct cam_cdm_bl_request *cdm_cmd;
+	struct cam_packet_iova_cache iova_cache;
+	struct list_head inflight_req_list;
+	bool retire_in_progress;
 };
 
 /**
@@ -127,11 +183,19 @@ struct cam_jpeg_hw_ctx_data {
  * @dentry: Debugfs entry
  * @camnoc_misr_test : debugfs entry to select camnoc_misr for read or write path
  * @bug_on_misr : enable/disable bug on when misr mismatch is seen
+ * @disable_job_preload: debugfs entry to stop staging the next job on a
+ *     busy device
  * @devices: Core hw Devices of JPEG hardware manager
+ * @num_devices: Number of core hw devices of each type
+ * @dev_cb_data: Irq callback data of each core device
  * @cdm_info: Cdm info for each core device.
  * @cdm_reg_map: Regmap of each device for cdm.
  * @device_in_use: Flag device being used for an active request
  * @dev_hw_cfg_args: Current cfg request per core dev
+ * @dev_staged_cfg_req: Cfg request staged to start right after the
+ *     current one per core dev
+ * @staged_cdm_cmd: Prebuilt cdm cmd of the staged request per core dev
+ * @idle_stats: Idle gap between back to back jobs per core dev
  * @hw_config_req_list: Pending hw update requests list
  * @free_req_list: Free nodes for above list
  * @req_list: Nodes of hw update list
@@ -153,16 +217,26 @@ struct cam_jpeg_hw_mgr {
 	struct dentry *dentry;
 	u64 camnoc_misr_test;
 	u64 bug_on_misr;
+	u64 disable_job_preload;
 
 	struct cam_hw_intf **devices[CAM_JPEG_DEV_TYPE_MAX];
+	uint32_t num_devices[CAM_JPEG_DEV_TYPE_MAX];
+	struct cam_jpeg_hw_dev_cb_data dev_cb_data[CAM_JPEG_DEV_TYPE_MAX]
+		[CAM_JPEG_HW_MGR_MAX_DEV_PER_TYPE];
 	struct cam_jpeg_hw_cdm_info_t cdm_info[CAM_JPEG_DEV_TYPE_MAX]
-		[CAM_JPEG_NUM_DEV_PER_RES_MAX];
+		[CAM_JPEG_HW_MGR_MAX_DEV_PER_TYPE];
 	struct cam_soc_reg_map *cdm_reg_map[CAM_JPEG_DEV_TYPE_MAX]
-		[CAM_JPEG_NUM_DEV_PER_RES_MAX];
+		[CAM_JPEG_HW_MGR_MAX_DEV_PER_TYPE];
 	uint32_t device_in_use[CAM_JPEG_DEV_TYPE_MAX]
-		[CAM_JPEG_NUM_DEV_PER_RES_MAX];
+		[CAM_JPEG_HW_MGR_MAX_DEV_PER_TYPE];
 	struct cam_jpeg_hw_cfg_req *dev_hw_cfg_args[CAM_JPEG_DEV_TYPE_MAX]
-		[CAM_JPEG_NUM_DEV_PER_RES_MAX];
+		[CAM_JPEG_HW_MGR_MAX_DEV_PER_TYPE];
+	struct cam_jpeg_hw_cfg_req *dev_staged_cfg_req[CAM_JPEG_DEV_TYPE_MAX]
+		[CAM_JPEG_HW_MGR_MAX_DEV_PER_TYPE];
+	struct cam_cdm_bl_request *staged_cdm_cmd[CAM_JPEG_DEV_TYPE_MAX]
+		[CAM_JPEG_HW_MGR_MAX_DEV_PER_TYPE];
+	struct cam_jpeg_hw_dev_idle_stats idle_stats[CAM_JPEG_DEV_TYPE_MAX]
+		[CAM_JPEG_HW_MGR_MAX_DEV_PER_TYPE];
 
 	struct list_head hw_config_req_list;
 	struct list_head free_req_list;
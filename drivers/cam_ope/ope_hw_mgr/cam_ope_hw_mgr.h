@@ -21,6 +21,7 @@
 #include "ope_hw.h"
 #include "cam_cdm_intf_api.h"
 #include "cam_req_mgr_timer.h"
+#include "cam_packet_util.h"
 
 #define OPE_CTX_MAX               32
 #define CAM_FRAME_CMD_MAX         20
@@ -449,6 +450,7 @@ struct cam_ope_cdm {
  * @clk_watch_dog_reset_counter: Reset counter
  * @last_flush_req: last flush req for this ctx
  * @req_timer_timeout: req timer timeout value
+ * @iova_cache:      Patch source buffer iova cache
  */
 struct cam_ope_ctx {
 	void *context_priv;
@@ -473,6 +475,7 @@ struct cam_ope_ctx {
 	uint64_t last_flush_req;
 	bool pf_mid_found;
 	uint64_t req_timer_timeout;
+	struct cam_packet_iova_cache iova_cache;
 };
 
 /**
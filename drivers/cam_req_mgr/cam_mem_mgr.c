@@ -22,6 +22,7 @@
 
 static struct cam_mem_table tbl;
 static atomic_t cam_mem_mgr_state = ATOMIC_INIT(CAM_MEM_MGR_UNINITIALIZED);
+static atomic_t cam_mem_unmap_gen = ATOMIC_INIT(0);
 
 static void cam_mem_mgr_print_tbl(void)
 {
@@ -173,6 +174,9 @@ int cam_mem_mgr_init(void)
 	for (i = 1; i < CAM_MEM_BUFQ_MAX; i++) {
 		tbl.bufq[i].fd = -1;
 		tbl.bufq[i].buf_handle = -1;
+		seqlock_init(&tbl.bufq[i].snap_lock);
+		tbl.bufq[i].snap.buf_handle = -1;
+		tbl.bufq[i].snap.fd = -1;
 	}
 	mutex_init(&tbl.m_lock);
 
@@ -183,6 +187,58 @@ int cam_mem_mgr_init(void)
 	return 0;
 }
 
+static void cam_mem_util_publish_snapshot(int32_t idx)
+{
+	struct cam_mem_buf_queue *bufq = &tbl.bufq[idx];
+
+	write_seqlock(&bufq->snap_lock);
+	bufq->snap.buf_handle = bufq->buf_handle;
+	bufq->snap.fd = bufq->fd;
+	bufq->snap.len = bufq->len;
+	bufq->snap.flags = bufq->flags;
+	bufq->snap.kmdvaddr = bufq->kmdvaddr;
+	bufq->snap.num_iova = 0;
+	write_sequnlock(&bufq->snap_lock);
+}
+
+static void cam_mem_util_clear_snapshot(int32_t idx)
+{
+	struct cam_mem_buf_queue *bufq = &tbl.bufq[idx];
+
+	write_seqlock(&bufq->snap_lock);
+	bufq->snap.buf_handle = -1;
+	bufq->snap.fd = -1;
+	bufq->snap.len = 0;
+	bufq->snap.flags = 0;
+	bufq->snap.kmdvaddr = 0;
+	bufq->snap.num_iova = 0;
+	write_sequnlock(&bufq->snap_lock);
+}
+
+static void cam_mem_util_cache_iova(int32_t idx, int32_t buf_handle,
+	int32_t mmu_handle, dma_addr_t iova, size_t len)
+{
+	struct cam_mem_buf_queue *bufq = &tbl.bufq[idx];
+	uint32_t i, n;
+
+	write_seqlock(&bufq->snap_lock);
+	n = bufq->snap.num_iova;
+	for (i = 0; i < n; i++) {
+		if (bufq->snap.mmu_hdls[i] == mmu_handle)
+			goto end;
+	}
+
+	if ((bufq->snap.buf_handle == buf_handle) &&
+		(n < CAM_MEM_MMU_MAX_HANDLE)) {
+		bufq->snap.mmu_hdls[n] = mmu_handle;
+		bufq->snap.iova[n] = iova;
+		bufq->snap.iova_len[n] = len;
+		bufq->snap.num_iova = n + 1;
+	}
+end:
+	write_sequnlock(&bufq->snap_lock);
+}
+
 static int32_t cam_mem_get_slot(void)
 {
 	int32_t idx;
@@ -213,6 +269,7 @@ static void cam_mem_put_slot(int32_t idx)
 	tbl.bufq[idx].release_deferred = false;
 	tbl.bufq[idx].is_internal = false;
 	memset(&tbl.bufq[idx].timestamp, 0, sizeof(struct timespec64));
+	cam_mem_util_clear_snapshot(idx);
 	mutex_unlock(&tbl.bufq[idx].q_lock);
 	mutex_lock(&tbl.bufq[idx].ref_lock);
 	memset(&tbl.bufq[idx].krefcount, 0, sizeof(struct kref));
@@ -228,6 +285,11 @@ int cam_mem_get_io_buf(int32_t buf_handle, int32_t mmu_handle,
 	dma_addr_t *iova_ptr, size_t *len_ptr)
 {
 	int rc = 0, idx;
+	int32_t snap_handle;
+	unsigned int seq;
+	uint32_t i;
+	bool hit;
+	struct cam_mem_buf_queue *bufq;
 
 	*len_ptr = 0;
 
@@ -240,53 +302,142 @@ int cam_mem_get_io_buf(int32_t buf_handle, int32_t mmu_handle,
 	if (idx >= CAM_MEM_BUFQ_MAX || idx <= 0)
 		return -ENOENT;
 
-	if (!tbl.bufq[idx].active) {
+	bufq = &tbl.bufq[idx];
+	if (!bufq->active) {
 		CAM_ERR(CAM_MEM, "Buffer at idx=%d is already unmapped,",
 			idx);
 		return -EAGAIN;
 	}
 
-	mutex_lock(&tbl.bufq[idx].q_lock);
-	if (buf_handle != tbl.bufq[idx].buf_handle) {
+	do {
+		seq = read_seqbegin(&bufq->snap_lock);
+		snap_handle = bufq->snap.buf_handle;
+		hit = false;
+		for (i = 0; (i < bufq->snap.num_iova) &&
+			(i < CAM_MEM_MMU_MAX_HANDLE); i++) {
+			if (bufq->snap.mmu_hdls[i] == mmu_handle) {
+				*iova_ptr = bufq->snap.iova[i];
+				*len_ptr = bufq->snap.iova_len[i];
+				hit = true;
+				break;
+			}
+		}
+	} while (read_seqretry(&bufq->snap_lock, seq));
+
+	if (snap_handle != buf_handle) {
+		*len_ptr = 0;
+		return -EINVAL;
+	}
+
+	if (hit) {
+		CAM_DBG(CAM_MEM, "handle:0x%x buf_hdl:0x%x iova:0x%llx len:%zu",
+			mmu_handle, buf_handle, (uint64_t)*iova_ptr, *len_ptr);
+		return 0;
+	}
+
+	/* First lookup for this mmu handle, resolve it through SMMU */
+	mutex_lock(&bufq->q_lock);
+	if (buf_handle != bufq->buf_handle) {
 		rc = -EINVAL;
 		goto handle_mismatch;
 	}
 
 	if (CAM_MEM_MGR_IS_SECURE_HDL(buf_handle))
 		rc = cam_smmu_get_stage2_iova(mmu_handle,
-			tbl.bufq[idx].fd,
+			bufq->fd,
 			iova_ptr,
 			len_ptr);
 	else
 		rc = cam_smmu_get_iova(mmu_handle,
-			tbl.bufq[idx].fd,
+			bufq->fd,
 			iova_ptr,
 			len_ptr);
 	if (rc) {
 		CAM_ERR(CAM_MEM,
 			"fail to map buf_hdl:0x%x, mmu_hdl: 0x%x for fd:%d",
-			buf_handle, mmu_handle, tbl.bufq[idx].fd);
+			buf_handle, mmu_handle, bufq->fd);
 		goto handle_mismatch;
 	}
 
+	cam_mem_util_cache_iova(idx, buf_handle, mmu_handle,
+		*iova_ptr, *len_ptr);
+
 	CAM_DBG(CAM_MEM,
 		"handle:0x%x fd:%d iova_ptr:%pK len_ptr:%llu",
-		mmu_handle, tbl.bufq[idx].fd, iova_ptr, *len_ptr);
+		mmu_handle, bufq->fd, iova_ptr, *len_ptr);
 handle_mismatch:
-	mutex_unlock(&tbl.bufq[idx].q_lock);
+	mutex_unlock(&bufq->q_lock);
 	return rc;
 }
 EXPORT_SYMBOL(cam_mem_get_io_buf);
 
-int cam_mem_get_cpu_buf(int32_t buf_handle, uintptr_t *vaddr_ptr, size_t *len)
+static int cam_mem_util_get_cpu_snapshot(int32_t idx, int32_t buf_handle,
+	uintptr_t *kmdvaddr, size_t *len)
 {
-	int idx;
+	struct cam_mem_buf_queue *bufq = &tbl.bufq[idx];
+	int32_t snap_handle;
+	uint32_t flags;
+	unsigned int seq;
 
-	if (!atomic_read(&cam_mem_mgr_state)) {
-		CAM_ERR(CAM_MEM, "failed. mem_mgr not initialized");
+	do {
+		seq = read_seqbegin(&bufq->snap_lock);
+		snap_handle = bufq->snap.buf_handle;
+		flags = bufq->snap.flags;
+		*kmdvaddr = bufq->snap.kmdvaddr;
+		*len = bufq->snap.len;
+	} while (read_seqretry(&bufq->snap_lock, seq));
+
+	if (buf_handle != snap_handle) {
+		CAM_ERR(CAM_MEM, "idx: %d Invalid buf handle %d",
+			idx, buf_handle);
+		return -EINVAL;
+	}
+
+	if (!(flags & CAM_MEM_FLAG_KMD_ACCESS)) {
+		CAM_ERR(CAM_MEM, "idx: %d Invalid flag 0x%x",
+			idx, flags);
+		return -EINVAL;
+	}
+
+	if (!*kmdvaddr) {
+		CAM_ERR(CAM_MEM, "No KMD access requested, kmdvddr= %p, idx= %d, buf_handle= %d",
+			*kmdvaddr, idx, buf_handle);
 		return -EINVAL;
 	}
 
+	return 0;
+}
+
+static void cam_mem_util_unmap_dummy(struct kref *kref);
+static void cam_mem_util_unmap_wrapper(struct kref *kref);
+
+/* Whether the slot snapshot now describes a different live buffer */
+static bool cam_mem_util_snapshot_reused(int32_t idx, int32_t buf_handle,
+	uintptr_t kmdvaddr)
+{
+	struct cam_mem_buf_queue *bufq = &tbl.bufq[idx];
+	int32_t snap_handle;
+	uintptr_t snap_kmdvaddr;
+	unsigned int seq;
+
+	do {
+		seq = read_seqbegin(&bufq->snap_lock);
+		snap_handle = bufq->snap.buf_handle;
+		snap_kmdvaddr = bufq->snap.kmdvaddr;
+	} while (read_seqretry(&bufq->snap_lock, seq));
+
+	if (snap_handle == -1)
+		return false;
+
+	return (snap_handle != buf_handle) || (snap_kmdvaddr != kmdvaddr);
+}
+
+int cam_mem_get_cpu_buf(int32_t buf_handle, uintptr_t *vaddr_ptr, size_t *len)
+{
+	int rc, idx;
+	uintptr_t kmdvaddr, kmdvaddr_chk;
+	size_t buf_len, len_chk;
+
 	if (!atomic_read(&cam_mem_mgr_state)) {
 		CAM_ERR(CAM_MEM, "failed. mem_mgr not initialized");
 		return -EINVAL;
@@ -306,49 +457,130 @@ int cam_mem_get_cpu_buf(int32_t buf_handle, uintptr_t *vaddr_ptr, size_t *len)
 		return -EPERM;
 	}
 
-	if (buf_handle != tbl.bufq[idx].buf_handle) {
-		CAM_ERR(CAM_MEM, "idx: %d Invalid buf handle %d",
-				idx, buf_handle);
-		return -EINVAL;
-	}
+	rc = cam_mem_util_get_cpu_snapshot(idx, buf_handle, &kmdvaddr,
+		&buf_len);
+	if (rc)
+		return rc;
 
-	if (!(tbl.bufq[idx].flags & CAM_MEM_FLAG_KMD_ACCESS)) {
-		CAM_ERR(CAM_MEM, "idx: %d Invalid flag 0x%x",
-					idx, tbl.bufq[idx].flags);
+	/*
+	 * Release paths drop krefcount to zero before unmapping, so a
+	 * successful get here keeps the mapping alive until put.
+	 */
+	if (!kref_get_unless_zero(&tbl.bufq[idx].krefcount)) {
+		CAM_ERR(CAM_MEM, "Buffer being released, idx= %d, buf_handle= %d",
+			idx, buf_handle);
 		return -EINVAL;
 	}
 
-	mutex_lock(&tbl.bufq[idx].ref_lock);
-	if (tbl.bufq[idx].kmdvaddr && kref_get_unless_zero(&tbl.bufq[idx].krefcount)) {
-		*vaddr_ptr = tbl.bufq[idx].kmdvaddr;
-		*len = tbl.bufq[idx].len;
-	} else {
-		mutex_unlock(&tbl.bufq[idx].ref_lock);
-		CAM_ERR(CAM_MEM, "No KMD access requested, kmdvddr= %p, idx= %d, buf_handle= %d",
-			tbl.bufq[idx].kmdvaddr, idx, buf_handle);
+	/* Slot may have been released and reused before the ref was taken */
+	rc = cam_mem_util_get_cpu_snapshot(idx, buf_handle, &kmdvaddr_chk,
+		&len_chk);
+	if (rc || (kmdvaddr_chk != kmdvaddr)) {
+		if (cam_mem_util_snapshot_reused(idx, buf_handle, kmdvaddr)) {
+			/*
+			 * Slot now belongs to another buffer, drop only the
+			 * ref taken above, its owner still holds its own and
+			 * does the unmap.
+			 */
+			mutex_lock(&tbl.bufq[idx].ref_lock);
+			kref_put(&tbl.bufq[idx].krefcount,
+				cam_mem_util_unmap_dummy);
+			mutex_unlock(&tbl.bufq[idx].ref_lock);
+		} else {
+			/*
+			 * Our buffer is being released, the owner's put may
+			 * have left the last ref to us, so unmap on release.
+			 */
+			kref_put(&tbl.bufq[idx].krefcount,
+				cam_mem_util_unmap_wrapper);
+		}
 		return -EINVAL;
 	}
-	mutex_unlock(&tbl.bufq[idx].ref_lock);
+
+	*vaddr_ptr = kmdvaddr;
+	*len = buf_len;
 
 	return 0;
 }
 EXPORT_SYMBOL(cam_mem_get_cpu_buf);
 
-int cam_mem_mgr_cache_ops(struct cam_mem_cache_ops_cmd *cmd)
+static int cam_mem_util_cache_ops(int idx, uint32_t mem_cache_ops,
+	uint64_t offset, uint64_t length)
 {
-	int rc = 0, idx;
-	uint32_t cache_dir;
+	int rc = 0;
+	uint32_t cache_dir, begin_dir;
 	unsigned long dmabuf_flag = 0;
+	struct dma_buf *dmabuf = tbl.bufq[idx].dma_buf;
+	bool partial;
 
-	if (!atomic_read(&cam_mem_mgr_state)) {
-		CAM_ERR(CAM_MEM, "failed. mem_mgr not initialized");
+	rc = dma_buf_get_flags(dmabuf, &dmabuf_flag);
+	if (rc) {
+		CAM_ERR(CAM_MEM, "cache get flags failed %d", rc);
+		return rc;
+	}
+
+	if (!(dmabuf_flag & ION_FLAG_CACHED)) {
+		CAM_DBG(CAM_MEM, "BUF is not cached");
+		return 0;
+	}
+
+	switch (mem_cache_ops) {
+	case CAM_MEM_CLEAN_CACHE:
+		cache_dir = DMA_TO_DEVICE;
+		break;
+	case CAM_MEM_INV_CACHE:
+		cache_dir = DMA_FROM_DEVICE;
+		break;
+	case CAM_MEM_CLEAN_INV_CACHE:
+		cache_dir = DMA_BIDIRECTIONAL;
+		break;
+	default:
+		CAM_ERR(CAM_MEM, "invalid cache ops :%d", mem_cache_ops);
 		return -EINVAL;
 	}
 
-	if (!cmd)
+	if ((offset >= tbl.bufq[idx].len) ||
+		(length > tbl.bufq[idx].len - offset)) {
+		CAM_ERR(CAM_MEM,
+			"Invalid range offset %llu length %llu buf len %zu idx %d",
+			offset, length, tbl.bufq[idx].len, idx);
 		return -EINVAL;
+	}
 
-	idx = CAM_MEM_MGR_GET_HDL_IDX(cmd->buf_handle);
+	if (!length)
+		length = tbl.bufq[idx].len - offset;
+	partial = (offset || length != tbl.bufq[idx].len);
+
+	begin_dir = (mem_cache_ops == CAM_MEM_CLEAN_INV_CACHE) ?
+		DMA_BIDIRECTIONAL : DMA_TO_DEVICE;
+
+	if (partial)
+		rc = dma_buf_begin_cpu_access_partial(dmabuf, begin_dir,
+			offset, length);
+	else
+		rc = dma_buf_begin_cpu_access(dmabuf, begin_dir);
+	if (rc) {
+		CAM_ERR(CAM_MEM, "dma begin access failed rc=%d", rc);
+		return rc;
+	}
+
+	if (partial)
+		rc = dma_buf_end_cpu_access_partial(dmabuf, cache_dir,
+			offset, length);
+	else
+		rc = dma_buf_end_cpu_access(dmabuf, cache_dir);
+	if (rc)
+		CAM_ERR(CAM_MEM, "dma end access failed rc=%d", rc);
+
+	return rc;
+}
+
+static int cam_mem_util_cache_ops_hdl(int32_t buf_handle,
+	uint32_t mem_cache_ops, uint64_t offset, uint64_t length)
+{
+	int rc = 0, idx;
+
+	idx = CAM_MEM_MGR_GET_HDL_IDX(buf_handle);
 	if (idx >= CAM_MEM_BUFQ_MAX || idx <= 0)
 		return -EINVAL;
 
@@ -361,59 +593,77 @@ int cam_mem_mgr_cache_ops(struct cam_mem_cache_ops_cmd *cmd)
 		goto end;
 	}
 
-	if (cmd->buf_handle != tbl.bufq[idx].buf_handle) {
+	if (buf_handle != tbl.bufq[idx].buf_handle) {
 		rc = -EINVAL;
 		goto end;
 	}
 
-	rc = dma_buf_get_flags(tbl.bufq[idx].dma_buf, &dmabuf_flag);
-	if (rc) {
-		CAM_ERR(CAM_MEM, "cache get flags failed %d", rc);
-		goto end;
+	rc = cam_mem_util_cache_ops(idx, mem_cache_ops, offset, length);
+
+end:
+	mutex_unlock(&tbl.bufq[idx].q_lock);
+	return rc;
+}
+
+int cam_mem_mgr_cache_ops(struct cam_mem_cache_ops_cmd *cmd)
+{
+	if (!atomic_read(&cam_mem_mgr_state)) {
+		CAM_ERR(CAM_MEM, "failed. mem_mgr not initialized");
+		return -EINVAL;
 	}
 
-	if (dmabuf_flag & ION_FLAG_CACHED) {
-		switch (cmd->mem_cache_ops) {
-		case CAM_MEM_CLEAN_CACHE:
-			cache_dir = DMA_TO_DEVICE;
-			break;
-		case CAM_MEM_INV_CACHE:
-			cache_dir = DMA_FROM_DEVICE;
-			break;
-		case CAM_MEM_CLEAN_INV_CACHE:
-			cache_dir = DMA_BIDIRECTIONAL;
-			break;
-		default:
-			CAM_ERR(CAM_MEM,
-				"invalid cache ops :%d", cmd->mem_cache_ops);
-			rc = -EINVAL;
-			goto end;
-		}
-	} else {
-		CAM_DBG(CAM_MEM, "BUF is not cached");
-		goto end;
+	if (!cmd)
+		return -EINVAL;
+
+	return cam_mem_util_cache_ops_hdl(cmd->buf_handle,
+		cmd->mem_cache_ops, 0, 0);
+}
+EXPORT_SYMBOL(cam_mem_mgr_cache_ops);
+
+int cam_mem_mgr_cache_ops_range(struct cam_mem_cache_ops_range_cmd *cmd)
+{
+	if (!atomic_read(&cam_mem_mgr_state)) {
+		CAM_ERR(CAM_MEM, "failed. mem_mgr not initialized");
+		return -EINVAL;
 	}
 
-	rc = dma_buf_begin_cpu_access(tbl.bufq[idx].dma_buf,
-		(cmd->mem_cache_ops == CAM_MEM_CLEAN_INV_CACHE) ?
-		DMA_BIDIRECTIONAL : DMA_TO_DEVICE);
-	if (rc) {
-		CAM_ERR(CAM_MEM, "dma begin access failed rc=%d", rc);
-		goto end;
+	if (!cmd)
+		return -EINVAL;
+
+	return cam_mem_util_cache_ops_hdl(cmd->buf_handle,
+		cmd->mem_cache_ops, cmd->offset, cmd->length);
+}
+EXPORT_SYMBOL(cam_mem_mgr_cache_ops_range);
+
+int cam_mem_mgr_cache_ops_vec(struct cam_mem_cache_ops_range_cmd *cmds,
+	uint32_t num_cmds)
+{
+	int rc = 0;
+	uint32_t i;
+
+	if (!atomic_read(&cam_mem_mgr_state)) {
+		CAM_ERR(CAM_MEM, "failed. mem_mgr not initialized");
+		return -EINVAL;
 	}
 
-	rc = dma_buf_end_cpu_access(tbl.bufq[idx].dma_buf,
-		cache_dir);
-	if (rc) {
-		CAM_ERR(CAM_MEM, "dma end access failed rc=%d", rc);
-		goto end;
+	if (!cmds || !num_cmds)
+		return -EINVAL;
+
+	for (i = 0; i < num_cmds; i++) {
+		rc = cam_mem_util_cache_ops_hdl(cmds[i].buf_handle,
+			cmds[i].mem_cache_ops, cmds[i].offset,
+			cmds[i].length);
+		if (rc) {
+			CAM_ERR(CAM_MEM,
+				"cache ops failed at range %u handle 0x%x rc %d",
+				i, cmds[i].buf_handle, rc);
+			break;
+		}
 	}
 
-end:
-	mutex_unlock(&tbl.bufq[idx].q_lock);
 	return rc;
 }
-EXPORT_SYMBOL(cam_mem_mgr_cache_ops);
+EXPORT_SYMBOL(cam_mem_mgr_cache_ops_vec);
 
 static int cam_mem_util_get_dma_buf(size_t len,
 	unsigned int heap_id_mask,
@@ -775,6 +1025,7 @@ int cam_mem_mgr_alloc_and_map(struct cam_mem_mgr_alloc_cmd *cmd)
 	kref_init(&tbl.bufq[idx].urefcount);
 
 	tbl.bufq[idx].smmu_mapping_client = CAM_SMMU_MAPPING_USER;
+	cam_mem_util_publish_snapshot(idx);
 	mutex_unlock(&tbl.bufq[idx].q_lock);
 
 	cmd->out.buf_handle = tbl.bufq[idx].buf_handle;
@@ -913,6 +1164,7 @@ int cam_mem_mgr_map(struct cam_mem_mgr_map_cmd *cmd)
 		kref_init(&tbl.bufq[idx].krefcount);
 	kref_init(&tbl.bufq[idx].urefcount);
 	tbl.bufq[idx].smmu_mapping_client = CAM_SMMU_MAPPING_USER;
+	cam_mem_util_publish_snapshot(idx);
 	mutex_unlock(&tbl.bufq[idx].q_lock);
 
 	cmd->out.buf_handle = tbl.bufq[idx].buf_handle;
@@ -1046,6 +1298,8 @@ static int cam_mem_mgr_cleanup_table(void)
 		tbl.bufq[i].active = false;
 		tbl.bufq[i].release_deferred = false;
 		tbl.bufq[i].is_internal = false;
+		cam_mem_util_clear_snapshot(i);
+		atomic_inc(&cam_mem_unmap_gen);
 		mutex_unlock(&tbl.bufq[i].q_lock);
 		mutex_lock(&tbl.bufq[i].ref_lock);
 		memset(&tbl.bufq[i].krefcount, 0, sizeof(struct kref));
@@ -1111,6 +1365,8 @@ static void cam_mem_util_unmap(int32_t idx)
 	tbl.bufq[idx].active = false;
 	tbl.bufq[idx].vaddr = 0;
 	tbl.bufq[idx].release_deferred = false;
+	cam_mem_util_clear_snapshot(idx);
+	atomic_inc(&cam_mem_unmap_gen);
 	mutex_unlock(&tbl.bufq[idx].q_lock);
 	mutex_unlock(&tbl.m_lock);
 
@@ -1189,46 +1445,25 @@ static void cam_mem_util_unmap_wrapper(struct kref *kref)
 	mutex_destroy(&tbl.bufq[idx].ref_lock);
 }
 
-void cam_mem_put_cpu_buf(int32_t buf_handle)
+static void cam_mem_util_put_kref(int32_t idx, int32_t buf_handle)
 {
-	int rc = 0;
-	int idx;
 	uint64_t ms, hrs, min, sec;
 	struct timespec64 current_ts;
 	uint32_t krefcount = 0, urefcount = 0;
 	bool unmap = false;
 
-	if (!buf_handle) {
-		CAM_ERR(CAM_MEM, "Invalid buf_handle");
-		return;
-	}
-
-	idx = CAM_MEM_MGR_GET_HDL_IDX(buf_handle);
-	if (idx >= CAM_MEM_BUFQ_MAX || idx <= 0) {
-		CAM_ERR(CAM_MEM, "idx: %d not valid", idx);
-		return;
-	}
-
-	if (!tbl.bufq[idx].active) {
-		CAM_ERR(CAM_MEM, "idx: %d not active", idx);
-		rc = -EPERM;
-		return;
-	}
-
-	if (buf_handle != tbl.bufq[idx].buf_handle) {
-		CAM_ERR(CAM_MEM, "idx: %d Invalid buf handle %d",
-				idx, buf_handle);
-		rc = -EINVAL;
-		return;
-	}
-
 	mutex_lock(&tbl.bufq[idx].ref_lock);
 	kref_put(&tbl.bufq[idx].krefcount, cam_mem_util_unmap_dummy);
 
 	krefcount = kref_read(&tbl.bufq[idx].krefcount);
 	urefcount = kref_read(&tbl.bufq[idx].urefcount);
 
-	if ((krefcount == 1) && (urefcount == 0))
+	/*
+	 * Claim the last kmd reference before unmapping so that a lockless
+	 * cam_mem_get_cpu_buf racing with us fails kref_get_unless_zero.
+	 */
+	if ((krefcount == 1) && (urefcount == 0) &&
+		refcount_dec_if_one(&tbl.bufq[idx].krefcount.refcount))
 		unmap = true;
 
 	if (unmap) {
@@ -1258,10 +1493,47 @@ void cam_mem_put_cpu_buf(int32_t buf_handle)
 
 	if (unmap)
 		mutex_destroy(&tbl.bufq[idx].ref_lock);
+}
 
+void cam_mem_put_cpu_buf(int32_t buf_handle)
+{
+	int rc = 0;
+	int idx;
+
+	if (!buf_handle) {
+		CAM_ERR(CAM_MEM, "Invalid buf_handle");
+		return;
+	}
+
+	idx = CAM_MEM_MGR_GET_HDL_IDX(buf_handle);
+	if (idx >= CAM_MEM_BUFQ_MAX || idx <= 0) {
+		CAM_ERR(CAM_MEM, "idx: %d not valid", idx);
+		return;
+	}
+
+	if (!tbl.bufq[idx].active) {
+		CAM_ERR(CAM_MEM, "idx: %d not active", idx);
+		rc = -EPERM;
+		return;
+	}
+
+	if (buf_handle != tbl.bufq[idx].buf_handle) {
+		CAM_ERR(CAM_MEM, "idx: %d Invalid buf handle %d",
+				idx, buf_handle);
+		rc = -EINVAL;
+		return;
+	}
+
+	cam_mem_util_put_kref(idx, buf_handle);
 }
 EXPORT_SYMBOL(cam_mem_put_cpu_buf);
 
+uint32_t cam_mem_mgr_get_unmap_gen(void)
+{
+	return (uint32_t)atomic_read(&cam_mem_unmap_gen);
+}
+EXPORT_SYMBOL(cam_mem_mgr_get_unmap_gen);
+
 
 int cam_mem_mgr_release(struct cam_mem_mgr_release_cmd *cmd)
 {
@@ -1310,7 +1582,8 @@ int cam_mem_mgr_release(struct cam_mem_mgr_release_cmd *cmd)
 
 	if (tbl.bufq[idx].flags & CAM_MEM_FLAG_KMD_ACCESS) {
 		krefcount = kref_read(&tbl.bufq[idx].krefcount);
-		if ((krefcount == 1) && (urefcount == 0))
+		if ((krefcount == 1) && (urefcount == 0) &&
+			refcount_dec_if_one(&tbl.bufq[idx].krefcount.refcount))
 			unmap = true;
 	} else {
 		if (urefcount == 0)
@@ -1464,6 +1737,7 @@ int cam_mem_mgr_request_mem(struct cam_mem_mgr_request_desc *inp,
 	tbl.bufq[idx].is_imported = false;
 	kref_init(&tbl.bufq[idx].krefcount);
 	tbl.bufq[idx].smmu_mapping_client = CAM_SMMU_MAPPING_KERNEL;
+	cam_mem_util_publish_snapshot(idx);
 	mutex_unlock(&tbl.bufq[idx].q_lock);
 
 	out->kva = kvaddr;
@@ -1621,6 +1895,7 @@ int cam_mem_mgr_reserve_memory_region(struct cam_mem_mgr_request_desc *inp,
 	tbl.bufq[idx].is_imported = false;
 	kref_init(&tbl.bufq[idx].krefcount);
 	tbl.bufq[idx].smmu_mapping_client = CAM_SMMU_MAPPING_KERNEL;
+	cam_mem_util_publish_snapshot(idx);
 	mutex_unlock(&tbl.bufq[idx].q_lock);
 
 	out->kva = 0;
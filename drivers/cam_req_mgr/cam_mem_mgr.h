@@ -8,6 +8,7 @@
 #define _CAM_MEM_MGR_H_
 
 #include <linux/mutex.h>
+#include <linux/seqlock.h>
 #include <linux/dma-buf.h>
 #include <media/cam_req_mgr.h>
 #include "cam_mem_mgr_api.h"
@@ -24,6 +25,34 @@ enum cam_smmu_mapping_client {
 	CAM_SMMU_MAPPING_KERNEL,
 };
 
+/**
+ * struct cam_mem_buf_snapshot
+ *
+ * Copy of the fields read on the io/cpu buffer lookup path, published
+ * under the slot snap_lock so that lookups do not take q_lock/ref_lock.
+ *
+ * @buf_handle:     Handle the snapshot is valid for, -1 if slot is not mapped
+ * @fd:             File descriptor of buffer
+ * @len:            Size of buffer
+ * @flags:          Attributes of buffer
+ * @kmdvaddr:       Kernel virtual address
+ * @num_iova:       Number of valid entries in the iova cache
+ * @mmu_hdls:       MMU handles for which the iova is cached
+ * @iova:           Cached iova per mmu handle
+ * @iova_len:       Cached mapping length per mmu handle
+ */
+struct cam_mem_buf_snapshot {
+	int32_t buf_handle;
+	int32_t fd;
+	size_t len;
+	uint32_t flags;
+	uintptr_t kmdvaddr;
+	uint32_t num_iova;
+	int32_t mmu_hdls[CAM_MEM_MMU_MAX_HANDLE];
+	dma_addr_t iova[CAM_MEM_MMU_MAX_HANDLE];
+	size_t iova_len[CAM_MEM_MMU_MAX_HANDLE];
+};
+
 /**
  * struct cam_mem_buf_queue
  *
@@ -49,6 +78,8 @@ enum cam_smmu_mapping_client {
  * @urefcount:      Reference counter to track whether the buffer is
  *                  mapped and in use by umd
  * @ref_lock:       Mutex lock for refcount
+ * @snap_lock:      Seqlock protecting the lookup snapshot
+ * @snap:           Lookup snapshot of the buffer
  */
 struct cam_mem_buf_queue {
 	struct dma_buf *dma_buf;
@@ -71,6 +102,8 @@ struct cam_mem_buf_queue {
 	enum cam_smmu_mapping_client smmu_mapping_client;
 	struct kref urefcount;
 	struct mutex ref_lock;
+	seqlock_t snap_lock;
+	struct cam_mem_buf_snapshot snap;
 };
 
 /**
@@ -132,6 +165,26 @@ int cam_mem_mgr_map(struct cam_mem_mgr_map_cmd *cmd);
  */
 int cam_mem_mgr_cache_ops(struct cam_mem_cache_ops_cmd *cmd);
 
+/**
+ * @brief: Perform cache ops on a range of the buffer
+ *
+ * @cmd:   Cache ops and range information
+ *
+ * @return Status of operation. Negative in case of error. Zero otherwise.
+ */
+int cam_mem_mgr_cache_ops_range(struct cam_mem_cache_ops_range_cmd *cmd);
+
+/**
+ * @brief: Perform cache ops on multiple ranges, possibly across buffers
+ *
+ * @cmds:       Array of cache ops and range information
+ * @num_cmds:   Number of entries in cmds
+ *
+ * @return Status of operation. Negative in case of error. Zero otherwise.
+ */
+int cam_mem_mgr_cache_ops_vec(struct cam_mem_cache_ops_range_cmd *cmds,
+	uint32_t num_cmds);
+
 /**
  * @brief: Initializes the memory manager
  *
@@ -98,6 +98,16 @@ int cam_mem_get_cpu_buf(int32_t buf_handle, uintptr_t *vaddr_ptr,
  */
 void cam_mem_put_cpu_buf(int32_t buf_handle);
 
+/**
+ * @brief: Returns the buffer unmap generation
+ *
+ * The generation is bumped every time a buffer is unmapped or released,
+ * so lookups cached by clients remain valid while it is unchanged.
+ *
+ * @return Current unmap generation
+ */
+uint32_t cam_mem_mgr_get_unmap_gen(void);
+
 static inline bool cam_mem_is_secure_buf(int32_t buf_handle)
 {
 	return CAM_MEM_MGR_IS_SECURE_HDL(buf_handle);
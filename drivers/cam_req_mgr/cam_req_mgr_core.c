@@ -159,6 +159,47 @@ static void __cam_req_mgr_dec_idx(int32_t *val, int32_t step, int32_t max_val)
 		*val = max_val + (*val);
 }
 
+/**
+ * __cam_req_mgr_in_q_set_req_id()
+ *
+ * @brief    : Update req id of a slot and keep req_id to slot map in sync.
+ *             Every write of slot req_id must go through this helper.
+ * @in_q     : input queue pointer
+ * @idx      : slot index to update
+ * @req_id   : new request id, negative value means slot holds no request
+ *
+ */
+static void __cam_req_mgr_in_q_set_req_id(struct cam_req_mgr_req_queue *in_q,
+	int32_t idx, int64_t req_id)
+{
+	struct cam_req_mgr_slot *slot = &in_q->slot[idx];
+
+	spin_lock(&in_q->map_lock);
+	hash_del(&slot->req_node);
+	slot->req_id = req_id;
+	if (req_id >= 0)
+		hash_add(in_q->req_map, &slot->req_node, req_id);
+	spin_unlock(&in_q->map_lock);
+}
+
+/**
+ * __cam_req_mgr_in_q_reset_req_map()
+ *
+ * @brief    : Drop all entries of req_id to slot map, to be used whenever
+ *             slot array is wiped as a whole, caller holds map_lock
+ * @in_q     : input queue pointer
+ *
+ */
+static void __cam_req_mgr_in_q_reset_req_map(
+	struct cam_req_mgr_req_queue *in_q)
+{
+	int32_t i;
+
+	hash_init(in_q->req_map);
+	for (i = 0; i < MAX_REQ_SLOTS; i++)
+		INIT_HLIST_NODE(&in_q->slot[i].req_node);
+}
+
 /**
  * __cam_req_mgr_inject_delay()
  *
@@ -471,7 +512,7 @@ static int __cam_req_mgr_traverse(struct cam_req_mgr_traverse *traverse_data)
 static void __cam_req_mgr_in_q_skip_idx(struct cam_req_mgr_req_queue *in_q,
 	int32_t idx)
 {
-	in_q->slot[idx].req_id = -1;
+	__cam_req_mgr_in_q_set_req_id(in_q, idx, -1);
 	in_q->slot[idx].skip_idx = 1;
 	in_q->slot[idx].status = CRM_SLOT_STATUS_REQ_ADDED;
 	CAM_DBG(CAM_CRM, "SET IDX SKIP on slot= %d", idx);
@@ -552,7 +593,7 @@ static void __cam_req_mgr_flush_req_slot(
 			idx, slot->req_id, slot->status);
 
 		/* Reset input queue slot */
-		slot->req_id = -1;
+		__cam_req_mgr_in_q_set_req_id(in_q, idx, -1);
 		slot->skip_idx = 1;
 		slot->recover = 0;
 		slot->additional_timeout = 0;
@@ -606,7 +647,7 @@ static void __cam_req_mgr_reset_req_slot(struct cam_req_mgr_core_link *link,
 		return;
 
 	/* Reset input queue slot */
-	slot->req_id = -1;
+	__cam_req_mgr_in_q_set_req_id(in_q, idx, -1);
 	slot->skip_idx = 0;
 	slot->recover = 0;
 	slot->additional_timeout = 0;
@@ -1133,22 +1174,30 @@ static int __cam_req_mgr_check_link_is_ready(struct cam_req_mgr_core_link *link,
 static int32_t __cam_req_mgr_find_slot_for_req(
 	struct cam_req_mgr_req_queue *in_q, int64_t req_id)
 {
-	int32_t                   idx, i;
+	int32_t                   idx = -1;
 	struct cam_req_mgr_slot  *slot;
 
-	idx = in_q->rd_idx;
-	for (i = 0; i < in_q->num_slots; i++) {
-		slot = &in_q->slot[idx];
+	if (req_id < 0)
+		return -1;
+
+	/*
+	 * Sync link lookups come in without the owning link's req lock,
+	 * map_lock keeps the walk consistent with set_req_id.
+	 */
+	spin_lock(&in_q->map_lock);
+	hash_for_each_possible(in_q->req_map, slot, req_node, req_id) {
 		if (slot->req_id == req_id) {
-			CAM_DBG(CAM_CRM,
-				"req: %lld found at idx: %d status: %d sync_mode: %d",
-				req_id, idx, slot->status, slot->sync_mode);
+			idx = slot->idx;
 			break;
 		}
-		__cam_req_mgr_dec_idx(&idx, 1, in_q->num_slots);
 	}
-	if (i >= in_q->num_slots)
-		idx = -1;
+	spin_unlock(&in_q->map_lock);
+
+	if (idx >= 0)
+		CAM_DBG(CAM_CRM,
+			"req: %lld found at idx: %d status: %d sync_mode: %d",
+			req_id, idx, in_q->slot[idx].status,
+			in_q->slot[idx].sync_mode);
 
 	return idx;
 }
@@ -1922,6 +1971,8 @@ static int __cam_req_mgr_process_req(struct cam_req_mgr_core_link *link,
 
 		CAM_DBG(CAM_CRM, "Applied req[%lld] on link[%x] success",
 			slot->req_id, link->link_hdl);
+		cam_common_lat_stamp(&link->lat_tracker, slot->req_id,
+			CAM_COMMON_LAT_APPLY);
 		spin_lock_bh(&link->link_state_spin_lock);
 		if (link->state == CAM_CRM_LINK_STATE_ERR) {
 			CAM_WARN(CAM_CRM, "Err recovery done idx %d",
@@ -2094,6 +2145,8 @@ static int  __cam_req_mgr_setup_in_q(struct cam_req_mgr_req_data *req)
 
 	mutex_lock(&req->lock);
 	in_q->num_slots = MAX_REQ_SLOTS;
+	spin_lock(&in_q->map_lock);
+	__cam_req_mgr_in_q_reset_req_map(in_q);
 
 	for (i = 0; i < in_q->num_slots; i++) {
 		in_q->slot[i].idx = i;
@@ -2101,6 +2154,7 @@ static int  __cam_req_mgr_setup_in_q(struct cam_req_mgr_req_data *req)
 		in_q->slot[i].skip_idx = 0;
 		in_q->slot[i].status = CRM_SLOT_STATUS_NO_REQ;
 	}
+	spin_unlock(&in_q->map_lock);
 
 	in_q->wr_idx = 0;
 	in_q->rd_idx = 0;
@@ -2128,8 +2182,11 @@ static int __cam_req_mgr_reset_in_q(struct cam_req_mgr_req_data *req)
 	}
 
 	mutex_lock(&req->lock);
+	spin_lock(&in_q->map_lock);
 	memset(in_q->slot, 0,
 		sizeof(struct cam_req_mgr_slot) * in_q->num_slots);
+	__cam_req_mgr_in_q_reset_req_map(in_q);
+	spin_unlock(&in_q->map_lock);
 	in_q->num_slots = 0;
 
 	in_q->wr_idx = 0;
@@ -2383,6 +2440,7 @@ static struct cam_req_mgr_core_link *__cam_req_mgr_reserve_link(
 {
 	struct cam_req_mgr_core_link *link;
 	struct cam_req_mgr_req_queue *in_q;
+	char name[CAM_COMMON_LAT_NAME_LEN];
 	int i;
 
 	if (!session || !g_crm_core_dev) {
@@ -2412,12 +2470,16 @@ static struct cam_req_mgr_core_link *__cam_req_mgr_reserve_link(
 		CAM_ERR(CAM_CRM, "failed to create input queue, no mem");
 		return NULL;
 	}
+	spin_lock_init(&in_q->map_lock);
 
 	mutex_lock(&link->lock);
 	link->num_devs = 0;
 	link->max_delay = 0;
+	spin_lock(&in_q->map_lock);
 	memset(in_q->slot, 0,
 		sizeof(struct cam_req_mgr_slot) * MAX_REQ_SLOTS);
+	__cam_req_mgr_in_q_reset_req_map(in_q);
+	spin_unlock(&in_q->map_lock);
 	link->req.in_q = in_q;
 	in_q->num_slots = 0;
 	link->state = CAM_CRM_LINK_STATE_IDLE;
@@ -2450,6 +2512,9 @@ static struct cam_req_mgr_core_link *__cam_req_mgr_reserve_link(
 		session->num_links);
 	mutex_unlock(&session->lock);
 
+	snprintf(name, sizeof(name), "crm_link%td", link - g_links);
+	cam_common_lat_register(&link->lat_tracker, name);
+
 	return link;
 error:
 	mutex_unlock(&session->lock);
@@ -2468,6 +2533,8 @@ error:
 static void __cam_req_mgr_free_link(struct cam_req_mgr_core_link *link)
 {
 	ptrdiff_t i;
+
+	cam_common_lat_unregister(&link->lat_tracker);
 	kfree(link->req.in_q);
 	link->req.in_q = NULL;
 	link->parent = NULL;
@@ -2662,7 +2729,7 @@ int cam_req_mgr_process_sched_req(void *priv, void *data)
 		CAM_WARN(CAM_CRM, "in_q overwrite %d", slot->status);
 
 	slot->status = CRM_SLOT_STATUS_REQ_ADDED;
-	slot->req_id = sched_req->req_id;
+	__cam_req_mgr_in_q_set_req_id(in_q, in_q->wr_idx, sched_req->req_id);
 	slot->sync_mode = sched_req->sync_mode;
 	slot->skip_idx = 0;
 	slot->recover = sched_req->bubble_enable;
@@ -2811,6 +2878,8 @@ int cam_req_mgr_process_add_req(void *priv, void *data)
 		slot->req_ready_map);
 
 	trace_cam_req_mgr_add_req(link, idx, add_req, tbl, device);
+	cam_common_lat_stamp(&link->lat_tracker, add_req->req_id,
+		CAM_COMMON_LAT_ADD_REQ);
 
 	if (slot->req_ready_map == tbl->dev_mask) {
 		CAM_DBG(CAM_REQ,
@@ -3815,6 +3884,8 @@ static int __cam_req_mgr_unlink(
 	struct cam_req_mgr_core_link *link)
 {
 	int rc;
+	uint32_t pending_hwm = 0;
+	uint32_t prio_hwm[CRM_TASK_PRIORITY_MAX] = {0};
 
 	spin_lock_bh(&link->link_state_spin_lock);
 	link->state = CAM_CRM_LINK_STATE_IDLE;
@@ -3834,6 +3905,10 @@ static int __cam_req_mgr_unlink(
 	spin_unlock_bh(&link->link_state_spin_lock);
 	/* Release session mutex for workq processing */
 	mutex_unlock(&session->lock);
+	cam_req_mgr_workq_get_hwm(link->workq, &pending_hwm, prio_hwm);
+	CAM_DBG(CAM_CRM, "link %x workq hwm pending %u prio0 %u prio1 %u",
+		link->link_hdl, pending_hwm,
+		prio_hwm[CRM_TASK_PRIORITY_0], prio_hwm[CRM_TASK_PRIORITY_1]);
 	/* Destroy workq of link */
 	cam_req_mgr_workq_destroy(&link->workq);
 	/* Acquire session mutex after workq flush */
@@ -7,12 +7,15 @@
 #define _CAM_REQ_MGR_CORE_H_
 
 #include <linux/spinlock.h>
+#include <linux/hashtable.h>
 #include "cam_req_mgr_interface.h"
 #include "cam_req_mgr_core_defs.h"
 #include "cam_req_mgr_timer.h"
+#include "cam_common_util.h"
 
 #define CAM_REQ_MGR_MAX_LINKED_DEV     16
 #define MAX_REQ_SLOTS                  48
+#define CAM_REQ_MGR_REQ_MAP_BITS       6
 
 #define CAM_REQ_MGR_WATCHDOG_TIMEOUT          1000
 #define CAM_REQ_MGR_WATCHDOG_TIMEOUT_DEFAULT  5000
@@ -268,6 +271,7 @@ struct cam_req_mgr_req_tbl {
  * @sync_mode          : Sync mode in which req id in this slot has to applied
  * @additional_timeout : Adjusted watchdog timeout value associated with
  * this request
+ * @req_node           : node in input queue req_id to slot map
  */
 struct cam_req_mgr_slot {
 	int32_t               idx;
@@ -277,6 +281,7 @@ struct cam_req_mgr_slot {
 	int64_t               req_id;
 	int32_t               sync_mode;
 	int32_t               additional_timeout;
+	struct hlist_node     req_node;
 };
 
 /**
@@ -286,6 +291,9 @@ struct cam_req_mgr_slot {
  * @rd_idx      : indicates slot index currently in process.
  * @wr_idx      : indicates slot index to hold new upcoming req.
  * @last_applied_idx : indicates slot index last applied successfully.
+ * @req_map     : hash of valid req_id to slot, kept in sync with slot req_id
+ * @map_lock    : protects req_map, lookups from a sync link do not hold
+ *                this link's req lock
  */
 struct cam_req_mgr_req_queue {
 	int32_t                     num_slots;
@@ -293,6 +301,8 @@ struct cam_req_mgr_req_queue {
 	int32_t                     rd_idx;
 	int32_t                     wr_idx;
 	int32_t                     last_applied_idx;
+	DECLARE_HASHTABLE(req_map, CAM_REQ_MGR_REQ_MAP_BITS);
+	spinlock_t                  map_lock;
 };
 
 /**
@@ -386,6 +396,7 @@ struct cam_req_mgr_connected_device {
  *                         case of long exposure use case
  * @last_sof_trigger_jiffies : Record the jiffies of last sof trigger jiffies
  * @wq_congestion        : Indicates if WQ congestion is detected or not
+ * @lat_tracker          : Per request add_req to apply latency accounting
  */
 struct cam_req_mgr_core_link {
 	int32_t                              link_hdl;
@@ -423,6 +434,7 @@ struct cam_req_mgr_core_link {
 	bool                                 skip_init_frame;
 	uint64_t                             last_sof_trigger_jiffies;
 	bool                                 wq_congestion;
+	struct cam_common_lat_tracker        lat_tracker;
 };
 
 /**
@@ -3,9 +3,12 @@
  * Copyright (c) 2016-2020, The Linux Foundation. All rights reserved.
  */
 
+#include <linux/vmalloc.h>
 #include "cam_req_mgr_debug.h"
+#include "cam_common_util.h"
 
 #define MAX_SESS_INFO_LINE_BUFF_LEN 256
+#define MAX_LATENCY_HIST_BUFF_LEN   (64 * 1024)
 
 static char sess_info_buffer[MAX_SESS_INFO_LINE_BUFF_LEN];
 static int cam_debug_mgr_delay_detect;
@@ -111,6 +114,39 @@ static const struct file_operations session_info = {
 	.write = session_info_write,
 };
 
+static ssize_t latency_hist_read(struct file *t_file, char *t_char,
+	size_t t_size_t, loff_t *t_loff_t)
+{
+	char *out_buffer;
+	size_t len;
+	ssize_t rc;
+
+	out_buffer = vzalloc(MAX_LATENCY_HIST_BUFF_LEN);
+	if (!out_buffer)
+		return -ENOMEM;
+
+	len = cam_common_lat_dump_all(out_buffer, MAX_LATENCY_HIST_BUFF_LEN);
+	rc = simple_read_from_buffer(t_char, t_size_t, t_loff_t,
+		out_buffer, len);
+	vfree(out_buffer);
+
+	return rc;
+}
+
+static ssize_t latency_hist_write(struct file *t_file,
+	const char *t_char, size_t t_size_t, loff_t *t_loff_t)
+{
+	cam_common_lat_reset_all();
+
+	return t_size_t;
+}
+
+static const struct file_operations latency_hist = {
+	.open = simple_open,
+	.read = latency_hist_read,
+	.write = latency_hist_write,
+};
+
 static struct dentry *debugfs_root;
 int cam_req_mgr_debug_register(struct cam_req_mgr_core_device *core_dev)
 {
@@ -134,6 +170,8 @@ int cam_req_mgr_debug_register(struct cam_req_mgr_core_device *core_dev)
 		debugfs_root, &core_dev->recovery_on_apply_fail);
 	dbgfileptr = debugfs_create_u32("delay_detect_count", 0644,
 		debugfs_root, &cam_debug_mgr_delay_detect);
+	dbgfileptr = debugfs_create_file("latency_hist", 0644,
+		debugfs_root, NULL, &latency_hist);
 	if (IS_ERR(dbgfileptr)) {
 		if (PTR_ERR(dbgfileptr) == -ENODEV)
 			CAM_WARN(CAM_MEM, "DebugFS not enabled in kernel!");
@@ -551,6 +551,61 @@ static long cam_private_ioctl(struct file *file, void *fh,
 			rc = -EINVAL;
 		}
 		break;
+	case CAM_REQ_MGR_CACHE_OPS_RANGE: {
+		struct cam_mem_cache_ops_range_cmd cmd;
+
+		if (k_ioctl->size != sizeof(cmd))
+			return -EINVAL;
+
+		if (copy_from_user(&cmd,
+			u64_to_user_ptr(k_ioctl->handle),
+			sizeof(struct cam_mem_cache_ops_range_cmd))) {
+			rc = -EFAULT;
+			break;
+		}
+
+		rc = cam_mem_mgr_cache_ops_range(&cmd);
+		if (rc)
+			rc = -EINVAL;
+		}
+		break;
+	case CAM_REQ_MGR_CACHE_OPS_VEC: {
+		struct cam_mem_cache_ops_vec_cmd cmd;
+		struct cam_mem_cache_ops_range_cmd *ranges;
+
+		if (k_ioctl->size != sizeof(cmd))
+			return -EINVAL;
+
+		if (copy_from_user(&cmd,
+			u64_to_user_ptr(k_ioctl->handle),
+			sizeof(struct cam_mem_cache_ops_vec_cmd))) {
+			rc = -EFAULT;
+			break;
+		}
+
+		if (!cmd.num_ranges ||
+			cmd.num_ranges > CAM_MEM_MAX_CACHE_OPS_RANGES)
+			return -EINVAL;
+
+		ranges = kcalloc(cmd.num_ranges, sizeof(*ranges), GFP_KERNEL);
+		if (!ranges) {
+			rc = -ENOMEM;
+			break;
+		}
+
+		if (copy_from_user(ranges, u64_to_user_ptr(cmd.ranges),
+			sizeof(*ranges) * cmd.num_ranges)) {
+			kfree(ranges);
+			rc = -EFAULT;
+			break;
+		}
+
+		rc = cam_mem_mgr_cache_ops_vec(ranges, cmd.num_ranges);
+		if (rc)
+			rc = -EINVAL;
+		kfree(ranges);
+		}
+		break;
 	case CAM_REQ_MGR_LINK_CONTROL: {
 		struct cam_req_mgr_link_control cmd;
 
@@ -21,28 +21,138 @@
 		spin_unlock_bh(&(workq)->lock_bh); \
 }
 
+static int cam_req_mgr_workq_ring_init(struct crm_workq_ring *ring,
+	uint32_t num_cells)
+{
+	unsigned long i, size = roundup_pow_of_two(max_t(uint32_t,
+		num_cells, 1));
+
+	ring->cells = kcalloc(size, sizeof(struct crm_workq_ring_cell),
+		GFP_KERNEL);
+	if (!ring->cells)
+		return -ENOMEM;
+
+	for (i = 0; i < size; i++)
+		ring->cells[i].seq = i;
+	ring->mask = size - 1;
+	atomic_long_set(&ring->head, 0);
+	atomic_long_set(&ring->tail, 0);
+
+	return 0;
+}
+
+static void cam_req_mgr_workq_ring_deinit(struct crm_workq_ring *ring)
+{
+	kfree(ring->cells);
+	ring->cells = NULL;
+}
+
+/**
+ * cam_req_mgr_workq_ring_push() - Add a task to the tail of the ring
+ * @ring: ring to push to
+ * @task: task to be added
+ *
+ * Safe against concurrent push and pop from any context, a producer
+ * only contends with other producers on the tail cursor.
+ */
+static int cam_req_mgr_workq_ring_push(struct crm_workq_ring *ring,
+	struct crm_workq_task *task)
+{
+	struct crm_workq_ring_cell *cell;
+	unsigned long pos, seq, prev;
+	long dif;
+
+	pos = atomic_long_read(&ring->tail);
+	for (;;) {
+		cell = &ring->cells[pos & ring->mask];
+		seq = smp_load_acquire(&cell->seq);
+		dif = (long)seq - (long)pos;
+		if (dif == 0) {
+			prev = atomic_long_cmpxchg(&ring->tail, pos, pos + 1);
+			if (prev == pos)
+				break;
+			pos = prev;
+		} else if (dif < 0) {
+			return -ENOSPC;
+		} else {
+			pos = atomic_long_read(&ring->tail);
+		}
+	}
+
+	cell->task = task;
+	smp_store_release(&cell->seq, pos + 1);
+
+	return 0;
+}
+
+/**
+ * cam_req_mgr_workq_ring_pop() - Remove a task from the head of the ring
+ * @ring: ring to pop from
+ *
+ * Returns NULL if ring is empty.
+ */
+static struct crm_workq_task *cam_req_mgr_workq_ring_pop(
+	struct crm_workq_ring *ring)
+{
+	struct crm_workq_ring_cell *cell;
+	struct crm_workq_task *task;
+	unsigned long pos, seq, prev;
+	long dif;
+
+	pos = atomic_long_read(&ring->head);
+	for (;;) {
+		cell = &ring->cells[pos & ring->mask];
+		seq = smp_load_acquire(&cell->seq);
+		dif = (long)seq - (long)(pos + 1);
+		if (dif == 0) {
+			prev = atomic_long_cmpxchg(&ring->head, pos, pos + 1);
+			if (prev == pos)
+				break;
+			pos = prev;
+		} else if (dif < 0) {
+			return NULL;
+		} else {
+			pos = atomic_long_read(&ring->head);
+		}
+	}
+
+	task = cell->task;
+	smp_store_release(&cell->seq, pos + ring->mask + 1);
+
+	return task;
+}
+
+static inline uint32_t cam_req_mgr_workq_ring_depth(
+	struct crm_workq_ring *ring)
+{
+	return (uint32_t)(atomic_long_read(&ring->tail) -
+		atomic_long_read(&ring->head));
+}
+
+static void cam_req_mgr_workq_update_hwm(atomic_t *hwm, int val)
+{
+	int old = atomic_read(hwm);
+
+	while (val > old) {
+		int prev = atomic_cmpxchg(hwm, old, val);
+
+		if (prev == old)
+			break;
+		old = prev;
+	}
+}
+
 struct crm_workq_task *cam_req_mgr_workq_get_task(
 	struct cam_req_mgr_core_workq *workq)
 {
 	struct crm_workq_task *task = NULL;
-	unsigned long flags = 0;
 
 	if (!workq)
 		return NULL;
 
-	WORKQ_ACQUIRE_LOCK(workq, flags);
-	if (list_empty(&workq->task.empty_head))
-		goto end;
-
-	task = list_first_entry(&workq->task.empty_head,
-		struct crm_workq_task, entry);
-	if (task) {
+	task = cam_req_mgr_workq_ring_pop(&workq->task.empty_q);
+	if (task)
 		atomic_sub(1, &workq->task.free_cnt);
-		list_del_init(&task->entry);
-	}
-
-end:
-	WORKQ_RELEASE_LOCK(workq, flags);
 
 	return task;
 }
@@ -51,17 +161,31 @@ static void cam_req_mgr_workq_put_task(struct crm_workq_task *task)
 {
 	struct cam_req_mgr_core_workq *workq =
 		(struct cam_req_mgr_core_workq *)task->parent;
-	unsigned long flags = 0;
 
-	list_del_init(&task->entry);
 	task->cancel = 0;
 	task->process_cb = NULL;
 	task->priv = NULL;
-	WORKQ_ACQUIRE_LOCK(workq, flags);
-	list_add_tail(&task->entry,
-		&workq->task.empty_head);
+	if (cam_req_mgr_workq_ring_push(&workq->task.empty_q, task)) {
+		CAM_ERR(CAM_CRM, "free task ring full, task %pK leaked", task);
+		return;
+	}
 	atomic_add(1, &workq->task.free_cnt);
-	WORKQ_RELEASE_LOCK(workq, flags);
+}
+
+void cam_req_mgr_workq_get_hwm(struct cam_req_mgr_core_workq *workq,
+	uint32_t *pending_hwm, uint32_t *prio_hwm)
+{
+	int i;
+
+	if (!workq)
+		return;
+
+	if (pending_hwm)
+		*pending_hwm = atomic_read(&workq->task.pending_hwm);
+
+	if (prio_hwm)
+		for (i = CRM_TASK_PRIORITY_0; i < CRM_TASK_PRIORITY_MAX; i++)
+			prio_hwm[i] = atomic_read(&workq->task.prio_hwm[i]);
 }
 
 /**
@@ -94,7 +218,6 @@ void cam_req_mgr_process_workq(struct work_struct *w)
 	struct cam_req_mgr_core_workq *workq = NULL;
 	struct crm_workq_task         *task;
 	int32_t                        i = CRM_TASK_PRIORITY_0;
-	unsigned long                  flags = 0;
 	ktime_t                        curr_time;
 
 	if (!w) {
@@ -110,19 +233,13 @@ void cam_req_mgr_process_workq(struct work_struct *w)
 		CAM_WORKQ_SCHEDULE_TIME_THRESHOLD);
 	curr_time = ktime_get();
 	while (i < CRM_TASK_PRIORITY_MAX) {
-		WORKQ_ACQUIRE_LOCK(workq, flags);
-		while (!list_empty(&workq->task.process_head[i])) {
-			task = list_first_entry(&workq->task.process_head[i],
-				struct crm_workq_task, entry);
+		while ((task = cam_req_mgr_workq_ring_pop(
+			&workq->task.process_q[i])) != NULL) {
 			atomic_sub(1, &workq->task.pending_cnt);
-			list_del_init(&task->entry);
-			WORKQ_RELEASE_LOCK(workq, flags);
 			cam_req_mgr_process_task(task);
 			CAM_DBG(CAM_CRM, "processed task %pK free_cnt %d",
 				task, atomic_read(&workq->task.free_cnt));
-			WORKQ_ACQUIRE_LOCK(workq, flags);
 		}
-		WORKQ_RELEASE_LOCK(workq, flags);
 		i++;
 	}
 	cam_common_util_thread_switch_delay_detect(
@@ -134,9 +251,9 @@ void cam_req_mgr_process_workq(struct work_struct *w)
 int cam_req_mgr_workq_enqueue_task(struct crm_workq_task *task,
 	void *priv, int32_t prio)
 {
-	int rc = 0;
+	int rc = 0, pending_cnt;
 	struct cam_req_mgr_core_workq *workq = NULL;
-	unsigned long flags = 0;
+	struct workqueue_struct       *job;
 
 	if (!task) {
 		CAM_WARN(CAM_CRM, "NULL task pointer can not schedule");
@@ -161,23 +278,34 @@ int cam_req_mgr_workq_enqueue_task(struct crm_workq_task *task,
 		(prio < CRM_TASK_PRIORITY_MAX && prio >= CRM_TASK_PRIORITY_0)
 		? prio : CRM_TASK_PRIORITY_0;
 
-	WORKQ_ACQUIRE_LOCK(workq, flags);
-		if (!workq->job) {
-			rc = -EINVAL;
-			WORKQ_RELEASE_LOCK(workq, flags);
-			goto end;
-		}
+	rcu_read_lock();
+	job = rcu_dereference(workq->job);
+	if (!job) {
+		rcu_read_unlock();
+		rc = -EINVAL;
+		goto end;
+	}
 
-	list_add_tail(&task->entry,
-		&workq->task.process_head[task->priority]);
+	if (cam_req_mgr_workq_ring_push(
+		&workq->task.process_q[task->priority], task)) {
+		rcu_read_unlock();
+		CAM_ERR(CAM_CRM, "task ring full prio %d", task->priority);
+		cam_req_mgr_workq_put_task(task);
+		rc = -EBUSY;
+		goto end;
+	}
 
-	atomic_add(1, &workq->task.pending_cnt);
+	pending_cnt = atomic_add_return(1, &workq->task.pending_cnt);
+	cam_req_mgr_workq_update_hwm(&workq->task.pending_hwm, pending_cnt);
+	cam_req_mgr_workq_update_hwm(&workq->task.prio_hwm[task->priority],
+		cam_req_mgr_workq_ring_depth(
+		&workq->task.process_q[task->priority]));
 	CAM_DBG(CAM_CRM, "enq task %pK pending_cnt %d",
-		task, atomic_read(&workq->task.pending_cnt));
+		task, pending_cnt);
 
-	queue_work(workq->job, &workq->work);
 	workq->workq_scheduled_ts = ktime_get();
-	WORKQ_RELEASE_LOCK(workq, flags);
+	queue_work(job, &workq->work);
+	rcu_read_unlock();
 end:
 	return rc;
 }
@@ -187,8 +315,10 @@ int cam_req_mgr_workq_create(char *name, int32_t num_tasks,
 	int flags, void (*func)(struct work_struct *w))
 {
 	int32_t i, wq_flags = 0, max_active_tasks = 0;
+	int rc = 0;
 	struct crm_workq_task  *task;
 	struct cam_req_mgr_core_workq *crm_workq = NULL;
+	struct workqueue_struct *job;
 	char buf[128] = "crm_workq-";
 
 	if (!*workq) {
@@ -206,12 +336,12 @@ int cam_req_mgr_workq_create(char *name, int32_t num_tasks,
 
 		strlcat(buf, name, sizeof(buf));
 		CAM_DBG(CAM_CRM, "create workque crm_workq-%s", name);
-		crm_workq->job = alloc_workqueue(buf,
-			wq_flags, max_active_tasks, NULL);
-		if (!crm_workq->job) {
+		job = alloc_workqueue(buf, wq_flags, max_active_tasks, NULL);
+		if (!job) {
 			kfree(crm_workq);
 			return -ENOMEM;
 		}
+		RCU_INIT_POINTER(crm_workq->job, job);
 
 		/* Workq attributes initialization */
 		INIT_WORK(&crm_workq->work, func);
@@ -222,26 +352,41 @@ int cam_req_mgr_workq_create(char *name, int32_t num_tasks,
 		/* Task attributes initialization */
 		atomic_set(&crm_workq->task.pending_cnt, 0);
 		atomic_set(&crm_workq->task.free_cnt, 0);
-		for (i = CRM_TASK_PRIORITY_0; i < CRM_TASK_PRIORITY_MAX; i++)
-			INIT_LIST_HEAD(&crm_workq->task.process_head[i]);
-		INIT_LIST_HEAD(&crm_workq->task.empty_head);
+		atomic_set(&crm_workq->task.pending_hwm, 0);
 		crm_workq->in_irq = in_irq;
 		crm_workq->task.num_task = num_tasks;
+
+		/*
+		 * Every ring is sized for the whole pool so a push can only
+		 * fail on corruption, never because of load.
+		 */
+		rc = cam_req_mgr_workq_ring_init(&crm_workq->task.empty_q,
+			num_tasks);
+		for (i = CRM_TASK_PRIORITY_0; !rc &&
+			i < CRM_TASK_PRIORITY_MAX; i++) {
+			atomic_set(&crm_workq->task.prio_hwm[i], 0);
+			rc = cam_req_mgr_workq_ring_init(
+				&crm_workq->task.process_q[i], num_tasks);
+		}
+		if (rc) {
+			CAM_WARN(CAM_CRM, "Insufficient memory for task rings");
+			goto free_rings;
+		}
+
 		crm_workq->task.pool = kcalloc(crm_workq->task.num_task,
 				sizeof(struct crm_workq_task), GFP_KERNEL);
 		if (!crm_workq->task.pool) {
 			CAM_WARN(CAM_CRM, "Insufficient memory %zu",
 				sizeof(struct crm_workq_task) *
 				crm_workq->task.num_task);
-			kfree(crm_workq);
-			return -ENOMEM;
+			rc = -ENOMEM;
+			goto free_rings;
 		}
 
 		for (i = 0; i < crm_workq->task.num_task; i++) {
 			task = &crm_workq->task.pool[i];
 			task->parent = (void *)crm_workq;
 			/* Put all tasks in free pool */
-			INIT_LIST_HEAD(&task->entry);
 			cam_req_mgr_workq_put_task(task);
 		}
 		*workq = crm_workq;
@@ -250,25 +395,50 @@ int cam_req_mgr_workq_create(char *name, int32_t num_tasks,
 	}
 
 	return 0;
+
+free_rings:
+	cam_req_mgr_workq_ring_deinit(&crm_workq->task.empty_q);
+	for (i = CRM_TASK_PRIORITY_0; i < CRM_TASK_PRIORITY_MAX; i++)
+		cam_req_mgr_workq_ring_deinit(&crm_workq->task.process_q[i]);
+	destroy_workqueue(job);
+	kfree(crm_workq);
+	return rc;
 }
 
 void cam_req_mgr_workq_destroy(struct cam_req_mgr_core_workq **crm_workq)
 {
 	unsigned long flags = 0;
 	struct workqueue_struct   *job;
+	int i;
 
 	CAM_DBG(CAM_CRM, "destroy workque %pK", crm_workq);
 	if (*crm_workq) {
 		WORKQ_ACQUIRE_LOCK(*crm_workq, flags);
-		if ((*crm_workq)->job) {
-			job = (*crm_workq)->job;
-			(*crm_workq)->job = NULL;
+		job = rcu_dereference_protected((*crm_workq)->job,
+			lockdep_is_held(&(*crm_workq)->lock_bh));
+		if (job) {
+			RCU_INIT_POINTER((*crm_workq)->job, NULL);
 			WORKQ_RELEASE_LOCK(*crm_workq, flags);
+			/* Let in flight lock free enqueues finish queue_work */
+			synchronize_rcu();
 			destroy_workqueue(job);
 		} else {
 			WORKQ_RELEASE_LOCK(*crm_workq, flags);
 		}
 
+		CAM_DBG(CAM_CRM, "workq %pK pending hwm %d prio hwm %d %d",
+			*crm_workq,
+			atomic_read(&(*crm_workq)->task.pending_hwm),
+			atomic_read(&(*crm_workq)->task.prio_hwm[
+			CRM_TASK_PRIORITY_0]),
+			atomic_read(&(*crm_workq)->task.prio_hwm[
+			CRM_TASK_PRIORITY_1]));
+
+		cam_req_mgr_workq_ring_deinit(&(*crm_workq)->task.empty_q);
+		for (i = CRM_TASK_PRIORITY_0; i < CRM_TASK_PRIORITY_MAX; i++)
+			cam_req_mgr_workq_ring_deinit(
+				&(*crm_workq)->task.process_q[i]);
+
 		/* Destroy workq payload data */
 		kfree((*crm_workq)->task.pool[0].payload);
 		(*crm_workq)->task.pool[0].payload = NULL;
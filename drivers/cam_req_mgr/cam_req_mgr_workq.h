@@ -13,6 +13,10 @@
 #include <linux/workqueue.h>
 #include <linux/slab.h>
 #include <linux/timer.h>
+#include <linux/atomic.h>
+#include <linux/cache.h>
+#include <linux/log2.h>
+#include <linux/rcupdate.h>
 
 #include "cam_req_mgr_core.h"
 
@@ -52,7 +56,6 @@ enum crm_workq_context {
  * @process_cb : registered callback called by workq when task enqueued is
  *               ready for processing in workq thread context
  * @parent     : workq's parent is link which is enqqueing taks to this workq
- * @entry      : list head of this list entry is worker's empty_head
  * @cancel     : if caller has got free task from pool but wants to abort
  *               or put back without using it
  * @priv       : when task is enqueuer caller can attach priv along which
@@ -64,31 +67,59 @@ struct crm_workq_task {
 	void                      *payload;
 	int32_t                  (*process_cb)(void *priv, void *data);
 	void                      *parent;
-	struct list_head           entry;
 	uint8_t                    cancel;
 	void                      *priv;
 	int32_t                    ret;
 };
 
+/** struct crm_workq_ring_cell
+ * @seq        : sequence number telling producers/consumers whose turn
+ *               it is to use this cell
+ * @task       : task stored in this cell
+ */
+struct crm_workq_ring_cell {
+	unsigned long              seq;
+	struct crm_workq_task     *task;
+};
+
+/** struct crm_workq_ring
+ * @brief      : bounded lock free multi producer ring of task pointers.
+ *               Producer and consumer cursors live on separate cache lines
+ *               so irq context producers do not bounce the consumer line.
+ * @tail       : next position to be claimed by a producer
+ * @head       : next position to be claimed by a consumer
+ * @cells      : ring storage, size is a power of two
+ * @mask       : size of cells - 1
+ */
+struct crm_workq_ring {
+	atomic_long_t              tail ____cacheline_aligned_in_smp;
+	atomic_long_t              head ____cacheline_aligned_in_smp;
+	struct crm_workq_ring_cell *cells ____cacheline_aligned_in_smp;
+	unsigned long              mask;
+};
+
 /** struct cam_req_mgr_core_workq
  * @work        : work token used by workqueue
- * @job         : workqueue internal job struct
- * @lock_bh     : lock for task structs
+ * @job         : workqueue internal job struct, RCU protected against
+ *                concurrent enqueue while workq is being destroyed
+ * @lock_bh     : lock serializing workq destroy
  * @in_irq      : set true if workque can be used in irq context
  * @workq_scheduled_ts: enqueue time of workq
  * task -
  * @lock        : Current task's lock handle
  * @pending_cnt : # of tasks left in queue
  * @free_cnt    : # of free/available tasks
- * @process_head:
- * @empty_head  : list  head of available taska which can be used
+ * @pending_hwm : high water mark of pending_cnt
+ * @prio_hwm    : high water mark of queue depth per priority
+ * @process_q   : lock free queue of enqueued tasks per priority
+ * @empty_q     : lock free queue of available tasks which can be used
  *                or acquired in order to enqueue a task to workq
  * @pool        : pool of tasks used for handling events in workq context
  * @num_task    : size of tasks pool
  */
 struct cam_req_mgr_core_workq {
 	struct work_struct         work;
-	struct workqueue_struct   *job;
+	struct workqueue_struct __rcu *job;
 	spinlock_t                 lock_bh;
 	uint32_t                   in_irq;
 	ktime_t                    workq_scheduled_ts;
@@ -98,9 +129,11 @@ struct cam_req_mgr_core_workq {
 		struct mutex           lock;
 		atomic_t               pending_cnt;
 		atomic_t               free_cnt;
+		atomic_t               pending_hwm;
+		atomic_t               prio_hwm[CRM_TASK_PRIORITY_MAX];
 
-		struct list_head       process_head[CRM_TASK_PRIORITY_MAX];
-		struct list_head       empty_head;
+		struct crm_workq_ring  process_q[CRM_TASK_PRIORITY_MAX];
+		struct crm_workq_ring  empty_q;
 		struct crm_workq_task *pool;
 		uint32_t               num_task;
 	} task;
@@ -158,4 +191,14 @@ int cam_req_mgr_workq_enqueue_task(struct crm_workq_task *task,
 struct crm_workq_task *cam_req_mgr_workq_get_task(
 	struct cam_req_mgr_core_workq *workq);
 
+/**
+ * cam_req_mgr_workq_get_hwm()
+ * @brief: Returns queue depth high water marks of the workq
+ * @workq: workque to query
+ * @pending_hwm: max number of tasks pending across all priorities
+ * @prio_hwm: max queue depth per priority, array of CRM_TASK_PRIORITY_MAX
+ */
+void cam_req_mgr_workq_get_hwm(struct cam_req_mgr_core_workq *workq,
+	uint32_t *pending_hwm, uint32_t *prio_hwm);
+
 #endif
@@ -9,6 +9,10 @@
 #include "cam_req_mgr_workq.h"
 #include "cam_common_util.h"
 
+/* Reuse prebuilt CCI queue words for repeated write reg table layouts */
+static bool cci_q_word_cache = true;
+module_param(cci_q_word_cache, bool, 0644);
+
 static int32_t cam_cci_convert_type_to_num_bytes(
 	enum camera_sensor_i2c_type type)
 {
@@ -698,6 +702,278 @@ static int32_t cam_cci_set_clk_param(struct cci_device *cci_dev,
 	return 0;
 }
 
+static bool cam_cci_q_word_cache_hit(struct cci_device *cci_dev,
+	struct cam_cci_q_word_cache *cache,
+	struct cam_sensor_i2c_reg_setting *i2c_msg)
+{
+	uint32_t i;
+
+	if (!cache->valid ||
+		cache->num_regs != i2c_msg->size ||
+		cache->addr_type != i2c_msg->addr_type ||
+		cache->data_type != i2c_msg->data_type ||
+		cache->cycles_per_us != cci_dev->cycles_per_us ||
+		cache->payload_size != cci_dev->payload_size)
+		return false;
+
+	for (i = 0; i < cache->num_regs; i++) {
+		if (cache->reg_addr[i] != i2c_msg->reg_setting[i].reg_addr ||
+			cache->delay[i] != i2c_msg->reg_setting[i].delay)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Encode the reg table into queue words exactly as the packing loop in
+ * cam_cci_data_queue() does for the non sequential write commands. Data
+ * bytes are left zero and filled in by cam_cci_q_word_cache_patch().
+ */
+static int32_t cam_cci_q_word_cache_build(struct cci_device *cci_dev,
+	struct cam_cci_ctrl *c_ctrl, struct cam_cci_q_word_cache *cache)
+{
+	struct cam_sensor_i2c_reg_setting *i2c_msg =
+		&c_ctrl->cfg.cci_i2c_write_cfg;
+	struct cam_sensor_i2c_reg_array *i2c_cmd = i2c_msg->reg_setting;
+	struct cam_cci_q_word_pkt *pkt;
+	uint32_t cmd_size = i2c_msg->size;
+	uint32_t pack = 0, delay, cmd;
+	uint16_t i, j, k, h, num_words;
+	uint16_t reg_idx = 0, word_idx = 0, num_pkts = 0;
+	int32_t len, data_len;
+	uint8_t data[16];
+
+	cache->valid = false;
+
+	data_len = cam_cci_convert_type_to_num_bytes(i2c_msg->data_type);
+	if (!data_len)
+		return -EINVAL;
+
+	while (cmd_size) {
+		len = cam_cci_calc_cmd_len(cci_dev, c_ctrl, cmd_size,
+			i2c_cmd, &pack);
+		if (len <= 0)
+			return -EINVAL;
+
+		memset(data, 0, sizeof(data));
+		delay = i2c_cmd->delay;
+		i = 0;
+		data[i++] = CCI_I2C_WRITE_CMD;
+
+		if (i2c_msg->addr_type == CAMERA_SENSOR_I2C_TYPE_BYTE) {
+			data[i++] = i2c_cmd->reg_addr;
+		} else {
+			data[i++] = (i2c_cmd->reg_addr & 0xFF00) >> 8;
+			data[i++] = i2c_cmd->reg_addr & 0x00FF;
+		}
+
+		do {
+			if ((i2c_msg->data_type !=
+				CAMERA_SENSOR_I2C_TYPE_BYTE) &&
+				((i + 1) > cci_dev->payload_size))
+				break;
+
+			cache->reg_addr[reg_idx] = i2c_cmd->reg_addr;
+			cache->delay[reg_idx] = i2c_cmd->delay;
+			cache->data_pos[reg_idx] = (word_idx * 4) + i;
+			reg_idx++;
+			i += data_len;
+			i2c_cmd++;
+			--cmd_size;
+		} while (pack-- && (cmd_size > 0) &&
+			(i <= cci_dev->payload_size));
+
+		data[0] |= ((i - 1) << 4);
+		num_words = ((i - 1) / 4) + 1;
+
+		for (h = 0, k = 0; h < num_words; h++) {
+			cmd = 0;
+			for (j = 0; (j < 4 && k < i); j++)
+				cmd |= (data[k++] << (j * 8));
+			cache->words[word_idx + h] = cmd;
+		}
+
+		if ((delay > 0) && (delay < CCI_MAX_DELAY)) {
+			cmd = (uint32_t)((delay * cci_dev->cycles_per_us) /
+				0x100);
+			cmd <<= 4;
+			cmd |= CCI_I2C_WAIT_CMD;
+			cache->words[word_idx + num_words++] = cmd;
+		}
+
+		pkt = &cache->pkt[num_pkts++];
+		pkt->word_idx = word_idx;
+		pkt->num_words = num_words;
+		pkt->check_len = len;
+		word_idx += num_words;
+	}
+
+	cache->addr_type = i2c_msg->addr_type;
+	cache->data_type = i2c_msg->data_type;
+	cache->cycles_per_us = cci_dev->cycles_per_us;
+	cache->payload_size = cci_dev->payload_size;
+	cache->num_regs = reg_idx;
+	cache->num_pkts = num_pkts;
+	cache->num_words = word_idx;
+	cache->valid = true;
+
+	return 0;
+}
+
+static void cam_cci_q_word_cache_patch(struct cam_cci_q_word_cache *cache,
+	struct cam_sensor_i2c_reg_array *i2c_cmd)
+{
+	uint32_t i, pos, shift;
+	int32_t b, data_len;
+
+	data_len = cam_cci_convert_type_to_num_bytes(cache->data_type);
+
+	for (i = 0; i < cache->num_regs; i++, i2c_cmd++) {
+		pos = cache->data_pos[i];
+		/* data goes out MSB first, queue words are little endian */
+		for (b = data_len - 1; b >= 0; b--, pos++) {
+			shift = (pos % 4) * 8;
+			cache->words[pos / 4] &= ~(0xFFU << shift);
+			cache->words[pos / 4] |=
+				((i2c_cmd->reg_data >> (b * 8)) & 0xFF) <<
+				shift;
+		}
+	}
+}
+
+/**
+ * cam_cci_q_word_cache_prepare()
+ *
+ * @brief:      Returns the queue words for a write reg table, re-encoding
+ *              them only if the table layout changed since the last
+ *              write on this queue. Returns NULL if the table has to go
+ *              through the regular packing loop.
+ *
+ * @cci_dev:    CCI device structure
+ * @c_ctrl:     CCI control structure
+ * @queue:      Queue the table is written to, its mutex_q must be held
+ */
+static struct cam_cci_q_word_cache *cam_cci_q_word_cache_prepare(
+	struct cci_device *cci_dev, struct cam_cci_ctrl *c_ctrl,
+	enum cci_i2c_queue_t queue)
+{
+	struct cam_sensor_i2c_reg_setting *i2c_msg =
+		&c_ctrl->cfg.cci_i2c_write_cfg;
+	enum cci_i2c_master_t master = c_ctrl->cci_info->cci_i2c_master;
+	struct cam_cci_master_info *cci_master =
+		&cci_dev->cci_master_info[master];
+	struct cam_cci_q_word_cache *cache;
+	int32_t rc;
+
+	if (!cci_q_word_cache)
+		return NULL;
+
+	switch (c_ctrl->cmd) {
+	case MSM_CCI_I2C_WRITE:
+	case MSM_CCI_I2C_WRITE_ASYNC:
+	case MSM_CCI_I2C_WRITE_SYNC:
+	case MSM_CCI_I2C_WRITE_SYNC_BLOCK:
+		break;
+	default:
+		return NULL;
+	}
+
+	if (i2c_msg->size > CCI_Q_WORD_CACHE_MAX_REGS)
+		return NULL;
+
+	cache = cci_master->q_word_cache[queue];
+	if (!cache) {
+		cache = kzalloc(sizeof(*cache), GFP_KERNEL);
+		if (!cache)
+			return NULL;
+		cci_master->q_word_cache[queue] = cache;
+	}
+
+	if (!cam_cci_q_word_cache_hit(cci_dev, cache, i2c_msg)) {
+		rc = cam_cci_q_word_cache_build(cci_dev, c_ctrl, cache);
+		if (rc) {
+			CAM_DBG(CAM_CCI, "Queue word build failed rc: %d", rc);
+			return NULL;
+		}
+		CAM_DBG(CAM_CCI,
+			"Master: %d, queue: %d, built regs: %u pkts: %u words: %u",
+			master, queue, cache->num_regs, cache->num_pkts,
+			cache->num_words);
+	}
+
+	cam_cci_q_word_cache_patch(cache, i2c_msg->reg_setting);
+
+	return cache;
+}
+
+/*
+ * Load prebuilt packets with relaxed writes and expose each one to the
+ * hardware with a single EXEC_WORD_CNT update. Queue space handling is
+ * the same as in the regular packing loop.
+ */
+static int32_t cam_cci_q_word_cache_load(struct cci_device *cci_dev,
+	struct cam_cci_q_word_cache *cache, enum cci_i2c_master_t master,
+	enum cci_i2c_queue_t queue, uint32_t queue_size)
+{
+	struct cam_cci_q_word_pkt *pkt;
+	uint32_t reg_offset = master * 0x200 + queue * 0x100;
+	uint32_t max_queue_size =
+		cci_dev->cci_i2c_queue_info[master][queue].max_queue_size;
+	void __iomem *base = cci_dev->soc_info.reg_map[0].mem_base;
+	uint32_t read_val, p = 0, w;
+	int32_t rc;
+
+	while (p < cache->num_pkts) {
+		pkt = &cache->pkt[p];
+
+		read_val = cam_io_r_mb(base +
+			CCI_I2C_M0_Q0_CUR_WORD_CNT_ADDR + reg_offset);
+		/* + 1 - space alocation for Report CMD */
+		if ((read_val + pkt->check_len + 1) > queue_size) {
+			if ((read_val + pkt->check_len + 1) > max_queue_size) {
+				rc = cam_cci_process_full_q(cci_dev,
+					master, queue);
+				if (rc < 0) {
+					CAM_ERR(CAM_CCI,
+						"Failed to process full queue rc: %d",
+						rc);
+					return rc;
+				}
+				continue;
+			}
+			cam_cci_process_half_q(cci_dev, master, queue);
+		}
+
+		read_val = cam_io_r_mb(base +
+			CCI_I2C_M0_Q0_CUR_WORD_CNT_ADDR + reg_offset);
+		for (w = 0; w < pkt->num_words; w++)
+			cam_io_w(cache->words[pkt->word_idx + w], base +
+				CCI_I2C_M0_Q0_LOAD_DATA_ADDR + reg_offset);
+
+		cam_io_w_mb(read_val + pkt->num_words, base +
+			CCI_I2C_M0_Q0_EXEC_WORD_CNT_ADDR + reg_offset);
+		p++;
+	}
+
+	return 0;
+}
+
+void cam_cci_free_q_word_cache(struct cci_device *cci_dev,
+	enum cci_i2c_master_t master)
+{
+	struct cam_cci_master_info *cci_master =
+		&cci_dev->cci_master_info[master];
+	uint32_t queue;
+
+	for (queue = 0; queue < NUM_QUEUES; queue++) {
+		mutex_lock(&cci_master->mutex_q[queue]);
+		kfree(cci_master->q_word_cache[queue]);
+		cci_master->q_word_cache[queue] = NULL;
+		mutex_unlock(&cci_master->mutex_q[queue]);
+	}
+}
+
 static int32_t cam_cci_data_queue(struct cci_device *cci_dev,
 	struct cam_cci_ctrl *c_ctrl, enum cci_i2c_queue_t queue,
 	enum cci_i2c_sync sync_en)
@@ -715,6 +991,7 @@ static int32_t cam_cci_data_queue(struct cci_device *cci_dev,
 	struct cam_hw_soc_info *soc_info =
 		&cci_dev->soc_info;
 	void __iomem *base = soc_info->reg_map[0].mem_base;
+	struct cam_cci_q_word_cache *q_word_cache;
 	unsigned long flags;
 
 	if (i2c_cmd == NULL) {
@@ -790,6 +1067,15 @@ static int32_t cam_cci_data_queue(struct cci_device *cci_dev,
 		return rc;
 	}
 
+	q_word_cache = cam_cci_q_word_cache_prepare(cci_dev, c_ctrl, queue);
+	if (q_word_cache) {
+		rc = cam_cci_q_word_cache_load(cci_dev, q_word_cache,
+			master, queue, queue_size);
+		if (rc < 0)
+			return rc;
+		cmd_size = 0;
+	}
+
 	while (cmd_size) {
 		uint32_t pack = 0;
 
@@ -28,6 +28,15 @@ void cam_cci_get_clk_rates(struct cci_device *cci_dev,
 int32_t cam_cci_core_cfg(struct v4l2_subdev *sd,
 	struct cam_cci_ctrl *cci_ctrl);
 
+/**
+ * @cci_dev: CCI device structure
+ * @master: CCI master index
+ *
+ * This API frees the prebuilt queue word caches of a CCI master
+ */
+void cam_cci_free_q_word_cache(struct cci_device *cci_dev,
+	enum cci_i2c_master_t master);
+
 /**
  * @irq_num: IRQ number
  * @data: CCI private structure
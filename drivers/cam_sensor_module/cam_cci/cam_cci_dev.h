@@ -54,6 +54,11 @@
 #define CCI_I2C_MAX_WRITE 20480
 #define CCI_I2C_MAX_BYTE_COUNT 65535
 
+/* Largest reg table whose queue words are prebuilt and cached */
+#define CCI_Q_WORD_CACHE_MAX_REGS 256
+/* Worst case: one 2 word write packet plus one wait word per register */
+#define CCI_Q_WORD_CACHE_MAX_WORDS (CCI_Q_WORD_CACHE_MAX_REGS * 3)
+
 #define CAMX_CCI_DEV_NAME "cam-cci-driver"
 
 #define MAX_CCI 2
@@ -120,6 +125,51 @@ struct cam_cci_i2c_queue_info {
 	uint32_t capture_rep_data;
 };
 
+/**
+ * struct cam_cci_q_word_pkt
+ * @word_idx:     Index of the first queue word of this packet
+ * @num_words:    Number of queue words including the optional wait word
+ * @check_len:    Queue space needed by the packet, as computed by
+ *                cam_cci_calc_cmd_len()
+ */
+struct cam_cci_q_word_pkt {
+	uint16_t word_idx;
+	uint8_t num_words;
+	uint8_t check_len;
+};
+
+/**
+ * struct cam_cci_q_word_cache
+ * @valid:          Set once the cached words match the key below
+ * @addr_type:      Address type the words were built for
+ * @data_type:      Data type the words were built for
+ * @cycles_per_us:  CCI clock the wait words were built for
+ * @payload_size:   CCI packet payload size the words were built for
+ * @num_regs:       Number of registers in the cached reg table
+ * @num_pkts:       Number of write packets
+ * @num_words:      Number of queue words
+ * @reg_addr:       Register addresses of the cached reg table
+ * @delay:          Per register delays of the cached reg table
+ * @data_pos:       Byte offset of each register's data within @words
+ * @pkt:            Packet layout
+ * @words:          Prebuilt queue words, register data patched per apply
+ */
+struct cam_cci_q_word_cache {
+	bool valid;
+	enum camera_sensor_i2c_type addr_type;
+	enum camera_sensor_i2c_type data_type;
+	uint32_t cycles_per_us;
+	uint8_t payload_size;
+	uint16_t num_regs;
+	uint16_t num_pkts;
+	uint16_t num_words;
+	uint32_t reg_addr[CCI_Q_WORD_CACHE_MAX_REGS];
+	uint32_t delay[CCI_Q_WORD_CACHE_MAX_REGS];
+	uint16_t data_pos[CCI_Q_WORD_CACHE_MAX_REGS];
+	struct cam_cci_q_word_pkt pkt[CCI_Q_WORD_CACHE_MAX_REGS];
+	uint32_t words[CCI_Q_WORD_CACHE_MAX_WORDS];
+};
+
 struct cam_cci_master_info {
 	int32_t status;
 	atomic_t q_free[NUM_QUEUES];
@@ -137,6 +187,7 @@ struct cam_cci_master_info {
 	spinlock_t freq_cnt_lock;
 	uint16_t freq_ref_cnt;
 	bool is_initilized;
+	struct cam_cci_q_word_cache *q_word_cache[NUM_QUEUES];
 };
 
 struct cam_cci_clk_params_t {
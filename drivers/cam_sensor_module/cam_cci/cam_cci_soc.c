@@ -426,6 +426,7 @@ int cam_cci_soc_release(struct cci_device *cci_dev,
 	for (i = 0; i < MASTER_MAX; i++) {
 		if (cci_dev->write_wq[i])
 			flush_workqueue(cci_dev->write_wq[i]);
+		cam_cci_free_q_word_cache(cci_dev, i);
 		cci_dev->i2c_freq_mode[i] = I2C_MAX_MODES;
 	}
 
@@ -20,6 +20,28 @@
 
 #define I2C_REG_DATA_MAX (20*1024)
 
+#define CAM_QUP_I2C_XFER_BUF_SIZE 4096
+#define CAM_QUP_I2C_XFER_MAX_MSGS 32
+
+/**
+ * struct cam_qup_i2c_xfer - QUP I2C batched write context
+ *
+ * @buf      : DMA safe buffer holding the messages of one transfer
+ * @buf_used : Bytes of buf used by the queued messages
+ * @msgs     : Messages queued for the next i2c_transfer
+ * @num_msgs : Number of queued messages
+ * @num_xfers: i2c_transfer calls issued for the current table
+ * @num_sent : Messages sent for the current table
+ */
+struct cam_qup_i2c_xfer {
+	uint8_t        *buf;
+	uint32_t        buf_used;
+	struct i2c_msg  msgs[CAM_QUP_I2C_XFER_MAX_MSGS];
+	uint32_t        num_msgs;
+	uint32_t        num_xfers;
+	uint32_t        num_sent;
+};
+
 /**
  * @client: CCI client structure
  * @data: I2C data
@@ -146,6 +168,24 @@ int32_t cam_qup_i2c_poll(struct i2c_client *client,
 	enum camera_sensor_i2c_type data_type,
 	uint32_t delay_ms);
 
+/**
+ * cam_qup_i2c_init : Allocate QUP I2C batched write context
+ * @client : QUP I2C client structure
+ *
+ * This API allocates the DMA buffer reused by cam_qup_i2c_write_table,
+ * only for clients with "i2c-batch-write" in DT or when batching is forced
+ * through the qup_i2c_batch_write module parameter
+ */
+int32_t cam_qup_i2c_init(struct camera_io_master *client);
+
+/**
+ * cam_qup_i2c_release : Free QUP I2C batched write context
+ * @client : QUP I2C client structure
+ *
+ * This API frees the context allocated by cam_qup_i2c_init
+ */
+int32_t cam_qup_i2c_release(struct camera_io_master *client);
+
 /**
  * cam_qup_i2c_write_table : QUP based I2C write random
  * @client        : QUP I2C client structure
@@ -190,8 +190,9 @@ int32_t camera_io_init(struct camera_io_master *io_master_info)
 		cam_cci_get_subdev(io_master_info->cci_client->cci_device);
 		return cam_sensor_cci_i2c_util(io_master_info->cci_client,
 			MSM_CCI_INIT);
-	} else if ((io_master_info->master_type == I2C_MASTER) ||
-			(io_master_info->master_type == SPI_MASTER)) {
+	} else if (io_master_info->master_type == I2C_MASTER) {
+		return cam_qup_i2c_init(io_master_info);
+	} else if (io_master_info->master_type == SPI_MASTER) {
 		return 0;
 	}
 
@@ -208,8 +209,9 @@ int32_t camera_io_release(struct camera_io_master *io_master_info)
 	if (io_master_info->master_type == CCI_MASTER) {
 		return cam_sensor_cci_i2c_util(io_master_info->cci_client,
 			MSM_CCI_RELEASE);
-	} else if ((io_master_info->master_type == I2C_MASTER) ||
-			(io_master_info->master_type == SPI_MASTER)) {
+	} else if (io_master_info->master_type == I2C_MASTER) {
+		return cam_qup_i2c_release(io_master_info);
+	} else if (io_master_info->master_type == SPI_MASTER) {
 		return 0;
 	}
 
@@ -14,17 +14,24 @@
 #define I2C_MASTER 2
 #define SPI_MASTER 3
 
+struct cam_qup_i2c_xfer;
+
 /**
  * @master_type: CCI master type
  * @client: I2C client information structure
  * @cci_client: CCI client information structure
  * @spi_client: SPI client information structure
+ * @qup_xfer: Preallocated QUP I2C batched write context
+ * @qup_batch_write: Client supports register auto increment and back to
+ *                   back writes without STOP, set from DT
  */
 struct camera_io_master {
 	int master_type;
 	struct i2c_client *client;
 	struct cam_sensor_cci_client *cci_client;
 	struct cam_sensor_spi_client *spi_client;
+	struct cam_qup_i2c_xfer *qup_xfer;
+	bool qup_batch_write;
 };
 
 /**
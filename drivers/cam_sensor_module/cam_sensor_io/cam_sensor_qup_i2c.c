@@ -3,12 +3,24 @@
  * Copyright (c) 2017-2021, The Linux Foundation. All rights reserved.
  */
 
+#include <linux/ktime.h>
+#include <linux/module.h>
+#include <linux/of.h>
+
 #include "cam_sensor_cmn_header.h"
 #include "cam_sensor_i2c.h"
 #include "cam_sensor_io.h"
 
 #define I2C_REG_MAX_BUF_SIZE   8
 
+/*
+ * Coalesce register tables into burst and multi message transfers for all
+ * QUP clients. Off by default, clients opt in with "i2c-batch-write" in DT
+ * since auto increment and back to back messages are not universal.
+ */
+static bool qup_i2c_batch_write;
+module_param(qup_i2c_batch_write, bool, 0644);
+
 static int32_t cam_qup_i2c_rxdata(
 	struct i2c_client *dev_client, unsigned char *rxdata,
 	enum camera_sensor_i2c_type addr_type,
@@ -329,6 +341,152 @@ deallocate_buffer:
 	return rc;
 }
 
+int32_t cam_qup_i2c_init(struct camera_io_master *client)
+{
+	struct cam_qup_i2c_xfer *xfer;
+
+	if (client->qup_xfer)
+		return 0;
+
+	client->qup_batch_write = client->client &&
+		of_property_read_bool(client->client->dev.of_node,
+		"i2c-batch-write");
+	if (!client->qup_batch_write && !qup_i2c_batch_write)
+		return 0;
+
+	xfer = kzalloc(sizeof(struct cam_qup_i2c_xfer), GFP_KERNEL);
+	if (!xfer)
+		return -ENOMEM;
+
+	xfer->buf = kzalloc(CAM_QUP_I2C_XFER_BUF_SIZE, GFP_KERNEL | GFP_DMA);
+	if (!xfer->buf) {
+		kfree(xfer);
+		return -ENOMEM;
+	}
+
+	client->qup_xfer = xfer;
+
+	return 0;
+}
+
+int32_t cam_qup_i2c_release(struct camera_io_master *client)
+{
+	if (!client->qup_xfer)
+		return 0;
+
+	kfree(client->qup_xfer->buf);
+	kfree(client->qup_xfer);
+	client->qup_xfer = NULL;
+
+	return 0;
+}
+
+static uint32_t cam_qup_i2c_pack(uint8_t *buf, uint32_t val,
+	enum camera_sensor_i2c_type type)
+{
+	uint32_t i;
+
+	/* Big endian, type is the size in bytes */
+	for (i = 0; i < type; i++)
+		buf[i] = val >> (BITS_PER_BYTE * (type - 1 - i));
+
+	return type;
+}
+
+static int32_t cam_qup_i2c_xfer_flush(struct camera_io_master *client)
+{
+	int32_t rc;
+	struct cam_qup_i2c_xfer *xfer = client->qup_xfer;
+
+	if (!xfer->num_msgs)
+		return 0;
+
+	rc = i2c_transfer(client->client->adapter, xfer->msgs,
+		xfer->num_msgs);
+	if (rc != xfer->num_msgs) {
+		CAM_ERR(CAM_SENSOR, "failed 0x%x msgs %u rc %d",
+			client->client->addr >> 1, xfer->num_msgs, rc);
+		rc = (rc < 0) ? rc : -EIO;
+	} else {
+		rc = 0;
+	}
+
+	xfer->num_xfers++;
+	xfer->num_sent += xfer->num_msgs;
+	xfer->num_msgs = 0;
+	xfer->buf_used = 0;
+
+	return rc;
+}
+
+static int32_t cam_qup_i2c_write_table_batched(
+	struct camera_io_master *client,
+	struct cam_sensor_i2c_reg_setting *write_setting)
+{
+	int32_t rc = 0;
+	uint32_t i = 0, run, msg_len, len;
+	uint32_t addr_type = write_setting->addr_type;
+	uint32_t data_type = write_setting->data_type;
+	uint32_t max_run = (CAM_QUP_I2C_XFER_BUF_SIZE - addr_type) / data_type;
+	struct cam_sensor_i2c_reg_array *reg_setting =
+		write_setting->reg_setting;
+	struct cam_qup_i2c_xfer *xfer = client->qup_xfer;
+	struct i2c_msg *msg;
+	ktime_t start_time = ktime_get();
+
+	xfer->num_msgs = 0;
+	xfer->buf_used = 0;
+	xfer->num_xfers = 0;
+	xfer->num_sent = 0;
+
+	while (i < write_setting->size) {
+		/* Consecutive registers go out as one auto increment burst */
+		for (run = 1; ((i + run) < write_setting->size) &&
+			(run < max_run); run++) {
+			if (reg_setting[i + run].reg_addr !=
+				(reg_setting[i + run - 1].reg_addr + data_type))
+				break;
+		}
+
+		msg_len = addr_type + (run * data_type);
+		if ((xfer->num_msgs == CAM_QUP_I2C_XFER_MAX_MSGS) ||
+			((xfer->buf_used + msg_len) >
+			CAM_QUP_I2C_XFER_BUF_SIZE)) {
+			rc = cam_qup_i2c_xfer_flush(client);
+			if (rc)
+				goto end;
+		}
+
+		len = cam_qup_i2c_pack(xfer->buf + xfer->buf_used,
+			reg_setting[i].reg_addr, addr_type);
+		for (; run; run--, i++) {
+			CAM_DBG(CAM_SENSOR, "addr 0x%x data 0x%x",
+				reg_setting[i].reg_addr,
+				reg_setting[i].reg_data);
+			len += cam_qup_i2c_pack(
+				xfer->buf + xfer->buf_used + len,
+				reg_setting[i].reg_data, data_type);
+		}
+
+		msg = &xfer->msgs[xfer->num_msgs++];
+		msg->addr = client->client->addr >> 1;
+		msg->flags = 0;
+		msg->len = len;
+		msg->buf = xfer->buf + xfer->buf_used;
+		xfer->buf_used += len;
+	}
+
+	rc = cam_qup_i2c_xfer_flush(client);
+
+end:
+	CAM_DBG(CAM_SENSOR,
+		"regs %u sent as %u msgs in %u transfers, %lld us rc %d",
+		write_setting->size, xfer->num_sent, xfer->num_xfers,
+		ktime_us_delta(ktime_get(), start_time), rc);
+
+	return rc;
+}
+
 int32_t cam_qup_i2c_write_table(struct camera_io_master *client,
 	struct cam_sensor_i2c_reg_setting *write_setting)
 {
@@ -345,6 +503,12 @@ int32_t cam_qup_i2c_write_table(struct camera_io_master *client,
 		|| write_setting->data_type >= CAMERA_SENSOR_I2C_TYPE_MAX)))
 		return rc;
 
+	if (client->qup_xfer &&
+		(client->qup_batch_write || qup_i2c_batch_write)) {
+		rc = cam_qup_i2c_write_table_batched(client, write_setting);
+		goto delay;
+	}
+
 	reg_setting = write_setting->reg_setting;
 
 	for (i = 0; i < write_setting->size; i++) {
@@ -358,6 +522,7 @@ int32_t cam_qup_i2c_write_table(struct camera_io_master *client,
 		reg_setting++;
 	}
 
+delay:
 	if (write_setting->delay > 20)
 		msleep(write_setting->delay);
 	else if (write_setting->delay)
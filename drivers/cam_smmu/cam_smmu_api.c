@@ -16,6 +16,7 @@
 #include <linux/genalloc.h>
 #include <linux/debugfs.h>
 #include <linux/dma-iommu.h>
+#include <linux/hashtable.h>
 
 #include <soc/qcom/secure_buffer.h>
 
@@ -38,6 +39,10 @@
 #define HANDLE_INIT (-1)
 #define CAM_SMMU_CB_MAX 6
 #define CAM_SMMU_SHARED_HDL_MAX 6
+/* Buckets of the per context bank fd/dma_buf mapping index */
+#define CAM_SMMU_BUF_HASH_BITS 7
+/* Lookup chain length histogram, last bin counts longer chains */
+#define CAM_SMMU_CHAIN_HIST_BINS 8
 
 #define GET_SMMU_HDL(x, y) (((x) << COOKIE_SIZE) | ((y) & COOKIE_MASK))
 #define GET_SMMU_TABLE_IDX(x) (((x) >> COOKIE_SIZE) & COOKIE_MASK)
@@ -148,6 +153,10 @@ struct cam_context_bank_info {
 
 	struct list_head smmu_buf_list;
 	struct list_head smmu_buf_kernel_list;
+	DECLARE_HASHTABLE(fd_hash, CAM_SMMU_BUF_HASH_BITS);
+	DECLARE_HASHTABLE(dma_buf_hash, CAM_SMMU_BUF_HASH_BITS);
+	DECLARE_HASHTABLE(sec_fd_hash, CAM_SMMU_BUF_HASH_BITS);
+	uint64_t chain_hist[CAM_SMMU_CHAIN_HIST_BINS];
 	struct mutex lock;
 	int handle;
 	enum cam_smmu_ops_param state;
@@ -203,6 +212,7 @@ struct cam_dma_buff_info {
 	int ref_count;
 	dma_addr_t paddr;
 	struct list_head list;
+	struct hlist_node hnode;
 	int ion_fd;
 	size_t len;
 	size_t phys_len;
@@ -218,6 +228,7 @@ struct cam_sec_buff_info {
 	int ref_count;
 	dma_addr_t paddr;
 	struct list_head list;
+	struct hlist_node hnode;
 	int ion_fd;
 	size_t len;
 };
@@ -911,6 +922,11 @@ void cam_smmu_reset_iommu_table(enum cam_smmu_init_dir ops)
 		iommu_cb_set.cb_info[i].handle = HANDLE_INIT;
 		INIT_LIST_HEAD(&iommu_cb_set.cb_info[i].smmu_buf_list);
 		INIT_LIST_HEAD(&iommu_cb_set.cb_info[i].smmu_buf_kernel_list);
+		hash_init(iommu_cb_set.cb_info[i].fd_hash);
+		hash_init(iommu_cb_set.cb_info[i].dma_buf_hash);
+		hash_init(iommu_cb_set.cb_info[i].sec_fd_hash);
+		memset(iommu_cb_set.cb_info[i].chain_hist, 0,
+			sizeof(iommu_cb_set.cb_info[i].chain_hist));
 		iommu_cb_set.cb_info[i].state = CAM_SMMU_DETACH;
 		iommu_cb_set.cb_info[i].dev = NULL;
 		iommu_cb_set.cb_info[i].cb_count = 0;
@@ -1141,6 +1157,69 @@ static int cam_smmu_free_scratch_va(struct scratch_mapping *mapping,
 	return 0;
 }
 
+static inline void cam_smmu_record_chain_len(int idx, uint32_t chain_len)
+{
+	if (chain_len >= CAM_SMMU_CHAIN_HIST_BINS)
+		chain_len = CAM_SMMU_CHAIN_HIST_BINS - 1;
+
+	iommu_cb_set.cb_info[idx].chain_hist[chain_len]++;
+}
+
+static struct cam_dma_buff_info *cam_smmu_lookup_fd(int idx, int ion_fd)
+{
+	struct cam_dma_buff_info *mapping;
+	uint32_t chain_len = 0;
+
+	hash_for_each_possible(iommu_cb_set.cb_info[idx].fd_hash, mapping,
+		hnode, ion_fd) {
+		chain_len++;
+		if (mapping->ion_fd == ion_fd) {
+			cam_smmu_record_chain_len(idx, chain_len);
+			return mapping;
+		}
+	}
+
+	cam_smmu_record_chain_len(idx, chain_len);
+	return NULL;
+}
+
+static struct cam_dma_buff_info *cam_smmu_lookup_dma_buf(int idx,
+	struct dma_buf *buf)
+{
+	struct cam_dma_buff_info *mapping;
+	uint32_t chain_len = 0;
+
+	hash_for_each_possible(iommu_cb_set.cb_info[idx].dma_buf_hash, mapping,
+		hnode, (unsigned long)buf) {
+		chain_len++;
+		if (mapping->buf == buf) {
+			cam_smmu_record_chain_len(idx, chain_len);
+			return mapping;
+		}
+	}
+
+	cam_smmu_record_chain_len(idx, chain_len);
+	return NULL;
+}
+
+static struct cam_sec_buff_info *cam_smmu_lookup_sec_fd(int idx, int ion_fd)
+{
+	struct cam_sec_buff_info *mapping;
+	uint32_t chain_len = 0;
+
+	hash_for_each_possible(iommu_cb_set.cb_info[idx].sec_fd_hash, mapping,
+		hnode, ion_fd) {
+		chain_len++;
+		if (mapping->ion_fd == ion_fd) {
+			cam_smmu_record_chain_len(idx, chain_len);
+			return mapping;
+		}
+	}
+
+	cam_smmu_record_chain_len(idx, chain_len);
+	return NULL;
+}
+
 static struct cam_dma_buff_info *cam_smmu_find_mapping_by_virt_address(int idx,
 	dma_addr_t virt_addr)
 {
@@ -1170,13 +1249,10 @@ static struct cam_dma_buff_info *cam_smmu_find_mapping_by_ion_index(int idx,
 		return NULL;
 	}
 
-	list_for_each_entry(mapping,
-			&iommu_cb_set.cb_info[idx].smmu_buf_list,
-			list) {
-		if (mapping->ion_fd == ion_fd) {
-			CAM_DBG(CAM_SMMU, "find ion_fd %d", ion_fd);
-			return mapping;
-		}
+	mapping = cam_smmu_lookup_fd(idx, ion_fd);
+	if (mapping) {
+		CAM_DBG(CAM_SMMU, "find ion_fd %d", ion_fd);
+		return mapping;
 	}
 
 	CAM_ERR(CAM_SMMU, "Error: Cannot find entry by index %d", idx);
@@ -1194,13 +1270,10 @@ static struct cam_dma_buff_info *cam_smmu_find_mapping_by_dma_buf(int idx,
 		return NULL;
 	}
 
-	list_for_each_entry(mapping,
-			&iommu_cb_set.cb_info[idx].smmu_buf_kernel_list,
-			list) {
-		if (mapping->buf == buf) {
-			CAM_DBG(CAM_SMMU, "find dma_buf %pK", buf);
-			return mapping;
-		}
+	mapping = cam_smmu_lookup_dma_buf(idx, buf);
+	if (mapping) {
+		CAM_DBG(CAM_SMMU, "find dma_buf %pK", buf);
+		return mapping;
 	}
 
 	CAM_ERR(CAM_SMMU, "Error: Cannot find entry by index %d", idx);
@@ -1213,12 +1286,10 @@ static struct cam_sec_buff_info *cam_smmu_find_mapping_by_sec_buf_idx(int idx,
 {
 	struct cam_sec_buff_info *mapping;
 
-	list_for_each_entry(mapping, &iommu_cb_set.cb_info[idx].smmu_buf_list,
-		list) {
-		if (mapping->ion_fd == ion_fd) {
-			CAM_DBG(CAM_SMMU, "find ion_fd %d", ion_fd);
-			return mapping;
-		}
+	mapping = cam_smmu_lookup_sec_fd(idx, ion_fd);
+	if (mapping) {
+		CAM_DBG(CAM_SMMU, "find ion_fd %d", ion_fd);
+		return mapping;
 	}
 	CAM_ERR(CAM_SMMU, "Error: Cannot find fd %d by index %d",
 		ion_fd, idx);
@@ -2202,6 +2273,8 @@ static int cam_smmu_map_buffer_and_add_to_list(int idx, int ion_fd,
 	/* add to the list */
 	list_add(&mapping_info->list,
 		&iommu_cb_set.cb_info[idx].smmu_buf_list);
+	hash_add(iommu_cb_set.cb_info[idx].fd_hash, &mapping_info->hnode,
+		mapping_info->ion_fd);
 
 	cam_smmu_update_monitor_array(&iommu_cb_set.cb_info[idx], true,
 		mapping_info);
@@ -2230,6 +2303,8 @@ static int cam_smmu_map_kernel_buffer_and_add_to_list(int idx,
 	/* add to the list */
 	list_add(&mapping_info->list,
 		&iommu_cb_set.cb_info[idx].smmu_buf_kernel_list);
+	hash_add(iommu_cb_set.cb_info[idx].dma_buf_hash, &mapping_info->hnode,
+		(unsigned long)mapping_info->buf);
 
 	cam_smmu_update_monitor_array(&iommu_cb_set.cb_info[idx], true,
 		mapping_info);
@@ -2321,6 +2396,7 @@ static int cam_smmu_unmap_buf_and_remove_from_list(
 	mapping_info->buf = NULL;
 
 	list_del_init(&mapping_info->list);
+	hash_del(&mapping_info->hnode);
 
 	/* free one buffer */
 	kfree(mapping_info);
@@ -2333,17 +2409,14 @@ static enum cam_smmu_buf_state cam_smmu_check_fd_in_list(int idx,
 {
 	struct cam_dma_buff_info *mapping;
 
-	list_for_each_entry(mapping,
-		&iommu_cb_set.cb_info[idx].smmu_buf_list, list) {
-		if (mapping->ion_fd == ion_fd) {
-			*paddr_ptr = mapping->paddr;
-			*len_ptr = mapping->len;
-			*ts_mapping = &mapping->ts;
-			return CAM_SMMU_BUFF_EXIST;
-		}
-	}
+	mapping = cam_smmu_lookup_fd(idx, ion_fd);
+	if (!mapping)
+		return CAM_SMMU_BUFF_NOT_EXIST;
 
-	return CAM_SMMU_BUFF_NOT_EXIST;
+	*paddr_ptr = mapping->paddr;
+	*len_ptr = mapping->len;
+	*ts_mapping = &mapping->ts;
+	return CAM_SMMU_BUFF_EXIST;
 }
 
 static enum cam_smmu_buf_state cam_smmu_user_reuse_fd_in_list(int idx,
@@ -2352,18 +2425,15 @@ static enum cam_smmu_buf_state cam_smmu_user_reuse_fd_in_list(int idx,
 {
 	struct cam_dma_buff_info *mapping;
 
-	list_for_each_entry(mapping,
-		&iommu_cb_set.cb_info[idx].smmu_buf_list, list) {
-		if (mapping->ion_fd == ion_fd) {
-			*paddr_ptr = mapping->paddr;
-			*len_ptr = mapping->len;
-			*ts_mapping = &mapping->ts;
-			mapping->ref_count++;
-			return CAM_SMMU_BUFF_EXIST;
-		}
-	}
+	mapping = cam_smmu_lookup_fd(idx, ion_fd);
+	if (!mapping)
+		return CAM_SMMU_BUFF_NOT_EXIST;
 
-	return CAM_SMMU_BUFF_NOT_EXIST;
+	*paddr_ptr = mapping->paddr;
+	*len_ptr = mapping->len;
+	*ts_mapping = &mapping->ts;
+	mapping->ref_count++;
+	return CAM_SMMU_BUFF_EXIST;
 }
 
 static enum cam_smmu_buf_state cam_smmu_check_dma_buf_in_list(int idx,
@@ -2371,16 +2441,13 @@ static enum cam_smmu_buf_state cam_smmu_check_dma_buf_in_list(int idx,
 {
 	struct cam_dma_buff_info *mapping;
 
-	list_for_each_entry(mapping,
-		&iommu_cb_set.cb_info[idx].smmu_buf_kernel_list, list) {
-		if (mapping->buf == buf) {
-			*paddr_ptr = mapping->paddr;
-			*len_ptr = mapping->len;
-			return CAM_SMMU_BUFF_EXIST;
-		}
-	}
+	mapping = cam_smmu_lookup_dma_buf(idx, buf);
+	if (!mapping)
+		return CAM_SMMU_BUFF_NOT_EXIST;
 
-	return CAM_SMMU_BUFF_NOT_EXIST;
+	*paddr_ptr = mapping->paddr;
+	*len_ptr = mapping->len;
+	return CAM_SMMU_BUFF_EXIST;
 }
 
 static enum cam_smmu_buf_state cam_smmu_check_secure_fd_in_list(int idx,
@@ -2389,18 +2456,14 @@ static enum cam_smmu_buf_state cam_smmu_check_secure_fd_in_list(int idx,
 {
 	struct cam_sec_buff_info *mapping;
 
-	list_for_each_entry(mapping,
-			&iommu_cb_set.cb_info[idx].smmu_buf_list,
-			list) {
-		if (mapping->ion_fd == ion_fd) {
-			*paddr_ptr = mapping->paddr;
-			*len_ptr = mapping->len;
-			mapping->ref_count++;
-			return CAM_SMMU_BUFF_EXIST;
-		}
-	}
+	mapping = cam_smmu_lookup_sec_fd(idx, ion_fd);
+	if (!mapping)
+		return CAM_SMMU_BUFF_NOT_EXIST;
 
-	return CAM_SMMU_BUFF_NOT_EXIST;
+	*paddr_ptr = mapping->paddr;
+	*len_ptr = mapping->len;
+	mapping->ref_count++;
+	return CAM_SMMU_BUFF_EXIST;
 }
 
 static enum cam_smmu_buf_state cam_smmu_validate_secure_fd_in_list(int idx,
@@ -2408,17 +2471,13 @@ static enum cam_smmu_buf_state cam_smmu_validate_secure_fd_in_list(int idx,
 {
 	struct cam_sec_buff_info *mapping;
 
-	list_for_each_entry(mapping,
-			&iommu_cb_set.cb_info[idx].smmu_buf_list,
-			list) {
-		if (mapping->ion_fd == ion_fd) {
-			*paddr_ptr = mapping->paddr;
-			*len_ptr = mapping->len;
-			return CAM_SMMU_BUFF_EXIST;
-		}
-	}
+	mapping = cam_smmu_lookup_sec_fd(idx, ion_fd);
+	if (!mapping)
+		return CAM_SMMU_BUFF_NOT_EXIST;
 
-	return CAM_SMMU_BUFF_NOT_EXIST;
+	*paddr_ptr = mapping->paddr;
+	*len_ptr = mapping->len;
+	return CAM_SMMU_BUFF_EXIST;
 }
 
 int cam_smmu_get_handle(char *identifier, int *handle_ptr)
@@ -2586,6 +2645,8 @@ static int cam_smmu_alloc_scratch_buffer_add_to_list(int idx,
 		mapping_info->len, mapping_info->phys_len);
 
 	list_add(&mapping_info->list, &iommu_cb_set.cb_info[idx].smmu_buf_list);
+	hash_add(iommu_cb_set.cb_info[idx].fd_hash, &mapping_info->hnode,
+		mapping_info->ion_fd);
 
 	*virt_addr = (dma_addr_t)iova;
 
@@ -2647,6 +2708,7 @@ static int cam_smmu_free_scratch_buffer_remove_from_list(
 	sg_free_table(mapping_info->table);
 	kfree(mapping_info->table);
 	list_del_init(&mapping_info->list);
+	hash_del(&mapping_info->hnode);
 
 	kfree(mapping_info);
 	mapping_info = NULL;
@@ -2871,6 +2933,8 @@ static int cam_smmu_map_stage2_buffer_and_add_to_list(int idx, int ion_fd,
 
 	/* add to the list */
 	list_add(&mapping_info->list, &iommu_cb_set.cb_info[idx].smmu_buf_list);
+	hash_add(iommu_cb_set.cb_info[idx].sec_fd_hash, &mapping_info->hnode,
+		mapping_info->ion_fd);
 
 	return 0;
 
@@ -2983,6 +3047,7 @@ static int cam_smmu_secure_unmap_buf_and_remove_from_list(
 	mapping_info->buf = NULL;
 
 	list_del_init(&mapping_info->list);
+	hash_del(&mapping_info->hnode);
 
 	CAM_DBG(CAM_SMMU, "unmap fd: %d, idx : %d", mapping_info->ion_fd, idx);
 
@@ -4168,6 +4233,62 @@ cb_init_fail:
 	return rc;
 }
 
+static ssize_t cam_smmu_chain_hist_read(struct file *file,
+	char __user *ubuf, size_t size, loff_t *ppos)
+{
+	struct cam_context_bank_info *cb_info;
+	char *buf;
+	int len = 0, i, j;
+	size_t buf_size = PAGE_SIZE;
+	ssize_t rc;
+
+	buf = kzalloc(buf_size, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	for (i = 0; i < iommu_cb_set.cb_num; i++) {
+		cb_info = &iommu_cb_set.cb_info[i];
+		if (!cb_info->name[0])
+			continue;
+
+		len += scnprintf(buf + len, buf_size - len, "%s:",
+			cb_info->name[0]);
+		mutex_lock(&cb_info->lock);
+		for (j = 0; j < CAM_SMMU_CHAIN_HIST_BINS; j++)
+			len += scnprintf(buf + len, buf_size - len, " %llu",
+				cb_info->chain_hist[j]);
+		mutex_unlock(&cb_info->lock);
+		len += scnprintf(buf + len, buf_size - len, "\n");
+	}
+
+	rc = simple_read_from_buffer(ubuf, size, ppos, buf, len);
+	kfree(buf);
+
+	return rc;
+}
+
+static ssize_t cam_smmu_chain_hist_write(struct file *file,
+	const char __user *ubuf, size_t size, loff_t *ppos)
+{
+	struct cam_context_bank_info *cb_info;
+	int i;
+
+	for (i = 0; i < iommu_cb_set.cb_num; i++) {
+		cb_info = &iommu_cb_set.cb_info[i];
+		mutex_lock(&cb_info->lock);
+		memset(cb_info->chain_hist, 0, sizeof(cb_info->chain_hist));
+		mutex_unlock(&cb_info->lock);
+	}
+
+	return size;
+}
+
+static const struct file_operations cam_smmu_chain_hist_fops = {
+	.open = simple_open,
+	.read = cam_smmu_chain_hist_read,
+	.write = cam_smmu_chain_hist_write,
+};
+
 static int cam_smmu_create_debug_fs(void)
 {
 	int rc = 0;
@@ -4186,6 +4307,12 @@ static int cam_smmu_create_debug_fs(void)
 		iommu_cb_set.dentry, &iommu_cb_set.cb_dump_enable);
 	dbgfileptr = debugfs_create_bool("map_profile_enable", 0644,
 		iommu_cb_set.dentry, &iommu_cb_set.map_profile_enable);
+	/*
+	 * Per context bank count of fd/dma_buf lookups by number of
+	 * entries visited, bins 0..6 and 7 or more. Any write clears it.
+	 */
+	dbgfileptr = debugfs_create_file("lookup_chain_hist", 0644,
+		iommu_cb_set.dentry, NULL, &cam_smmu_chain_hist_fops);
 	if (IS_ERR(dbgfileptr)) {
 		if (PTR_ERR(dbgfileptr) == -ENODEV)
 			CAM_WARN(CAM_SMMU, "DebugFS not enabled in kernel!");
@@ -9,6 +9,10 @@
 #include <linux/module.h>
 #include <linux/platform_device.h>
 #include <linux/debugfs.h>
+#include <linux/sort.h>
+#include <linux/wait.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
 #if IS_REACHABLE(CONFIG_MSM_GLOBAL_SYNX)
 #include <synx_api.h>
 #endif
@@ -28,6 +32,13 @@ struct sync_device *sync_dev;
  */
 static bool trigger_cb_without_switch;
 
+/*
+ * Flag to determine whether kernel callbacks of a signaled
+ * fence and of its merged parents are dispatched from one
+ * work item instead of one work item per callback
+ */
+static bool batch_cb_dispatch;
+
 static void cam_sync_print_fence_table(void)
 {
 	int idx;
@@ -104,7 +115,7 @@ int cam_sync_register_callback(sync_callback cb_func,
 		return -EINVAL;
 	}
 
-	sync_cb = kzalloc(sizeof(*sync_cb), GFP_ATOMIC);
+	sync_cb = cam_sync_util_alloc_cb();
 	if (!sync_cb) {
 		spin_unlock_bh(&sync_dev->row_spinlocks[sync_obj]);
 		return -ENOMEM;
@@ -119,7 +130,7 @@ int cam_sync_register_callback(sync_callback cb_func,
 			CAM_DBG(CAM_SYNC, "Invoke callback for sync object:%d",
 				sync_obj);
 			status = row->state;
-			kfree(sync_cb);
+			cam_sync_util_free_cb(sync_cb);
 			spin_unlock_bh(&sync_dev->row_spinlocks[sync_obj]);
 			cb_func(sync_obj, status, userdata);
 		} else {
@@ -177,7 +188,7 @@ int cam_sync_deregister_callback(sync_callback cb_func,
 		if (sync_cb->callback_func == cb_func &&
 			sync_cb->cb_data == userdata) {
 			list_del_init(&sync_cb->list);
-			kfree(sync_cb);
+			cam_sync_util_free_cb(sync_cb);
 			found = true;
 		}
 	}
@@ -186,13 +197,48 @@ int cam_sync_deregister_callback(sync_callback cb_func,
 	return found ? 0 : -ENOENT;
 }
 
+/**
+ * cam_sync_signal_parent() - Account signaled children of a merged object
+ * and dispatch its callbacks once no children remain
+ *
+ * @parent_id   : Sync id of the merged object
+ * @num_signaled: Number of its children that got signaled
+ * @status      : Combined status of those children, the first error or
+ *                cancel status in signaling order if any, else success
+ * @event_cause : Event cause propagated to callbacks
+ * @cb_list     : Batch list for kernel callbacks, may be NULL
+ */
+static void cam_sync_signal_parent(int32_t parent_id, uint32_t num_signaled,
+	uint32_t status, uint32_t event_cause, struct list_head *cb_list)
+{
+	struct sync_table_row *parent_row = sync_dev->sync_table + parent_id;
+	int rc;
+
+	spin_lock_bh(&sync_dev->row_spinlocks[parent_id]);
+	parent_row->remaining -= num_signaled;
+
+	rc = cam_sync_util_update_parent_state(parent_row, status);
+	if (rc) {
+		CAM_ERR(CAM_SYNC, "Invalid parent state %d",
+			parent_row->state);
+		spin_unlock_bh(&sync_dev->row_spinlocks[parent_id]);
+		return;
+	}
+
+	if (!parent_row->remaining)
+		cam_sync_util_dispatch_signaled_cb(parent_id,
+			parent_row->state, event_cause, cb_list);
+
+	spin_unlock_bh(&sync_dev->row_spinlocks[parent_id]);
+}
+
 int cam_sync_signal(int32_t sync_obj, uint32_t status, uint32_t event_cause)
 {
 	struct sync_table_row *row = NULL;
-	struct sync_table_row *parent_row = NULL;
 	struct sync_parent_info *parent_info, *temp_parent_info;
 	struct list_head parents_list;
-	int rc = 0;
+	struct list_head cb_list;
+	struct list_head *batch_list = NULL;
 
 	if (sync_obj >= CAM_SYNC_MAX_OBJS || sync_obj <= 0) {
 		CAM_ERR(CAM_SYNC, "Error: Out of range sync obj (0 <= %d < %d)",
@@ -240,16 +286,23 @@ int cam_sync_signal(int32_t sync_obj, uint32_t status, uint32_t event_cause)
 		return 0;
 	}
 
+	INIT_LIST_HEAD(&cb_list);
+	if (batch_cb_dispatch)
+		batch_list = &cb_list;
+
 	row->state = status;
-	cam_sync_util_dispatch_signaled_cb(sync_obj, status, event_cause);
+	cam_sync_util_dispatch_signaled_cb(sync_obj, status, event_cause,
+		batch_list);
 
 	/* copy parent list to local and release child lock */
 	INIT_LIST_HEAD(&parents_list);
 	list_splice_init(&row->parents_list, &parents_list);
 	spin_unlock_bh(&sync_dev->row_spinlocks[sync_obj]);
 
-	if (list_empty(&parents_list))
+	if (list_empty(&parents_list)) {
+		cam_sync_util_queue_cb_list(&cb_list);
 		return 0;
+	}
 
 	/*
 	 * Now iterate over all parents of this object and if they too need to
@@ -259,30 +312,294 @@ int cam_sync_signal(int32_t sync_obj, uint32_t status, uint32_t event_cause)
 		temp_parent_info,
 		&parents_list,
 		list) {
-		parent_row = sync_dev->sync_table + parent_info->sync_id;
-		spin_lock_bh(&sync_dev->row_spinlocks[parent_info->sync_id]);
-		parent_row->remaining--;
+		cam_sync_signal_parent(parent_info->sync_id, 1, status,
+			event_cause, batch_list);
+		list_del_init(&parent_info->list);
+		kfree(parent_info);
+	}
 
-		rc = cam_sync_util_update_parent_state(
-			parent_row,
-			status);
-		if (rc) {
-			CAM_ERR(CAM_SYNC, "Invalid parent state %d",
-				parent_row->state);
-			spin_unlock_bh(
-				&sync_dev->row_spinlocks[parent_info->sync_id]);
+	cam_sync_util_queue_cb_list(&cb_list);
+
+	return 0;
+}
+
+static int cam_sync_batch_entry_cmp(const void *a, const void *b)
+{
+	const struct cam_sync_batch_entry *entry_a = a;
+	const struct cam_sync_batch_entry *entry_b = b;
+
+	return entry_a->sync_obj - entry_b->sync_obj;
+}
+
+/**
+ * cam_sync_batch_resolve_parents() - Signal merged parents of a batch,
+ * locking each distinct parent once no matter how many of its children
+ * were part of the batch
+ */
+static void cam_sync_batch_resolve_parents(
+	struct cam_sync_batch_entry *entries, uint32_t num_entries,
+	uint32_t event_cause, struct list_head *cb_list)
+{
+	struct cam_sync_parent_signal *parents;
+	struct sync_parent_info *parent_info, *temp_parent_info;
+	uint32_t i, j, num_nodes = 0, num_parents = 0;
+
+	for (i = 0; i < num_entries; i++)
+		list_for_each_entry(parent_info, &entries[i].parents_list, list)
+			num_nodes++;
+
+	if (!num_nodes)
+		return;
+
+	parents = kcalloc(num_nodes, sizeof(*parents), GFP_KERNEL);
+
+	for (i = 0; i < num_entries; i++) {
+		list_for_each_entry_safe(parent_info, temp_parent_info,
+			&entries[i].parents_list, list) {
+			if (!parents) {
+				/* Cannot aggregate, resolve parents one by one */
+				cam_sync_signal_parent(parent_info->sync_id, 1,
+					entries[i].status, event_cause, cb_list);
+				goto free_node;
+			}
+
+			for (j = 0; j < num_parents; j++)
+				if (parents[j].sync_id == parent_info->sync_id)
+					break;
+
+			if (j == num_parents) {
+				parents[j].sync_id = parent_info->sync_id;
+				parents[j].status =
+					CAM_SYNC_STATE_SIGNALED_SUCCESS;
+				num_parents++;
+			}
+
+			/* First error or cancel sticks, as in serial signal */
+			parents[j].num_signaled++;
+			if (parents[j].status == CAM_SYNC_STATE_SIGNALED_SUCCESS)
+				parents[j].status = entries[i].status;
+free_node:
+			list_del_init(&parent_info->list);
 			kfree(parent_info);
+		}
+	}
+
+	for (j = 0; j < num_parents; j++)
+		cam_sync_signal_parent(parents[j].sync_id,
+			parents[j].num_signaled, parents[j].status,
+			event_cause, cb_list);
+
+	kfree(parents);
+}
+
+/**
+ * cam_sync_batch_check_row() - Check that a row can be signaled by a batch
+ * Caller holds the row spinlock.
+ */
+static int cam_sync_batch_check_row(int32_t sync_obj)
+{
+	struct sync_table_row *row = sync_dev->sync_table + sync_obj;
+
+	if ((row->state == CAM_SYNC_STATE_INVALID) ||
+		(row->type == CAM_SYNC_TYPE_GROUP)) {
+		CAM_ERR(CAM_SYNC,
+			"Error: cannot signal sync obj = %d state %u type %d",
+			sync_obj, row->state, row->type);
+		return -EINVAL;
+	}
+
+	if (row->state != CAM_SYNC_STATE_ACTIVE) {
+		CAM_ERR(CAM_SYNC,
+			"Error: Sync object already signaled sync_obj = %d",
+			sync_obj);
+		return -EALREADY;
+	}
+
+	if (atomic_read(&row->ref_cnt)) {
+		CAM_ERR(CAM_SYNC,
+			"Error: sync obj = %d has kernel references %d",
+			sync_obj, atomic_read(&row->ref_cnt));
+		return -EBUSY;
+	}
+
+	return 0;
+}
+
+/**
+ * cam_sync_signal_batch() - Signal a set of individual sync objects from
+ * user space, either all of them are signaled or none is
+ *
+ * Every row is validated under its own lock first, then signaled one at
+ * a time, so at most one row lock is held at any point. table_lock keeps
+ * merges, which take child row locks under the group row lock, out for
+ * the whole batch. Objects with kernel references held fail the batch.
+ */
+static int cam_sync_signal_batch(struct cam_sync_batch_entry *entries,
+	uint32_t num_entries, uint32_t event_cause)
+{
+	struct sync_table_row *row;
+	struct list_head cb_list;
+	struct list_head *batch_list = NULL;
+	int32_t sync_obj;
+	uint32_t i;
+	int rc = 0;
+
+	for (i = 0; i < num_entries; i++) {
+		if (entries[i].sync_obj >= CAM_SYNC_MAX_OBJS ||
+			entries[i].sync_obj <= 0) {
+			CAM_ERR(CAM_SYNC, "Error: Out of range sync obj %d",
+				entries[i].sync_obj);
+			return -EINVAL;
+		}
+
+		if ((entries[i].status != CAM_SYNC_STATE_SIGNALED_SUCCESS) &&
+			(entries[i].status != CAM_SYNC_STATE_SIGNALED_ERROR) &&
+			(entries[i].status != CAM_SYNC_STATE_SIGNALED_CANCEL)) {
+			CAM_ERR(CAM_SYNC,
+				"Error: signaling with undefined status = %d",
+				entries[i].status);
+			return -EINVAL;
+		}
+
+		entries[i].signaled = false;
+		INIT_LIST_HEAD(&entries[i].parents_list);
+	}
+
+	sort(entries, num_entries, sizeof(*entries),
+		cam_sync_batch_entry_cmp, NULL);
+
+	for (i = 1; i < num_entries; i++) {
+		if (entries[i].sync_obj == entries[i - 1].sync_obj) {
+			CAM_ERR(CAM_SYNC, "Error: duplicate sync obj %d in batch",
+				entries[i].sync_obj);
+			return -EINVAL;
+		}
+	}
+
+	INIT_LIST_HEAD(&cb_list);
+	if (batch_cb_dispatch)
+		batch_list = &cb_list;
+
+	mutex_lock(&sync_dev->table_lock);
+	for (i = 0; i < num_entries; i++) {
+		sync_obj = entries[i].sync_obj;
+		spin_lock_bh(&sync_dev->row_spinlocks[sync_obj]);
+		rc = cam_sync_batch_check_row(sync_obj);
+		spin_unlock_bh(&sync_dev->row_spinlocks[sync_obj]);
+		if (rc)
+			goto unlock;
+	}
+
+	for (i = 0; i < num_entries; i++) {
+		sync_obj = entries[i].sync_obj;
+		row = sync_dev->sync_table + sync_obj;
+		spin_lock_bh(&sync_dev->row_spinlocks[sync_obj]);
+		/* Only a racing single signal or destroy can fail here */
+		rc = cam_sync_batch_check_row(sync_obj);
+		if (rc) {
+			spin_unlock_bh(&sync_dev->row_spinlocks[sync_obj]);
+			break;
+		}
+
+		row->state = entries[i].status;
+		entries[i].signaled = true;
+		cam_sync_util_dispatch_signaled_cb(sync_obj,
+			entries[i].status, event_cause, batch_list);
+		list_splice_init(&row->parents_list, &entries[i].parents_list);
+		spin_unlock_bh(&sync_dev->row_spinlocks[sync_obj]);
+	}
+
+	/* Parents of what got signaled must be accounted even on failure */
+	cam_sync_batch_resolve_parents(entries, num_entries, event_cause,
+		batch_list);
+
+unlock:
+	mutex_unlock(&sync_dev->table_lock);
+	cam_sync_util_queue_cb_list(&cb_list);
+
+	return rc;
+}
+
+static bool cam_sync_wait_batch_done(int32_t *sync_objs, uint32_t num_objs,
+	bool wait_all, int32_t *signaled_idx)
+{
+	uint32_t i, state;
+
+	for (i = 0; i < num_objs; i++) {
+		state = READ_ONCE(sync_dev->sync_table[sync_objs[i]].state);
+		/* Destroyed under the waiter, no point waiting for the rest */
+		if (state == CAM_SYNC_STATE_INVALID) {
+			*signaled_idx = i;
+			return true;
+		}
+
+		if (state == CAM_SYNC_STATE_ACTIVE) {
+			if (wait_all)
+				return false;
 			continue;
 		}
 
-		if (!parent_row->remaining)
-			cam_sync_util_dispatch_signaled_cb(
-				parent_info->sync_id, parent_row->state,
-				event_cause);
+		if (!wait_all) {
+			*signaled_idx = i;
+			return true;
+		}
+	}
 
-		spin_unlock_bh(&sync_dev->row_spinlocks[parent_info->sync_id]);
-		list_del_init(&parent_info->list);
-		kfree(parent_info);
+	return wait_all;
+}
+
+static int cam_sync_wait_batch(int32_t *sync_objs, uint32_t num_objs,
+	bool wait_all, uint64_t timeout_ms, int32_t *signaled_idx)
+{
+	unsigned long timeleft;
+	uint32_t i;
+
+	*signaled_idx = -1;
+	for (i = 0; i < num_objs; i++) {
+		if (sync_objs[i] >= CAM_SYNC_MAX_OBJS || sync_objs[i] <= 0)
+			return -EINVAL;
+
+		if (sync_dev->sync_table[sync_objs[i]].state ==
+			CAM_SYNC_STATE_INVALID) {
+			CAM_ERR(CAM_SYNC,
+				"Error: accessing an uninitialized sync obj = %d",
+				sync_objs[i]);
+			*signaled_idx = i;
+			return -EINVAL;
+		}
+	}
+
+	timeleft = wait_event_timeout(sync_dev->signal_wait_q,
+		cam_sync_wait_batch_done(sync_objs, num_objs, wait_all,
+		signaled_idx), msecs_to_jiffies(timeout_ms));
+	if (!timeleft) {
+		CAM_ERR(CAM_SYNC, "Error: timed out waiting on %u objs, all %d",
+			num_objs, wait_all);
+		return -ETIMEDOUT;
+	}
+
+	if ((*signaled_idx >= 0) &&
+		(sync_dev->sync_table[sync_objs[*signaled_idx]].state ==
+		CAM_SYNC_STATE_INVALID)) {
+		CAM_ERR(CAM_SYNC, "Error: obj = %d destroyed while waiting",
+			sync_objs[*signaled_idx]);
+		return -EINVAL;
+	}
+
+	if (!wait_all)
+		return (sync_dev->sync_table[sync_objs[*signaled_idx]].state ==
+			CAM_SYNC_STATE_SIGNALED_SUCCESS) ? 0 : -EINVAL;
+
+	for (i = 0; i < num_objs; i++) {
+		if (sync_dev->sync_table[sync_objs[i]].state !=
+			CAM_SYNC_STATE_SIGNALED_SUCCESS) {
+			CAM_ERR(CAM_SYNC,
+				"Error: Wait on invalid state = %d, obj = %d",
+				sync_dev->sync_table[sync_objs[i]].state,
+				sync_objs[i]);
+			*signaled_idx = i;
+			return -EINVAL;
+		}
 	}
 
 	return 0;
@@ -326,6 +643,8 @@ int cam_sync_merge(int32_t *sync_obj, uint32_t num_objs, int32_t *merged_obj)
 		bit = test_and_set_bit(idx, sync_dev->bitmap);
 	} while (bit);
 
+	/* Keep batch signals, which may hold children, out while merging */
+	mutex_lock(&sync_dev->table_lock);
 	spin_lock_bh(&sync_dev->row_spinlocks[idx]);
 	rc = cam_sync_init_group_object(sync_dev->sync_table,
 		idx, sync_obj,
@@ -335,11 +654,13 @@ int cam_sync_merge(int32_t *sync_obj, uint32_t num_objs, int32_t *merged_obj)
 			idx);
 		clear_bit(idx, sync_dev->bitmap);
 		spin_unlock_bh(&sync_dev->row_spinlocks[idx]);
+		mutex_unlock(&sync_dev->table_lock);
 		return -EINVAL;
 	}
 	CAM_DBG(CAM_SYNC, "Init row at idx:%ld to merge objects", idx);
 	*merged_obj = idx;
 	spin_unlock_bh(&sync_dev->row_spinlocks[idx]);
+	mutex_unlock(&sync_dev->table_lock);
 
 	return 0;
 }
@@ -598,6 +919,98 @@ static int cam_sync_handle_wait(struct cam_private_ioctl_arg *k_ioctl)
 	return 0;
 }
 
+static int cam_sync_handle_signal_batch(struct cam_private_ioctl_arg *k_ioctl)
+{
+	struct cam_sync_signal_batch signal_batch;
+	struct cam_sync_signal *signals;
+	struct cam_sync_batch_entry *entries;
+	uint32_t i;
+	int rc;
+
+	if (k_ioctl->size != sizeof(struct cam_sync_signal_batch))
+		return -EINVAL;
+
+	if (!k_ioctl->ioctl_ptr)
+		return -EINVAL;
+
+	if (copy_from_user(&signal_batch,
+		u64_to_user_ptr(k_ioctl->ioctl_ptr),
+		k_ioctl->size))
+		return -EFAULT;
+
+	if (!signal_batch.num_signals ||
+		signal_batch.num_signals > CAM_SYNC_MAX_BATCH_OBJS)
+		return -EINVAL;
+
+	signals = kcalloc(signal_batch.num_signals, sizeof(*signals),
+		GFP_KERNEL);
+	if (!signals)
+		return -ENOMEM;
+
+	entries = kcalloc(signal_batch.num_signals, sizeof(*entries),
+		GFP_KERNEL);
+	if (!entries) {
+		kfree(signals);
+		return -ENOMEM;
+	}
+
+	if (copy_from_user(signals,
+		u64_to_user_ptr(signal_batch.signals),
+		sizeof(*signals) * signal_batch.num_signals)) {
+		rc = -EFAULT;
+		goto end;
+	}
+
+	for (i = 0; i < signal_batch.num_signals; i++) {
+		entries[i].sync_obj = signals[i].sync_obj;
+		entries[i].status = signals[i].sync_state;
+	}
+
+	rc = cam_sync_signal_batch(entries, signal_batch.num_signals,
+		CAM_SYNC_COMMON_SYNC_SIGNAL_EVENT);
+
+end:
+	kfree(entries);
+	kfree(signals);
+	return rc;
+}
+
+static int cam_sync_handle_wait_batch(struct cam_private_ioctl_arg *k_ioctl,
+	bool wait_all)
+{
+	struct cam_sync_wait_batch wait_batch;
+	int32_t sync_objs[CAM_SYNC_MAX_BATCH_OBJS];
+
+	if (k_ioctl->size != sizeof(struct cam_sync_wait_batch))
+		return -EINVAL;
+
+	if (!k_ioctl->ioctl_ptr)
+		return -EINVAL;
+
+	if (copy_from_user(&wait_batch,
+		u64_to_user_ptr(k_ioctl->ioctl_ptr),
+		k_ioctl->size))
+		return -EFAULT;
+
+	if (!wait_batch.num_objs ||
+		wait_batch.num_objs > CAM_SYNC_MAX_BATCH_OBJS)
+		return -EINVAL;
+
+	if (copy_from_user(sync_objs,
+		u64_to_user_ptr(wait_batch.sync_objs),
+		sizeof(int32_t) * wait_batch.num_objs))
+		return -EFAULT;
+
+	k_ioctl->result = cam_sync_wait_batch(sync_objs, wait_batch.num_objs,
+		wait_all, wait_batch.timeout_ms, &wait_batch.signaled_idx);
+
+	if (copy_to_user(u64_to_user_ptr(k_ioctl->ioctl_ptr),
+		&wait_batch, k_ioctl->size))
+		return -EFAULT;
+
+	return 0;
+}
+
 static int cam_sync_handle_destroy(struct cam_private_ioctl_arg *k_ioctl)
 {
 	struct cam_sync_info sync_create;
@@ -641,7 +1054,7 @@ static int cam_sync_handle_register_user_payload(
 	if (sync_obj >= CAM_SYNC_MAX_OBJS || sync_obj <= 0)
 		return -EINVAL;
 
-	user_payload_kernel = kzalloc(sizeof(*user_payload_kernel), GFP_KERNEL);
+	user_payload_kernel = cam_sync_util_alloc_payload();
 	if (!user_payload_kernel)
 		return -ENOMEM;
 
@@ -657,7 +1070,7 @@ static int cam_sync_handle_register_user_payload(
 			"Error: accessing an uninitialized sync obj = %d",
 			sync_obj);
 		spin_unlock_bh(&sync_dev->row_spinlocks[sync_obj]);
-		kfree(user_payload_kernel);
+		cam_sync_util_free_payload(user_payload_kernel);
 		return -EINVAL;
 	}
 
@@ -673,7 +1086,7 @@ static int cam_sync_handle_register_user_payload(
 			CAM_SYNC_COMMON_REG_PAYLOAD_EVENT);
 
 		spin_unlock_bh(&sync_dev->row_spinlocks[sync_obj]);
-		kfree(user_payload_kernel);
+		cam_sync_util_free_payload(user_payload_kernel);
 		return 0;
 	}
 
@@ -687,7 +1100,7 @@ static int cam_sync_handle_register_user_payload(
 				user_payload_kernel->payload_data[1]) {
 
 			spin_unlock_bh(&sync_dev->row_spinlocks[sync_obj]);
-			kfree(user_payload_kernel);
+			cam_sync_util_free_payload(user_payload_kernel);
 			return -EALREADY;
 		}
 	}
@@ -742,7 +1155,7 @@ static int cam_sync_handle_deregister_user_payload(
 				user_payload_kernel->payload_data[1] ==
 				userpayload_info.payload[1]) {
 			list_del_init(&user_payload_kernel->list);
-			kfree(user_payload_kernel);
+			cam_sync_util_free_payload(user_payload_kernel);
 		}
 	}
 
@@ -796,6 +1209,16 @@ static long cam_sync_dev_ioctl(struct file *filep, void *fh,
 		((struct cam_private_ioctl_arg *)arg)->result =
 			k_ioctl.result;
 		break;
+	case CAM_SYNC_SIGNAL_BATCH:
+		rc = cam_sync_handle_signal_batch(&k_ioctl);
+		break;
+	case CAM_SYNC_WAIT_ANY:
+	case CAM_SYNC_WAIT_ALL:
+		rc = cam_sync_handle_wait_batch(&k_ioctl,
+			(k_ioctl.id == CAM_SYNC_WAIT_ALL));
+		((struct cam_private_ioctl_arg *)arg)->result =
+			k_ioctl.result;
+		break;
 	default:
 		rc = -ENOIOCTLCMD;
 	}
@@ -807,19 +1230,88 @@ static unsigned int cam_sync_poll(struct file *f,
 	struct poll_table_struct *pll_table)
 {
 	int rc = 0;
+	uint32_t seqno;
 	struct v4l2_fh *eventq = f->private_data;
 
 	if (!eventq)
 		return -EINVAL;
 
 	poll_wait(f, &eventq->wait, pll_table);
+	poll_wait(f, &sync_dev->signal_wait_q, pll_table);
 
 	if (v4l2_event_pending(eventq))
 		rc = POLLPRI;
 
+	if (sync_dev->status_map) {
+		seqno = READ_ONCE(sync_dev->status_map[0].seqno);
+		if (seqno != sync_dev->poll_seqno) {
+			sync_dev->poll_seqno = seqno;
+			rc |= POLLIN | POLLRDNORM;
+		}
+	}
+
 	return rc;
 }
 
+static void cam_sync_status_map_release(struct kref *kref)
+{
+	struct cam_sync_status_map_ref *map_ref = container_of(kref,
+		struct cam_sync_status_map_ref, kref);
+
+	vfree(map_ref->entries);
+	kfree(map_ref);
+}
+
+static void cam_sync_status_map_vm_open(struct vm_area_struct *vma)
+{
+	struct cam_sync_status_map_ref *map_ref = vma->vm_private_data;
+
+	kref_get(&map_ref->kref);
+}
+
+static void cam_sync_status_map_vm_close(struct vm_area_struct *vma)
+{
+	struct cam_sync_status_map_ref *map_ref = vma->vm_private_data;
+
+	kref_put(&map_ref->kref, cam_sync_status_map_release);
+}
+
+static const struct vm_operations_struct cam_sync_status_map_vm_ops = {
+	.open = cam_sync_status_map_vm_open,
+	.close = cam_sync_status_map_vm_close,
+};
+
+static int cam_sync_mmap(struct file *filep, struct vm_area_struct *vma)
+{
+	int rc;
+	unsigned long size = vma->vm_end - vma->vm_start;
+
+	if (!sync_dev->status_map)
+		return -ENODEV;
+
+	if (vma->vm_pgoff || size > CAM_SYNC_STATUS_MAP_SIZE) {
+		CAM_ERR(CAM_SYNC, "Invalid status map offset %lu size %lu",
+			vma->vm_pgoff, size);
+		return -EINVAL;
+	}
+
+	/* Status array is owned by kernel, user space may only read it */
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+	vma->vm_flags &= ~VM_MAYWRITE;
+
+	rc = remap_vmalloc_range(vma, sync_dev->status_map, 0);
+	if (rc)
+		return rc;
+
+	/* Mapping may outlive the device, it holds its own reference */
+	vma->vm_private_data = sync_dev->status_map_ref;
+	vma->vm_ops = &cam_sync_status_map_vm_ops;
+	kref_get(&sync_dev->status_map_ref->kref);
+
+	return 0;
+}
+
 static int cam_sync_open(struct file *filep)
 {
 	int rc;
@@ -981,6 +1473,7 @@ static struct v4l2_file_operations cam_sync_v4l2_fops = {
 	.open  = cam_sync_open,
 	.release = cam_sync_close,
 	.poll = cam_sync_poll,
+	.mmap = cam_sync_mmap,
 	.unlocked_ioctl   = video_ioctl2,
 #ifdef CONFIG_COMPAT
 	.compat_ioctl32 = video_ioctl2,
@@ -1050,6 +1543,37 @@ static void cam_sync_init_entity(struct sync_device *sync_dev)
 }
 #endif
 
+static int cam_sync_dispatch_stats_open(struct inode *inode,
+	struct file *file)
+{
+	file->private_data = inode->i_private;
+	return 0;
+}
+
+static ssize_t cam_sync_dispatch_stats_read(struct file *file,
+	char __user *ubuf, size_t size, loff_t *ppos)
+{
+	struct sync_dispatch_stats *stats =
+		(struct sync_dispatch_stats *)file->private_data;
+	char buf[256];
+	int len;
+
+	len = scnprintf(buf, sizeof(buf),
+		"pool_alloc: %lld\nheap_alloc: %lld\ncb_dispatched: %lld\nwork_queued: %lld\nwork_saved: %lld\n",
+		atomic64_read(&stats->pool_alloc),
+		atomic64_read(&stats->heap_alloc),
+		atomic64_read(&stats->cb_dispatched),
+		atomic64_read(&stats->work_queued),
+		atomic64_read(&stats->work_saved));
+
+	return simple_read_from_buffer(ubuf, size, ppos, buf, len);
+}
+
+static const struct file_operations cam_sync_dispatch_stats_fops = {
+	.open = cam_sync_dispatch_stats_open,
+	.read = cam_sync_dispatch_stats_read,
+};
+
 static int cam_sync_create_debugfs(void)
 {
 	int rc = 0;
@@ -1071,7 +1595,21 @@ static int cam_sync_create_debugfs(void)
 			CAM_WARN(CAM_SYNC, "DebugFS not enabled in kernel!");
 		else
 			rc = PTR_ERR(dbgfileptr);
+		goto end;
+	}
+
+	dbgfileptr = debugfs_create_bool("batch_cb_dispatch", 0644,
+		sync_dev->dentry, &batch_cb_dispatch);
+	if (IS_ERR(dbgfileptr)) {
+		rc = PTR_ERR(dbgfileptr);
+		goto end;
 	}
+
+	dbgfileptr = debugfs_create_file("dispatch_stats", 0444,
+		sync_dev->dentry, &sync_dev->dispatch_stats,
+		&cam_sync_dispatch_stats_fops);
+	if (IS_ERR(dbgfileptr))
+		rc = PTR_ERR(dbgfileptr);
 end:
 	return rc;
 }
@@ -1160,6 +1698,25 @@ static int cam_sync_component_bind(struct device *dev,
 
 	mutex_init(&sync_dev->table_lock);
 	spin_lock_init(&sync_dev->cam_sync_eventq_lock);
+	init_waitqueue_head(&sync_dev->signal_wait_q);
+	spin_lock_init(&sync_dev->status_map_lock);
+
+	BUILD_BUG_ON(CAM_SYNC_MAX_OBJS != CAM_SYNC_MAX_OBJS_UAPI);
+	sync_dev->status_map_ref = kzalloc(sizeof(*sync_dev->status_map_ref),
+		GFP_KERNEL);
+	if (!sync_dev->status_map_ref) {
+		rc = -ENOMEM;
+		goto status_map_fail;
+	}
+
+	sync_dev->status_map = vmalloc_user(CAM_SYNC_STATUS_MAP_SIZE);
+	if (!sync_dev->status_map) {
+		kfree(sync_dev->status_map_ref);
+		rc = -ENOMEM;
+		goto status_map_fail;
+	}
+	kref_init(&sync_dev->status_map_ref->kref);
+	sync_dev->status_map_ref->entries = sync_dev->status_map;
 
 	for (idx = 0; idx < CAM_SYNC_MAX_OBJS; idx++)
 		spin_lock_init(&sync_dev->row_spinlocks[idx]);
@@ -1219,7 +1776,9 @@ static int cam_sync_component_bind(struct device *dev,
 		goto v4l2_fail;
 	}
 
+	cam_sync_util_init_node_pool();
 	trigger_cb_without_switch = false;
+	batch_cb_dispatch = true;
 	cam_sync_create_debugfs();
 #if IS_REACHABLE(CONFIG_MSM_GLOBAL_SYNX)
 	CAM_DBG(CAM_SYNC, "Registering with synx driver");
@@ -1239,6 +1798,8 @@ mcinit_fail:
 	video_unregister_device(sync_dev->vdev);
 	video_device_release(sync_dev->vdev);
 vdev_fail:
+	kref_put(&sync_dev->status_map_ref->kref, cam_sync_status_map_release);
+status_map_fail:
 	mutex_destroy(&sync_dev->table_lock);
 	kfree(sync_dev);
 	return rc;
@@ -1262,6 +1823,8 @@ static void cam_sync_component_unbind(struct device *dev,
 	for (i = 0; i < CAM_SYNC_MAX_OBJS; i++)
 		spin_lock_init(&sync_dev->row_spinlocks[i]);
 
+	/* Freed here unless user space still has it mapped */
+	kref_put(&sync_dev->status_map_ref->kref, cam_sync_status_map_release);
 	kfree(sync_dev);
 	sync_dev = NULL;
 }
@@ -10,6 +10,7 @@
 #include <linux/videodev2.h>
 #include <linux/workqueue.h>
 #include <linux/interrupt.h>
+#include <linux/kref.h>
 #include <linux/debugfs.h>
 #include <media/v4l2-fh.h>
 #include <media/v4l2-device.h>
@@ -37,6 +38,11 @@
 #define CAM_SYNC_PAYLOAD_WORDS          2
 #define CAM_SYNC_NAME                   "cam_sync"
 #define CAM_SYNC_WORKQUEUE_NAME         "HIPRIO_SYNC_WORK_QUEUE"
+#define CAM_SYNC_CB_POOL_SIZE           256
+#define CAM_SYNC_PAYLOAD_POOL_SIZE      256
+#define CAM_SYNC_BATCH_POOL_SIZE        64
+#define CAM_SYNC_STATUS_MAP_SIZE        \
+	PAGE_ALIGN(CAM_SYNC_MAX_OBJS * sizeof(struct cam_sync_status_entry))
 
 #define CAM_SYNC_TYPE_INDV              0
 #define CAM_SYNC_TYPE_GROUP             1
@@ -124,6 +130,63 @@ struct sync_user_payload {
 	struct list_head list;
 };
 
+/**
+ * struct sync_cb_batch - Group of kernel callbacks dispatched from a
+ * single work item
+ *
+ * @cb_list            : Callbacks to be invoked, in signaling order
+ * @num_cb             : Number of callbacks in cb_list
+ * @workq_scheduled_ts : workqueue scheduled timestamp
+ * @batch_dispatch_work: Work representing the batch dispatch
+ * @list               : List member used to keep this node in the pool
+ */
+struct sync_cb_batch {
+	struct list_head cb_list;
+	uint32_t num_cb;
+	ktime_t workq_scheduled_ts;
+	struct work_struct batch_dispatch_work;
+	struct list_head list;
+};
+
+/**
+ * struct sync_node_pool - Preallocated nodes for callbacks, user payloads
+ * and callback batches, falls back to heap when a free list runs dry
+ *
+ * @lock          : Spinlock protecting the free lists
+ * @cb_nodes      : Storage for callback nodes
+ * @free_cb       : Free list of callback nodes
+ * @payload_nodes : Storage for user payload nodes
+ * @free_payload  : Free list of user payload nodes
+ * @batch_nodes   : Storage for callback batches
+ * @free_batch    : Free list of callback batches
+ */
+struct sync_node_pool {
+	spinlock_t lock;
+	struct sync_callback_info cb_nodes[CAM_SYNC_CB_POOL_SIZE];
+	struct list_head free_cb;
+	struct sync_user_payload payload_nodes[CAM_SYNC_PAYLOAD_POOL_SIZE];
+	struct list_head free_payload;
+	struct sync_cb_batch batch_nodes[CAM_SYNC_BATCH_POOL_SIZE];
+	struct list_head free_batch;
+};
+
+/**
+ * struct sync_dispatch_stats - Counters for callback dispatch
+ *
+ * @pool_alloc    : Nodes served from the pool, i.e. heap allocations saved
+ * @heap_alloc    : Nodes allocated from heap as the pool was exhausted
+ * @cb_dispatched : Kernel callbacks dispatched through the workqueue
+ * @work_queued   : Work items queued for callback dispatch
+ * @work_saved    : Work items, hence context switches, saved by batching
+ */
+struct sync_dispatch_stats {
+	atomic64_t pool_alloc;
+	atomic64_t heap_alloc;
+	atomic64_t cb_dispatched;
+	atomic64_t work_queued;
+	atomic64_t work_saved;
+};
+
 /**
  * struct sync_table_row - Single row of information about a sync object, used
  * for internal book keeping in the sync driver
@@ -171,6 +234,45 @@ struct cam_signalable_info {
 	struct list_head list;
 };
 
+/**
+ * struct cam_sync_batch_entry - Per object state of a batch signal
+ *
+ * @sync_obj     : Sync object to be signaled
+ * @status       : Status with which to signal
+ * @signaled     : Set if this call moved the object out of ACTIVE
+ * @parents_list : Parents of the object, detached while signaling
+ */
+struct cam_sync_batch_entry {
+	int32_t sync_obj;
+	uint32_t status;
+	bool signaled;
+	struct list_head parents_list;
+};
+
+/**
+ * struct cam_sync_parent_signal - Aggregated signal towards a merged object
+ *
+ * @sync_id      : Sync id of the merged object
+ * @num_signaled : Number of its children signaled in the batch
+ * @status       : Combined status of those children
+ */
+struct cam_sync_parent_signal {
+	int32_t sync_id;
+	uint32_t num_signaled;
+	uint32_t status;
+};
+
+/**
+ * struct cam_sync_status_map_ref - Lifetime of the status array buffer
+ *
+ * @kref    : One reference held by the device, one per user mapping
+ * @entries : vmalloc_user buffer backing the status array
+ */
+struct cam_sync_status_map_ref {
+	struct kref kref;
+	struct cam_sync_status_entry *entries;
+};
+
 /**
  * struct sync_device - Internal struct to book keep sync driver details
  *
@@ -186,6 +288,16 @@ struct cam_signalable_info {
  * @bitmap          : Bitmap representation of all sync objects
  * @params          : Parameters for synx call back registration
  * @version         : version support
+ * @signal_wait_q   : Wait queue woken on every signal, for batch waits
+ *                   and poll on status array updates
+ * @status_map      : Read-only mmap-able fence status array
+ * @status_map_ref  : Refcounted owner of status_map, keeps it alive for
+ *                   user mappings that outlive the device
+ * @status_map_lock : Lock serializing updates of the global seqno entry
+ * @poll_seqno      : Status array seqno last reported through poll, the
+ *                   device is single open so one copy is enough
+ * @node_pool       : Preallocated callback/payload/batch nodes
+ * @dispatch_stats  : Callback dispatch counters
  */
 struct sync_device {
 	struct video_device *vdev;
@@ -203,6 +315,13 @@ struct sync_device {
 	struct synx_register_params params;
 #endif
 	uint32_t version;
+	wait_queue_head_t signal_wait_q;
+	struct cam_sync_status_entry *status_map;
+	struct cam_sync_status_map_ref *status_map_ref;
+	spinlock_t status_map_lock;
+	uint32_t poll_seqno;
+	struct sync_node_pool node_pool;
+	struct sync_dispatch_stats dispatch_stats;
 };
 
 
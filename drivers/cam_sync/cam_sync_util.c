@@ -7,6 +7,171 @@
 #include "cam_req_mgr_workq.h"
 #include "cam_common_util.h"
 
+void cam_sync_util_init_node_pool(void)
+{
+	struct sync_node_pool *pool = &sync_dev->node_pool;
+	int i;
+
+	spin_lock_init(&pool->lock);
+	INIT_LIST_HEAD(&pool->free_cb);
+	INIT_LIST_HEAD(&pool->free_payload);
+	INIT_LIST_HEAD(&pool->free_batch);
+
+	for (i = 0; i < CAM_SYNC_CB_POOL_SIZE; i++)
+		list_add_tail(&pool->cb_nodes[i].list, &pool->free_cb);
+
+	for (i = 0; i < CAM_SYNC_PAYLOAD_POOL_SIZE; i++)
+		list_add_tail(&pool->payload_nodes[i].list,
+			&pool->free_payload);
+
+	for (i = 0; i < CAM_SYNC_BATCH_POOL_SIZE; i++)
+		list_add_tail(&pool->batch_nodes[i].list, &pool->free_batch);
+
+	atomic64_set(&sync_dev->dispatch_stats.pool_alloc, 0);
+	atomic64_set(&sync_dev->dispatch_stats.heap_alloc, 0);
+	atomic64_set(&sync_dev->dispatch_stats.cb_dispatched, 0);
+	atomic64_set(&sync_dev->dispatch_stats.work_queued, 0);
+	atomic64_set(&sync_dev->dispatch_stats.work_saved, 0);
+}
+
+static struct list_head *cam_sync_util_pool_get(struct list_head *free_list)
+{
+	struct list_head *node = NULL;
+
+	spin_lock_bh(&sync_dev->node_pool.lock);
+	if (!list_empty(free_list)) {
+		node = free_list->next;
+		list_del_init(node);
+	}
+	spin_unlock_bh(&sync_dev->node_pool.lock);
+
+	if (node)
+		atomic64_inc(&sync_dev->dispatch_stats.pool_alloc);
+	else
+		atomic64_inc(&sync_dev->dispatch_stats.heap_alloc);
+
+	return node;
+}
+
+static void cam_sync_util_pool_put(struct list_head *node,
+	struct list_head *free_list)
+{
+	spin_lock_bh(&sync_dev->node_pool.lock);
+	list_add(node, free_list);
+	spin_unlock_bh(&sync_dev->node_pool.lock);
+}
+
+#define CAM_SYNC_NODE_IN_POOL(node, nodes) \
+	(((node) >= &(nodes)[0]) && ((node) < &(nodes)[ARRAY_SIZE(nodes)]))
+
+struct sync_callback_info *cam_sync_util_alloc_cb(void)
+{
+	struct sync_callback_info *sync_cb;
+	struct list_head *node;
+
+	node = cam_sync_util_pool_get(&sync_dev->node_pool.free_cb);
+	if (!node)
+		return kzalloc(sizeof(*sync_cb), GFP_ATOMIC);
+
+	sync_cb = list_entry(node, struct sync_callback_info, list);
+	memset(sync_cb, 0, sizeof(*sync_cb));
+	INIT_LIST_HEAD(&sync_cb->list);
+
+	return sync_cb;
+}
+
+void cam_sync_util_free_cb(struct sync_callback_info *sync_cb)
+{
+	if (!CAM_SYNC_NODE_IN_POOL(sync_cb, sync_dev->node_pool.cb_nodes)) {
+		kfree(sync_cb);
+		return;
+	}
+
+	cam_sync_util_pool_put(&sync_cb->list, &sync_dev->node_pool.free_cb);
+}
+
+struct sync_user_payload *cam_sync_util_alloc_payload(void)
+{
+	struct sync_user_payload *payload;
+	struct list_head *node;
+
+	node = cam_sync_util_pool_get(&sync_dev->node_pool.free_payload);
+	if (!node)
+		return kzalloc(sizeof(*payload), GFP_ATOMIC);
+
+	payload = list_entry(node, struct sync_user_payload, list);
+	memset(payload, 0, sizeof(*payload));
+	INIT_LIST_HEAD(&payload->list);
+
+	return payload;
+}
+
+void cam_sync_util_free_payload(struct sync_user_payload *payload)
+{
+	if (!CAM_SYNC_NODE_IN_POOL(payload,
+		sync_dev->node_pool.payload_nodes)) {
+		kfree(payload);
+		return;
+	}
+
+	cam_sync_util_pool_put(&payload->list,
+		&sync_dev->node_pool.free_payload);
+}
+
+static struct sync_cb_batch *cam_sync_util_alloc_batch(void)
+{
+	struct sync_cb_batch *batch;
+	struct list_head *node;
+
+	node = cam_sync_util_pool_get(&sync_dev->node_pool.free_batch);
+	if (!node)
+		batch = kzalloc(sizeof(*batch), GFP_ATOMIC);
+	else
+		batch = list_entry(node, struct sync_cb_batch, list);
+
+	if (!batch)
+		return NULL;
+
+	INIT_LIST_HEAD(&batch->cb_list);
+	INIT_LIST_HEAD(&batch->list);
+	batch->num_cb = 0;
+	INIT_WORK(&batch->batch_dispatch_work,
+		cam_sync_util_batch_cb_dispatch);
+
+	return batch;
+}
+
+static void cam_sync_util_free_batch(struct sync_cb_batch *batch)
+{
+	if (!CAM_SYNC_NODE_IN_POOL(batch, sync_dev->node_pool.batch_nodes)) {
+		kfree(batch);
+		return;
+	}
+
+	cam_sync_util_pool_put(&batch->list, &sync_dev->node_pool.free_batch);
+}
+
+void cam_sync_util_publish_state(int32_t sync_obj, uint32_t state)
+{
+	struct cam_sync_status_entry *entry;
+
+	if (!sync_dev->status_map)
+		return;
+
+	entry = &sync_dev->status_map[sync_obj];
+	WRITE_ONCE(entry->seqno, entry->seqno + 1);
+	smp_wmb();
+	WRITE_ONCE(entry->state, state);
+	smp_wmb();
+	WRITE_ONCE(entry->seqno, entry->seqno + 1);
+
+	/* Entry 0 is never a valid object, it counts all updates */
+	entry = &sync_dev->status_map[0];
+	spin_lock(&sync_dev->status_map_lock);
+	WRITE_ONCE(entry->seqno, entry->seqno + 2);
+	spin_unlock(&sync_dev->status_map_lock);
+}
+
 int cam_sync_util_find_and_set_empty_row(struct sync_device *sync_dev,
 	long *idx)
 {
@@ -45,6 +210,7 @@ int cam_sync_init_row(struct sync_table_row *table,
 	row->state = CAM_SYNC_STATE_ACTIVE;
 	row->remaining = 0;
 	atomic_set(&row->ref_cnt, 0);
+	cam_sync_util_publish_state(idx, row->state);
 	init_completion(&row->signaled);
 	INIT_LIST_HEAD(&row->callback_list);
 	INIT_LIST_HEAD(&row->user_payload_list);
@@ -129,6 +295,7 @@ int cam_sync_init_group_object(struct sync_table_row *table,
 		if ((row->state != CAM_SYNC_STATE_SIGNALED_ERROR) &&
 			(row->state != CAM_SYNC_STATE_SIGNALED_CANCEL))
 			row->state = CAM_SYNC_STATE_SIGNALED_SUCCESS;
+		cam_sync_util_publish_state(idx, row->state);
 		complete_all(&row->signaled);
 	}
 
@@ -136,6 +303,7 @@ int cam_sync_init_group_object(struct sync_table_row *table,
 
 clean_children_info:
 	row->state = CAM_SYNC_STATE_INVALID;
+	cam_sync_util_publish_state(idx, row->state);
 	for (i = i-1; i >= 0; i--) {
 		spin_lock_bh(&sync_dev->row_spinlocks[sync_objs[i]]);
 		child_row = table + sync_objs[i];
@@ -180,6 +348,9 @@ int cam_sync_deinit_object(struct sync_table_row *table, uint32_t idx)
 			row->name, row->sync_id);
 
 	row->state = CAM_SYNC_STATE_INVALID;
+	/* Batch waiters sleep on the device queue, not on row->signaled */
+	if (wq_has_sleeper(&sync_dev->signal_wait_q))
+		wake_up_all(&sync_dev->signal_wait_q);
 
 	/* Object's child and parent objects will be added into this list */
 	INIT_LIST_HEAD(&temp_child_list);
@@ -267,16 +438,17 @@ int cam_sync_deinit_object(struct sync_table_row *table, uint32_t idx)
 	list_for_each_entry_safe(upayload_info, temp_upayload,
 			&row->user_payload_list, list) {
 		list_del_init(&upayload_info->list);
-		kfree(upayload_info);
+		cam_sync_util_free_payload(upayload_info);
 	}
 
 	list_for_each_entry_safe(sync_cb, temp_cb,
 			&row->callback_list, list) {
 		list_del_init(&sync_cb->list);
-		kfree(sync_cb);
+		cam_sync_util_free_cb(sync_cb);
 	}
 
 	memset(row, 0, sizeof(*row));
+	cam_sync_util_publish_state(idx, CAM_SYNC_STATE_INVALID);
 	clear_bit(idx, sync_dev->bitmap);
 	INIT_LIST_HEAD(&row->callback_list);
 	INIT_LIST_HEAD(&row->parents_list);
@@ -301,11 +473,75 @@ void cam_sync_util_cb_dispatch(struct work_struct *cb_dispatch_work)
 		CAM_WORKQ_SCHEDULE_TIME_THRESHOLD);
 	sync_data(cb_info->sync_obj, cb_info->status, cb_info->cb_data);
 
-	kfree(cb_info);
+	cam_sync_util_free_cb(cb_info);
+}
+
+void cam_sync_util_batch_cb_dispatch(struct work_struct *batch_dispatch_work)
+{
+	struct sync_cb_batch *batch = container_of(batch_dispatch_work,
+		struct sync_cb_batch, batch_dispatch_work);
+	struct sync_callback_info *cb_info, *temp_cb_info;
+
+	cam_common_util_thread_switch_delay_detect(
+		"CAM-SYNC batch workq schedule",
+		batch->workq_scheduled_ts,
+		CAM_WORKQ_SCHEDULE_TIME_THRESHOLD);
+
+	list_for_each_entry_safe(cb_info, temp_cb_info, &batch->cb_list,
+		list) {
+		list_del_init(&cb_info->list);
+		cb_info->callback_func(cb_info->sync_obj, cb_info->status,
+			cb_info->cb_data);
+		cam_sync_util_free_cb(cb_info);
+	}
+
+	cam_sync_util_free_batch(batch);
+}
+
+static void cam_sync_util_queue_cb(struct sync_callback_info *sync_cb)
+{
+	sync_cb->workq_scheduled_ts = ktime_get();
+	atomic64_inc(&sync_dev->dispatch_stats.cb_dispatched);
+	atomic64_inc(&sync_dev->dispatch_stats.work_queued);
+	queue_work(sync_dev->work_queue, &sync_cb->cb_dispatch_work);
+}
+
+void cam_sync_util_queue_cb_list(struct list_head *cb_list)
+{
+	struct sync_callback_info *sync_cb, *temp_sync_cb;
+	struct sync_cb_batch *batch = NULL;
+
+	if (list_empty(cb_list))
+		return;
+
+	/* A single callback gains nothing from a batch */
+	if (!list_is_singular(cb_list))
+		batch = cam_sync_util_alloc_batch();
+
+	if (!batch) {
+		list_for_each_entry_safe(sync_cb, temp_sync_cb, cb_list,
+			list) {
+			list_del_init(&sync_cb->list);
+			cam_sync_util_queue_cb(sync_cb);
+		}
+		return;
+	}
+
+	list_for_each_entry(sync_cb, cb_list, list)
+		batch->num_cb++;
+	list_splice_init(cb_list, &batch->cb_list);
+
+	atomic64_add(batch->num_cb, &sync_dev->dispatch_stats.cb_dispatched);
+	atomic64_inc(&sync_dev->dispatch_stats.work_queued);
+	atomic64_add(batch->num_cb - 1, &sync_dev->dispatch_stats.work_saved);
+	CAM_DBG(CAM_SYNC, "Enqueue batch of %u callbacks", batch->num_cb);
+
+	batch->workq_scheduled_ts = ktime_get();
+	queue_work(sync_dev->work_queue, &batch->batch_dispatch_work);
 }
 
 void cam_sync_util_dispatch_signaled_cb(int32_t sync_obj,
-	uint32_t status, uint32_t event_cause)
+	uint32_t status, uint32_t event_cause, struct list_head *cb_list)
 {
 	struct sync_callback_info  *sync_cb;
 	struct sync_user_payload   *payload_info;
@@ -320,13 +556,17 @@ void cam_sync_util_dispatch_signaled_cb(int32_t sync_obj,
 		return;
 	}
 
+	cam_sync_util_publish_state(sync_obj, signalable_row->state);
+
 	/* Dispatch kernel callbacks if any were registered earlier */
 	list_for_each_entry_safe(sync_cb,
 		temp_sync_cb, &signalable_row->callback_list, list) {
 		sync_cb->status = status;
 		list_del_init(&sync_cb->list);
-		queue_work(sync_dev->work_queue,
-			&sync_cb->cb_dispatch_work);
+		if (cb_list)
+			list_add_tail(&sync_cb->list, cb_list);
+		else
+			cam_sync_util_queue_cb(sync_cb);
 	}
 
 	/* Dispatch user payloads if any were registered earlier */
@@ -353,7 +593,7 @@ void cam_sync_util_dispatch_signaled_cb(int32_t sync_obj,
 		 * sending V4L event will make a deep copy
 		 * anyway
 		 */
-		 kfree(payload_info);
+		cam_sync_util_free_payload(payload_info);
 	}
 
 	/*
@@ -361,6 +601,8 @@ void cam_sync_util_dispatch_signaled_cb(int32_t sync_obj,
 	 * who might be blocked and waiting on this sync object
 	 */
 	complete_all(&signalable_row->signaled);
+	if (wq_has_sleeper(&sync_dev->signal_wait_q))
+		wake_up_all(&sync_dev->signal_wait_q);
 }
 
 void cam_sync_util_send_v4l2_event(uint32_t id,
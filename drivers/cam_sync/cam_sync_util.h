@@ -78,17 +78,89 @@ int cam_sync_deinit_object(struct sync_table_row *table, uint32_t idx);
  */
 void cam_sync_util_cb_dispatch(struct work_struct *cb_dispatch_work);
 
+/**
+ * @brief: Function to dispatch a batch of kernel callbacks
+ *
+ * @param batch_dispatch_work : Pointer to the work_struct of the batch
+ *
+ * @return None
+ */
+void cam_sync_util_batch_cb_dispatch(struct work_struct *batch_dispatch_work);
+
 /**
  * @brief: Function to dispatch callbacks for a signaled sync object
  *
  * @sync_obj    : Sync object that is signaled
  * @status      : Status of the signaled object
  * @evt_param   : Event paramaeter
+ * @cb_list     : If not NULL, kernel callbacks are moved to this list to be
+ *                dispatched later through cam_sync_util_queue_cb_list
+ *                instead of queueing one work item per callback
  *
  * @return None
  */
 void cam_sync_util_dispatch_signaled_cb(int32_t sync_obj,
-	uint32_t status, uint32_t evt_param);
+	uint32_t status, uint32_t evt_param, struct list_head *cb_list);
+
+/**
+ * @brief: Function to queue a list of callbacks gathered while signaling
+ *         using as few work items as possible
+ *
+ * @cb_list     : List of sync_callback_info to be dispatched
+ *
+ * @return None
+ */
+void cam_sync_util_queue_cb_list(struct list_head *cb_list);
+
+/**
+ * @brief: Function to publish state of a sync object to the mmap-able
+ *         status array, to be called with the row spinlock held
+ *
+ * @sync_obj    : Sync object whose state changed
+ * @state       : New state of the sync object
+ *
+ * @return None
+ */
+void cam_sync_util_publish_state(int32_t sync_obj, uint32_t state);
+
+/**
+ * @brief: Function to initialize the callback/payload/batch node pool
+ *
+ * @return None
+ */
+void cam_sync_util_init_node_pool(void);
+
+/**
+ * @brief: Function to get a zeroed callback node, from pool if available
+ *
+ * @return Callback node or NULL on failure
+ */
+struct sync_callback_info *cam_sync_util_alloc_cb(void);
+
+/**
+ * @brief: Function to release a callback node
+ *
+ * @sync_cb     : Node returned by cam_sync_util_alloc_cb
+ *
+ * @return None
+ */
+void cam_sync_util_free_cb(struct sync_callback_info *sync_cb);
+
+/**
+ * @brief: Function to get a zeroed user payload node, from pool if available
+ *
+ * @return User payload node or NULL on failure
+ */
+struct sync_user_payload *cam_sync_util_alloc_payload(void);
+
+/**
+ * @brief: Function to release a user payload node
+ *
+ * @payload     : Node returned by cam_sync_util_alloc_payload
+ *
+ * @return None
+ */
+void cam_sync_util_free_payload(struct sync_user_payload *payload);
 
 /**
  * @brief: Function to send V4L event to user space
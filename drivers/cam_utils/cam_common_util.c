@@ -6,10 +6,26 @@
 #include <linux/string.h>
 #include <linux/types.h>
 #include <linux/slab.h>
+#include <linux/mutex.h>
+#include <linux/math64.h>
 
 #include "cam_common_util.h"
 #include "cam_debug_util.h"
 
+static LIST_HEAD(cam_common_lat_list);
+static DEFINE_MUTEX(cam_common_lat_mutex);
+
+static const char *cam_common_lat_stage_name[CAM_COMMON_LAT_STAGE_MAX] = {
+	"config_dev",
+	"add_req",
+	"apply",
+	"cdm_submit",
+	"cdm_done",
+	"sof",
+	"buf_done",
+	"fence_signal",
+};
+
 int cam_common_util_get_string_index(const char **strings,
 	uint32_t num_strings, const char *matching_string, uint32_t *index)
 {
@@ -72,3 +88,186 @@ void cam_common_util_thread_switch_delay_detect(
 	}
 
 }
+
+static void cam_common_lat_hist_add(struct cam_common_lat_hist *hist,
+	int64_t delta_us)
+{
+	uint32_t idx;
+	int64_t old, prev;
+
+	if (delta_us < 0)
+		delta_us = 0;
+
+	idx = min_t(uint32_t, fls64(delta_us), CAM_COMMON_LAT_BUCKETS - 1);
+	atomic64_inc(&hist->bucket[idx]);
+	atomic64_inc(&hist->count);
+	atomic64_add(delta_us, &hist->sum_us);
+
+	old = atomic64_read(&hist->max_us);
+	while (delta_us > old) {
+		prev = atomic64_cmpxchg(&hist->max_us, old, delta_us);
+		if (prev == old)
+			break;
+		old = prev;
+	}
+}
+
+static void cam_common_lat_hist_reset(struct cam_common_lat_hist *hist)
+{
+	int i;
+
+	for (i = 0; i < CAM_COMMON_LAT_BUCKETS; i++)
+		atomic64_set(&hist->bucket[i], 0);
+	atomic64_set(&hist->count, 0);
+	atomic64_set(&hist->sum_us, 0);
+	atomic64_set(&hist->max_us, 0);
+}
+
+/* Upper bound of the bucket holding the pct percentile, capped by max */
+static uint64_t cam_common_lat_hist_percentile(
+	struct cam_common_lat_hist *hist, uint64_t count, uint32_t pct)
+{
+	int i;
+	uint64_t target, cum = 0;
+	uint64_t max_us = atomic64_read(&hist->max_us);
+
+	target = div_u64(count * pct + 99, 100);
+	for (i = 0; i < CAM_COMMON_LAT_BUCKETS - 1; i++) {
+		cum += atomic64_read(&hist->bucket[i]);
+		if (cum >= target)
+			return min_t(uint64_t, i ? BIT_ULL(i) : 0, max_us);
+	}
+
+	return max_us;
+}
+
+void cam_common_lat_register(struct cam_common_lat_tracker *tracker,
+	const char *name)
+{
+	int i;
+
+	if (!tracker)
+		return;
+
+	spin_lock_init(&tracker->lock);
+	memset(tracker->slot, 0, sizeof(tracker->slot));
+	for (i = 0; i < CAM_COMMON_LAT_STAGE_MAX; i++)
+		cam_common_lat_hist_reset(&tracker->hist[i]);
+	strlcpy(tracker->name, name, sizeof(tracker->name));
+
+	mutex_lock(&cam_common_lat_mutex);
+	list_add_tail(&tracker->list, &cam_common_lat_list);
+	mutex_unlock(&cam_common_lat_mutex);
+}
+
+void cam_common_lat_unregister(struct cam_common_lat_tracker *tracker)
+{
+	/* Zeroed tracker that never got registered */
+	if (!tracker || !tracker->list.next)
+		return;
+
+	mutex_lock(&cam_common_lat_mutex);
+	list_del_init(&tracker->list);
+	mutex_unlock(&cam_common_lat_mutex);
+}
+
+void cam_common_lat_stamp(struct cam_common_lat_tracker *tracker,
+	int64_t req_id, enum cam_common_lat_stage stage)
+{
+	int                              prev;
+	ktime_t                          cur_time, prev_time = 0;
+	unsigned long                    flags;
+	struct cam_common_lat_slot      *slot;
+
+	if (!tracker || (req_id <= 0) || (stage >= CAM_COMMON_LAT_STAGE_MAX))
+		return;
+
+	/* Zeroed tracker that never got registered, lock is not set up */
+	if (!tracker->list.next)
+		return;
+
+	cur_time = ktime_get();
+	slot = &tracker->slot[req_id & (CAM_COMMON_LAT_SLOTS - 1)];
+
+	spin_lock_irqsave(&tracker->lock, flags);
+	if (slot->req_id != req_id) {
+		memset(slot->ts, 0, sizeof(slot->ts));
+		slot->req_id = req_id;
+	}
+
+	if (slot->ts[stage]) {
+		spin_unlock_irqrestore(&tracker->lock, flags);
+		return;
+	}
+	slot->ts[stage] = cur_time;
+
+	for (prev = stage - 1; prev >= 0; prev--) {
+		if (slot->ts[prev]) {
+			prev_time = slot->ts[prev];
+			break;
+		}
+	}
+	spin_unlock_irqrestore(&tracker->lock, flags);
+
+	if (prev_time)
+		cam_common_lat_hist_add(&tracker->hist[stage],
+			ktime_us_delta(cur_time, prev_time));
+}
+
+void cam_common_lat_reset_all(void)
+{
+	int i;
+	struct cam_common_lat_tracker *tracker;
+
+	mutex_lock(&cam_common_lat_mutex);
+	list_for_each_entry(tracker, &cam_common_lat_list, list) {
+		for (i = 0; i < CAM_COMMON_LAT_STAGE_MAX; i++)
+			cam_common_lat_hist_reset(&tracker->hist[i]);
+	}
+	mutex_unlock(&cam_common_lat_mutex);
+}
+
+size_t cam_common_lat_dump_all(char *buf, size_t size)
+{
+	int                              i, j;
+	size_t                           len = 0;
+	uint64_t                         count, cnt;
+	struct cam_common_lat_hist      *hist;
+	struct cam_common_lat_tracker   *tracker;
+
+	mutex_lock(&cam_common_lat_mutex);
+	list_for_each_entry(tracker, &cam_common_lat_list, list) {
+		len += scnprintf(buf + len, size - len, "%s\n",
+			tracker->name);
+		for (i = 0; i < CAM_COMMON_LAT_STAGE_MAX; i++) {
+			hist = &tracker->hist[i];
+			count = atomic64_read(&hist->count);
+			if (!count)
+				continue;
+
+			len += scnprintf(buf + len, size - len,
+				"  %-12s cnt %llu avg %llu p50 %llu p90 %llu p99 %llu max %lld us\n   ",
+				cam_common_lat_stage_name[i], count,
+				div64_u64(atomic64_read(&hist->sum_us), count),
+				cam_common_lat_hist_percentile(hist, count, 50),
+				cam_common_lat_hist_percentile(hist, count, 90),
+				cam_common_lat_hist_percentile(hist, count, 99),
+				atomic64_read(&hist->max_us));
+			for (j = 0; j < CAM_COMMON_LAT_BUCKETS; j++) {
+				cnt = atomic64_read(&hist->bucket[j]);
+				if (!cnt)
+					continue;
+				if (j == CAM_COMMON_LAT_BUCKETS - 1)
+					len += scnprintf(buf + len, size - len,
+						" >=%llu:%llu", BIT_ULL(j - 1), cnt);
+				else
+					len += scnprintf(buf + len, size - len,
+						" <%llu:%llu", BIT_ULL(j), cnt);
+			}
+			len += scnprintf(buf + len, size - len, "\n");
+		}
+	}
+	mutex_unlock(&cam_common_lat_mutex);
+
+	return len;
+}
@@ -8,6 +8,10 @@
 
 #include <linux/types.h>
 #include <linux/kernel.h>
+#include <linux/list.h>
+#include <linux/ktime.h>
+#include <linux/atomic.h>
+#include <linux/spinlock.h>
 
 #define CAM_BITS_MASK_SHIFT(x, mask, shift) (((x) & (mask)) >> shift)
 
@@ -41,6 +45,74 @@
 	(hrs) = do_div(tmp, 24);                                                             \
 })
 
+/* Requests tracked concurrently per latency tracker, power of 2 */
+#define CAM_COMMON_LAT_SLOTS           64
+/* Bucket 0 holds 0us, bucket n holds [2^(n-1), 2^n) us, last one the rest */
+#define CAM_COMMON_LAT_BUCKETS         24
+#define CAM_COMMON_LAT_NAME_LEN        32
+
+/**
+ * enum cam_common_lat_stage - Request life cycle stages
+ *
+ * Each stage's histogram records the time since the closest earlier
+ * stage that was stamped for the same request.
+ */
+enum cam_common_lat_stage {
+	CAM_COMMON_LAT_CONFIG_DEV,
+	CAM_COMMON_LAT_ADD_REQ,
+	CAM_COMMON_LAT_APPLY,
+	CAM_COMMON_LAT_CDM_SUBMIT,
+	CAM_COMMON_LAT_CDM_DONE,
+	CAM_COMMON_LAT_SOF,
+	CAM_COMMON_LAT_BUF_DONE,
+	CAM_COMMON_LAT_FENCE_SIGNAL,
+	CAM_COMMON_LAT_STAGE_MAX,
+};
+
+/**
+ * struct cam_common_lat_slot - Stage timestamps of one request
+ *
+ * @req_id:                Request id owning the slot
+ * @ts:                    Time each stage was first reached, 0 if not yet
+ */
+struct cam_common_lat_slot {
+	int64_t    req_id;
+	ktime_t    ts[CAM_COMMON_LAT_STAGE_MAX];
+};
+
+/**
+ * struct cam_common_lat_hist - log2 latency histogram
+ *
+ * @bucket:                Sample count per log2 microsecond bucket
+ * @count:                 Total number of samples
+ * @sum_us:                Sum of all samples
+ * @max_us:                Largest sample
+ */
+struct cam_common_lat_hist {
+	atomic64_t bucket[CAM_COMMON_LAT_BUCKETS];
+	atomic64_t count;
+	atomic64_t sum_us;
+	atomic64_t max_us;
+};
+
+/**
+ * struct cam_common_lat_tracker - Per link or per context latency tracker
+ *
+ * @list:                  Node in the registered tracker list
+ * @name:                  Name shown in the debugfs dump
+ * @lock:                  Serializes slot claim and stamp, callers run in
+ *                         both IRQ and worker context
+ * @slot:                  Stage timestamps of the in flight requests
+ * @hist:                  Histogram per stage
+ */
+struct cam_common_lat_tracker {
+	struct list_head               list;
+	char                           name[CAM_COMMON_LAT_NAME_LEN];
+	spinlock_t                     lock;
+	struct cam_common_lat_slot     slot[CAM_COMMON_LAT_SLOTS];
+	struct cam_common_lat_hist     hist[CAM_COMMON_LAT_STAGE_MAX];
+};
+
 /**
  * cam_common_util_get_string_index()
  *
@@ -85,4 +157,64 @@ uint32_t cam_common_util_remove_duplicate_arr(int32_t *array,
 void cam_common_util_thread_switch_delay_detect(const char *token,
 	ktime_t scheduled_time, uint32_t threshold);
 
+/**
+ * cam_common_lat_register()
+ *
+ * @brief                  Reset a latency tracker and add it to the list
+ *                         dumped through debugfs
+ *
+ * @tracker:               Tracker to register
+ * @name:                  Name shown in the dump
+ *
+ */
+void cam_common_lat_register(struct cam_common_lat_tracker *tracker,
+	const char *name);
+
+/**
+ * cam_common_lat_unregister()
+ *
+ * @brief                  Remove a latency tracker from the dump list
+ *
+ * @tracker:               Tracker to unregister
+ *
+ */
+void cam_common_lat_unregister(struct cam_common_lat_tracker *tracker);
+
+/**
+ * cam_common_lat_stamp()
+ *
+ * @brief                  Record that a request reached a stage. Only the
+ *                         first stamp of a stage per request is accounted.
+ *                         Takes the tracker spinlock with IRQs off for a
+ *                         few stores, can be called from any context.
+ *                         Stamps on an unregistered tracker are ignored.
+ *
+ * @tracker:               Tracker of the link or context, may be NULL
+ * @req_id:                Request id
+ * @stage:                 Stage reached
+ *
+ */
+void cam_common_lat_stamp(struct cam_common_lat_tracker *tracker,
+	int64_t req_id, enum cam_common_lat_stage stage);
+
+/**
+ * cam_common_lat_reset_all()
+ *
+ * @brief                  Clear the histograms of all registered trackers
+ *
+ */
+void cam_common_lat_reset_all(void);
+
+/**
+ * cam_common_lat_dump_all()
+ *
+ * @brief                  Print the histograms of all registered trackers
+ *
+ * @buf:                   Output buffer
+ * @size:                  Output buffer size
+ *
+ * @return:                Number of bytes written
+ */
+size_t cam_common_lat_dump_all(char *buf, size_t size);
+
 #endif /* _CAM_COMMON_UTIL_H_ */
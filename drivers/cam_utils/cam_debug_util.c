@@ -10,8 +10,8 @@
 
 #include "cam_debug_util.h"
 
-static uint debug_mdl;
-module_param(debug_mdl, uint, 0644);
+uint cam_debug_mdl;
+module_param_named(debug_mdl, cam_debug_mdl, uint, 0644);
 
 /* 0x0 - only logs, 0x1 - only trace, 0x2 - logs + trace */
 static uint debug_type;
@@ -257,7 +257,7 @@ const char *cam_get_tag_name(unsigned int tag_id)
 void cam_debug_log(unsigned int module_id, const char *func, const int line,
 	const char *fmt, ...)
 {
-	if (debug_mdl & module_id) {
+	if (cam_debug_mdl & module_id) {
 		char str_buffer[STR_BUFFER_MAX_LENGTH];
 		va_list args;
 
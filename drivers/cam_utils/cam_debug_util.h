@@ -53,6 +53,9 @@
 
 #define STR_BUFFER_MAX_LENGTH  512
 
+/* Bit mask of modules with debug logs enabled, debug_mdl module param */
+extern uint cam_debug_mdl;
+
 /**
  * struct cam_cpas_debug_settings - Sysfs debug settings for cpas driver
  */
@@ -205,14 +208,20 @@ const char *cam_get_module_name(unsigned int module_id);
 
 /*
  * CAM_DBG
- * @brief    :  This Macro will print debug logs when enabled using GROUP
+ * @brief    :  This Macro will print debug logs when enabled using GROUP.
+ *              The module mask is checked inline so that arguments are not
+ *              evaluated and no call is made while the module is disabled.
  *
  * @__module :  Respective module id which is been calling this Macro
  * @fmt      :  Formatted string which needs to be print in log
  * @args     :  Arguments which needs to be print in log
  */
-#define CAM_DBG(__module, fmt, args...)                            \
-	cam_debug_log(__module, __func__, __LINE__, fmt, ##args)
+#define CAM_DBG(__module, fmt, args...)                                        \
+	do {                                                                   \
+		if (unlikely(cam_debug_mdl & (__module)))                      \
+			cam_debug_log(__module, __func__, __LINE__,            \
+				fmt, ##args);                                  \
+	} while (0)
 
 /*
  * CAM_ERR_RATE_LIMIT
@@ -7,15 +7,229 @@
 #include <linux/delay.h>
 #include <linux/io.h>
 #include <linux/err.h>
+#include <linux/module.h>
+#include <linux/percpu.h>
+#include <linux/sched/clock.h>
+#include <linux/spinlock.h>
 #include "cam_io_util.h"
 #include "cam_debug_util.h"
 
+#define CAM_IO_TRACE_RING_SIZE       256
+#define CAM_IO_TRACE_MAX_BLOCKS      64
+#define CAM_IO_TRACE_DUMP_MAX        16
+
+enum cam_io_trace_op {
+	CAM_IO_TRACE_OP_WRITE,
+	CAM_IO_TRACE_OP_READ,
+};
+
+/**
+ * struct cam_io_trace_entry - Single register access record
+ *
+ * @timestamp:          local_clock() timestamp of the access in ns
+ * @addr:               Register address accessed
+ * @value:              Value written or read back
+ * @op:                 Access type, enum cam_io_trace_op
+ */
+struct cam_io_trace_entry {
+	uint64_t       timestamp;
+	void __iomem  *addr;
+	uint32_t       value;
+	uint8_t        op;
+};
+
+/**
+ * struct cam_io_trace_dump_entry - Resolved record copied out for dump
+ *
+ * @entry:              Copy of the ring record
+ * @block_name:         Name of the block holding the address, NULL if none
+ * @offset:             Offset of the address inside the block
+ */
+struct cam_io_trace_dump_entry {
+	struct cam_io_trace_entry   entry;
+	const char                 *block_name;
+	uint32_t                    offset;
+};
+
+/**
+ * struct cam_io_trace_ring - Per cpu ring of register access records
+ *
+ * @head:               Total number of records written to this ring
+ * @entries:            Ring storage, indexed by head modulo ring size
+ */
+struct cam_io_trace_ring {
+	uint32_t                    head;
+	struct cam_io_trace_entry   entries[CAM_IO_TRACE_RING_SIZE];
+};
+
+/**
+ * struct cam_io_trace_block - Register block known to the io tracer
+ *
+ * @name:               Name of the block, used to resolve dump addresses
+ * @base:               Mapped base address of the block
+ * @size:               Size of the mapped region
+ */
+struct cam_io_trace_block {
+	const char    *name;
+	void __iomem  *base;
+	resource_size_t size;
+};
+
+static bool io_trace_enable;
+module_param(io_trace_enable, bool, 0644);
+
+static DEFINE_PER_CPU(struct cam_io_trace_ring, cam_io_trace_rings);
+
+static DEFINE_SPINLOCK(cam_io_trace_block_lock);
+static struct cam_io_trace_block cam_io_trace_blocks[CAM_IO_TRACE_MAX_BLOCKS];
+
+static inline void cam_io_trace_record(uint8_t op, void __iomem *addr,
+	uint32_t value)
+{
+	struct cam_io_trace_ring  *ring;
+	struct cam_io_trace_entry *entry;
+	unsigned long              flags;
+
+	if (likely(!io_trace_enable))
+		return;
+
+	local_irq_save(flags);
+	ring = this_cpu_ptr(&cam_io_trace_rings);
+	entry = &ring->entries[ring->head % CAM_IO_TRACE_RING_SIZE];
+	entry->timestamp = local_clock();
+	entry->addr = addr;
+	entry->value = value;
+	entry->op = op;
+	ring->head++;
+	local_irq_restore(flags);
+}
+
+void cam_io_trace_register_block(const char *name, void __iomem *base,
+	resource_size_t size)
+{
+	int i;
+	unsigned long flags;
+
+	if (!base || !size)
+		return;
+
+	spin_lock_irqsave(&cam_io_trace_block_lock, flags);
+	for (i = 0; i < CAM_IO_TRACE_MAX_BLOCKS; i++) {
+		if (!cam_io_trace_blocks[i].base) {
+			cam_io_trace_blocks[i].name = name;
+			cam_io_trace_blocks[i].base = base;
+			cam_io_trace_blocks[i].size = size;
+			break;
+		}
+	}
+	spin_unlock_irqrestore(&cam_io_trace_block_lock, flags);
+
+	if (i == CAM_IO_TRACE_MAX_BLOCKS)
+		CAM_DBG(CAM_IO_ACCESS, "No free io trace slot for %s",
+			name ? name : "unknown");
+}
+
+void cam_io_trace_unregister_block(void __iomem *base)
+{
+	int i;
+	unsigned long flags;
+
+	if (!base)
+		return;
+
+	spin_lock_irqsave(&cam_io_trace_block_lock, flags);
+	for (i = 0; i < CAM_IO_TRACE_MAX_BLOCKS; i++) {
+		if (cam_io_trace_blocks[i].base == base) {
+			cam_io_trace_blocks[i].name = NULL;
+			cam_io_trace_blocks[i].base = NULL;
+			cam_io_trace_blocks[i].size = 0;
+			break;
+		}
+	}
+	spin_unlock_irqrestore(&cam_io_trace_block_lock, flags);
+}
+
+/* Caller must hold cam_io_trace_block_lock */
+static const char *cam_io_trace_resolve(void __iomem *addr,
+	uint32_t *offset)
+{
+	int i;
+	struct cam_io_trace_block *block;
+
+	for (i = 0; i < CAM_IO_TRACE_MAX_BLOCKS; i++) {
+		block = &cam_io_trace_blocks[i];
+		if (!block->base)
+			continue;
+
+		if ((addr >= block->base) &&
+			(addr < (block->base + block->size))) {
+			*offset = (uint32_t)(addr - block->base);
+			return block->name ? block->name : "unknown";
+		}
+	}
+
+	*offset = 0;
+	return NULL;
+}
+
+void cam_io_trace_dump(void)
+{
+	int                             cpu;
+	uint32_t                        i, n, head, count;
+	struct cam_io_trace_ring       *ring;
+	struct cam_io_trace_entry      *entry;
+	struct cam_io_trace_dump_entry  dump[CAM_IO_TRACE_DUMP_MAX];
+	unsigned long                   flags;
+
+	if (!io_trace_enable)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		ring = per_cpu_ptr(&cam_io_trace_rings, cpu);
+
+		/* Copy out under the lock, print with the lock dropped */
+		spin_lock_irqsave(&cam_io_trace_block_lock, flags);
+		head = READ_ONCE(ring->head);
+		count = min_t(uint32_t, head, CAM_IO_TRACE_DUMP_MAX);
+		for (i = head - count, n = 0; i != head; i++, n++) {
+			dump[n].entry =
+				ring->entries[i % CAM_IO_TRACE_RING_SIZE];
+			dump[n].block_name = cam_io_trace_resolve(
+				dump[n].entry.addr, &dump[n].offset);
+		}
+		spin_unlock_irqrestore(&cam_io_trace_block_lock, flags);
+
+		if (!count)
+			continue;
+
+		CAM_INFO(CAM_IO_ACCESS, "cpu %d: last %u of %u register accesses",
+			cpu, count, head);
+		for (n = 0; n < count; n++) {
+			entry = &dump[n].entry;
+			if (dump[n].block_name)
+				CAM_INFO(CAM_IO_ACCESS,
+					"cpu %d [%llu] %s %s+0x%x 0x%08x",
+					cpu, entry->timestamp,
+					(entry->op == CAM_IO_TRACE_OP_WRITE) ?
+					"W" : "R", dump[n].block_name,
+					dump[n].offset, entry->value);
+			else
+				CAM_INFO(CAM_IO_ACCESS,
+					"cpu %d [%llu] %s 0x%pK 0x%08x",
+					cpu, entry->timestamp,
+					(entry->op == CAM_IO_TRACE_OP_WRITE) ?
+					"W" : "R", entry->addr, entry->value);
+		}
+	}
+}
+
 int cam_io_w(uint32_t data, void __iomem *addr)
 {
 	if (!addr)
 		return -EINVAL;
 
 	CAM_DBG(CAM_IO_ACCESS, "0x%pK %08x", addr, data);
+	cam_io_trace_record(CAM_IO_TRACE_OP_WRITE, addr, data);
 	writel_relaxed_no_log(data, addr);
 
 	return 0;
@@ -27,6 +241,7 @@ int cam_io_w_mb(uint32_t data, void __iomem *addr)
 		return -EINVAL;
 
 	CAM_DBG(CAM_IO_ACCESS, "0x%pK %08x", addr, data);
+	cam_io_trace_record(CAM_IO_TRACE_OP_WRITE, addr, data);
 	/* Ensure previous writes are done */
 	wmb();
 	writel_relaxed_no_log(data, addr);
@@ -47,6 +262,7 @@ uint32_t cam_io_r(void __iomem *addr)
 
 	data = readl_relaxed(addr);
 	CAM_DBG(CAM_IO_ACCESS, "0x%pK %08x", addr, data);
+	cam_io_trace_record(CAM_IO_TRACE_OP_READ, addr, data);
 
 	return data;
 }
@@ -64,6 +280,7 @@ uint32_t cam_io_r_mb(void __iomem *addr)
 	rmb();
 	data = readl_relaxed(addr);
 	CAM_DBG(CAM_IO_ACCESS, "0x%pK %08x", addr, data);
+	cam_io_trace_record(CAM_IO_TRACE_OP_READ, addr, data);
 	/* Ensure previous read is done */
 	rmb();
 
@@ -84,6 +301,8 @@ int cam_io_memcpy(void __iomem *dest_addr,
 
 	for (i = 0; i < len/4; i++) {
 		CAM_DBG(CAM_IO_ACCESS, "0x%pK %08x", d, *s);
+		cam_io_trace_record(CAM_IO_TRACE_OP_WRITE,
+			(void __iomem *)d, *s);
 		writel_relaxed(*s++, d++);
 	}
 
@@ -109,6 +328,8 @@ int  cam_io_memcpy_mb(void __iomem *dest_addr,
 	wmb();
 	for (i = 0; i < (len / 4); i++) {
 		CAM_DBG(CAM_IO_ACCESS, "0x%pK %08x", d, *s);
+		cam_io_trace_record(CAM_IO_TRACE_OP_WRITE,
+			(void __iomem *)d, *s);
 		writel_relaxed(*s++, d++);
 	}
 	/* Ensure previous writes are done */
@@ -177,6 +398,7 @@ int cam_io_w_same_offset_block(const uint32_t *data, void __iomem *addr,
 	for (i = 0; i < len; i++) {
 		CAM_DBG(CAM_IO_ACCESS, "i= %d len =%d val=%x addr =%pK",
 			i, len, data[i], addr);
+		cam_io_trace_record(CAM_IO_TRACE_OP_WRITE, addr, data[i]);
 		writel_relaxed(data[i], addr);
 	}
 
@@ -194,6 +416,7 @@ int cam_io_w_mb_same_offset_block(const uint32_t *data, void __iomem *addr,
 	for (i = 0; i < len; i++) {
 		CAM_DBG(CAM_IO_ACCESS, "i= %d len =%d val=%x addr =%pK",
 			i, len, data[i], addr);
+		cam_io_trace_record(CAM_IO_TRACE_OP_WRITE, addr, data[i]);
 		/* Ensure previous writes are done */
 		wmb();
 		writel_relaxed(data[i], addr);
@@ -216,6 +439,8 @@ int cam_io_w_offset_val_block(const uint32_t data[][2],
 		CAM_DBG(CAM_IO_ACCESS,
 			"i= %d len =%d val=%x addr_base =%pK reg=%x",
 			i, len, __VAL(i), addr_base, __OFFSET(i));
+		cam_io_trace_record(CAM_IO_TRACE_OP_WRITE,
+			addr_base + __OFFSET(i), __VAL(i));
 		writel_relaxed(__VAL(i), addr_base + __OFFSET(i));
 	}
 
@@ -236,6 +461,8 @@ int cam_io_w_mb_offset_val_block(const uint32_t data[][2],
 		CAM_DBG(CAM_IO_ACCESS,
 			"i= %d len =%d val=%x addr_base =%pK reg=%x",
 			i, len, __VAL(i), addr_base, __OFFSET(i));
+		cam_io_trace_record(CAM_IO_TRACE_OP_WRITE,
+			addr_base + __OFFSET(i), __VAL(i));
 		writel_relaxed(__VAL(i), addr_base + __OFFSET(i));
 	}
 
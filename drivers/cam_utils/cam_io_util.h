@@ -229,4 +229,37 @@ int32_t cam_io_w_mb_offset_val_block(const uint32_t data[][2],
  */
 int cam_io_dump(void __iomem *base_addr, uint32_t start_offset, int size);
 
+/**
+ * cam_io_trace_register_block()
+ *
+ * @brief:              Register a mapped register block with the io tracer
+ *                      so that traced addresses can be resolved to a block
+ *                      name and offset when the trace is dumped
+ *
+ * @name:               Name of the register block
+ * @base:               Mapped base address of the block
+ * @size:               Size of the mapped region
+ */
+void cam_io_trace_register_block(const char *name, void __iomem *base,
+	resource_size_t size);
+
+/**
+ * cam_io_trace_unregister_block()
+ *
+ * @brief:              Remove a register block from the io tracer
+ *
+ * @base:               Mapped base address used at registration
+ */
+void cam_io_trace_unregister_block(void __iomem *base);
+
+/**
+ * cam_io_trace_dump()
+ *
+ * @brief:              Dump the most recent accesses of each per cpu
+ *                      register access ring, oldest first. Accesses are
+ *                      only recorded while the io_trace_enable module
+ *                      parameter is set.
+ */
+void cam_io_trace_dump(void);
+
 #endif /* _CAM_IO_UTIL_H_ */
@@ -11,12 +11,13 @@
 #include "cam_packet_util.h"
 #include "cam_debug_util.h"
 
-#define CAM_UNIQUE_SRC_HDL_MAX 50
+/* Max destination buffers kept mapped while patching one packet */
+#define CAM_PATCH_DST_HDL_MAX 16
 
-struct cam_patch_unique_src_buf_tbl {
+struct cam_patch_dst_buf_tbl {
 	int32_t       hdl;
-	dma_addr_t    iova;
-	size_t        buf_size;
+	uintptr_t     cpu_addr;
+	size_t        buf_len;
 };
 
 int cam_packet_util_get_cmd_mem_addr(int handle, uint32_t **buf_addr,
@@ -239,81 +240,135 @@ void cam_packet_dump_patch_info(struct cam_packet *packet,
 }
 
 static int cam_packet_util_get_patch_iova(
-	struct cam_patch_unique_src_buf_tbl *tbl,
+	struct cam_packet_iova_cache *cache,
 	int32_t hdl, uint32_t buf_hdl, dma_addr_t *iova, size_t *buf_size)
 {
-	int idx = 0;
+	struct cam_packet_iova_cache_entry *entry;
+	uint32_t idx;
 	int rc = 0;
 	size_t src_buf_size;
 	dma_addr_t iova_addr;
-	bool is_found = false;
 
-	for (idx = 0; idx < CAM_UNIQUE_SRC_HDL_MAX; idx++) {
-		if (buf_hdl == tbl[idx].hdl) {
+	for (idx = 0; idx < cache->num_entries; idx++) {
+		entry = &cache->entries[idx];
+		if ((entry->buf_hdl == (int32_t)buf_hdl) &&
+			(entry->mmu_hdl == hdl)) {
 			CAM_DBG(CAM_UTIL,
-				"Matched entry for src_buf_hdl: 0x%x with src_hdl[%d]: 0x%x",
-				buf_hdl, idx, tbl[idx].hdl);
-			*iova = tbl[idx].iova;
-			*buf_size = tbl[idx].buf_size;
-			is_found = true;
-			break;
-		} else if ((tbl[idx].hdl == 0) || (tbl[idx].iova == 0)) {
-			CAM_DBG(CAM_UTIL, "New src handle detected 0x%x",
-				buf_hdl);
-			is_found = false;
-			break;
+				"Matched entry for src_buf_hdl: 0x%x at idx: %u",
+				buf_hdl, idx);
+			*iova = entry->iova;
+			*buf_size = entry->buf_size;
+			return 0;
 		}
-		CAM_DBG(CAM_UTIL,
-			"Index: %d is filled with differnt src_hdl: 0x%x",
-			idx, buf_hdl);
 	}
 
-	if (!is_found) {
-		CAM_DBG(CAM_UTIL, "src_hdl 0x%x not found in table entries",
+	CAM_DBG(CAM_UTIL, "src_hdl 0x%x not found in table entries",
+		buf_hdl);
+	rc = cam_mem_get_io_buf(buf_hdl, hdl,
+		&iova_addr, &src_buf_size);
+	if (rc < 0) {
+		CAM_ERR(CAM_UTIL,
+			"unable to get iova for src_hdl: 0x%x",
 			buf_hdl);
-		rc = cam_mem_get_io_buf(buf_hdl, hdl,
-			&iova_addr, &src_buf_size);
-		if (rc < 0) {
-			CAM_ERR(CAM_UTIL,
-				"unable to get iova for src_hdl: 0x%x",
-				buf_hdl);
-			return rc;
+		return rc;
+	}
+
+	/* Update the table entry with unique src buf handle */
+	if (cache->num_entries < CAM_PACKET_IOVA_CACHE_MAX) {
+		idx = cache->num_entries++;
+	} else {
+		idx = cache->next_victim;
+		cache->next_victim = (idx + 1) % CAM_PACKET_IOVA_CACHE_MAX;
+	}
+
+	entry = &cache->entries[idx];
+	entry->buf_hdl = buf_hdl;
+	entry->mmu_hdl = hdl;
+	entry->iova = iova_addr;
+	entry->buf_size = src_buf_size;
+	CAM_DBG(CAM_UTIL, "Updated table index: %u with src_buf_hdl: 0x%x",
+		idx, buf_hdl);
+
+	*iova = iova_addr;
+	*buf_size = src_buf_size;
+
+	return rc;
+}
+
+static int cam_packet_util_get_patch_dst(
+	struct cam_patch_dst_buf_tbl *tbl, uint32_t *num_dst,
+	int32_t buf_hdl, uintptr_t *cpu_addr, size_t *buf_len,
+	bool *is_tracked)
+{
+	uint32_t idx;
+	int rc;
+
+	for (idx = 0; idx < *num_dst; idx++) {
+		if (tbl[idx].hdl == buf_hdl) {
+			*cpu_addr = tbl[idx].cpu_addr;
+			*buf_len = tbl[idx].buf_len;
+			*is_tracked = true;
+			return 0;
 		}
-		/* Update the table entry with unique src buf handle */
-		if (idx < CAM_UNIQUE_SRC_HDL_MAX && tbl[idx].hdl == 0) {
-			tbl[idx].buf_size = src_buf_size;
-			tbl[idx].iova = iova_addr;
-			tbl[idx].hdl = buf_hdl;
-			CAM_DBG(CAM_UTIL,
-				"Updated table index: %d with src_buf_hdl: 0x%x",
-				idx, tbl[idx].hdl);
+	}
+
+	rc = cam_mem_get_cpu_buf(buf_hdl, cpu_addr, buf_len);
+	if (rc < 0 || !(*cpu_addr) || (*buf_len == 0)) {
+		CAM_ERR(CAM_UTIL, "unable to get dst buf address");
+		if (!rc) {
+			cam_mem_put_cpu_buf(buf_hdl);
+			rc = -EINVAL;
 		}
-		*iova = iova_addr;
-		*buf_size = src_buf_size;
+		return rc;
 	}
 
-	return rc;
+	/* Keep the dst buffer until the whole packet is patched */
+	*is_tracked = (*num_dst < CAM_PATCH_DST_HDL_MAX);
+	if (*is_tracked) {
+		tbl[*num_dst].hdl = buf_hdl;
+		tbl[*num_dst].cpu_addr = *cpu_addr;
+		tbl[*num_dst].buf_len = *buf_len;
+		(*num_dst)++;
+	}
+
+	return 0;
 }
 
 int cam_packet_util_process_patches(struct cam_packet *packet,
-	int32_t iommu_hdl, int32_t sec_mmu_hdl)
+	int32_t iommu_hdl, int32_t sec_mmu_hdl,
+	struct cam_packet_iova_cache *iova_cache)
 {
 	struct cam_patch_desc *patch_desc = NULL;
+	struct cam_packet_iova_cache local_cache;
+	struct cam_patch_dst_buf_tbl dst_tbl[CAM_PATCH_DST_HDL_MAX];
 	dma_addr_t iova_addr;
 	uintptr_t  cpu_addr = 0;
 	uint32_t   temp;
 	uint32_t  *dst_cpu_addr;
 	uint32_t  *src_buf_iova_addr;
+	uint32_t   num_dst = 0;
+	uint32_t   mem_gen;
 	size_t     dst_buf_len;
 	size_t     src_buf_size;
 	int        i  = 0;
 	int        rc = 0;
 	int32_t    hdl;
-	struct cam_patch_unique_src_buf_tbl
-		tbl[CAM_UNIQUE_SRC_HDL_MAX];
+	bool       dst_tracked;
 
-	memset(tbl, 0, CAM_UNIQUE_SRC_HDL_MAX *
-		sizeof(struct cam_patch_unique_src_buf_tbl));
+	if (!iova_cache) {
+		iova_cache = &local_cache;
+		iova_cache->mem_gen = 0;
+		iova_cache->num_entries = 0;
+		iova_cache->next_victim = 0;
+	}
+
+	/* Drop cached iova if any buffer got unmapped since last packet */
+	mem_gen = cam_mem_mgr_get_unmap_gen();
+	if (iova_cache->mem_gen != mem_gen) {
+		iova_cache->num_entries = 0;
+		iova_cache->next_victim = 0;
+		iova_cache->mem_gen = mem_gen;
+	}
 
 	/* process patch descriptor */
 	patch_desc = (struct cam_patch_desc *)
@@ -327,31 +382,31 @@ int cam_packet_util_process_patches(struct cam_packet *packet,
 		hdl = cam_mem_is_secure_buf(patch_desc[i].src_buf_hdl) ?
 			sec_mmu_hdl : iommu_hdl;
 
-		rc = cam_packet_util_get_patch_iova(&tbl[0], hdl,
+		rc = cam_packet_util_get_patch_iova(iova_cache, hdl,
 			patch_desc[i].src_buf_hdl, &iova_addr, &src_buf_size);
 		if (rc) {
 			CAM_ERR(CAM_UTIL,
 				"get_iova failed for patch[%d], src_buf_hdl: 0x%x: rc: %d",
 				i, patch_desc[i].src_buf_hdl, rc);
-			return rc;
+			goto put_dst;
 		}
 
 		if ((size_t)patch_desc[i].src_offset >= src_buf_size) {
 			CAM_ERR(CAM_UTIL,
 				"Invalid src buf patch offset: patch:src_offset: 0x%x, src_buf_size: %zu",
 				patch_desc[i].src_offset, src_buf_size);
-			return -EINVAL;
+			rc = -EINVAL;
+			goto put_dst;
 		}
 
 		src_buf_iova_addr = (uint32_t *)iova_addr;
 		temp = iova_addr;
 
-		rc = cam_mem_get_cpu_buf(patch_desc[i].dst_buf_hdl,
-			&cpu_addr, &dst_buf_len);
-		if (rc < 0 || !cpu_addr || (dst_buf_len == 0)) {
-			CAM_ERR(CAM_UTIL, "unable to get dst buf address");
-			return rc;
-		}
+		rc = cam_packet_util_get_patch_dst(dst_tbl, &num_dst,
+			patch_desc[i].dst_buf_hdl, &cpu_addr, &dst_buf_len,
+			&dst_tracked);
+		if (rc)
+			goto put_dst;
 		dst_cpu_addr = (uint32_t *)cpu_addr;
 
 		CAM_DBG(CAM_UTIL, "i = %d patch info = %x %x %x %x", i,
@@ -363,8 +418,11 @@ int cam_packet_util_process_patches(struct cam_packet *packet,
 			(size_t)patch_desc[i].dst_offset)) {
 			CAM_ERR(CAM_UTIL,
 				"Invalid dst buf patch offset");
-			cam_mem_put_cpu_buf((int32_t)patch_desc[i].dst_buf_hdl);
-			return -EINVAL;
+			if (!dst_tracked)
+				cam_mem_put_cpu_buf(
+					(int32_t)patch_desc[i].dst_buf_hdl);
+			rc = -EINVAL;
+			goto put_dst;
 		}
 
 		dst_cpu_addr = (uint32_t *)((uint8_t *)dst_cpu_addr +
@@ -377,9 +435,14 @@ int cam_packet_util_process_patches(struct cam_packet *packet,
 			"patch is done for dst %pK with src %pK value %llx",
 			dst_cpu_addr, src_buf_iova_addr,
 			*((uint64_t *)dst_cpu_addr));
-		cam_mem_put_cpu_buf((int32_t)patch_desc[i].dst_buf_hdl);
+		if (!dst_tracked)
+			cam_mem_put_cpu_buf((int32_t)patch_desc[i].dst_buf_hdl);
 	}
 
+put_dst:
+	while (num_dst)
+		cam_mem_put_cpu_buf(dst_tbl[--num_dst].hdl);
+
 	return rc;
 }
 
@@ -7,8 +7,47 @@
 #ifndef _CAM_PACKET_UTIL_H_
 #define _CAM_PACKET_UTIL_H_
 
+#include <linux/types.h>
 #include <media/cam_defs.h>
 
+/* Max patch source buffers remembered per context */
+#define CAM_PACKET_IOVA_CACHE_MAX 50
+
+/**
+ * @brief                  Cached iova of a patch source buffer
+ *
+ * @buf_hdl:               Source buffer memory handle
+ * @mmu_hdl:               IOMMU handle the iova belongs to
+ * @iova:                  IOVA of the buffer
+ * @buf_size:              Size of the buffer
+ *
+ */
+struct cam_packet_iova_cache_entry {
+	int32_t      buf_hdl;
+	int32_t      mmu_hdl;
+	dma_addr_t   iova;
+	size_t       buf_size;
+};
+
+/**
+ * @brief                  Per context iova cache for patch processing
+ *
+ * Entries survive across packets and are dropped as a whole once the
+ * mem mgr unmap generation changes.
+ *
+ * @mem_gen:               Mem mgr unmap generation of the entries
+ * @num_entries:           Number of valid entries
+ * @next_victim:           Entry to replace once the cache is full
+ * @entries:               Cached entries
+ *
+ */
+struct cam_packet_iova_cache {
+	uint32_t                            mem_gen;
+	uint32_t                            num_entries;
+	uint32_t                            next_victim;
+	struct cam_packet_iova_cache_entry  entries[CAM_PACKET_IOVA_CACHE_MAX];
+};
+
 /**
  * @brief                  KMD scratch buffer information
  *
@@ -111,12 +150,15 @@ void cam_packet_dump_patch_info(struct cam_packet *packet,
  * @iommu_hdl:          IOMMU handle of the HW Device that received the packet
  * @sec_iommu_hdl:      Secure IOMMU handle of the HW Device that
  *                      received the packet
+ * @iova_cache:         Context iova cache kept across packets, may be
+ *                      NULL to resolve every source buffer per packet
  *
  * @return:             0: Success
  *                      Negative: Failure
  */
 int cam_packet_util_process_patches(struct cam_packet *packet,
-	int32_t iommu_hdl, int32_t sec_mmu_hdl);
+	int32_t iommu_hdl, int32_t sec_mmu_hdl,
+	struct cam_packet_iova_cache *iova_cache);
 
 /**
  * cam_packet_util_process_generic_cmd_buffer()
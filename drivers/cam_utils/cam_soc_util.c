@@ -1638,6 +1638,9 @@ int cam_soc_util_request_platform_resource(
 			soc_info->mem_block_cam_base[i];
 		soc_info->reg_map[i].size =
 			resource_size(soc_info->mem_block[i]);
+		cam_io_trace_register_block(soc_info->mem_block_name[i],
+			soc_info->reg_map[i].mem_base,
+			soc_info->reg_map[i].size);
 		soc_info->num_reg_map++;
 	}
 
@@ -1728,6 +1731,7 @@ unmap_base:
 		if (soc_info->reserve_mem)
 			release_mem_region(soc_info->mem_block[i]->start,
 				resource_size(soc_info->mem_block[i]));
+		cam_io_trace_unregister_block(soc_info->reg_map[i].mem_base);
 		iounmap(soc_info->reg_map[i].mem_base);
 		soc_info->reg_map[i].mem_base = NULL;
 		soc_info->reg_map[i].size = 0;
@@ -1758,6 +1762,7 @@ int cam_soc_util_release_platform_resource(struct cam_hw_soc_info *soc_info)
 	}
 
 	for (i = soc_info->num_reg_map - 1; i >= 0; i--) {
+		cam_io_trace_unregister_block(soc_info->reg_map[i].mem_base);
 		iounmap(soc_info->reg_map[i].mem_base);
 		soc_info->reg_map[i].mem_base = NULL;
 		soc_info->reg_map[i].size = 0;
@@ -368,6 +368,27 @@ TRACE_EVENT(cam_irq_handled,
 	)
 );
 
+TRACE_EVENT(cam_irq_th_duration,
+	TP_PROTO(const char *entity, uint64_t duration_ns,
+		uint32_t num_handlers),
+	TP_ARGS(entity, duration_ns, num_handlers),
+	TP_STRUCT__entry(
+		__string(entity, entity)
+		__field(uint64_t, duration_ns)
+		__field(uint32_t, num_handlers)
+	),
+	TP_fast_assign(
+		__assign_str(entity, entity);
+		__entry->duration_ns = duration_ns;
+		__entry->num_handlers = num_handlers;
+	),
+	TP_printk(
+		"%8s: top half duration=%lluns handlers=%u",
+			__get_str(entity), __entry->duration_ns,
+			__entry->num_handlers
+	)
+);
+
 TRACE_EVENT(cam_cdm_cb,
 	TP_PROTO(const char *entity, uint32_t status),
 	TP_ARGS(entity, status),
@@ -267,6 +267,8 @@ struct cam_req_mgr_link_control {
 #define CAM_REQ_MGR_LINK_CONTROL                (CAM_COMMON_OPCODE_MAX + 13)
 #define CAM_REQ_MGR_LINK_V2                     (CAM_COMMON_OPCODE_MAX + 14)
 #define CAM_REQ_MGR_REQUEST_DUMP                (CAM_COMMON_OPCODE_MAX + 15)
+#define CAM_REQ_MGR_CACHE_OPS_RANGE             (CAM_COMMON_OPCODE_MAX + 16)
+#define CAM_REQ_MGR_CACHE_OPS_VEC               (CAM_COMMON_OPCODE_MAX + 17)
 
 /* end of cam_req_mgr opcodes */
 
@@ -419,6 +421,37 @@ struct cam_mem_cache_ops_cmd {
 	__u32 mem_cache_ops;
 };
 
+/* Max number of ranges in one CAM_REQ_MGR_CACHE_OPS_VEC call */
+#define CAM_MEM_MAX_CACHE_OPS_RANGES            64
+
+/**
+ * struct cam_mem_cache_ops_range_cmd
+ * @buf_handle: buffer handle
+ * @ops: cache operations
+ * @offset: offset of the range from start of the buffer
+ * @length: length of the range, zero means till end of the buffer
+ */
+/* CAM_REQ_MGR_CACHE_OPS_RANGE */
+struct cam_mem_cache_ops_range_cmd {
+	__s32 buf_handle;
+	__u32 mem_cache_ops;
+	__u64 offset;
+	__u64 length;
+};
+
+/**
+ * struct cam_mem_cache_ops_vec_cmd
+ * @ranges: user pointer to array of struct cam_mem_cache_ops_range_cmd
+ * @num_ranges: number of ranges, at most CAM_MEM_MAX_CACHE_OPS_RANGES
+ * @reserved: reserved field
+ */
+/* CAM_REQ_MGR_CACHE_OPS_VEC */
+struct cam_mem_cache_ops_vec_cmd {
+	__u64 ranges;
+	__u32 num_ranges;
+	__u32 reserved;
+};
+
 /**
  * Request Manager : error message type
  * @CAM_REQ_MGR_ERROR_TYPE_DEVICE: Device error message, fatal to session
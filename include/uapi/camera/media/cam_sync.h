@@ -23,6 +23,12 @@
 /* Size of opaque payload sent to kernel for safekeeping until signal time */
 #define CAM_SYNC_USER_PAYLOAD_SIZE               2
 
+/* Max number of sync objects, size of the mmap-able fence status array */
+#define CAM_SYNC_MAX_OBJS_UAPI                   2048
+
+/* Max number of sync objects in one batch signal or batch wait */
+#define CAM_SYNC_MAX_BATCH_OBJS                  64
+
 /* Device type for sync device needed for device discovery */
 #define CAM_SYNC_DEVICE_TYPE                     (MEDIA_ENT_F_OLD_BASE)
 
@@ -146,6 +152,24 @@ struct cam_sync_ev_header_v2 {
 	uint32_t evt_param[CAM_SYNC_EVENT_CNT];
 };
 
+/**
+ * struct cam_sync_status_entry - Entry of the read-only fence status array
+ *
+ * The sync device can be mmap'd read-only at offset 0 to get an array of
+ * CAM_SYNC_MAX_OBJS_UAPI entries indexed by sync object. Each entry is
+ * updated like a seqcount: seqno is odd while an update is in progress,
+ * so a reader must retry until it reads the same even seqno before and
+ * after reading state. Entry 0 is not a valid sync object, its seqno
+ * counts all updates of the array and its state is unused.
+ *
+ * @state: CAM_SYNC_STATE_* of the sync object
+ * @seqno: Sequence number of the entry
+ */
+struct cam_sync_status_entry {
+	__u32 state;
+	__u32 seqno;
+};
+
 /**
  * struct cam_sync_info - Sync object creation information
  *
@@ -207,6 +231,38 @@ struct cam_sync_wait {
 	uint64_t timeout_ms;
 };
 
+/**
+ * struct cam_sync_signal_batch - Signal multiple sync objects at once
+ *
+ * @signals:     Pointer to array of struct cam_sync_signal
+ * @num_signals: Number of entries in the array, at most
+ *               CAM_SYNC_MAX_BATCH_OBJS, sync objects must be unique
+ * @reserved:    Reserved
+ */
+struct cam_sync_signal_batch {
+	__u64 signals;
+	__u32 num_signals;
+	__u32 reserved;
+};
+
+/**
+ * struct cam_sync_wait_batch - Wait on multiple sync objects at once
+ *
+ * @sync_objs:    Pointer to array of __s32 sync objects
+ * @num_objs:     Number of entries in the array, at most
+ *                CAM_SYNC_MAX_BATCH_OBJS
+ * @signaled_idx: Index in sync_objs of an object found signaled, for
+ *                CAM_SYNC_WAIT_ANY, or of the first failing object, for
+ *                CAM_SYNC_WAIT_ALL; -1 if none
+ * @timeout_ms:   Timeout in milliseconds
+ */
+struct cam_sync_wait_batch {
+	__u64    sync_objs;
+	__u32    num_objs;
+	__s32    signaled_idx;
+	uint64_t timeout_ms;
+};
+
 /**
  * struct cam_private_ioctl_arg - Sync driver ioctl argument
  *
@@ -234,5 +290,8 @@ struct cam_private_ioctl_arg {
 #define CAM_SYNC_REGISTER_PAYLOAD                4
 #define CAM_SYNC_DEREGISTER_PAYLOAD              5
 #define CAM_SYNC_WAIT                            6
+#define CAM_SYNC_SIGNAL_BATCH                    7
+#define CAM_SYNC_WAIT_ANY                        8
+#define CAM_SYNC_WAIT_ALL                        9
 
 #endif /* __UAPI_CAM_SYNC_H__ */